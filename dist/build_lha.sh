@@ -30,13 +30,15 @@ fi
 STAGING=$(mktemp -d)
 trap 'rm -rf "$STAGING"' EXIT
 
-mkdir -p "$STAGING/bsdsocktest/host"
+mkdir -p "$STAGING/bsdsocktest/host" "$STAGING/bsdsocktest/replay"
 
 cp bsdsocktest           "$STAGING/bsdsocktest/"
 cp bsdsocktest.readme    "$STAGING/bsdsocktest/"
 cp dist/bsdsocktest.info "$STAGING/bsdsocktest/"
 cp LICENSE               "$STAGING/bsdsocktest/"
 cp host/bsdsocktest_helper.py "$STAGING/bsdsocktest/host/"
+cp host/bsdsocktest_trace.py  "$STAGING/bsdsocktest/host/"
+cp replay/*.rpl          "$STAGING/bsdsocktest/replay/"
 
 # Create the archive from the staging directory so paths start with bsdsocktest/
 ARCHIVE="bsdsocktest-${VERSION}.lha"
@@ -3,7 +3,10 @@
 bsdsocktest_helper.py -- Host-side helper for bsdsocktest network tests.
 
 Provides passive services (echo, sink, source) and active coordination
-(connect-to-Amiga) via a line-based control channel.
+(connect-to-Amiga, client load against an Amiga server) via a line-based
+control channel.  Each service can be impaired (delay, jitter, loss,
+bandwidth cap) from the control channel to emulate a slow or lossy link
+without tc/netem.
 
 Services (port offsets from --ctrl-port):
   ctrl+0  Control channel (TCP) — protocol commands
@@ -11,13 +14,42 @@ Services (port offsets from --ctrl-port):
   ctrl+2  UDP echo server — echoes datagrams back
   ctrl+3  TCP sink server — receives and discards data
   ctrl+4  TCP source server — sends test pattern data until close
+  ctrl+5  UDP sink — counts sequence-numbered datagrams (loss/reorder/dup)
+  ctrl+6  UDP blaster — source port for BLAST bursts towards the Amiga
+  ctrl+7  UDP timestamp — echoes datagrams with receive/send times added
+
+With --workers N, the TCP echo, UDP echo, TCP sink, TCP source, UDP sink
+and UDP timestamp ports of every block are served by N forked processes bound with
+SO_REUSEPORT, so the kernel spreads connections and flows across cores.
+The main process keeps the control channel and the blasters, and drives
+the workers over a socketpair (one JSON object per line): opening and
+closing session blocks, mirroring IMPAIR and gathering UDPSTATS.
+
+Several Amiga clients may share one helper.  Each control connection is a
+session; a session that sends SESSION gets a private copy of ctrl+1..7 at
+ctrl+10*n+1..7 so its statistics and impairments are its own.
+
+A session that sends STREAM has its TAP log mirrored over the control
+channel as LOG lines, which are appended to a per-session file in
+--log-dir.  If the control connection drops without QUIT (the guest
+crashed), the file is closed with a Bail out! line.
 
 Usage:
   python3 bsdsocktest_helper.py [-v] [--bind ADDR] [--ctrl-port PORT]
+                                [--max-sessions N] [--workers N]
+                                [--log-dir DIR]
 """
 
 import argparse
+import datetime
+import errno
+import functools
+import heapq
+import json
+import os
+import random
 import selectors
+import signal
 import socket
 import struct
 import sys
@@ -26,14 +58,84 @@ import time
 # Default ports (must match helper_proto.h)
 DEFAULT_CTRL_PORT = 8700
 
+# Private service blocks handed out by SESSION start at ctrl+10, ctrl+20, ...
+SESSION_STRIDE = 10
+DEFAULT_MAX_SESSIONS = 16
+
+# Outbound CONNECT gives up after this many seconds
+CONNECT_TIMEOUT = 5.0
+
+# Services of a block, in port-offset order (also the IMPAIR names)
+BLOCK_SERVICES = ("tcpecho", "udpecho", "tcpsink", "tcpsource",
+                  "udpsink", "blast", "udptime")
+# Services handed to --workers processes; the blaster stays with the
+# control channel that drives it
+WORKER_SERVICES = tuple(name for name in BLOCK_SERVICES if name != "blast")
+BLOCK_SIZE = len(BLOCK_SERVICES)
+# Seconds to wait for every worker to answer a forwarded query
+WORKER_QUERY_TIMEOUT = 1.0
+
+# UDP timestamp service: the first TS_REQUEST.size bytes of a request
+# (client fields, returned untouched) followed by the helper's receive
+# and send times as seconds + microseconds of its monotonic clock.
+# Must match HELPER_TS_REQ_SIZE / HELPER_TS_REPLY_SIZE in helper_proto.h.
+TS_REQUEST = struct.Struct("!16s")
+TS_STAMPS = struct.Struct("!IIII")
+
+# UDP sink/blaster datagram header: sequence number, run id (big-endian).
+# Must match HELPER_SEQ_HDR_SIZE in helper_proto.h.
+SEQ_HEADER = struct.Struct("!II")
+
+# UDP sink accounting interval (seconds) and per-host run history
+SINK_INTERVAL = 1.0
+SINK_MAX_RUNS = 16
+
+# Blaster pacing tick (seconds) and burst size when unpaced
+BLAST_TICK = 0.01
+BLAST_BURST = 64
+BLAST_MAX_COUNT = 100000
+
+# TCP cannot drop bytes from userspace; a "lost" TCP chunk is instead held
+# back for roughly one retransmission timeout.
+IMPAIR_LOSS_STALL = 0.2
+# Token bucket depth (bytes) for the bandwidth cap
+IMPAIR_BURST = 8192
+# UDP datagrams queued longer than this behind the bandwidth cap are
+# tail-dropped, like a router with a finite queue
+IMPAIR_QUEUE_TIME = 0.25
+# Echo bytes held for delayed delivery before reading is paused
+IMPAIR_TCP_QUEUE = 65536
+
+# LOAD runs: client connections opened towards an Amiga server
+LOAD_MODES = ("echo", "sink")
+LOAD_MAX_CONNS = 256
+LOAD_MAX_COUNT = 100000
+LOAD_MAX_SIZE = 65536
+LOAD_DEADLINE = 30.0
+# FLOOD runs: connections not established this long after the last one
+# was opened count as timed out (SYN dropped by a full backlog)
+FLOOD_WAIT = 3.0
+
+# REPLAY responders: steps per connection, and how long one waits
+# without traffic (or for its connection) before closing
+REPLAY_MAX_STEPS = 100000
+REPLAY_IDLE = 30.0
+
 
 def log(msg, verbose_only=False):
     """Log to stderr."""
     if verbose_only and not log.verbose:
         return
-    print(f"[helper] {msg}", file=sys.stderr, flush=True)
+    print(f"[{log.prefix}] {msg}", file=sys.stderr, flush=True)
 
 log.verbose = False
+log.prefix = "helper"
+
+
+def timestamp():
+    """Monotonic clock as (seconds, microseconds), 32 bits each."""
+    us = int(time.monotonic() * 1000000)
+    return (us // 1000000) & 0xFFFFFFFF, us % 1000000
 
 
 def fill_test_pattern(length, seed):
@@ -47,32 +149,401 @@ def fill_test_pattern(length, seed):
     return bytes(result)
 
 
+class SeqStats:
+    """Sequence accounting for one UDP sink run.
+
+    A datagram is a duplicate if its sequence number was already seen,
+    reordered if it arrives below the highest sequence seen so far, and
+    lost if it never arrives.  Only the sender knows how many it sent,
+    so run loss needs its count; without it, datagrams lost after the
+    highest one received go unnoticed.  Per-interval loss counts the
+    gaps opened in that interval; a late arrival that fills a gap is
+    reported as a reorder in the interval where it lands.
+    """
+
+    def __init__(self, now):
+        self.start = now
+        self.last = now
+        self.received = 0
+        self.bytes = 0
+        self.highest = -1
+        self.seen = set()
+        self.reordered = 0
+        self.duplicates = 0
+        # Per interval: [received, reordered, duplicates, advanced,
+        #                highest seq when the interval opened]
+        self.intervals = []
+
+    def add(self, seq, size, now):
+        idx = int((now - self.start) / SINK_INTERVAL)
+        while len(self.intervals) <= idx:
+            self.intervals.append([0, 0, 0, 0, self.highest])
+        iv = self.intervals[idx]
+        self.last = now
+
+        if seq in self.seen:
+            self.duplicates += 1
+            iv[2] += 1
+            return
+        self.seen.add(seq)
+        self.received += 1
+        self.bytes += size
+        iv[0] += 1
+        if seq < self.highest:
+            self.reordered += 1
+            iv[1] += 1
+        else:
+            self.highest = seq
+            iv[3] += 1
+
+    def lost(self, sent=None):
+        """Datagrams lost out of 'sent', or gaps below the highest."""
+        expected = self.highest + 1
+        if sent is not None and sent > expected:
+            expected = sent
+        return expected - self.received
+
+    def dump(self):
+        """Summary for forwarding from a worker process (JSON-safe)."""
+        return {"start": self.start, "last": self.last,
+                "received": self.received, "bytes": self.bytes,
+                "highest": self.highest, "reordered": self.reordered,
+                "duplicates": self.duplicates, "intervals": self.intervals}
+
+    @classmethod
+    def merge(cls, parts):
+        """Combine worker summaries of one run.  SO_REUSEPORT hashes a
+        flow to a single worker, so normally there is only one part;
+        otherwise the counters are summed and the intervals aligned by
+        time (duplicates across workers are not detected)."""
+        merged = cls(min(p["start"] for p in parts))
+        merged.last = max(p["last"] for p in parts)
+        merged.highest = max(p["highest"] for p in parts)
+        for p in parts:
+            merged.received += p["received"]
+            merged.bytes += p["bytes"]
+            merged.reordered += p["reordered"]
+            merged.duplicates += p["duplicates"]
+            shift = int((p["start"] - merged.start) / SINK_INTERVAL)
+            for i, iv in enumerate(p["intervals"]):
+                while len(merged.intervals) <= i + shift:
+                    merged.intervals.append([0, 0, 0, 0, iv[4]])
+                dst = merged.intervals[i + shift]
+                for k in range(4):
+                    dst[k] += iv[k]
+                dst[4] = min(dst[4], iv[4])
+        return merged
+
+    def report(self, sent=None):
+        """Return the STATS line and INTERVAL lines for UDPSTATS."""
+        elapsed_ms = int((self.last - self.start) * 1000)
+        lines = [f"STATS {self.received} {self.lost(sent)} "
+                 f"{self.reordered} {self.duplicates} {self.bytes} "
+                 f"{elapsed_ms}\n"]
+        for i, iv in enumerate(self.intervals):
+            if i + 1 < len(self.intervals):
+                end_highest = self.intervals[i + 1][4]
+            else:
+                end_highest = self.highest
+            gaps = max(0, end_highest - iv[4] - iv[3])
+            lines.append(f"INTERVAL {i} {iv[0]} {gaps} {iv[1]} {iv[2]}\n")
+        return lines
+
+
+class Impairment:
+    """Userspace link impairment for one service.
+
+    delay and jitter are in milliseconds (jitter is uniform, +/-), loss is
+    a percentage, rate is a bandwidth cap in KB/s (0 = uncapped).  The cap
+    is a token bucket that may run into debt: data that finds the bucket
+    empty is released when the debt has drained.
+    """
+
+    KEYS = ("delay", "jitter", "loss", "rate")
+
+    def __init__(self, delay=0.0, jitter=0.0, loss=0.0, rate=0.0):
+        self.delay = delay
+        self.jitter = jitter
+        self.loss = loss
+        self.rate = rate
+        self._rng = random.Random()
+        self._tokens = float(IMPAIR_BURST)
+        self._stamp = time.monotonic()
+        self._last_due = 0.0
+
+    @classmethod
+    def parse(cls, words):
+        """Build from "key=value" words; raises ValueError if malformed."""
+        values = {}
+        for word in words:
+            key, sep, value = word.partition("=")
+            if not sep or key not in cls.KEYS or key in values:
+                raise ValueError(f"bad setting {word}")
+            values[key] = float(value)
+            if values[key] < 0:
+                raise ValueError(f"negative {key}")
+        if values.get("loss", 0.0) > 100.0:
+            raise ValueError("loss above 100%")
+        if values.get("jitter", 0.0) > values.get("delay", 0.0):
+            raise ValueError("jitter exceeds delay")
+        return cls(**values)
+
+    def __str__(self):
+        return (f"delay={self.delay:g}ms jitter={self.jitter:g}ms "
+                f"loss={self.loss:g}% rate={self.rate:g}KB/s")
+
+    def lost(self):
+        """Decide whether the next packet or chunk is lost."""
+        return self.loss > 0 and self._rng.random() * 100.0 < self.loss
+
+    def stall(self):
+        """Hold time for the next TCP chunk: a loss costs a retransmit."""
+        return IMPAIR_LOSS_STALL if self.lost() else 0.0
+
+    def latency(self):
+        """One-way delay for the next packet, in seconds."""
+        if not self.jitter:
+            return self.delay / 1000.0
+        return max(0.0, self.delay + self._rng.uniform(-self.jitter,
+                                                       self.jitter)) / 1000.0
+
+    def admit(self, nbytes, now, latency=True, queue_limit=None,
+              in_order=False, stall=0.0):
+        """Return the time nbytes may be delivered, or None to tail-drop.
+
+        in_order keeps a stream's chunks in sequence despite jitter;
+        stall is extra hold time (a TCP loss)."""
+        wait = 0.0
+        if self.rate:
+            bps = self.rate * 1024.0
+            self._tokens = min(float(IMPAIR_BURST),
+                               self._tokens + (now - self._stamp) * bps)
+            self._stamp = now
+            if self._tokens < nbytes:
+                wait = (nbytes - self._tokens) / bps
+                if queue_limit is not None and wait > queue_limit:
+                    return None
+            self._tokens -= nbytes
+        due = now + wait + stall + (self.latency() if latency else 0.0)
+        if in_order:
+            due = max(due, self._last_due)
+            self._last_due = due
+        return due
+
+
+class Blast:
+    """One BLAST burst: sequence-numbered datagrams sent at a fixed rate."""
+
+    def __init__(self, dest, count, size, rate, run_id):
+        self.dest = dest
+        self.count = count
+        self.size = size
+        self.rate = rate            # datagrams per second, 0 = unpaced
+        self.run_id = run_id
+        self.sent = 0
+        self.start = time.monotonic()
+        self.payload = fill_test_pattern(max(0, size - SEQ_HEADER.size),
+                                         run_id & 0xFFFF)
+
+
+class LoadConn:
+    """One client connection of a LOAD run."""
+
+    def __init__(self, index, sock):
+        self.index = index
+        self.sock = sock
+        self.start = time.monotonic()
+        self.connected = False
+        self.request = b""          # echo: request in flight
+        self.sent = 0               # bytes of the request (or stream) sent
+        self.got = b""              # echo: reply collected so far
+        self.requests = 0           # echo: completed round trips
+        self.req_start = 0.0
+        self.closing = False        # sink: all sent, awaiting the close
+
+
+class LoadRun:
+    """One LOAD run: 'conns' clients connecting to an Amiga server at
+    'rate' connections/s, each doing 'count' echo round trips of 'size'
+    bytes or streaming count * size bytes into a sink.  A FLOOD run is
+    mode "connect": connections only, held open until the report."""
+
+    def __init__(self, mode, dest, conns, rate, count, size,
+                 deadline=LOAD_DEADLINE):
+        self.mode = mode
+        self.dest = dest
+        self.conns = conns
+        self.rate = rate
+        self.count = count
+        self.size = size
+        self.payload = fill_test_pattern(size, size)
+        self.deadline = deadline    # seconds after the start
+        self.active = {}            # sock -> LoadConn
+        self.held = []              # established FLOOD connections
+        self.finished = 0
+        self.outcomes = {"ok": 0, "failed": 0, "refused": 0,
+                         "timeout": 0, "bad": 0}
+        self.bytes = 0
+        self.conn_us = []           # connect latencies
+        self.rt_us = []             # echo round trips / sink transfers
+        self.start = time.monotonic()
+        self.done = False
+
+    def report(self):
+        """The RESULT line sent back to the Amiga (times in us)."""
+        def pct(values, p):
+            if not values:
+                return 0
+            values = sorted(values)
+            return values[min(len(values) - 1, len(values) * p // 100)]
+
+        ms = int((time.monotonic() - self.start) * 1000)
+        fields = [f"{k}={v}" for k, v in self.outcomes.items()]
+        fields += [f"bytes={self.bytes}", f"ms={ms}",
+                   f"conn_p50={pct(self.conn_us, 50)}",
+                   f"conn_p90={pct(self.conn_us, 90)}",
+                   f"conn_max={max(self.conn_us, default=0)}",
+                   f"rt_p50={pct(self.rt_us, 50)}",
+                   f"rt_p90={pct(self.rt_us, 90)}",
+                   f"rt_p99={pct(self.rt_us, 99)}",
+                   f"rt_max={max(self.rt_us, default=0)}"]
+        return "RESULT " + " ".join(fields) + "\n"
+
+
+class ReplayPeer:
+    """The remote end of one connection of a replayed trace.  Step i
+    waits for expect[i] more bytes from the Amiga, then answers with
+    answer[i] bytes (one datagram for UDP)."""
+
+    pattern = b""               # answer payload, built on first use
+
+    def __init__(self, proto, count):
+        self.proto = proto
+        self.count = count          # steps announced by REPLAY
+        self.steps = []             # (expect, answer)
+        self.step = 0
+        self.got = 0                # bytes towards the current step
+        self.out = b""              # TCP answer bytes not yet sent
+        self.sock = None            # TCP listener or UDP socket
+        self.conn = None            # accepted TCP connection
+        self.dest = None            # UDP: the Amiga's address
+        self.last = time.monotonic()
+
+    def advance(self, nbytes):
+        """Count received bytes; return the answers now due."""
+        answers = []
+        self.got += nbytes
+        while (self.step < len(self.steps) and
+               self.got >= self.steps[self.step][0]):
+            expect, answer = self.steps[self.step]
+            self.got -= expect
+            self.step += 1
+            if not ReplayPeer.pattern:
+                ReplayPeer.pattern = fill_test_pattern(65536, 0)
+            repeat = answer // len(ReplayPeer.pattern) + 1
+            answers.append((ReplayPeer.pattern * repeat)[:answer])
+        return answers
+
+
+class ServiceBlock:
+    """One set of data service ports, at offsets 1-6 from 'base'.
+
+    The default block (base = control port) is shared by every session
+    that does not ask for its own.  A private block belongs to a single
+    session and closes with it.  Impairments, UDP sink runs and the
+    blaster live in the block, so sessions on private blocks cannot
+    disturb each other's results.
+    """
+
+    def __init__(self, base):
+        self.base = base
+        self.listeners = []
+        self.blast_sock = None
+        self.impair = {}            # service name -> Impairment
+        self.impair_owner = None    # session that set the impairments
+        self.udp_runs = {}          # (ip, run id) -> SeqStats
+
+
+class Worker:
+    """A forked process serving the shared data ports (--workers)."""
+
+    def __init__(self, index, pid, chan):
+        self.index = index
+        self.pid = pid
+        self.chan = chan
+        self.buf = b""
+
+    def send(self, msg):
+        try:
+            self.chan.sendall(json.dumps(msg).encode("ascii") + b"\n")
+        except OSError:
+            pass
+
+
+class Session:
+    """One Amiga control connection and its state."""
+
+    def __init__(self, sid, conn, addr, block):
+        self.id = sid
+        self.conn = conn
+        self.amiga_ip = addr[0]
+        self.port = addr[1]
+        self.buf = b""
+        self.block = block
+        self.slot = None            # private block slot, if any
+        self.load = None            # LoadRun in progress, if any
+        self.stream = None          # STREAM log file, if any
+        self.replay = None          # ReplayPeer awaiting its STEP lines
+        self.replays = []           # open ReplayPeers
+        self.quit = False           # QUIT received
+
+    def send(self, msg):
+        if self.conn:
+            try:
+                self.conn.sendall(msg.encode("ascii"))
+            except OSError:
+                pass
+
+
 class Helper:
     """Main helper server managing all services and control connections."""
 
-    def __init__(self, bind_addr, ctrl_port):
+    def __init__(self, bind_addr, ctrl_port, max_sessions=DEFAULT_MAX_SESSIONS,
+                 workers=0, log_dir="."):
         self.bind_addr = bind_addr
         self.ctrl_port = ctrl_port
+        self.max_sessions = max_sessions
+        self.log_dir = log_dir
+        self.nworkers = workers
+        self.workers = []           # Worker processes (main process only)
+        self._queries = {}          # request id -> pending worker query
+        self._next_query = 1
+        self._stop = False
         self.sel = selectors.DefaultSelector()
-        self.amiga_ip = None
-        self.ctrl_conn = None
-        self.ctrl_buf = b""
         self.listeners = []
+        self.default_block = None
+        self.sessions = {}          # control socket -> Session
+        self._next_session = 1
+        self._free_slots = list(range(1, max_sessions + 1))
         self._sink_totals = {}      # fd -> bytes received
         self._source_state = {}     # fd -> (offset, pattern)
+        self._timers = []           # heap of (due, seq, callback, args)
+        self._timer_seq = 0
+        self._echo_pending = {}     # sock -> [queued bytes, closing]
+        self._connecting = set()    # outbound CONNECT sockets in progress
 
     def start(self):
         """Start all listeners."""
+        # Workers first, so they inherit nothing but their channel
+        for index in range(1, self.nworkers + 1):
+            self._spawn_worker(index)
         # Control channel
         self._listen_tcp(self.ctrl_port, self._accept_ctrl)
-        # TCP echo
-        self._listen_tcp(self.ctrl_port + 1, self._accept_echo)
-        # UDP echo
-        self._listen_udp(self.ctrl_port + 2, self._handle_udp_echo)
-        # TCP sink
-        self._listen_tcp(self.ctrl_port + 3, self._accept_sink)
-        # TCP source
-        self._listen_tcp(self.ctrl_port + 4, self._accept_source)
+        # Shared data services at ctrl+1 .. ctrl+7
+        if self.workers:
+            self.default_block = self._open_block(self.ctrl_port, ("blast",))
+        else:
+            self.default_block = self._open_block(self.ctrl_port)
 
         log(f"Listening on {self.bind_addr}")
         log(f"  Control:    port {self.ctrl_port}")
@@ -80,38 +551,265 @@ class Helper:
         log(f"  UDP echo:   port {self.ctrl_port + 2}")
         log(f"  TCP sink:   port {self.ctrl_port + 3}")
         log(f"  TCP source: port {self.ctrl_port + 4}")
+        log(f"  UDP sink:   port {self.ctrl_port + 5}")
+        log(f"  UDP blast:  port {self.ctrl_port + 6}")
+        log(f"  UDP time:   port {self.ctrl_port + 7}")
+        if self.max_sessions:
+            log(f"  Sessions:   ports {self.ctrl_port + SESSION_STRIDE}-"
+                f"{self.ctrl_port + SESSION_STRIDE * self.max_sessions + BLOCK_SIZE}"
+                f" ({self.max_sessions} private blocks)")
+        if self.workers:
+            log(f"  Workers:    {len(self.workers)} processes serve echo, "
+                f"sink and source ports (SO_REUSEPORT)")
+
+    def _open_block(self, base, services=BLOCK_SERVICES, reuseport=False):
+        """Open the data services of one block; raises OSError if a port
+        is taken (nothing is left open in that case)."""
+        block = ServiceBlock(base)
+        opened = {
+            "tcpecho": lambda port: self._listen_tcp(port, functools.partial(
+                self._accept_echo, block), block.listeners, reuseport),
+            "udpecho": lambda port: self._listen_udp(port, functools.partial(
+                self._handle_udp_echo, block), block.listeners, reuseport),
+            "tcpsink": lambda port: self._listen_tcp(port, functools.partial(
+                self._accept_sink, block), block.listeners, reuseport),
+            "tcpsource": lambda port: self._listen_tcp(port, functools.partial(
+                self._accept_source, block), block.listeners, reuseport),
+            "udpsink": lambda port: self._listen_udp(port, functools.partial(
+                self._handle_udp_sink, block), block.listeners, reuseport),
+            "blast": lambda port: self._bind_blaster(block, port),
+            "udptime": lambda port: self._listen_udp(port, functools.partial(
+                self._handle_udp_time, block), block.listeners, reuseport),
+        }
+        try:
+            for offset, name in enumerate(BLOCK_SERVICES, 1):
+                if name in services:
+                    opened[name](base + offset)
+        except OSError:
+            self._close_block(block)
+            raise
+        return block
+
+    def _bind_blaster(self, block, port):
+        # Send-only; bound so the source port is predictable
+        block.blast_sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        block.blast_sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        block.blast_sock.bind((self.bind_addr, port))
+        block.blast_sock.setblocking(False)
+
+    def _close_block(self, block):
+        for sock in block.listeners:
+            try:
+                self.sel.unregister(sock)
+            except (KeyError, ValueError):
+                pass
+            sock.close()
+        block.listeners = []
+        if block.blast_sock:
+            block.blast_sock.close()
+            block.blast_sock = None
 
     def run(self):
         """Main event loop."""
         try:
-            while True:
-                events = self.sel.select(timeout=1.0)
+            while not self._stop:
+                timeout = 1.0
+                if self._timers:
+                    timeout = max(0.0, min(timeout,
+                                           self._timers[0][0] -
+                                           time.monotonic()))
+                events = self.sel.select(timeout=timeout)
                 for key, mask in events:
                     callback = key.data
                     callback(key.fileobj, mask)
+                self._run_timers()
         except KeyboardInterrupt:
             log("Shutting down (Ctrl-C)")
         finally:
             self._cleanup()
 
-    def _listen_tcp(self, port, accept_callback):
+    def _call_later(self, delay, callback, *args):
+        """Run callback(*args) from the event loop after delay seconds."""
+        self._call_at(time.monotonic() + delay, callback, *args)
+
+    def _call_at(self, when, callback, *args):
+        """Run callback(*args) at monotonic time 'when'.  Callbacks due at
+        the same time run in the order they were scheduled."""
+        self._timer_seq += 1
+        heapq.heappush(self._timers, (when, self._timer_seq, callback, args))
+
+    def _run_timers(self):
+        now = time.monotonic()
+        while self._timers and self._timers[0][0] <= now:
+            _, _, callback, args = heapq.heappop(self._timers)
+            callback(*args)
+
+    def _listen_tcp(self, port, accept_callback, owner=None, reuseport=False):
         """Create a TCP listener."""
         sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
-        sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
-        sock.bind((self.bind_addr, port))
-        sock.listen(5)
+        try:
+            sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+            if reuseport:
+                sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEPORT, 1)
+            sock.bind((self.bind_addr, port))
+            sock.listen(5)
+        except OSError:
+            sock.close()
+            raise
         sock.setblocking(False)
         self.sel.register(sock, selectors.EVENT_READ, accept_callback)
-        self.listeners.append(sock)
+        (self.listeners if owner is None else owner).append(sock)
 
-    def _listen_udp(self, port, handler):
+    def _listen_udp(self, port, handler, owner=None, reuseport=False):
         """Create a UDP listener."""
         sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
-        sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
-        sock.bind((self.bind_addr, port))
+        try:
+            sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+            if reuseport:
+                sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEPORT, 1)
+            sock.bind((self.bind_addr, port))
+        except OSError:
+            sock.close()
+            raise
         sock.setblocking(False)
         self.sel.register(sock, selectors.EVENT_READ, handler)
-        self.listeners.append(sock)
+        (self.listeners if owner is None else owner).append(sock)
+
+    # ---- Worker processes ----
+
+    def _spawn_worker(self, index):
+        """Fork a worker serving the data ports of every block."""
+        parent_chan, child_chan = socket.socketpair()
+        pid = os.fork()
+        if pid == 0:
+            parent_chan.close()
+            for w in self.workers:
+                w.chan.close()
+            self._worker_main(index, child_chan)
+            os._exit(0)
+        child_chan.close()
+        parent_chan.setblocking(False)
+        worker = Worker(index, pid, parent_chan)
+        self.workers.append(worker)
+        self.sel.register(parent_chan, selectors.EVENT_READ,
+                          functools.partial(self._handle_worker, worker))
+
+    def _worker_main(self, index, chan):
+        """Body of a worker process: serve data ports until the main
+        process goes away."""
+        log.prefix = f"helper:w{index}"
+        # Ctrl-C reaches the whole process group; the main process
+        # shuts us down by closing the channel instead
+        signal.signal(signal.SIGINT, signal.SIG_IGN)
+        self.sel.close()
+        self.sel = selectors.DefaultSelector()
+        self.workers = []
+        self.max_sessions = 0
+        self._blocks = {}           # base port -> ServiceBlock
+        try:
+            self.default_block = self._open_block(
+                self.ctrl_port, WORKER_SERVICES, reuseport=True)
+        except OSError as e:
+            log(f"Cannot open shared ports: {e}")
+            return
+        self._blocks[self.ctrl_port] = self.default_block
+        self.sel.register(chan, selectors.EVENT_READ,
+                          functools.partial(self._handle_master, [b""]))
+        self.run()
+        for block in self._blocks.values():
+            self._close_block(block)
+
+    def _handle_master(self, state, chan, mask):
+        """Worker side: requests from the main process."""
+        try:
+            data = chan.recv(65536)
+        except OSError:
+            data = b""
+        if not data:
+            self._stop = True           # main process gone: shut down
+            return
+
+        state[0] += data
+        while b"\n" in state[0]:
+            line, state[0] = state[0].split(b"\n", 1)
+            msg = json.loads(line)
+            op, base = msg["op"], msg["base"]
+            block = self._blocks.get(base)
+            result = None
+            if op == "open" and block is None:
+                try:
+                    self._blocks[base] = self._open_block(
+                        base, WORKER_SERVICES, reuseport=True)
+                    result = True
+                except OSError as e:
+                    result = str(e)
+            elif op == "close" and block is not None:
+                self._close_block(self._blocks.pop(base))
+            elif op == "impair" and block is not None:
+                for name in msg["services"]:
+                    if msg["spec"] is None:
+                        block.impair.pop(name, None)
+                    else:
+                        block.impair[name] = Impairment.parse(msg["spec"])
+            elif op == "udpstats" and block is not None:
+                stats = block.udp_runs.get((msg["ip"], msg["run"]))
+                result = stats.dump() if stats else None
+            if "req" in msg:
+                reply = {"req": msg["req"], "result": result}
+                chan.sendall(json.dumps(reply).encode("ascii") + b"\n")
+
+    def _handle_worker(self, worker, chan, mask):
+        """Main process side: replies from a worker."""
+        try:
+            data = chan.recv(65536)
+        except OSError:
+            data = b""
+        if not data:
+            log(f"Worker {worker.index} (pid {worker.pid}) exited")
+            self.sel.unregister(chan)
+            chan.close()
+            self.workers.remove(worker)
+            for req in list(self._queries):
+                self._query_reply(req, worker, None)
+            return
+
+        worker.buf += data
+        while b"\n" in worker.buf:
+            line, worker.buf = worker.buf.split(b"\n", 1)
+            msg = json.loads(line)
+            self._query_reply(msg["req"], worker, msg["result"])
+
+    def _query_workers(self, msg, done):
+        """Send msg to every worker; call done(list of non-null replies)
+        once all have answered or WORKER_QUERY_TIMEOUT has passed."""
+        req = self._next_query
+        self._next_query += 1
+        self._queries[req] = (set(self.workers), [], done)
+        msg["req"] = req
+        for w in self.workers:
+            w.send(msg)
+        self._call_later(WORKER_QUERY_TIMEOUT, self._query_finish, req)
+
+    def _query_reply(self, req, worker, payload):
+        query = self._queries.get(req)
+        if query is None:
+            return              # answered too late
+        waiting, replies, _ = query
+        waiting.discard(worker)
+        if payload is not None:
+            replies.append(payload)
+        if not waiting:
+            self._query_finish(req)
+
+    def _query_finish(self, req):
+        query = self._queries.pop(req, None)
+        if query is not None:
+            query[2](query[1])
+
+    def _tell_workers(self, msg):
+        """Send msg to every worker without waiting for an answer."""
+        for w in self.workers:
+            w.send(msg)
 
     # ---- Control channel ----
 
@@ -119,121 +817,804 @@ class Helper:
         conn, addr = sock.accept()
         conn.setblocking(False)
 
-        if self.ctrl_conn is not None:
-            log(f"New control connection from {addr[0]}:{addr[1]}, "
-                f"closing previous")
-            self._close_ctrl()
-
-        self.amiga_ip = addr[0]
-        self.ctrl_conn = conn
-        self.ctrl_buf = b""
-        log(f"Control connection from {self.amiga_ip}:{addr[1]}")
+        session = Session(self._next_session, conn, addr, self.default_block)
+        self._next_session += 1
+        self.sessions[conn] = session
+        log(f"Control connection from {addr[0]}:{addr[1]} "
+            f"(session {session.id}, {len(self.sessions)} active)")
 
         # Send OK
         try:
             conn.sendall(b"OK\n")
         except OSError as e:
             log(f"Error sending OK: {e}")
-            self._close_ctrl()
+            self._close_session(session)
             return
 
-        self.sel.register(conn, selectors.EVENT_READ, self._handle_ctrl)
+        self.sel.register(conn, selectors.EVENT_READ,
+                          functools.partial(self._handle_ctrl, session))
 
-    def _handle_ctrl(self, sock, mask):
+    def _handle_ctrl(self, session, sock, mask):
         try:
             data = sock.recv(1024)
         except OSError:
             data = b""
 
         if not data:
-            log("Control connection closed by Amiga")
-            self._close_ctrl()
+            log(f"Session {session.id}: control connection closed by Amiga")
+            self._close_session(session)
             return
 
-        self.ctrl_buf += data
-        while b"\n" in self.ctrl_buf:
-            line, self.ctrl_buf = self.ctrl_buf.split(b"\n", 1)
+        session.buf += data
+        while b"\n" in session.buf and session.conn:
+            line, session.buf = session.buf.split(b"\n", 1)
+            # LOG lines are data, not commands: kept verbatim, unanswered
+            if line.startswith(b"LOG "):
+                self._handle_log(session, line[4:].rstrip(b"\r"))
+                continue
             line = line.strip().decode("ascii", errors="replace")
-            self._process_ctrl_command(line)
+            self._process_ctrl_command(session, line)
 
-    def _process_ctrl_command(self, line):
-        log(f"Control command: {line}", verbose_only=True)
+    def _process_ctrl_command(self, session, line):
+        log(f"Session {session.id}: command: {line}", verbose_only=True)
 
         if line.startswith("CONNECT "):
             try:
                 port = int(line.split()[1])
             except (IndexError, ValueError):
-                self._ctrl_send("FAIL bad port\n")
+                session.send("FAIL bad port\n")
+                return
+            self._handle_connect(session, port)
+
+        elif line == "SESSION":
+            self._handle_session(session)
+
+        elif line.startswith("UDPSTATS "):
+            # UDPSTATS <run> [<sent>]
+            try:
+                words = [int(v) for v in line.split()[1:3]]
+                run_id = words[0]
+            except (IndexError, ValueError):
+                session.send("FAIL bad run id\n")
                 return
-            self._handle_connect(port)
+            self._handle_udpstats(session, run_id,
+                                  words[1] if len(words) > 1 else None)
+
+        elif line.startswith("BLAST "):
+            try:
+                port, count, size, rate, run_id = \
+                    (int(v) for v in line.split()[1:6])
+            except ValueError:
+                session.send("FAIL bad arguments\n")
+                return
+            self._handle_blast(session, port, count, size, rate, run_id)
+
+        elif line.startswith("IMPAIR "):
+            self._handle_impair(session, line.split()[1:])
+
+        elif line.startswith("LOAD "):
+            words = line.split()
+            try:
+                port, conns, rate, count, size = \
+                    (int(v) for v in words[2:7])
+            except ValueError:
+                session.send("FAIL bad arguments\n")
+                return
+            if len(words) != 7:
+                session.send("FAIL bad arguments\n")
+                return
+            self._handle_load(session, words[1], port, conns, rate,
+                              count, size)
+
+        elif line.startswith("FLOOD "):
+            try:
+                port, conns, rate = (int(v) for v in line.split()[1:4])
+            except ValueError:
+                session.send("FAIL bad arguments\n")
+                return
+            self._handle_flood(session, port, conns, rate)
+
+        elif line.startswith("REPLAY "):
+            words = line.split()
+            try:
+                count = int(words[2])
+            except (IndexError, ValueError):
+                session.send("FAIL bad arguments\n")
+                return
+            self._handle_replay(session, words[1], count)
+
+        elif line.startswith("STEP "):
+            try:
+                expect, answer = (int(v) for v in line.split()[1:3])
+            except ValueError:
+                session.send("FAIL bad arguments\n")
+                return
+            self._handle_step(session, expect, answer)
+
+        elif line == "STREAM":
+            self._handle_stream(session)
 
         elif line == "QUIT":
-            log("QUIT received, closing control connection")
-            self._close_ctrl()
+            log(f"Session {session.id}: QUIT received, "
+                f"closing control connection")
+            session.quit = True
+            self._close_session(session)
 
         else:
-            log(f"Unknown command: {line}")
-            self._ctrl_send(f"FAIL unknown command\n")
+            log(f"Session {session.id}: unknown command: {line}")
+            session.send(f"FAIL unknown command\n")
+
+    def _handle_session(self, session):
+        """Handle SESSION: give the session a private service block."""
+        if session.block is not self.default_block:
+            session.send(f"SESSION {session.id} {session.block.base}\n")
+            return
+
+        self._try_slots(session, list(self._free_slots))
+
+    def _try_slots(self, session, slots):
+        """Open a private block in the first usable slot.  With workers
+        the data ports are bound there, which completes asynchronously."""
+        while slots:
+            slot = slots.pop(0)
+            if slot not in self._free_slots:
+                continue
+            base = self.ctrl_port + SESSION_STRIDE * slot
+            try:
+                block = self._open_block(
+                    base, ("blast",) if self.workers else BLOCK_SERVICES)
+            except OSError as e:
+                log(f"Session block at {base} unavailable: {e}",
+                    verbose_only=True)
+                continue
+            self._free_slots.remove(slot)
+
+            if not self.workers:
+                self._grant_session(session, slot, block)
+                return
+
+            expected = len(self.workers)
+
+            def done(results, slot=slot, block=block):
+                if (session.conn and len(results) == expected and
+                        all(r is True for r in results)):
+                    self._grant_session(session, slot, block)
+                    return
+                for r in results:
+                    if r is not True:
+                        log(f"Session block at {block.base} unavailable: "
+                            f"{r}", verbose_only=True)
+                self._release_block(slot, block)
+                if session.conn:
+                    self._try_slots(session, slots)
+
+            self._query_workers({"op": "open", "base": base}, done)
+            return
+
+        session.send("FAIL no free session ports\n")
+
+    def _grant_session(self, session, slot, block):
+        session.slot = slot
+        session.block = block
+        log(f"Session {session.id}: private services at "
+            f"ports {block.base + 1}-{block.base + BLOCK_SIZE}")
+        session.send(f"SESSION {session.id} {block.base}\n")
+
+    def _release_block(self, slot, block):
+        """Close a private block here and in the workers; free its slot."""
+        self._close_block(block)
+        self._tell_workers({"op": "close", "base": block.base})
+        self._free_slots.append(slot)
+        self._free_slots.sort()
+
+    def _handle_stream(self, session):
+        """Handle STREAM: open the session's log file for LOG lines."""
+        if session.stream:
+            session.send(f"OK {os.path.basename(session.stream.name)}\n")
+            return
+
+        stamp = datetime.datetime.now().strftime("%Y%m%d-%H%M%S")
+        name = f"bsdsocktest-{session.amiga_ip}-{stamp}-s{session.id}.log"
+        try:
+            # Line buffered: every LOG line reaches the file at once
+            session.stream = open(os.path.join(self.log_dir, name), "a",
+                                  buffering=1, encoding="latin-1")
+        except OSError as e:
+            log(f"Session {session.id}: cannot open stream log: {e}")
+            session.send("FAIL cannot open log file\n")
+            return
+        log(f"Session {session.id}: streaming log to {session.stream.name}")
+        session.send(f"OK {name}\n")
+
+    def _handle_log(self, session, data):
+        """Handle LOG: append one TAP line to the session's stream file."""
+        if not session.stream:
+            return
+        try:
+            session.stream.write(data.decode("latin-1") + "\n")
+        except OSError as e:
+            log(f"Session {session.id}: stream log write failed: {e}")
+            session.stream.close()
+            session.stream = None
 
-    def _handle_connect(self, port):
+    def _handle_connect(self, session, port):
         """Handle CONNECT command: connect to Amiga on the specified port."""
-        if not self.amiga_ip:
-            self._ctrl_send("FAIL no Amiga IP\n")
+        if not 0 < port < 65536:
+            session.send("FAIL bad port\n")
             return
 
-        log(f"CONNECT to {self.amiga_ip}:{port}", verbose_only=True)
-        self._ctrl_send("GO\n")
+        log(f"CONNECT to {session.amiga_ip}:{port}", verbose_only=True)
+        session.send("GO\n")
 
-        # Sleep to let Amiga set up its listener
-        time.sleep(0.5)
+        # Give the Amiga time to set up its listener.  The connect is
+        # non-blocking so other sessions keep being served meanwhile.
+        self._call_later(0.5, self._connect_start, session.amiga_ip, port)
 
+    def _connect_start(self, ip, port):
+        s = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        s.setblocking(False)
+        err = s.connect_ex((ip, port))
+        if err not in (0, errno.EINPROGRESS, errno.EWOULDBLOCK):
+            log(f"CONNECT to {ip}:{port} failed: {os.strerror(err)}")
+            s.close()
+            return
+        self._connecting.add(s)
+        self.sel.register(s, selectors.EVENT_WRITE,
+                          functools.partial(self._connect_ready, ip, port))
+        self._call_later(CONNECT_TIMEOUT, self._connect_expire, s, ip, port)
+
+    def _connect_ready(self, ip, port, s, mask):
+        self.sel.unregister(s)
+        self._connecting.discard(s)
+        err = s.getsockopt(socket.SOL_SOCKET, socket.SO_ERROR)
         try:
-            s = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
-            s.settimeout(5.0)
-            s.connect((self.amiga_ip, port))
+            if err:
+                raise OSError(err, os.strerror(err))
             s.sendall(b"BSDSOCKTEST HELLO FROM HELPER\n")
-            s.close()
-            log(f"CONNECT to {self.amiga_ip}:{port} completed",
-                verbose_only=True)
+            log(f"CONNECT to {ip}:{port} completed", verbose_only=True)
         except OSError as e:
-            log(f"CONNECT to {self.amiga_ip}:{port} failed: {e}")
+            log(f"CONNECT to {ip}:{port} failed: {e}")
+        s.close()
+
+    def _connect_expire(self, s, ip, port):
+        if s in self._connecting:
+            self._connecting.discard(s)
+            self.sel.unregister(s)
+            s.close()
+            log(f"CONNECT to {ip}:{port} failed: timed out")
+
+    def _handle_impair(self, session, words):
+        """Handle IMPAIR: set or clear impairment on one or all services."""
+        block = session.block
+        if not words or (words[0] != "all" and
+                         words[0] not in BLOCK_SERVICES):
+            session.send("FAIL unknown service\n")
+            return
+        services = BLOCK_SERVICES if words[0] == "all" else (words[0],)
+
+        if words[1:] == ["off"]:
+            for name in services:
+                block.impair.pop(name, None)
+            self._tell_workers({"op": "impair", "base": block.base,
+                                "services": services, "spec": None})
+            log(f"Session {session.id}: IMPAIR {words[0]}: off")
+            session.send("OK\n")
+            return
+
+        try:
+            Impairment.parse(words[1:])
+        except ValueError as e:
+            session.send(f"FAIL {e}\n")
+            return
+        # Separate instances: each service gets its own bottleneck
+        for name in services:
+            block.impair[name] = Impairment.parse(words[1:])
+        self._tell_workers({"op": "impair", "base": block.base,
+                            "services": services, "spec": words[1:]})
+        block.impair_owner = session
+        log(f"Session {session.id}: IMPAIR {words[0]}: "
+            f"{block.impair[services[0]]}")
+        session.send("OK\n")
+
+    def _handle_udpstats(self, session, run_id, sent):
+        """Handle UDPSTATS: report sink accounting for one run of 'sent'
+        datagrams (None: unknown)."""
+        if self.workers:
+            # The sink runs in the workers: gather their parts
+            def done(parts):
+                stats = SeqStats.merge(parts) if parts else None
+                self._send_udpstats(session, stats, sent)
+            self._query_workers({"op": "udpstats",
+                                 "base": session.block.base,
+                                 "ip": session.amiga_ip, "run": run_id},
+                                done)
+            return
+        self._send_udpstats(session,
+                            session.block.udp_runs.get((session.amiga_ip,
+                                                        run_id)), sent)
+
+    def _send_udpstats(self, session, stats, sent):
+        if stats is None:
+            lines = [f"STATS 0 {sent or 0} 0 0 0 0\n"]
+        else:
+            lines = stats.report(sent)
+        lines.append("END\n")
+        session.send("".join(lines))
+
+    def _handle_blast(self, session, port, count, size, rate, run_id):
+        """Handle BLAST: send count datagrams of size bytes to the Amiga."""
+        if not (0 < port < 65536 and 0 < count <= BLAST_MAX_COUNT and
+                SEQ_HEADER.size <= size <= 65507 and rate >= 0):
+            session.send("FAIL bad arguments\n")
+            return
+
+        log(f"BLAST {count} x {size} bytes at {rate}/s to "
+            f"{session.amiga_ip}:{port}", verbose_only=True)
+        session.send("GO\n")
+
+        blast = Blast((session.amiga_ip, port), count, size, rate, run_id)
+        # Same settling delay as CONNECT: let the Amiga reach its recv loop
+        self._call_later(0.5, self._blast_tick, blast, session)
 
-    def _ctrl_send(self, msg):
-        if self.ctrl_conn:
+    def _blast_tick(self, blast, session):
+        if session.conn is None:
+            return      # control connection went away; abandon the burst
+        block = session.block
+
+        if blast.sent == 0:
+            blast.start = time.monotonic()
+        if blast.rate:
+            due = int((time.monotonic() - blast.start) * blast.rate) + 1
+            due = min(due, blast.count) - blast.sent
+        else:
+            due = min(BLAST_BURST, blast.count - blast.sent)
+
+        imp = block.impair.get("blast")
+        while due > 0:
+            packet = SEQ_HEADER.pack(blast.sent, blast.run_id) + blast.payload
+            if imp:
+                # Lost or tail-dropped datagrams still count as sent
+                when = None if imp.lost() else \
+                    imp.admit(len(packet), time.monotonic(),
+                              queue_limit=IMPAIR_QUEUE_TIME)
+                if when is not None:
+                    self._call_at(when, self._blast_send, block, packet,
+                                  blast.dest)
+                blast.sent += 1
+                due -= 1
+                continue
             try:
-                self.ctrl_conn.sendall(msg.encode("ascii"))
+                block.blast_sock.sendto(packet, blast.dest)
+            except (BlockingIOError, InterruptedError):
+                break           # socket buffer full; retry next tick
+            except OSError as e:
+                log(f"BLAST sendto failed: {e}", verbose_only=True)
+                break
+            blast.sent += 1
+            due -= 1
+
+        if blast.sent < blast.count:
+            self._call_later(BLAST_TICK if blast.rate else 0,
+                             self._blast_tick, blast, session)
+            return
+
+        elapsed_ms = int((time.monotonic() - blast.start) * 1000)
+        log(f"BLAST done: {blast.sent} datagrams in {elapsed_ms} ms",
+            verbose_only=True)
+        session.send(f"DONE {blast.sent} {elapsed_ms}\n")
+
+    def _blast_send(self, block, packet, dest):
+        if block.blast_sock is None:
+            return          # session's private block already closed
+        try:
+            block.blast_sock.sendto(packet, dest)
+        except OSError:
+            pass            # impaired path: a full buffer is just more loss
+
+    # ---- LOAD and FLOOD: client load towards an Amiga server ----
+
+    def _handle_load(self, session, mode, port, conns, rate, count, size):
+        """Handle LOAD: open client connections to the Amiga's server."""
+        min_size = SEQ_HEADER.size if mode == "echo" else 1
+        if not (mode in LOAD_MODES and 0 < port < 65536 and
+                0 < conns <= LOAD_MAX_CONNS and rate >= 0 and
+                0 < count <= LOAD_MAX_COUNT and
+                min_size <= size <= LOAD_MAX_SIZE):
+            session.send("FAIL bad arguments\n")
+            return
+        if session.load:
+            session.send("FAIL load run in progress\n")
+            return
+
+        log(f"Session {session.id}: LOAD {mode} {conns} connections at "
+            f"{rate}/s to {session.amiga_ip}:{port}", verbose_only=True)
+        run = LoadRun(mode, (session.amiga_ip, port), conns, rate, count,
+                      size)
+        session.load = run
+        session.send("GO\n")
+        # Same settling delay as CONNECT: let the Amiga reach its loop
+        self._call_later(0.5, self._load_begin, session, run)
+
+    def _handle_flood(self, session, port, conns, rate):
+        """Handle FLOOD: open connections to the Amiga as fast as
+        possible (or at 'rate'/s) and report how many it absorbed."""
+        if not (0 < port < 65536 and 0 < conns <= LOAD_MAX_CONNS and
+                rate >= 0):
+            session.send("FAIL bad arguments\n")
+            return
+        if session.load:
+            session.send("FAIL load run in progress\n")
+            return
+
+        log(f"Session {session.id}: FLOOD {conns} connections at "
+            f"{rate}/s to {session.amiga_ip}:{port}", verbose_only=True)
+        spread = (conns - 1) / rate if rate else 0.0
+        run = LoadRun("connect", (session.amiga_ip, port), conns, rate,
+                      0, 0, spread + FLOOD_WAIT)
+        session.load = run
+        session.send("GO\n")
+        self._call_later(0.5, self._load_begin, session, run)
+
+    def _load_begin(self, session, run):
+        if run.done:
+            return
+        run.start = time.monotonic()
+        self._call_later(run.deadline, self._load_expire, session, run)
+        for index in range(run.conns):
+            if run.rate:
+                self._call_at(run.start + index / run.rate,
+                              self._load_open, session, run, index)
+            else:
+                self._load_open(session, run, index)
+
+    def _load_open(self, session, run, index):
+        if run.done:
+            return
+        s = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        s.setblocking(False)
+        if run.mode == "echo":
+            s.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        conn = LoadConn(index, s)
+        run.active[s] = conn
+        err = s.connect_ex(run.dest)
+        if err not in (0, errno.EINPROGRESS, errno.EWOULDBLOCK):
+            self._load_end(session, run, conn,
+                           "refused" if err == errno.ECONNREFUSED
+                           else "failed")
+            return
+        self.sel.register(s, selectors.EVENT_WRITE,
+                          functools.partial(self._load_io, session, run,
+                                            conn))
+
+    def _load_io(self, session, run, conn, sock, mask):
+        now = time.monotonic()
+        if not conn.connected:
+            err = sock.getsockopt(socket.SOL_SOCKET, socket.SO_ERROR)
+            if err:
+                self._load_end(session, run, conn,
+                               "refused" if err == errno.ECONNREFUSED
+                               else "failed")
+                return
+            conn.connected = True
+            conn.req_start = now
+            run.conn_us.append(int((now - conn.start) * 1000000))
+            if run.mode == "connect":
+                self._load_end(session, run, conn, "ok", hold=True)
+                return
+
+        if mask & selectors.EVENT_READ:
+            try:
+                data = sock.recv(65536)
+            except (BlockingIOError, InterruptedError):
+                data = None
             except OSError:
+                self._load_end(session, run, conn, "failed")
+                return
+            if data == b"":
+                # The Amiga closing a sink after the last byte is success
+                if conn.closing:
+                    run.bytes += run.count * run.size
+                    run.rt_us.append(int((now - conn.req_start) * 1000000))
+                    self._load_end(session, run, conn, "ok")
+                else:
+                    self._load_end(session, run, conn, "failed")
+                return
+            if data and run.mode == "echo":
+                conn.got += data
+                if not conn.request.startswith(conn.got):
+                    self._load_end(session, run, conn, "bad")
+                    return
+                if len(conn.got) == run.size:
+                    run.rt_us.append(int((now - conn.req_start) * 1000000))
+                    run.bytes += run.size
+                    conn.requests += 1
+                    if conn.requests == run.count:
+                        self._load_end(session, run, conn, "ok")
+                        return
+                    conn.request = b""
+                    conn.req_start = now
+
+        if run.mode == "echo":
+            if not conn.request:
+                # Header ties the reply to this connection and round trip
+                conn.request = SEQ_HEADER.pack(conn.index, conn.requests) + \
+                    run.payload[SEQ_HEADER.size:]
+                conn.sent = 0
+                conn.got = b""
+            data = conn.request[conn.sent:]
+        else:
+            left = run.count * run.size - conn.sent
+            offset = conn.sent % run.size
+            data = run.payload[offset:offset + left]
+        if data:
+            try:
+                conn.sent += sock.send(data)
+            except (BlockingIOError, InterruptedError):
                 pass
+            except OSError:
+                self._load_end(session, run, conn, "failed")
+                return
+        if (run.mode == "sink" and not conn.closing and
+                conn.sent == run.count * run.size):
+            sock.shutdown(socket.SHUT_WR)
+            conn.closing = True
+
+        writing = conn.sent < (len(conn.request) if run.mode == "echo"
+                               else run.count * run.size)
+        self.sel.modify(sock, selectors.EVENT_READ |
+                        (selectors.EVENT_WRITE if writing else 0),
+                        functools.partial(self._load_io, session, run, conn))
+
+    def _load_end(self, session, run, conn, outcome, hold=False):
+        """One connection is finished; report once all of them are."""
+        run.active.pop(conn.sock, None)
+        try:
+            self.sel.unregister(conn.sock)
+        except (KeyError, ValueError):
+            pass
+        if hold:
+            run.held.append(conn.sock)
+        else:
+            conn.sock.close()
+        run.outcomes[outcome] += 1
+        run.finished += 1
+        if run.finished == run.conns:
+            self._load_report(session, run)
+
+    def _load_expire(self, session, run):
+        if run.done:
+            return
+        # Stuck connections, and any the rate never got round to opening
+        for conn in list(run.active.values()):
+            self._load_end(session, run, conn, "timeout")
+        if not run.done:
+            run.outcomes["timeout"] += run.conns - run.finished
+            run.finished = run.conns
+            self._load_report(session, run)
 
-    def _close_ctrl(self):
-        if self.ctrl_conn:
+    def _load_report(self, session, run):
+        run.done = True
+        session.load = None
+        line = run.report()
+        for sock in run.held:
+            sock.close()
+        run.held = []
+        log(f"Session {session.id}: LOAD done: {line.strip()}",
+            verbose_only=True)
+        session.send(line)
+
+    def _load_abort(self, run):
+        run.done = True
+        for conn in list(run.active.values()):
             try:
-                self.sel.unregister(self.ctrl_conn)
+                self.sel.unregister(conn.sock)
             except (KeyError, ValueError):
                 pass
+            conn.sock.close()
+        run.active.clear()
+        for sock in run.held:
+            sock.close()
+        run.held = []
+
+    def _close_session(self, session):
+        conn = session.conn
+        if conn is None:
+            return
+        self.sessions.pop(conn, None)
+        try:
+            self.sel.unregister(conn)
+        except (KeyError, ValueError):
+            pass
+        try:
+            conn.close()
+        except OSError:
+            pass
+        session.conn = None
+        if session.load:
+            self._load_abort(session.load)
+            session.load = None
+        session.replay = None
+        for peer in list(session.replays):
+            self._replay_close(session, peer)
+        if session.stream:
+            try:
+                if not session.quit:
+                    session.stream.write("Bail out! Control connection "
+                                         "lost before QUIT\n")
+                session.stream.close()
+            except OSError:
+                pass
+            session.stream = None
+
+        block = session.block
+        if session.slot is not None:
+            self._release_block(session.slot, block)
+            session.slot = None
+        elif block.impair_owner is session and block.impair:
+            log("Impairments cleared")
+            block.impair.clear()
+            block.impair_owner = None
+            self._tell_workers({"op": "impair", "base": block.base,
+                                "services": BLOCK_SERVICES, "spec": None})
+
+    # ---- REPLAY responders ----
+
+    def _handle_replay(self, session, proto, count):
+        """Handle REPLAY: the STEP lines that follow define a responder,
+        which listens on a port of its own once the last one arrives."""
+        if proto not in ("tcp", "udp") or not 0 <= count <= REPLAY_MAX_STEPS:
+            session.send("FAIL bad arguments\n")
+            return
+        session.replay = ReplayPeer(proto, count)
+        if count == 0:
+            self._replay_open(session)
+
+    def _handle_step(self, session, expect, answer):
+        peer = session.replay
+        if (peer is None or expect < 0 or not
+                0 <= answer <= (65507 if peer.proto == "udp"
+                                else LOAD_MAX_SIZE * 256)):
+            session.replay = None
+            session.send("FAIL bad step\n")
+            return
+        peer.steps.append((expect, answer))
+        if len(peer.steps) == peer.count:
+            self._replay_open(session)
+
+    def _replay_open(self, session):
+        peer = session.replay
+        session.replay = None
+        kind = socket.SOCK_STREAM if peer.proto == "tcp" else \
+            socket.SOCK_DGRAM
+        sock = socket.socket(socket.AF_INET, kind)
+        try:
+            sock.bind((self.bind_addr, 0))
+            if peer.proto == "tcp":
+                sock.listen(1)
+        except OSError as e:
+            sock.close()
+            log(f"Session {session.id}: REPLAY: {e}")
+            session.send("FAIL cannot listen\n")
+            return
+        sock.setblocking(False)
+        peer.sock = sock
+        session.replays.append(peer)
+        handler = self._replay_accept if peer.proto == "tcp" else \
+            self._replay_udp
+        self.sel.register(sock, selectors.EVENT_READ,
+                          functools.partial(handler, session, peer))
+        self._call_later(REPLAY_IDLE, self._replay_expire, session, peer)
+        port = sock.getsockname()[1]
+        log(f"Session {session.id}: REPLAY {peer.proto} responder with "
+            f"{peer.count} steps on port {port}", verbose_only=True)
+        session.send(f"PORT {port}\n")
+
+    def _replay_accept(self, session, peer, sock, mask):
+        try:
+            conn, _ = sock.accept()
+        except OSError:
+            return
+        # One connection per responder
+        self.sel.unregister(sock)
+        sock.close()
+        peer.sock = None
+        conn.setblocking(False)
+        peer.conn = conn
+        peer.last = time.monotonic()
+        # Answers owed before any request, e.g. a server greeting
+        peer.out = b"".join(peer.advance(0))
+        events = selectors.EVENT_READ
+        if peer.out:
+            events |= selectors.EVENT_WRITE
+        self.sel.register(conn, events,
+                          functools.partial(self._replay_io, session, peer))
+
+    def _replay_io(self, session, peer, sock, mask):
+        peer.last = time.monotonic()
+        if mask & selectors.EVENT_READ:
             try:
-                self.ctrl_conn.close()
+                data = sock.recv(65536)
+            except (BlockingIOError, InterruptedError):
+                data = None
             except OSError:
+                data = b""
+            if data == b"":
+                self._replay_close(session, peer)
+                return
+            if data:
+                peer.out += b"".join(peer.advance(len(data)))
+        if peer.out:
+            try:
+                sent = sock.send(peer.out)
+                peer.out = peer.out[sent:]
+            except (BlockingIOError, InterruptedError):
                 pass
-            self.ctrl_conn = None
-            self.amiga_ip = None
-            self.ctrl_buf = b""
+            except OSError:
+                self._replay_close(session, peer)
+                return
+        self.sel.modify(sock, selectors.EVENT_READ |
+                        (selectors.EVENT_WRITE if peer.out else 0),
+                        functools.partial(self._replay_io, session, peer))
+
+    def _replay_udp(self, session, peer, sock, mask):
+        try:
+            data, addr = sock.recvfrom(65536)
+        except OSError:
+            return
+        peer.last = time.monotonic()
+        peer.dest = addr
+        for answer in peer.advance(len(data)):
+            try:
+                sock.sendto(answer, peer.dest)
+            except OSError as e:
+                log(f"REPLAY sendto failed: {e}", verbose_only=True)
+
+    def _replay_expire(self, session, peer):
+        if peer not in session.replays:
+            return
+        idle = time.monotonic() - peer.last
+        if idle < REPLAY_IDLE:
+            self._call_later(REPLAY_IDLE - idle, self._replay_expire,
+                             session, peer)
+            return
+        log(f"Session {session.id}: REPLAY responder idle, closing",
+            verbose_only=True)
+        self._replay_close(session, peer)
+
+    def _replay_close(self, session, peer):
+        session.replays.remove(peer)
+        for sock in (peer.sock, peer.conn):
+            if sock is None:
+                continue
+            try:
+                self.sel.unregister(sock)
+            except (KeyError, ValueError):
+                pass
+            sock.close()
+        peer.sock = peer.conn = None
 
     # ---- TCP echo ----
 
-    def _accept_echo(self, sock, mask):
+    def _accept_echo(self, block, sock, mask):
         conn, addr = sock.accept()
         # Keep echo connections blocking — sendall() needs to block when
         # the TCP send buffer fills (Amiga sends all data before reading).
         log(f"Echo connection from {addr[0]}:{addr[1]}", verbose_only=True)
-        self.sel.register(conn, selectors.EVENT_READ, self._handle_echo)
+        self.sel.register(conn, selectors.EVENT_READ,
+                          functools.partial(self._handle_echo, block))
 
-    def _handle_echo(self, sock, mask):
+    def _handle_echo(self, block, sock, mask):
         try:
             data = sock.recv(8192)
         except OSError:
             data = b""
 
+        imp = block.impair.get("tcpecho")
+        pending = self._echo_pending.get(sock)
+        if imp or pending:
+            self._echo_impaired(block, sock, data, imp, pending)
+            return
+
         if not data:
             log("Echo connection closed", verbose_only=True)
             self.sel.unregister(sock)
@@ -246,9 +1627,59 @@ class Helper:
             self.sel.unregister(sock)
             sock.close()
 
+    def _echo_impaired(self, block, sock, data, imp, pending):
+        """Queue echoed data for delayed, rate-limited, in-order delivery."""
+        if pending is None:
+            pending = self._echo_pending[sock] = [0, False]
+        if not data:
+            # Peer done sending: close once the queued echo has gone out
+            self.sel.unregister(sock)
+            pending[1] = True
+            if not pending[0]:
+                self._echo_close(sock)
+            return
+
+        now = time.monotonic()
+        if imp:
+            when = imp.admit(len(data), now, in_order=True,
+                             stall=imp.stall())
+        else:
+            when = now      # impairment cleared while data was queued
+        pending[0] += len(data)
+        self._call_at(when, self._echo_send, block, sock, data)
+        if pending[0] > IMPAIR_TCP_QUEUE:
+            self.sel.unregister(sock)   # bottleneck queue full: backpressure
+
+    def _echo_send(self, block, sock, data):
+        pending = self._echo_pending.get(sock)
+        if pending is None:
+            return          # connection already torn down
+        try:
+            sock.sendall(data)
+        except OSError:
+            try:
+                self.sel.unregister(sock)
+            except (KeyError, ValueError):
+                pass        # already paused or closing
+            self._echo_close(sock)
+            return
+        paused = pending[0] > IMPAIR_TCP_QUEUE
+        pending[0] -= len(data)
+        if pending[1]:
+            if not pending[0]:
+                self._echo_close(sock)
+        elif paused and pending[0] <= IMPAIR_TCP_QUEUE:
+            self.sel.register(sock, selectors.EVENT_READ,
+                              functools.partial(self._handle_echo, block))
+
+    def _echo_close(self, sock):
+        self._echo_pending.pop(sock, None)
+        log("Echo connection closed", verbose_only=True)
+        sock.close()
+
     # ---- UDP echo ----
 
-    def _handle_udp_echo(self, sock, mask):
+    def _handle_udp_echo(self, block, sock, mask):
         try:
             data, addr = sock.recvfrom(65536)
         except OSError:
@@ -257,21 +1688,106 @@ class Helper:
         log(f"UDP echo: {len(data)} bytes from {addr[0]}:{addr[1]}",
             verbose_only=True)
 
+        imp = block.impair.get("udpecho")
+        if imp:
+            now = time.monotonic()
+            when = None if imp.lost() else \
+                imp.admit(len(data), now, queue_limit=IMPAIR_QUEUE_TIME)
+            if when is not None:
+                self._call_at(when, self._udp_echo_send,
+                                 sock, data, addr)
+            return
+
+        self._udp_echo_send(sock, data, addr)
+
+    def _udp_echo_send(self, sock, data, addr):
+        if sock.fileno() < 0:
+            return          # session's private block already closed
         try:
             sock.sendto(data, addr)
         except OSError as e:
             log(f"UDP echo sendto failed: {e}", verbose_only=True)
 
+    # ---- UDP timestamp ----
+
+    def _handle_udp_time(self, block, sock, mask):
+        try:
+            data, addr = sock.recvfrom(65536)
+        except OSError:
+            return
+        received = timestamp()
+
+        if len(data) < TS_REQUEST.size:
+            log(f"UDP time: short datagram ({len(data)} bytes) from "
+                f"{addr[0]}", verbose_only=True)
+            return
+
+        # Stamp the send time before any impairment: emulated delay is
+        # on the wire towards the Amiga, not inside the helper
+        reply = (data[:TS_REQUEST.size] +
+                 TS_STAMPS.pack(*received, *timestamp()))
+
+        imp = block.impair.get("udptime")
+        if imp:
+            now = time.monotonic()
+            when = None if imp.lost() else \
+                imp.admit(len(reply), now, queue_limit=IMPAIR_QUEUE_TIME)
+            if when is not None:
+                self._call_at(when, self._udp_echo_send, sock, reply, addr)
+            return
+
+        self._udp_echo_send(sock, reply, addr)
+
+    # ---- UDP sink ----
+
+    def _handle_udp_sink(self, block, sock, mask):
+        try:
+            data, addr = sock.recvfrom(65536)
+        except OSError:
+            return
+
+        if len(data) < SEQ_HEADER.size:
+            log(f"UDP sink: short datagram ({len(data)} bytes) from "
+                f"{addr[0]}", verbose_only=True)
+            return
+
+        imp = block.impair.get("udpsink")
+        if imp:
+            now = time.monotonic()
+            when = None if imp.lost() else \
+                imp.admit(len(data), now, queue_limit=IMPAIR_QUEUE_TIME)
+            if when is not None:
+                self._call_at(when, self._udp_sink_account,
+                                 block, data, addr)
+            return
+
+        self._udp_sink_account(block, data, addr)
+
+    def _udp_sink_account(self, block, data, addr):
+        seq, run_id = SEQ_HEADER.unpack_from(data)
+        key = (addr[0], run_id)
+        stats = block.udp_runs.get(key)
+        if stats is None:
+            # Bound the history: drop the oldest run from this host
+            runs = [k for k in block.udp_runs if k[0] == addr[0]]
+            if len(runs) >= SINK_MAX_RUNS:
+                del block.udp_runs[runs[0]]
+            stats = SeqStats(time.monotonic())
+            block.udp_runs[key] = stats
+            log(f"UDP sink: run {run_id} from {addr[0]}", verbose_only=True)
+        stats.add(seq, len(data), time.monotonic())
+
     # ---- TCP sink ----
 
-    def _accept_sink(self, sock, mask):
+    def _accept_sink(self, block, sock, mask):
         conn, addr = sock.accept()
         conn.setblocking(False)
         log(f"Sink connection from {addr[0]}:{addr[1]}", verbose_only=True)
         self._sink_totals[conn.fileno()] = 0
-        self.sel.register(conn, selectors.EVENT_READ, self._handle_sink)
+        self.sel.register(conn, selectors.EVENT_READ,
+                          functools.partial(self._handle_sink, block))
 
-    def _handle_sink(self, sock, mask):
+    def _handle_sink(self, block, sock, mask):
         try:
             data = sock.recv(65536)
         except OSError:
@@ -288,18 +1804,39 @@ class Helper:
 
         self._sink_totals[fd] = self._sink_totals.get(fd, 0) + len(data)
 
+        # Receive side: only the rate cap and loss stall apply.  The kernel
+        # acknowledges on our behalf, so delay cannot be emulated here;
+        # pausing reads lets the window close on the sender instead.
+        imp = block.impair.get("tcpsink")
+        if imp:
+            now = time.monotonic()
+            when = imp.admit(len(data), now, latency=False,
+                             stall=imp.stall())
+            if when > now:
+                self.sel.unregister(sock)
+                self._call_at(when, self._resume, sock,
+                                 selectors.EVENT_READ,
+                                 functools.partial(self._handle_sink, block))
+
     # ---- TCP source ----
 
-    def _accept_source(self, sock, mask):
+    def _accept_source(self, block, sock, mask):
         conn, addr = sock.accept()
         conn.setblocking(False)
         log(f"Source connection from {addr[0]}:{addr[1]}", verbose_only=True)
         pattern = fill_test_pattern(8192, 0xDEAD)
         self._source_state[conn.fileno()] = [0, pattern]
-        # Register for write readiness
-        self.sel.register(conn, selectors.EVENT_WRITE, self._handle_source)
+        # Register for write readiness (after the link delay, if impaired)
+        handler = functools.partial(self._handle_source, block)
+        imp = block.impair.get("tcpsource")
+        delay = imp.latency() if imp else 0.0
+        if delay > 0:
+            self._call_later(delay, self._resume, conn,
+                             selectors.EVENT_WRITE, handler)
+        else:
+            self.sel.register(conn, selectors.EVENT_WRITE, handler)
 
-    def _handle_source(self, sock, mask):
+    def _handle_source(self, block, sock, mask):
         fd = sock.fileno()
         state = self._source_state.get(fd)
         if not state:
@@ -316,11 +1853,41 @@ class Helper:
                 verbose_only=True)
             self.sel.unregister(sock)
             sock.close()
+            return
+
+        # Delay applies once, at connection start; after that the rate
+        # cap and loss stall pace the stream
+        imp = block.impair.get("tcpsource")
+        if imp:
+            now = time.monotonic()
+            when = imp.admit(n, now, latency=False, stall=imp.stall())
+            if when > now:
+                self.sel.unregister(sock)
+                self._call_at(when, self._resume, sock,
+                                 selectors.EVENT_WRITE,
+                                 functools.partial(self._handle_source,
+                                                   block))
+
+    def _resume(self, sock, events, callback):
+        """Re-register a socket paused by impairment, unless it closed."""
+        if sock.fileno() >= 0:
+            self.sel.register(sock, events, callback)
 
     # ---- Cleanup ----
 
     def _cleanup(self):
-        self._close_ctrl()
+        for session in list(self.sessions.values()):
+            self._close_session(session)
+        for s in list(self._connecting):
+            s.close()
+        if self.default_block:
+            self._close_block(self.default_block)
+        for w in self.workers:
+            w.chan.close()      # workers exit on EOF
+            try:
+                os.waitpid(w.pid, 0)
+            except OSError:
+                pass
         for sock in self.listeners:
             try:
                 self.sel.unregister(sock)
@@ -338,13 +1905,35 @@ def main():
                         help="Bind address (default: 0.0.0.0)")
     parser.add_argument("--ctrl-port", type=int, default=DEFAULT_CTRL_PORT,
                         help=f"Control channel port (default: {DEFAULT_CTRL_PORT})")
+    parser.add_argument("--max-sessions", type=int,
+                        default=DEFAULT_MAX_SESSIONS,
+                        help=f"Private service blocks for concurrent Amiga "
+                             f"clients (default: {DEFAULT_MAX_SESSIONS})")
+    parser.add_argument("--workers", type=int, default=0,
+                        help="Serve the shared data ports from N processes "
+                             "using SO_REUSEPORT (default: 0, single "
+                             "process)")
+    parser.add_argument("--log-dir", default=".",
+                        help="Directory for STREAM session logs "
+                             "(default: current directory)")
     parser.add_argument("-v", "--verbose", action="store_true",
                         help="Verbose logging")
     args = parser.parse_args()
 
+    if args.max_sessions < 0:
+        parser.error("--max-sessions must not be negative")
+    if args.workers < 0:
+        parser.error("--workers must not be negative")
+    if not os.path.isdir(args.log_dir):
+        parser.error(f"--log-dir {args.log_dir} is not a directory")
+    if args.workers and not (hasattr(os, "fork") and
+                             hasattr(socket, "SO_REUSEPORT")):
+        parser.error("--workers needs fork() and SO_REUSEPORT")
+
     log.verbose = args.verbose
 
-    helper = Helper(args.bind, args.ctrl_port)
+    helper = Helper(args.bind, args.ctrl_port, args.max_sessions,
+                    args.workers, args.log_dir)
     helper.start()
     helper.run()
 
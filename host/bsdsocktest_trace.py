@@ -0,0 +1,296 @@
+#!/usr/bin/env python3
+"""
+bsdsocktest_trace.py -- Decode a bsdsocktest call trace (TRACE <path>).
+
+bsdsocktest keeps its most recent socket calls in a ring and writes the
+ring to the trace file when a test fails, times out or Ctrl-D asks for
+it.  This prints each dump as a table: time since the dump's first call,
+the call with its scalar arguments, result, errno and duration.
+
+With --replay it writes a dump's connections instead as a script for the
+replay tests (REPLAY <script>): each connect, send, recv, timed-out
+WaitSelect() and CloseSocket() of a socket the dump saw created, at its
+recorded time and with its recorded duration.
+
+The format is described in src/trace.h; all fields are big-endian.
+
+Usage:
+  python3 bsdsocktest_trace.py [--test N] [--call NAME] [--errors] TRACE
+  python3 bsdsocktest_trace.py --replay [--test N] TRACE > script
+"""
+
+import argparse
+import errno
+import os
+import struct
+import sys
+
+MAGIC = b"BSTT"
+DUMP_MAGIC = b"DUMP"
+VERSION = 1
+
+# version, record size, call count, name bytes
+HEADER = struct.Struct(">HHHH")
+# reason, test, records, records lost
+DUMP = struct.Struct(">HHLL")
+# secs, micro, us, call, test, args[4], result, error
+RECORD = struct.Struct(">LLLHH4lll")
+
+REASONS = {1: "failed", 2: "timed out", 3: "requested"}
+
+# Replay scripts: connection numbers, socket types, EINPROGRESS
+REPLAY_SLOTS = 8
+SOCK_STREAM, SOCK_DGRAM = 1, 2
+EINPROGRESS = 36
+
+# Arguments trace.c keeps per call (profile.c passes them in this order)
+ARG_NAMES = {
+    "socket": ("domain", "type", "protocol"),
+    "bind": ("s", "namelen"),
+    "listen": ("s", "backlog"),
+    "accept": ("s",),
+    "connect": ("s", "namelen"),
+    "send": ("s", "len", "flags"),
+    "recv": ("s", "len", "flags"),
+    "sendto": ("s", "len", "flags", "tolen"),
+    "recvfrom": ("s", "len", "flags"),
+    "sendmsg": ("s", "flags"),
+    "recvmsg": ("s", "flags"),
+    "shutdown": ("s", "how"),
+    "setsockopt": ("s", "level", "optname", "optlen"),
+    "getsockopt": ("s", "level", "optname"),
+    "getsockname": ("s",),
+    "getpeername": ("s",),
+    "CloseSocket": ("s",),
+    "IoctlSocket": ("s", "request"),
+    "WaitSelect": ("nfds", "timeout_ms", "mask", "mask_out"),
+    "SetSocketSignals": ("intr", "io", "urg"),
+    "ObtainSocket": ("id", "domain", "type", "protocol"),
+    "ReleaseSocket": ("s", "id"),
+    "ReleaseCopyOfSocket": ("s", "id"),
+    "SetErrnoPtr": ("size",),
+    "Inet_NtoA": ("in",),
+    "Inet_LnaOf": ("in",),
+    "Inet_NetOf": ("in",),
+    "Inet_MakeAddr": ("net", "host"),
+    "gethostbyaddr": ("len", "type"),
+    "getnetbyaddr": ("net", "type"),
+    "getservbyport": ("port",),
+    "getprotobynumber": ("proto",),
+    "vsyslog": ("level",),
+    "Dup2Socket": ("old", "new"),
+    "gethostname": ("len",),
+    "SocketBaseTags": ("tag", "data", "tags"),
+    "GetSocketEvents": ("mask_out",),
+}
+
+# Shown in hex: masks, ioctl requests, tags, addresses
+HEX_ARGS = {"mask", "mask_out", "request", "tag", "data", "intr", "io",
+            "urg", "in", "net", "host"}
+
+# Calls returning a pointer: the trace keeps 1 (non-NULL) or 0
+POINTER_CALLS = {"Inet_NtoA", "gethostbyname", "gethostbyaddr",
+                 "getnetbyname", "getnetbyaddr", "getservbyname",
+                 "getservbyport", "getprotobyname", "getprotobynumber"}
+
+# Calls returning an address or value in full
+HEX_RESULTS = {"inet_addr", "inet_network", "Inet_LnaOf", "Inet_NetOf",
+               "Inet_MakeAddr", "gethostid"}
+
+
+class TraceError(Exception):
+    pass
+
+
+def read_exact(f, n, what):
+    data = f.read(n)
+    if len(data) != n:
+        raise TraceError("truncated %s" % what)
+    return data
+
+
+def read_header(f):
+    if f.read(4) != MAGIC:
+        raise TraceError("not a bsdsocktest trace")
+    version, size, count, name_bytes = HEADER.unpack(
+        read_exact(f, HEADER.size, "header"))
+    if version != VERSION:
+        raise TraceError("trace version %d, expected %d" % (version, VERSION))
+    if size != RECORD.size:
+        raise TraceError("record size %d, expected %d" % (size, RECORD.size))
+    names = read_exact(f, name_bytes, "call names").split(b"\0")[:count]
+    return [n.decode("ascii") for n in names]
+
+
+def read_dumps(f):
+    """Yield (reason, test, lost, records) for each dump in the file."""
+    while True:
+        magic = f.read(4)
+        if not magic:
+            return
+        if magic != DUMP_MAGIC:
+            raise TraceError("bad dump marker at offset %d" % (f.tell() - 4))
+        reason, test, count, lost = DUMP.unpack(
+            read_exact(f, DUMP.size, "dump header"))
+        data = read_exact(f, count * RECORD.size, "dump")
+        yield reason, test, lost, [r for r in RECORD.iter_unpack(data)]
+
+
+def errno_name(value):
+    # bsdsocket.library errno values are the BSD ones; the low values
+    # match Linux, the socket range does not, so only name the former
+    if 0 < value < 35:
+        return errno.errorcode.get(value, str(value))
+    return str(value)
+
+
+def format_call(name, args):
+    labels = ARG_NAMES.get(name, ())
+    parts = []
+    for label, value in zip(labels, args):
+        if label in HEX_ARGS:
+            parts.append("%s=0x%x" % (label, value & 0xFFFFFFFF))
+        else:
+            parts.append("%s=%d" % (label, value))
+    return "%s(%s)" % (name, ", ".join(parts))
+
+
+def format_result(name, result):
+    if name in POINTER_CALLS:
+        return "ptr" if result else "NULL"
+    if name in HEX_RESULTS:
+        return "0x%x" % (result & 0xFFFFFFFF)
+    return str(result)
+
+
+def print_dump(names, reason, test, lost, records, args):
+    print("== test %d (%s): %d calls%s" % (
+        test, REASONS.get(reason, "reason %d" % reason), len(records),
+        ", %d earlier calls lost" % lost if lost else ""))
+    if not records:
+        return
+    print("test    time (s) duration  call = result (errno)")
+    base = records[0][0] * 1000000 + records[0][1]
+    for secs, micro, us, call, rtest, a0, a1, a2, a3, result, error in records:
+        name = names[call] if call < len(names) else "call%d" % call
+        if args.call and name != args.call:
+            continue
+        if args.errors and not error:
+            continue
+        offset = secs * 1000000 + micro - base
+        line = "%4d %10.6f %8dus  %s = %s" % (
+            rtest, offset / 1e6, us, format_call(name, (a0, a1, a2, a3)),
+            format_result(name, result))
+        if error:
+            line += " (%s)" % errno_name(error)
+        print(line)
+
+
+def replay_script(names, test, records, out):
+    """Write the connections in one dump as a replay script."""
+    kinds = {}          # fd -> "tcp" or "udp", from socket()
+    slots = {}          # fd -> connection number
+    sent = {}           # fd -> bytes sent since connect
+    last = None         # connection of the latest send or recv
+    base = None
+    skipped = 0
+
+    def emit(rec, slot, op):
+        nonlocal base
+        start = rec[0] * 1000000 + rec[1]
+        if base is None:
+            base = start
+        out.write("%-9.3f %d %-16s %d\n" % (
+            (start - base) / 1000.0, slot, op, rec[2]))
+
+    def open_slot(rec, fd):
+        nonlocal skipped
+        free = set(range(1, REPLAY_SLOTS + 1)) - set(slots.values())
+        if not free:
+            skipped += 1
+            return None
+        slots[fd] = min(free)
+        sent[fd] = 0
+        emit(rec, slots[fd], "connect " + kinds[fd])
+        return slots[fd]
+
+    out.write("# bsdsocktest replay script: test %d, %d calls\n" % (
+        test, len(records)))
+    out.write("# <ms> <conn> <operation> [<argument>] [<recorded us>]\n")
+    for rec in records:
+        name = names[rec[3]] if rec[3] < len(names) else ""
+        fd, result, error = rec[5], rec[9], rec[10]
+        if name == "socket" and result >= 0 and not error:
+            if rec[6] in (SOCK_STREAM, SOCK_DGRAM):
+                kinds[result] = "tcp" if rec[6] == SOCK_STREAM else "udp"
+        elif name == "connect" and fd in kinds and fd not in slots:
+            if not error or error == EINPROGRESS:
+                last = open_slot(rec, fd) and fd
+        elif name in ("send", "sendto") and result > 0 and fd in kinds:
+            # An unconnected UDP socket starts its connection here
+            if fd not in slots and (kinds[fd] != "udp" or
+                                    not open_slot(rec, fd)):
+                continue
+            sent[fd] += result
+            emit(rec, slots[fd], "send %d" % result)
+            last = fd
+        elif name in ("recv", "recvfrom") and result > 0 and fd in slots:
+            # A UDP remote end can only answer once it has heard from us
+            if kinds[fd] == "udp" and not sent[fd]:
+                continue
+            emit(rec, slots[fd], "recv %d" % result)
+            last = fd
+        elif name == "WaitSelect" and result == 0 and rec[6] > 0:
+            if last in slots:
+                emit(rec, slots[last], "wait %d" % rec[6])
+        elif name == "CloseSocket" and fd in kinds:
+            if fd in slots:
+                emit(rec, slots.pop(fd), "close")
+            del kinds[fd]
+            if last == fd:
+                last = None
+    if base is None:
+        out.write("# no connections in this dump\n")
+    if skipped:
+        print("%d connections beyond %d at once left out" % (
+            skipped, REPLAY_SLOTS), file=sys.stderr)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Decode a bsdsocktest call trace (TRACE <path>)")
+    parser.add_argument("trace", help="trace file written by bsdsocktest")
+    parser.add_argument("--test", type=int, default=None,
+                        help="only dumps taken for this test number")
+    parser.add_argument("--call", default=None,
+                        help="only this call (e.g. WaitSelect)")
+    parser.add_argument("--errors", action="store_true",
+                        help="only calls that failed")
+    parser.add_argument("--replay", action="store_true",
+                        help="write the first (selected) dump as a replay "
+                        "script")
+    args = parser.parse_args()
+
+    try:
+        with open(args.trace, "rb") as f:
+            names = read_header(f)
+            dumps = 0
+            for reason, test, lost, records in read_dumps(f):
+                if args.test is not None and test != args.test:
+                    continue
+                if args.replay:
+                    replay_script(names, test, records, sys.stdout)
+                    return
+                if dumps:
+                    print()
+                print_dump(names, reason, test, lost, records, args)
+                dumps += 1
+    except (OSError, TraceError) as e:
+        print("%s: %s" % (os.path.basename(sys.argv[0]), e), file=sys.stderr)
+        sys.exit(1)
+    if dumps == 0:
+        print("no dumps in %s" % args.trace)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,2345 @@
+/*
+ * bsdsocktest — POSIX host compatibility layer
+ *
+ * Just enough of exec, dos, timer.device and bsdsocket.library to run
+ * the suite natively on Linux against the host TCP/IP stack. This is a
+ * development aid for the test logic and the host helper, not a stack
+ * under test: semantics follow AmiTCP where the suite depends on them
+ * (per-opener descriptor tables, errno pointers, WaitSelect signal
+ * masks, SO_EVENTMASK) and the host wherever it does not matter.
+ */
+
+#define _GNU_SOURCE
+#define BST_COMPAT_IMPL
+
+#include <exec/types.h>
+#include <proto/exec.h>
+#include <proto/dos.h>
+#include <dos/dostags.h>
+#include <proto/icon.h>
+#include <proto/timer.h>
+#include <proto/bsdsocket.h>
+#include <sys/filio.h>
+
+#include "faults.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <malloc.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+/* ---- exec: tasks and signals ---- */
+
+#define NT_MESSAGE  5
+#define NT_REPLYMSG 7
+
+/* Bits 0-15 belong to the system, as on AmigaOS */
+#define SYSTEM_SIGS 0x0000FFFFUL
+
+struct host_task {
+    struct Task task;
+    int wake[2];        /* self-pipe: Signal() writes, waiters poll */
+    pid_t pid;          /* SystemTags() child, else 0 */
+};
+
+static __thread struct Task *cur_task;
+static struct Task *main_task;
+
+static struct Task *task_create(const char *name)
+{
+    struct host_task *ht;
+
+    ht = (struct host_task *)calloc(1, sizeof(*ht));
+    if (!ht)
+        abort();
+    if (pipe2(ht->wake, O_NONBLOCK | O_CLOEXEC) < 0)
+        abort();
+    ht->task.tc_Node.ln_Name = (char *)name;
+    ht->task.tc_SigAlloc = SYSTEM_SIGS;
+    ht->task.tc_Private = ht;
+    return &ht->task;
+}
+
+static int task_wake_fd(struct Task *task)
+{
+    return ((struct host_task *)task->tc_Private)->wake[0];
+}
+
+static void task_drain(struct Task *task)
+{
+    char buf[64];
+
+    while (read(task_wake_fd(task), buf, sizeof(buf)) > 0)
+        ;
+}
+
+static struct Task *proc_find(const char *name);
+
+struct Task *FindTask(CONST_STRPTR name)
+{
+    if (name)
+        return proc_find((const char *)name);
+    if (!cur_task)
+        cur_task = task_create("bsdsocktest");
+    return cur_task;
+}
+
+void Signal(struct Task *task, ULONG signals)
+{
+    struct host_task *ht = (struct host_task *)task->tc_Private;
+    char c = 0;
+    ssize_t rc;
+
+    if (ht->pid) {
+        /* A worker process: only Ctrl-C reaches it */
+        if (signals & SIGBREAKF_CTRL_C)
+            kill(ht->pid, SIGINT);
+        return;
+    }
+    __atomic_fetch_or(&task->tc_SigRecvd, signals, __ATOMIC_SEQ_CST);
+    rc = write(ht->wake[1], &c, 1);
+    (void)rc;
+}
+
+ULONG SetSignal(ULONG new_signals, ULONG signal_mask)
+{
+    struct Task *task = FindTask(NULL);
+    ULONG old, upd;
+
+    old = __atomic_load_n(&task->tc_SigRecvd, __ATOMIC_SEQ_CST);
+    do {
+        upd = (old & ~signal_mask) | (new_signals & signal_mask);
+    } while (!__atomic_compare_exchange_n(&task->tc_SigRecvd, &old, upd, 0,
+                                          __ATOMIC_SEQ_CST,
+                                          __ATOMIC_SEQ_CST));
+    return old;
+}
+
+/* Atomically take the given signals from the current task. */
+static ULONG take_signals(struct Task *task, ULONG mask)
+{
+    ULONG got;
+
+    got = __atomic_fetch_and(&task->tc_SigRecvd, ~mask, __ATOMIC_SEQ_CST);
+    return got & mask;
+}
+
+ULONG Wait(ULONG signal_set)
+{
+    struct Task *task = FindTask(NULL);
+    struct pollfd pfd;
+    ULONG got;
+
+    for (;;) {
+        got = take_signals(task, signal_set);
+        if (got)
+            return got;
+        pfd.fd = task_wake_fd(task);
+        pfd.events = POLLIN;
+        poll(&pfd, 1, -1);
+        task_drain(task);
+    }
+}
+
+BYTE AllocSignal(LONG signal_num)
+{
+    struct Task *task = FindTask(NULL);
+    int bit;
+
+    if (signal_num >= 0) {
+        if (task->tc_SigAlloc & (1UL << signal_num))
+            return -1;
+        bit = (int)signal_num;
+    } else {
+        for (bit = 31; bit >= 16; bit--)
+            if (!(task->tc_SigAlloc & (1UL << bit)))
+                break;
+        if (bit < 16)
+            return -1;
+    }
+    task->tc_SigAlloc |= 1UL << bit;
+    SetSignal(0, 1UL << bit);
+    return (BYTE)bit;
+}
+
+void FreeSignal(LONG signal_num)
+{
+    struct Task *task = FindTask(NULL);
+
+    if (signal_num >= 16 && signal_num < 32)
+        task->tc_SigAlloc &= ~(1UL << signal_num);
+}
+
+/* ---- exec: memory and arbitration ---- */
+
+APTR AllocMem(ULONG size, ULONG attributes)
+{
+    if (attributes & MEMF_CLEAR)
+        return calloc(1, size);
+    return malloc(size);
+}
+
+void FreeMem(APTR memory, ULONG size)
+{
+    (void)size;
+    free(memory);
+}
+
+APTR AllocVec(ULONG size, ULONG attributes)
+{
+    return AllocMem(size, attributes);
+}
+
+void FreeVec(APTR memory)
+{
+    free(memory);
+}
+
+/* Report a notional 256 MB pool minus what the process has allocated,
+ * so that leaks show up as a drop in AvailMem() just like on a real
+ * machine. */
+ULONG AvailMem(ULONG attributes)
+{
+    struct mallinfo2 mi = mallinfo2();
+    ULONG pool = 256UL * 1024 * 1024;
+
+    if (attributes & MEMF_TOTAL)
+        return pool;
+    if ((ULONG)mi.uordblks >= pool)
+        return 0;
+    return pool - (ULONG)mi.uordblks;
+}
+
+static pthread_mutex_t forbid_lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+void Forbid(void)
+{
+    pthread_mutex_lock(&forbid_lock);
+}
+
+void Permit(void)
+{
+    pthread_mutex_unlock(&forbid_lock);
+}
+
+/* ---- exec: message ports ---- */
+
+static pthread_mutex_t port_lock = PTHREAD_MUTEX_INITIALIZER;
+
+struct MsgPort *CreateMsgPort(void)
+{
+    struct MsgPort *port;
+    BYTE sig;
+
+    sig = AllocSignal(-1);
+    if (sig < 0)
+        return NULL;
+    port = (struct MsgPort *)calloc(1, sizeof(*port));
+    if (!port) {
+        FreeSignal(sig);
+        return NULL;
+    }
+    port->mp_Flags = PA_SIGNAL;
+    port->mp_SigBit = (UBYTE)sig;
+    port->mp_SigTask = FindTask(NULL);
+    return port;
+}
+
+void DeleteMsgPort(struct MsgPort *port)
+{
+    if (!port)
+        return;
+    FreeSignal(port->mp_SigBit);
+    free(port);
+}
+
+/* Unlink a message from its port. Caller holds port_lock. */
+static void port_remove(struct MsgPort *port, struct Message *msg)
+{
+    struct Node **pp = &port->mp_MsgList.mlh_Head;
+
+    while (*pp) {
+        if (*pp == &msg->mn_Node) {
+            *pp = msg->mn_Node.ln_Succ;
+            if (port->mp_MsgList.mlh_TailPred == &msg->mn_Node) {
+                struct Node *n = port->mp_MsgList.mlh_Head;
+                while (n && n->ln_Succ)
+                    n = n->ln_Succ;
+                port->mp_MsgList.mlh_TailPred = n;
+            }
+            msg->mn_Node.ln_Succ = NULL;
+            return;
+        }
+        pp = &(*pp)->ln_Succ;
+    }
+}
+
+void PutMsg(struct MsgPort *port, struct Message *message)
+{
+    pthread_mutex_lock(&port_lock);
+    message->mn_Node.ln_Succ = NULL;
+    if (port->mp_MsgList.mlh_TailPred)
+        port->mp_MsgList.mlh_TailPred->ln_Succ = &message->mn_Node;
+    else
+        port->mp_MsgList.mlh_Head = &message->mn_Node;
+    port->mp_MsgList.mlh_TailPred = &message->mn_Node;
+    pthread_mutex_unlock(&port_lock);
+
+    if (port->mp_Flags == PA_SIGNAL && port->mp_SigTask)
+        Signal(port->mp_SigTask, 1UL << port->mp_SigBit);
+}
+
+struct Message *GetMsg(struct MsgPort *port)
+{
+    struct Message *msg;
+
+    pthread_mutex_lock(&port_lock);
+    msg = (struct Message *)port->mp_MsgList.mlh_Head;
+    if (msg)
+        port_remove(port, msg);
+    pthread_mutex_unlock(&port_lock);
+    return msg;
+}
+
+void ReplyMsg(struct Message *message)
+{
+    message->mn_Node.ln_Type = NT_REPLYMSG;
+    if (message->mn_ReplyPort)
+        PutMsg(message->mn_ReplyPort, message);
+}
+
+struct Message *WaitPort(struct MsgPort *port)
+{
+    while (!port->mp_MsgList.mlh_Head)
+        Wait(1UL << port->mp_SigBit);
+    return (struct Message *)port->mp_MsgList.mlh_Head;
+}
+
+/* ---- exec: I/O requests and timer.device ---- */
+
+static struct Device timer_device;
+
+struct timer_pending {
+    struct timerequest *tr;
+    struct timespec due;
+    int aborted;
+    struct timer_pending *next;
+};
+
+static pthread_mutex_t timer_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t timer_cond;
+static struct timer_pending *timer_queue;
+static struct timer_pending *timer_free;     /* recycled entries */
+static int timer_thread_started;
+
+APTR CreateIORequest(struct MsgPort *port, ULONG size)
+{
+    struct IORequest *io;
+
+    if (!port)
+        return NULL;
+    io = (struct IORequest *)calloc(1, size);
+    if (!io)
+        return NULL;
+    io->io_Message.mn_ReplyPort = port;
+    io->io_Message.mn_Length = (UWORD)size;
+    return io;
+}
+
+void DeleteIORequest(APTR iorequest)
+{
+    free(iorequest);
+}
+
+BYTE OpenDevice(CONST_STRPTR dev_name, ULONG unit,
+                struct IORequest *iorequest, ULONG flags)
+{
+    (void)unit;
+    (void)flags;
+    if (strcmp((const char *)dev_name, TIMERNAME) != 0) {
+        iorequest->io_Error = -1;
+        return -1;
+    }
+    iorequest->io_Device = &timer_device;
+    iorequest->io_Error = 0;
+    return 0;
+}
+
+void CloseDevice(struct IORequest *iorequest)
+{
+    iorequest->io_Device = NULL;
+}
+
+static void timespec_now(struct timespec *ts)
+{
+    clock_gettime(CLOCK_MONOTONIC, ts);
+}
+
+static int timespec_before(const struct timespec *a, const struct timespec *b)
+{
+    if (a->tv_sec != b->tv_sec)
+        return a->tv_sec < b->tv_sec;
+    return a->tv_nsec < b->tv_nsec;
+}
+
+static void *timer_thread(void *arg)
+{
+    struct timer_pending **pp, *p, *done;
+    struct timespec now, next;
+    int have_next;
+
+    (void)arg;
+    pthread_mutex_lock(&timer_lock);
+    for (;;) {
+        timespec_now(&now);
+        done = NULL;
+        have_next = 0;
+        pp = &timer_queue;
+        while ((p = *pp) != NULL) {
+            if (p->aborted || !timespec_before(&now, &p->due)) {
+                *pp = p->next;
+                p->next = done;
+                done = p;
+                continue;
+            }
+            if (!have_next || timespec_before(&p->due, &next)) {
+                next = p->due;
+                have_next = 1;
+            }
+            pp = &p->next;
+        }
+
+        if (done) {
+            pthread_mutex_unlock(&timer_lock);
+            while (done) {
+                struct timerequest *tr;
+
+                /* Recycled, not freed: memory freed on this thread
+                 * stays in its cache and would read as a leak in
+                 * AvailMem() (LEAKCHECK) */
+                p = done;
+                done = p->next;
+                tr = p->tr;
+                tr->tr_node.io_Error = p->aborted ? -2 : 0;
+                pthread_mutex_lock(&timer_lock);
+                p->next = timer_free;
+                timer_free = p;
+                pthread_mutex_unlock(&timer_lock);
+                ReplyMsg(&tr->tr_node.io_Message);
+            }
+            pthread_mutex_lock(&timer_lock);
+            continue;
+        }
+
+        if (have_next)
+            pthread_cond_timedwait(&timer_cond, &timer_lock, &next);
+        else
+            pthread_cond_wait(&timer_cond, &timer_lock);
+    }
+    return NULL;
+}
+
+static void timer_start_thread(void)
+{
+    pthread_condattr_t attr;
+    pthread_t tid;
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&timer_cond, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_create(&tid, NULL, timer_thread, NULL);
+    pthread_detach(tid);
+    timer_thread_started = 1;
+}
+
+void SendIO(struct IORequest *iorequest)
+{
+    struct timerequest *tr = (struct timerequest *)iorequest;
+    struct timer_pending *p;
+
+    iorequest->io_Flags &= ~IOF_QUICK;
+    iorequest->io_Error = 0;
+    iorequest->io_Message.mn_Node.ln_Type = NT_MESSAGE;
+
+    if (iorequest->io_Device != &timer_device ||
+        iorequest->io_Command != TR_ADDREQUEST) {
+        if (iorequest->io_Command == TR_GETSYSTIME)
+            GetSysTime(&tr->tr_time);
+        else
+            iorequest->io_Error = -3;   /* IOERR_NOCMD */
+        ReplyMsg(&iorequest->io_Message);
+        return;
+    }
+
+    pthread_mutex_lock(&timer_lock);
+    p = timer_free;
+    if (p)
+        timer_free = p->next;
+    pthread_mutex_unlock(&timer_lock);
+    if (p)
+        memset(p, 0, sizeof(*p));
+    else
+        p = (struct timer_pending *)calloc(1, sizeof(*p));
+    if (!p)
+        abort();
+    p->tr = tr;
+    timespec_now(&p->due);
+    p->due.tv_sec += tr->tr_time.tv_sec;
+    p->due.tv_nsec += tr->tr_time.tv_usec * 1000L;
+    while (p->due.tv_nsec >= 1000000000L) {
+        p->due.tv_sec++;
+        p->due.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&timer_lock);
+    if (!timer_thread_started)
+        timer_start_thread();
+    p->next = timer_queue;
+    timer_queue = p;
+    pthread_cond_signal(&timer_cond);
+    pthread_mutex_unlock(&timer_lock);
+}
+
+struct IORequest *CheckIO(struct IORequest *iorequest)
+{
+    if (iorequest->io_Message.mn_Node.ln_Type == NT_MESSAGE)
+        return NULL;
+    return iorequest;
+}
+
+BYTE WaitIO(struct IORequest *iorequest)
+{
+    struct MsgPort *port = iorequest->io_Message.mn_ReplyPort;
+
+    while (iorequest->io_Message.mn_Node.ln_Type == NT_MESSAGE)
+        Wait(1UL << port->mp_SigBit);
+
+    pthread_mutex_lock(&port_lock);
+    port_remove(port, &iorequest->io_Message);
+    pthread_mutex_unlock(&port_lock);
+    return iorequest->io_Error;
+}
+
+BYTE DoIO(struct IORequest *iorequest)
+{
+    SendIO(iorequest);
+    return WaitIO(iorequest);
+}
+
+void AbortIO(struct IORequest *iorequest)
+{
+    struct timer_pending *p;
+
+    pthread_mutex_lock(&timer_lock);
+    for (p = timer_queue; p; p = p->next) {
+        if (&p->tr->tr_node == iorequest) {
+            p->aborted = 1;
+            pthread_cond_signal(&timer_cond);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&timer_lock);
+}
+
+/* The suite only takes differences of system time (timer_now()), so
+ * the monotonic clock serves: a wall clock step cannot skew a
+ * benchmark. */
+void GetSysTime(struct timeval *dest)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    dest->tv_sec = ts.tv_sec;
+    dest->tv_usec = ts.tv_nsec / 1000;
+}
+
+/* ---- exec: libraries ---- */
+
+struct bsd_base;
+static struct Library *bsd_open(void);
+static void bsd_close(struct Library *lib);
+
+static struct Library misc_library;
+
+struct Library *OpenLibrary(CONST_STRPTR name, ULONG version)
+{
+    const char *n = (const char *)name;
+
+    (void)version;
+    if (strcmp(n, "bsdsocket.library") == 0)
+        return bsd_open();
+    if (strcmp(n, "icon.library") == 0 || strcmp(n, "dos.library") == 0 ||
+        strcmp(n, "utility.library") == 0) {
+        misc_library.lib_Version = 40;
+        return &misc_library;
+    }
+    return NULL;
+}
+
+void CloseLibrary(struct Library *library)
+{
+    if (!library || library == &misc_library)
+        return;
+    bsd_close(library);
+}
+
+/* ---- dos.library ---- */
+
+static int saved_argc;
+static char **saved_argv;
+
+static struct FileHandle fh_stdin = { NULL, NULL, NULL, 0 };
+static struct FileHandle fh_stdout = { NULL, NULL, NULL, 1 };
+
+/* SIGINT is Ctrl-C; SIGQUIT (Ctrl-\) stands in for Ctrl-D */
+static void break_handler(int sig)
+{
+    if (main_task)
+        Signal(main_task, sig == SIGQUIT ? SIGBREAKF_CTRL_D
+                                         : SIGBREAKF_CTRL_C);
+}
+
+/* Runs before main(): glibc passes the process arguments to ELF
+ * constructors, which is where ReadArgs() picks up the command line. */
+__attribute__((constructor))
+static void compat_init(int argc, char **argv, char **envp)
+{
+    struct sigaction sa;
+
+    (void)envp;
+    saved_argc = argc;
+    saved_argv = argv;
+
+    main_task = FindTask(NULL);
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = break_handler;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);   /* no SA_RESTART: like a break signal */
+    sigaction(SIGQUIT, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    faults_init();
+}
+
+/* Argument storage hung off RDA_DAList, released by FreeArgs() */
+struct rda_store {
+    int owned;          /* RDArgs allocated by ReadArgs() itself */
+    int count;
+    char *strings[64];
+    LONG numbers[32];
+    int num_count;
+};
+
+struct tmpl_item {
+    char names[4][32];
+    int name_count;
+    int is_switch, is_key, is_num, is_req;
+};
+
+static int parse_template(const char *tmpl, struct tmpl_item *items, int max)
+{
+    int n = 0;
+    const char *p = tmpl;
+
+    while (*p && n < max) {
+        struct tmpl_item *it = &items[n];
+        char field[128];
+        int len = 0;
+        char *tok, *slash;
+
+        memset(it, 0, sizeof(*it));
+        while (*p && *p != ',' && len < (int)sizeof(field) - 1)
+            field[len++] = *p++;
+        field[len] = '\0';
+        if (*p == ',')
+            p++;
+
+        slash = strchr(field, '/');
+        if (slash) {
+            char *m;
+            for (m = slash; *m; m++) {
+                if (*m != '/')
+                    continue;
+                switch (m[1] | 0x20) {
+                case 's': it->is_switch = 1; break;
+                case 'k': it->is_key = 1; break;
+                case 'n': it->is_num = 1; break;
+                case 'a': it->is_req = 1; break;
+                default: break;
+                }
+            }
+            *slash = '\0';
+        }
+
+        tok = strtok(field, "=");
+        while (tok && it->name_count < 4) {
+            strncpy(it->names[it->name_count], tok, 31);
+            it->names[it->name_count][31] = '\0';
+            it->name_count++;
+            tok = strtok(NULL, "=");
+        }
+        n++;
+    }
+    return n;
+}
+
+static int match_item(const struct tmpl_item *items, int n, const char *word,
+                      int wlen)
+{
+    int i, j;
+
+    for (i = 0; i < n; i++)
+        for (j = 0; j < items[i].name_count; j++)
+            if ((int)strlen(items[i].names[j]) == wlen &&
+                strncasecmp(items[i].names[j], word, wlen) == 0)
+                return i;
+    return -1;
+}
+
+/* Split a CSource buffer into words, honouring double quotes. */
+static int split_source(const char *buf, int len, char **words, int max)
+{
+    int n = 0, i = 0;
+
+    while (i < len && n < max) {
+        char word[256];
+        int wl = 0;
+
+        while (i < len && (buf[i] == ' ' || buf[i] == '\t'))
+            i++;
+        if (i >= len || buf[i] == '\n' || buf[i] == '\0')
+            break;
+        if (buf[i] == '"') {
+            i++;
+            while (i < len && buf[i] != '"' && wl < 255)
+                word[wl++] = buf[i++];
+            if (i < len)
+                i++;
+        } else {
+            while (i < len && buf[i] != ' ' && buf[i] != '\t' &&
+                   buf[i] != '\n' && wl < 255)
+                word[wl++] = buf[i++];
+        }
+        word[wl] = '\0';
+        words[n++] = strdup(word);
+    }
+    return n;
+}
+
+static int store_value(struct rda_store *st, const struct tmpl_item *it,
+                       LONG *slot, const char *value)
+{
+    char *copy, *end;
+    long v;
+
+    if (st->count >= 64)
+        return 0;
+    copy = strdup(value);
+    st->strings[st->count++] = copy;
+    if (it->is_num) {
+        v = strtol(copy, &end, 10);
+        if (*copy == '\0' || *end != '\0' || st->num_count >= 32)
+            return 0;
+        st->numbers[st->num_count] = v;
+        *slot = (LONG)&st->numbers[st->num_count];
+        st->num_count++;
+    } else {
+        *slot = (LONG)copy;
+    }
+    return 1;
+}
+
+struct RDArgs *ReadArgs(CONST_STRPTR arg_template, LONG *array,
+                        struct RDArgs *args)
+{
+    struct tmpl_item items[32];
+    struct rda_store *st;
+    char *words[64];
+    int nwords = 0, nitems, i, ok = 1;
+    int filled[32];
+
+    nitems = parse_template((const char *)arg_template, items, 32);
+    memset(filled, 0, sizeof(filled));
+
+    if (args && args->RDA_Source.CS_Buffer) {
+        nwords = split_source((const char *)args->RDA_Source.CS_Buffer,
+                              (int)args->RDA_Source.CS_Length, words, 64);
+    } else {
+        for (i = 1; i < saved_argc && nwords < 64; i++)
+            words[nwords++] = strdup(saved_argv[i]);
+    }
+
+    st = (struct rda_store *)calloc(1, sizeof(*st));
+    if (!args) {
+        args = (struct RDArgs *)calloc(1, sizeof(*args));
+        st->owned = 1;
+    }
+    args->RDA_DAList = st;
+
+    for (i = 0; i < nwords && ok; i++) {
+        char *eq = strchr(words[i], '=');
+        int wl = eq ? (int)(eq - words[i]) : (int)strlen(words[i]);
+        int idx = match_item(items, nitems, words[i], wl);
+
+        if (idx >= 0) {
+            if (items[idx].is_switch) {
+                array[idx] = DOSTRUE;
+            } else if (eq) {
+                ok = store_value(st, &items[idx], &array[idx], eq + 1);
+            } else if (i + 1 < nwords) {
+                i++;
+                ok = store_value(st, &items[idx], &array[idx], words[i]);
+            } else {
+                ok = 0;
+            }
+            filled[idx] = 1;
+            continue;
+        }
+
+        /* Positional: first unfilled non-switch, non-keyword item */
+        for (idx = 0; idx < nitems; idx++)
+            if (!filled[idx] && !items[idx].is_switch && !items[idx].is_key)
+                break;
+        if (idx >= nitems) {
+            ok = 0;
+            break;
+        }
+        ok = store_value(st, &items[idx], &array[idx], words[i]);
+        filled[idx] = 1;
+    }
+
+    for (i = 0; i < nitems && ok; i++)
+        if (items[i].is_req && !filled[i])
+            ok = 0;
+
+    for (i = 0; i < nwords; i++)
+        free(words[i]);
+
+    if (!ok) {
+        FreeArgs(args);
+        return NULL;
+    }
+    return args;
+}
+
+void FreeArgs(struct RDArgs *args)
+{
+    struct rda_store *st;
+    int i;
+
+    if (!args)
+        return;
+    st = (struct rda_store *)args->RDA_DAList;
+    args->RDA_DAList = NULL;
+    if (!st)
+        return;
+    for (i = 0; i < st->count; i++)
+        free(st->strings[i]);
+    if (st->owned)
+        free(args);
+    free(st);
+}
+
+BPTR Input(void)
+{
+    return MKBADDR(&fh_stdin);
+}
+
+BPTR Output(void)
+{
+    return MKBADDR(&fh_stdout);
+}
+
+LONG IsInteractive(BPTR file)
+{
+    struct FileHandle *fh = (struct FileHandle *)BADDR(file);
+
+    return fh && isatty((int)fh->fh_Args) ? DOSTRUE : DOSFALSE;
+}
+
+LONG SetMode(BPTR fh, LONG mode)
+{
+    static struct termios saved;
+    static int raw;
+    struct FileHandle *f = (struct FileHandle *)BADDR(fh);
+    struct termios t;
+    int fd = (int)f->fh_Args;
+
+    if (mode && !raw && tcgetattr(fd, &saved) == 0) {
+        t = saved;
+        t.c_lflag &= ~(ICANON | ECHO | ISIG);
+        t.c_cc[VMIN] = 1;
+        t.c_cc[VTIME] = 0;
+        tcsetattr(fd, TCSANOW, &t);
+        raw = 1;
+    } else if (!mode && raw) {
+        tcsetattr(fd, TCSANOW, &saved);
+        raw = 0;
+    }
+    return DOSTRUE;
+}
+
+LONG Read(BPTR file, APTR buffer, LONG length)
+{
+    struct FileHandle *fh = (struct FileHandle *)BADDR(file);
+
+    return (LONG)read((int)fh->fh_Args, buffer, (size_t)length);
+}
+
+LONG DoPkt(struct MsgPort *port, LONG action, LONG arg1, LONG arg2,
+           LONG arg3, LONG arg4, LONG arg5)
+{
+    (void)port; (void)action; (void)arg1; (void)arg2;
+    (void)arg3; (void)arg4; (void)arg5;
+    return DOSFALSE;
+}
+
+BPTR CurrentDir(BPTR lock)
+{
+    (void)lock;
+    return 0;
+}
+
+void Delay(LONG ticks)
+{
+    usleep((useconds_t)ticks * 20000);
+}
+
+/* ---- dos.library: files and processes ---- */
+
+/* A "segment" is just the resolved path of the executable to run */
+static void resolve_path(const char *name, char *out, size_t len)
+{
+    char self[1024];
+    char *slash;
+    ssize_t n;
+
+    if (strncasecmp(name, "PROGDIR:", 8) == 0) {
+        n = readlink("/proc/self/exe", self, sizeof(self) - 1);
+        self[n > 0 ? n : 0] = '\0';
+        slash = strrchr(self, '/');
+        if (slash)
+            slash[1] = '\0';
+        snprintf(out, len, "%s%s", self, name + 8);
+    } else if (strcasecmp(name, "NIL:") == 0) {
+        snprintf(out, len, "/dev/null");
+    } else if (strncasecmp(name, "T:", 2) == 0) {
+        snprintf(out, len, "/tmp/%s", name + 2);
+    } else {
+        snprintf(out, len, "%s", name);
+    }
+}
+
+BPTR Open(CONST_STRPTR name, LONG mode)
+{
+    struct FileHandle *fh;
+    char path[1024];
+    int fd;
+
+    resolve_path((const char *)name, path, sizeof(path));
+    if (mode == MODE_NEWFILE)
+        fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    else
+        fd = open(path, O_RDWR | O_CLOEXEC);
+    if (fd < 0)
+        return 0;
+    fh = (struct FileHandle *)calloc(1, sizeof(*fh));
+    fh->fh_Args = fd;
+    return MKBADDR(fh);
+}
+
+LONG Close(BPTR file)
+{
+    struct FileHandle *fh = (struct FileHandle *)BADDR(file);
+
+    if (!fh || fh == &fh_stdin || fh == &fh_stdout)
+        return DOSTRUE;
+    close((int)fh->fh_Args);
+    free(fh);
+    return DOSTRUE;
+}
+
+LONG DeleteFile(CONST_STRPTR name)
+{
+    char path[1024];
+
+    resolve_path((const char *)name, path, sizeof(path));
+    return unlink(path) == 0 ? DOSTRUE : DOSFALSE;
+}
+
+BOOL GetProgramName(STRPTR buf, LONG len)
+{
+    if (!saved_argv || !saved_argv[0])
+        return DOSFALSE;
+    snprintf((char *)buf, (size_t)len, "%s", saved_argv[0]);
+    return DOSTRUE;
+}
+
+STRPTR FilePart(CONST_STRPTR path)
+{
+    const char *p = (const char *)path;
+    const char *q;
+
+    for (q = p; *q; q++) {
+        if (*q == '/' || *q == ':')
+            p = q + 1;
+    }
+    return (STRPTR)p;
+}
+
+BOOL AddPart(STRPTR dirname, CONST_STRPTR filename, ULONG size)
+{
+    size_t n = strlen((char *)dirname);
+
+    if (n && dirname[n - 1] != '/' && dirname[n - 1] != ':') {
+        if (n + 1 >= size)
+            return DOSFALSE;
+        dirname[n++] = '/';
+        dirname[n] = '\0';
+    }
+    if (n + strlen((const char *)filename) >= size)
+        return DOSFALSE;
+    strcpy((char *)dirname + n, (const char *)filename);
+    return DOSTRUE;
+}
+
+/* A host "process" is a child running an asynchronous SystemTags()
+ * command line; a reaper thread runs NP_ExitCode once it has exited.
+ * FindTask() finds it by its NP_Name. */
+struct host_proc {
+    struct Process proc;
+    struct host_proc *next;
+    pid_t pid;
+    BPTR in, out;
+    void (*exit_code)(APTR);
+    APTR exit_data;
+};
+
+static struct host_proc *host_procs;   /* newest first, never freed */
+static pthread_mutex_t proc_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static struct Task *proc_find(const char *name)
+{
+    struct host_proc *hp;
+
+    pthread_mutex_lock(&proc_lock);
+    for (hp = host_procs; hp; hp = hp->next) {
+        if (strcmp(hp->proc.pr_Task.tc_Node.ln_Name, name) == 0)
+            break;
+    }
+    pthread_mutex_unlock(&proc_lock);
+    return hp ? &hp->proc.pr_Task : NULL;
+}
+
+static void *proc_reaper(void *arg)
+{
+    struct host_proc *hp = (struct host_proc *)arg;
+    int status;
+
+    while (waitpid(hp->pid, &status, 0) < 0 && errno == EINTR)
+        ;
+    Close(hp->in);
+    Close(hp->out);
+    if (hp->exit_code)
+        hp->exit_code(hp->exit_data);
+    /* The Process stays allocated: the parent may still look at it */
+    return NULL;
+}
+
+/* Only what parallel.c uses: SYS_Asynch with SYS_Input and SYS_Output.
+ * The command is run as the shell would, its first word resolved like
+ * any other Amiga path. */
+LONG SystemTagList(CONST_STRPTR command, const struct TagItem *tags)
+{
+    struct host_proc *hp;
+    struct host_task *ht;
+    const char *p = (const char *)command;
+    const char *name = NULL;
+    char word[1024], path[1024], cmd[4096];
+    pthread_t th;
+    size_t n = 0;
+    int in_fd, out_fd, asynch = 0;
+
+    hp = (struct host_proc *)calloc(1, sizeof(*hp));
+    if (!hp)
+        return -1;
+    for (; tags->ti_Tag != TAG_DONE; tags++) {
+        switch (tags->ti_Tag) {
+        case SYS_Input:      hp->in = (BPTR)tags->ti_Data; break;
+        case SYS_Output:     hp->out = (BPTR)tags->ti_Data; break;
+        case SYS_Asynch:     asynch = (int)tags->ti_Data; break;
+        case NP_Name:        name = (const char *)tags->ti_Data; break;
+        case NP_ExitCode:
+            hp->exit_code = (void (*)(APTR))tags->ti_Data;
+            break;
+        case NP_ExitData:    hp->exit_data = (APTR)tags->ti_Data; break;
+        default: break;
+        }
+    }
+    if (!asynch || !hp->in || !hp->out) {
+        free(hp);
+        return -1;
+    }
+
+    /* First word, quoted or not */
+    while (*p == ' ')
+        p++;
+    if (*p == '"') {
+        for (p++; *p && *p != '"' && n < sizeof(word) - 1; p++)
+            word[n++] = *p;
+        if (*p == '"')
+            p++;
+    } else {
+        for (; *p && *p != ' ' && n < sizeof(word) - 1; p++)
+            word[n++] = *p;
+    }
+    word[n] = '\0';
+    resolve_path(word, path, sizeof(path));
+    snprintf(cmd, sizeof(cmd), "exec '%s'%s", path, p);
+    in_fd = (int)((struct FileHandle *)BADDR(hp->in))->fh_Args;
+    out_fd = (int)((struct FileHandle *)BADDR(hp->out))->fh_Args;
+
+    hp->pid = fork();
+    if (hp->pid < 0) {
+        free(hp);
+        return -1;
+    }
+    if (hp->pid == 0) {
+        dup2(in_fd, 0);
+        dup2(out_fd, 1);
+        execl("/bin/sh", "sh", "-c", cmd, (char *)NULL);
+        _exit(127);
+    }
+
+    ht = (struct host_task *)calloc(1, sizeof(*ht));
+    ht->wake[0] = ht->wake[1] = -1;
+    ht->pid = hp->pid;
+    hp->proc.pr_Task.tc_Private = ht;
+    hp->proc.pr_Task.tc_Node.ln_Name = strdup(name ? name : "");
+    pthread_mutex_lock(&proc_lock);
+    hp->next = host_procs;
+    host_procs = hp;
+    pthread_mutex_unlock(&proc_lock);
+    if (pthread_create(&th, NULL, proc_reaper, hp) != 0)
+        abort();
+    pthread_detach(th);
+    return 0;
+}
+
+LONG SystemTags(CONST_STRPTR command, Tag tag1, ...)
+{
+    struct TagItem tags[32];
+    va_list ap;
+    int n = 0;
+
+    tags[0].ti_Tag = tag1;
+    va_start(ap, tag1);
+    while (tags[n].ti_Tag != TAG_DONE && n < 31) {
+        tags[n].ti_Data = va_arg(ap, ULONG);
+        tags[++n].ti_Tag = va_arg(ap, Tag);
+    }
+    va_end(ap);
+    tags[n].ti_Tag = TAG_DONE;
+    return SystemTagList(command, tags);
+}
+
+/* ---- icon.library ---- */
+
+struct DiskObject *GetDiskObject(CONST_STRPTR name)
+{
+    (void)name;
+    return NULL;
+}
+
+void FreeDiskObject(struct DiskObject *diskobj)
+{
+    (void)diskobj;
+}
+
+UBYTE *FindToolType(CONST_STRPTR *tool_type_array, CONST_STRPTR type_name)
+{
+    (void)tool_type_array;
+    (void)type_name;
+    return NULL;
+}
+
+/* ---- bsdsocket.library ---- */
+
+#define BSD_MAXFD      512
+#define BSD_DEFAULT_DT 64
+
+/* Event re-arm flags: an event fires once until the matching call
+ * (recv, accept, send) consumes the condition, as in AmiTCP. */
+#define ARM_READ    0x01
+#define ARM_WRITE   0x02
+#define ARM_ACCEPT  0x04
+#define ARM_CLOSE   0x08
+#define ARM_OOB     0x10
+#define ARM_ALL     0x1F
+
+struct bsd_sock {
+    int fd;             /* host descriptor, -1 if slot free */
+    int type;           /* SOCK_STREAM / SOCK_DGRAM / SOCK_RAW */
+    ULONG evmask;       /* SO_EVENTMASK */
+    ULONG events;       /* pending for GetSocketEvents() */
+    UBYTE armed;
+    UBYTE connecting;
+    UBYTE listening;
+};
+
+struct bsd_base {
+    struct Library lib;
+    struct Task *owner;
+    struct bsd_sock s[BSD_MAXFD];
+    LONG dtsize;
+    void *errno_ptr;
+    LONG errno_size;
+    LONG *herrno_ptr;
+    LONG last_errno;
+    LONG last_herrno;
+    ULONG breakmask;
+    ULONG sigiomask;
+    ULONG sigurgmask;
+    ULONG sigeventmask;
+    ULONG fdcallback;
+    STRPTR logtag;
+    ULONG logfacility;
+    ULONG logmask;
+    ULONG logstat;
+    int ev_next;
+    char ntoa_buf[20];
+};
+
+#define BASE(lib) ((struct bsd_base *)(lib))
+
+/* Names the active faults, so they are recorded in the log header */
+static char bsd_release[200];
+
+static struct Library *bsd_open(void)
+{
+    struct bsd_base *b;
+    int i;
+
+    if (!bsd_release[0])
+        snprintf(bsd_release, sizeof(bsd_release),
+                 "bsdsocket.library 4.1 (POSIX host%s%s)",
+                 faults_describe()[0] ? ", " : "", faults_describe());
+
+    b = (struct bsd_base *)calloc(1, sizeof(*b));
+    if (!b)
+        return NULL;
+    b->lib.lib_Version = 4;
+    b->lib.lib_Revision = 1;
+    b->owner = FindTask(NULL);
+    for (i = 0; i < BSD_MAXFD; i++)
+        b->s[i].fd = -1;
+    b->dtsize = BSD_DEFAULT_DT;
+    b->breakmask = SIGBREAKF_CTRL_C;
+    b->logmask = 0xff;
+    return &b->lib;
+}
+
+static void bsd_close(struct Library *lib)
+{
+    struct bsd_base *b = BASE(lib);
+    int i;
+
+    for (i = 0; i < BSD_MAXFD; i++)
+        if (b->s[i].fd >= 0)
+            close(b->s[i].fd);
+    free(b);
+}
+
+static void set_errno(struct bsd_base *b, LONG err)
+{
+    b->last_errno = err;
+    if (!b->errno_ptr)
+        return;
+    switch (b->errno_size) {
+    case 1: *(BYTE *)b->errno_ptr = (BYTE)err; break;
+    case 2: *(WORD *)b->errno_ptr = (WORD)err; break;
+    case 4: *(int *)b->errno_ptr = (int)err; break;
+    default: *(LONG *)b->errno_ptr = err; break;
+    }
+}
+
+static void set_herrno(struct bsd_base *b, LONG err)
+{
+    b->last_herrno = err;
+    if (b->herrno_ptr)
+        *b->herrno_ptr = err;
+}
+
+static LONG fail(struct bsd_base *b)
+{
+    set_errno(b, errno);
+    return -1;
+}
+
+static LONG fail_with(struct bsd_base *b, int err)
+{
+    set_errno(b, err);
+    return -1;
+}
+
+/* Host descriptor for a socket slot, or -1 with EBADF. */
+static int hfd(struct bsd_base *b, LONG s)
+{
+    if (s < 0 || s >= b->dtsize || b->s[s].fd < 0) {
+        set_errno(b, EBADF);
+        return -1;
+    }
+    return b->s[s].fd;
+}
+
+/* Entry to a call on socket s: injected latency, then its host
+ * descriptor (-1 with EBADF). */
+static int enter(struct bsd_base *b, LONG s)
+{
+    fault_latency();
+    return hfd(b, s);
+}
+
+/* Fail a call on a non-blocking descriptor with an injected
+ * EWOULDBLOCK, re-arming the event the call would consume. */
+static int injected_wouldblock(struct bsd_base *b, LONG s, UBYTE arm)
+{
+    if (!fault_wouldblock(b->s[s].fd))
+        return 0;
+    b->s[s].armed |= arm;
+    set_errno(b, EWOULDBLOCK);
+    return 1;
+}
+
+static LONG slot_alloc(struct bsd_base *b, int fd)
+{
+    LONG i;
+    socklen_t len = sizeof(int);
+    int type = 0;
+
+    for (i = 0; i < b->dtsize; i++) {
+        if (b->s[i].fd < 0) {
+            memset(&b->s[i], 0, sizeof(b->s[i]));
+            b->s[i].fd = fd;
+            getsockopt(fd, SOL_SOCKET, SO_TYPE, &type, &len);
+            b->s[i].type = type;
+            b->s[i].armed = ARM_ALL;
+            return i;
+        }
+    }
+    close(fd);
+    return fail_with(b, EMFILE);
+}
+
+LONG __bst_socket(struct Library *lib, LONG d, LONG t, LONG p)
+{
+    struct bsd_base *b = BASE(lib);
+    int fd;
+
+    fault_latency();
+    fd = socket((int)d, (int)t, (int)p);
+    if (fd < 0)
+        return fail(b);
+    return slot_alloc(b, fd);
+}
+
+LONG __bst_bind(struct Library *lib, LONG s, const void *a, LONG l)
+{
+    struct bsd_base *b = BASE(lib);
+    int fd = enter(b, s);
+
+    if (fd < 0)
+        return -1;
+    if (bind(fd, (const struct sockaddr *)a, (socklen_t)l) < 0)
+        return fail(b);
+    return 0;
+}
+
+LONG __bst_listen(struct Library *lib, LONG s, LONG backlog)
+{
+    struct bsd_base *b = BASE(lib);
+    int fd = enter(b, s);
+
+    if (fd < 0)
+        return -1;
+    if (listen(fd, (int)backlog) < 0)
+        return fail(b);
+    b->s[s].listening = 1;
+    return 0;
+}
+
+LONG __bst_accept(struct Library *lib, LONG s, void *a, void *l)
+{
+    struct bsd_base *b = BASE(lib);
+    int fd = enter(b, s), nfd;
+
+    if (fd < 0 || injected_wouldblock(b, s, ARM_ACCEPT))
+        return -1;
+    nfd = accept(fd, (struct sockaddr *)a, (socklen_t *)l);
+    b->s[s].armed |= ARM_ACCEPT;
+    if (nfd < 0)
+        return fail(b);
+    return slot_alloc(b, nfd);
+}
+
+LONG __bst_connect(struct Library *lib, LONG s, const void *a, LONG l)
+{
+    struct bsd_base *b = BASE(lib);
+    int fd = enter(b, s);
+
+    if (fd < 0)
+        return -1;
+    if (connect(fd, (const struct sockaddr *)a, (socklen_t)l) < 0) {
+        if (errno == EINPROGRESS)
+            b->s[s].connecting = 1;
+        return fail(b);
+    }
+    return 0;
+}
+
+LONG __bst_send(struct Library *lib, LONG s, const void *buf, LONG len,
+                LONG flags)
+{
+    struct bsd_base *b = BASE(lib);
+    int fd = enter(b, s);
+    ssize_t rc;
+
+    if (fd < 0 || injected_wouldblock(b, s, ARM_WRITE))
+        return -1;
+    if (b->s[s].type == SOCK_STREAM)
+        len = fault_send_len(len);
+    rc = send(fd, buf, (size_t)len, (int)flags | MSG_NOSIGNAL);
+    if (rc < 0) {
+        if (errno == EWOULDBLOCK)
+            b->s[s].armed |= ARM_WRITE;
+        return fail(b);
+    }
+    return (LONG)rc;
+}
+
+LONG __bst_recv(struct Library *lib, LONG s, void *buf, LONG len, LONG flags)
+{
+    struct bsd_base *b = BASE(lib);
+    int fd = enter(b, s);
+    ssize_t rc;
+
+    if (fd < 0 || injected_wouldblock(b, s, ARM_READ))
+        return -1;
+    rc = recv(fd, buf, (size_t)len, (int)flags);
+    b->s[s].armed |= (flags & MSG_OOB) ? ARM_OOB : ARM_READ;
+    if (rc < 0)
+        return fail(b);
+    return (LONG)rc;
+}
+
+LONG __bst_sendto(struct Library *lib, LONG s, const void *buf, LONG len,
+                  LONG flags, const void *to, LONG tolen)
+{
+    struct bsd_base *b = BASE(lib);
+    int fd = enter(b, s);
+    ssize_t rc;
+
+    if (fd < 0 || injected_wouldblock(b, s, ARM_WRITE))
+        return -1;
+    if (b->s[s].type == SOCK_STREAM)
+        len = fault_send_len(len);
+    rc = sendto(fd, buf, (size_t)len, (int)flags | MSG_NOSIGNAL,
+                (const struct sockaddr *)to, (socklen_t)tolen);
+    if (rc < 0)
+        return fail(b);
+    return (LONG)rc;
+}
+
+LONG __bst_recvfrom(struct Library *lib, LONG s, void *buf, LONG len,
+                    LONG flags, void *from, void *fromlen)
+{
+    struct bsd_base *b = BASE(lib);
+    int fd = enter(b, s);
+    ssize_t rc;
+
+    if (fd < 0 || injected_wouldblock(b, s, ARM_READ))
+        return -1;
+    rc = recvfrom(fd, buf, (size_t)len, (int)flags,
+                  (struct sockaddr *)from, (socklen_t *)fromlen);
+    b->s[s].armed |= ARM_READ;
+    if (rc < 0)
+        return fail(b);
+    return (LONG)rc;
+}
+
+LONG __bst_sendmsg(struct Library *lib, LONG s, const struct msghdr *m,
+                   LONG flags)
+{
+    struct bsd_base *b = BASE(lib);
+    int fd = enter(b, s);
+    ssize_t rc;
+
+    if (fd < 0)
+        return -1;
+    rc = sendmsg(fd, m, (int)flags | MSG_NOSIGNAL);
+    if (rc < 0)
+        return fail(b);
+    return (LONG)rc;
+}
+
+LONG __bst_recvmsg(struct Library *lib, LONG s, struct msghdr *m, LONG flags)
+{
+    struct bsd_base *b = BASE(lib);
+    int fd = enter(b, s);
+    ssize_t rc;
+
+    if (fd < 0)
+        return -1;
+    rc = recvmsg(fd, m, (int)flags);
+    b->s[s].armed |= ARM_READ;
+    if (rc < 0)
+        return fail(b);
+    return (LONG)rc;
+}
+
+LONG __bst_shutdown(struct Library *lib, LONG s, LONG how)
+{
+    struct bsd_base *b = BASE(lib);
+    int fd = enter(b, s);
+
+    if (fd < 0)
+        return -1;
+    if (shutdown(fd, (int)how) < 0)
+        return fail(b);
+    return 0;
+}
+
+/* Options whose value is not a plain int on either side. */
+static int opt_is_struct(LONG level, LONG opt)
+{
+    return level == SOL_SOCKET &&
+           (opt == SO_LINGER || opt == SO_RCVTIMEO || opt == SO_SNDTIMEO);
+}
+
+LONG __bst_setsockopt(struct Library *lib, LONG s, LONG level, LONG opt,
+                      const void *val, LONG len)
+{
+    struct bsd_base *b = BASE(lib);
+    int fd = enter(b, s);
+    int iv;
+
+    if (fd < 0)
+        return -1;
+
+    if (level == SOL_SOCKET && opt == SO_EVENTMASK) {
+        if (!val || len < (LONG)sizeof(int))
+            return fail_with(b, EINVAL);
+        b->s[s].evmask = len >= (LONG)sizeof(LONG) ?
+                         (ULONG)*(const LONG *)val :
+                         (ULONG)*(const int *)val;
+        b->s[s].events = 0;
+        b->s[s].armed = ARM_ALL;
+        return 0;
+    }
+
+    /* LONG is wider than int on the host; narrow int-valued options */
+    if (val && len == (LONG)sizeof(LONG) && !opt_is_struct(level, opt)) {
+        iv = (int)*(const LONG *)val;
+        if (setsockopt(fd, (int)level, (int)opt, &iv, sizeof(iv)) < 0)
+            return fail(b);
+        return 0;
+    }
+
+    if (setsockopt(fd, (int)level, (int)opt, val, (socklen_t)len) < 0)
+        return fail(b);
+    return 0;
+}
+
+/* Length arguments are socklen_t on the host but LONG in some callers;
+ * only the low 32 bits are read or written, which is correct for both
+ * on a little-endian host as long as the caller initialised them. */
+LONG __bst_getsockopt(struct Library *lib, LONG s, LONG level, LONG opt,
+                      void *val, void *lenp)
+{
+    struct bsd_base *b = BASE(lib);
+    int fd = enter(b, s);
+    socklen_t *len = (socklen_t *)lenp;
+    socklen_t ilen;
+    int iv;
+
+    if (fd < 0)
+        return -1;
+
+    if (level == SOL_SOCKET && opt == SO_EVENTMASK) {
+        if (!val || !len || *len < sizeof(int))
+            return fail_with(b, EINVAL);
+        if (*len >= sizeof(LONG))
+            *(LONG *)val = (LONG)b->s[s].evmask;
+        else
+            *(int *)val = (int)b->s[s].evmask;
+        return 0;
+    }
+
+    if (val && len && *len == sizeof(LONG) && !opt_is_struct(level, opt)) {
+        ilen = sizeof(iv);
+        if (getsockopt(fd, (int)level, (int)opt, &iv, &ilen) < 0)
+            return fail(b);
+        *(LONG *)val = iv;
+        return 0;
+    }
+
+    if (getsockopt(fd, (int)level, (int)opt, val, len) < 0)
+        return fail(b);
+    return 0;
+}
+
+LONG __bst_getsockname(struct Library *lib, LONG s, void *a, void *l)
+{
+    struct bsd_base *b = BASE(lib);
+    int fd = enter(b, s);
+
+    if (fd < 0)
+        return -1;
+    if (getsockname(fd, (struct sockaddr *)a, (socklen_t *)l) < 0)
+        return fail(b);
+    return 0;
+}
+
+LONG __bst_getpeername(struct Library *lib, LONG s, void *a, void *l)
+{
+    struct bsd_base *b = BASE(lib);
+    int fd = enter(b, s);
+
+    if (fd < 0)
+        return -1;
+    if (getpeername(fd, (struct sockaddr *)a, (socklen_t *)l) < 0)
+        return fail(b);
+    return 0;
+}
+
+LONG __bst_CloseSocket(struct Library *lib, LONG s)
+{
+    struct bsd_base *b = BASE(lib);
+    int fd = enter(b, s);
+
+    if (fd < 0)
+        return -1;
+    close(fd);
+    b->s[s].fd = -1;
+    b->s[s].evmask = 0;
+    b->s[s].events = 0;
+    return 0;
+}
+
+LONG __bst_IoctlSocket(struct Library *lib, LONG s, ULONG req, APTR argp)
+{
+    struct bsd_base *b = BASE(lib);
+    int fd = enter(b, s);
+    int iv;
+
+    if (fd < 0)
+        return -1;
+    if (!argp)
+        return fail_with(b, EFAULT);
+
+    switch (req) {
+    case FIONBIO:
+    case FIOASYNC:
+        iv = *(int *)argp;
+        if (ioctl(fd, req, &iv) < 0)
+            return fail(b);
+        return 0;
+    case FIONREAD:
+        if (ioctl(fd, req, &iv) < 0)
+            return fail(b);
+        *(LONG *)argp = iv;
+        return 0;
+    default:
+        if (ioctl(fd, req, argp) < 0)
+            return fail(b);
+        return 0;
+    }
+}
+
+/* Detect SO_EVENTMASK conditions on all sockets of a base and latch
+ * them into the pending set. Signals the owner when anything new
+ * fired. Returns non-zero if any socket has an event mask set. */
+static int scan_events(struct bsd_base *b)
+{
+    struct pollfd pfd[BSD_MAXFD];
+    int slot[BSD_MAXFD];
+    int n = 0, i, fired = 0;
+
+    for (i = 0; i < b->dtsize; i++) {
+        if (b->s[i].fd < 0 || !b->s[i].evmask)
+            continue;
+        pfd[n].fd = b->s[i].fd;
+        pfd[n].events = POLLIN | POLLOUT | POLLPRI | POLLRDHUP;
+        pfd[n].revents = 0;
+        slot[n++] = i;
+    }
+    if (n == 0)
+        return 0;
+
+    poll(pfd, n, 0);
+
+    for (i = 0; i < n; i++) {
+        struct bsd_sock *so = &b->s[slot[i]];
+        short re = pfd[i].revents;
+        ULONG ev = 0;
+        struct sockaddr_storage ss;
+        socklen_t sl = sizeof(ss);
+        int connected, err = 0, avail = 0;
+        socklen_t el = sizeof(err);
+
+        if (so->listening) {
+            if ((re & POLLIN) && (so->armed & ARM_ACCEPT)) {
+                ev |= FD_ACCEPT;
+                so->armed &= ~ARM_ACCEPT;
+            }
+        } else if (so->connecting) {
+            if (re & (POLLOUT | POLLERR | POLLHUP)) {
+                so->connecting = 0;
+                getsockopt(so->fd, SOL_SOCKET, SO_ERROR, &err, &el);
+                ev |= err ? FD_ERROR : FD_CONNECT;
+            }
+        } else {
+            connected = (so->type != SOCK_STREAM) ||
+                        getpeername(so->fd, (struct sockaddr *)&ss, &sl) == 0;
+            if (so->type == SOCK_STREAM && (re & (POLLRDHUP | POLLHUP)))
+                connected = 1;
+            if (connected) {
+                if (re & POLLIN)
+                    ioctl(so->fd, FIONREAD, &avail);
+                if (avail > 0 && (so->armed & ARM_READ)) {
+                    ev |= FD_READ;
+                    so->armed &= ~ARM_READ;
+                }
+                if ((re & POLLPRI) && (so->armed & ARM_OOB)) {
+                    ev |= FD_OOB;
+                    so->armed &= ~ARM_OOB;
+                }
+                if (so->type == SOCK_STREAM &&
+                    (re & (POLLRDHUP | POLLHUP)) &&
+                    (so->armed & ARM_CLOSE)) {
+                    ev |= FD_CLOSE;
+                    so->armed &= ~ARM_CLOSE;
+                }
+                if ((re & POLLOUT) && !(re & POLLHUP) &&
+                    (so->armed & ARM_WRITE)) {
+                    ev |= FD_WRITE;
+                    so->armed &= ~ARM_WRITE;
+                }
+            }
+        }
+
+        ev &= so->evmask;
+        if (ev) {
+            so->events |= ev;
+            fired = 1;
+        }
+    }
+
+    if (fired && b->sigeventmask && !fault_drop_signal())
+        Signal(b->owner, b->sigeventmask);
+    return 1;
+}
+
+LONG __bst_WaitSelect(struct Library *lib, LONG nfds, fd_set *r, fd_set *w,
+                      fd_set *e, struct timeval *tv, ULONG *sigp)
+{
+    struct bsd_base *b = BASE(lib);
+    struct Task *task = FindTask(NULL);
+    struct pollfd pfd[BSD_MAXFD + 1];
+    int amiga_fd[BSD_MAXFD];
+    struct timespec now, deadline;
+    ULONG waitmask, got;
+    int n, i, ready, timeout_ms, events_active;
+    LONG fd;
+
+    fault_latency();
+    waitmask = (sigp ? *sigp : 0) | b->breakmask;
+
+    if (nfds > b->dtsize)
+        nfds = b->dtsize;
+
+    n = 0;
+    for (fd = 0; fd < nfds; fd++) {
+        short want = 0;
+
+        if (r && FD_ISSET(fd, r))
+            want |= POLLIN;
+        if (w && FD_ISSET(fd, w))
+            want |= POLLOUT;
+        if (e && FD_ISSET(fd, e))
+            want |= POLLPRI;
+        if (!want)
+            continue;
+        if (hfd(b, fd) < 0)
+            return -1;
+        pfd[n].fd = b->s[fd].fd;
+        pfd[n].events = want;
+        amiga_fd[n] = (int)fd;
+        n++;
+    }
+    pfd[n].fd = task_wake_fd(task);
+    pfd[n].events = POLLIN;
+
+    if (tv) {
+        timespec_now(&deadline);
+        deadline.tv_sec += tv->tv_sec;
+        deadline.tv_nsec += tv->tv_usec * 1000L;
+        while (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+    }
+
+    for (;;) {
+        events_active = scan_events(b);
+
+        got = __atomic_load_n(&task->tc_SigRecvd, __ATOMIC_SEQ_CST);
+        if (got & b->breakmask) {
+            if (sigp)
+                *sigp = 0;
+            return fail_with(b, EINTR);
+        }
+
+        timeout_ms = -1;
+        if (tv) {
+            long ms;
+
+            timespec_now(&now);
+            ms = (deadline.tv_sec - now.tv_sec) * 1000L +
+                 (deadline.tv_nsec - now.tv_nsec) / 1000000L;
+            timeout_ms = ms < 0 ? 0 : (int)ms;
+        }
+        if (got & waitmask)
+            timeout_ms = 0;
+        if (events_active && (timeout_ms < 0 || timeout_ms > 10))
+            timeout_ms = 10;
+
+        for (i = 0; i <= n; i++)
+            pfd[i].revents = 0;
+        ready = poll(pfd, n + 1, timeout_ms);
+        if (ready < 0 && errno != EINTR)
+            return fail(b);
+        if (pfd[n].revents)
+            task_drain(task);
+
+        ready = 0;
+        for (i = 0; i < n; i++) {
+            short re = pfd[i].revents;
+            if ((re & POLLHUP) && !(re & (POLLIN | POLLRDHUP | POLLERR)))
+                pfd[i].revents = re = 0;
+            if (re)
+                ready++;
+        }
+
+        got = take_signals(task, waitmask & ~b->breakmask);
+        if (ready || got) {
+            fault_wakeup();
+            break;
+        }
+
+        if (tv) {
+            timespec_now(&now);
+            if (!timespec_before(&now, &deadline))
+                break;
+        }
+    }
+
+    if (r) FD_ZERO(r);
+    if (w) FD_ZERO(w);
+    if (e) FD_ZERO(e);
+    for (i = 0; i < n; i++) {
+        short re = pfd[i].revents;
+
+        /* Linux flags an unconnected stream socket as hung up; BSD
+         * select() reports it as neither readable nor writable. */
+        if ((re & POLLHUP) && !(re & (POLLIN | POLLRDHUP | POLLERR)))
+            re = 0;
+        if (r && (pfd[i].events & POLLIN) &&
+            (re & (POLLIN | POLLHUP | POLLERR)))
+            FD_SET(amiga_fd[i], r);
+        if (w && (pfd[i].events & POLLOUT) && (re & (POLLOUT | POLLERR)))
+            FD_SET(amiga_fd[i], w);
+        if (e && (pfd[i].events & POLLPRI) && (re & POLLPRI))
+            FD_SET(amiga_fd[i], e);
+    }
+
+    if (sigp)
+        *sigp = got;
+    return ready;
+}
+
+void __bst_SetSocketSignals(struct Library *lib, ULONG intr, ULONG io,
+                            ULONG urg)
+{
+    struct bsd_base *b = BASE(lib);
+
+    b->breakmask = intr;
+    b->sigiomask = io;
+    b->sigurgmask = urg;
+}
+
+LONG __bst_getdtablesize(struct Library *lib)
+{
+    return BASE(lib)->dtsize;
+}
+
+/* ReleaseSocket pool, shared by every opener in the process */
+struct pool_entry {
+    LONG id;
+    int fd;
+    int domain, type, protocol;
+    struct pool_entry *next;
+};
+
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct pool_entry *pool;
+static LONG pool_next_id = 0x10000;
+
+static LONG pool_put(struct bsd_base *b, int fd, LONG id)
+{
+    struct pool_entry *pe;
+    int v = 0;
+    socklen_t len = sizeof(v);
+
+    pe = (struct pool_entry *)calloc(1, sizeof(*pe));
+    if (!pe)
+        return fail_with(b, ENOMEM);
+
+    pthread_mutex_lock(&pool_lock);
+    if (id == UNIQUE_ID) {
+        id = pool_next_id++;
+    } else {
+        struct pool_entry *q;
+        for (q = pool; q; q = q->next) {
+            if (q->id == id) {
+                pthread_mutex_unlock(&pool_lock);
+                free(pe);
+                return fail_with(b, EINVAL);
+            }
+        }
+    }
+    pe->id = id;
+    pe->fd = fd;
+    getsockopt(fd, SOL_SOCKET, SO_DOMAIN, &v, &len);
+    pe->domain = v;
+    len = sizeof(v);
+    getsockopt(fd, SOL_SOCKET, SO_TYPE, &v, &len);
+    pe->type = v;
+    len = sizeof(v);
+    getsockopt(fd, SOL_SOCKET, SO_PROTOCOL, &v, &len);
+    pe->protocol = v;
+    pe->next = pool;
+    pool = pe;
+    pthread_mutex_unlock(&pool_lock);
+    return id;
+}
+
+LONG __bst_ObtainSocket(struct Library *lib, LONG id, LONG domain,
+                        LONG type, LONG protocol)
+{
+    struct bsd_base *b = BASE(lib);
+    struct pool_entry **pp, *pe;
+    int fd = -1;
+
+    pthread_mutex_lock(&pool_lock);
+    for (pp = &pool; (pe = *pp) != NULL; pp = &pe->next) {
+        if (id == UNIQUE_ID ? (pe->domain == domain && pe->type == type)
+                            : pe->id == id) {
+            (void)protocol;
+            *pp = pe->next;
+            fd = pe->fd;
+            free(pe);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&pool_lock);
+
+    if (fd < 0)
+        return fail_with(b, EWOULDBLOCK);
+    return slot_alloc(b, fd);
+}
+
+LONG __bst_ReleaseSocket(struct Library *lib, LONG s, LONG id)
+{
+    struct bsd_base *b = BASE(lib);
+    int fd = enter(b, s);
+    LONG rc;
+
+    if (fd < 0)
+        return -1;
+    rc = pool_put(b, fd, id);
+    if (rc == -1)
+        return -1;
+    b->s[s].fd = -1;
+    b->s[s].evmask = 0;
+    b->s[s].events = 0;
+    return rc;
+}
+
+LONG __bst_ReleaseCopyOfSocket(struct Library *lib, LONG s, LONG id)
+{
+    struct bsd_base *b = BASE(lib);
+    int fd = enter(b, s), nfd;
+    LONG rc;
+
+    if (fd < 0)
+        return -1;
+    nfd = dup(fd);
+    if (nfd < 0)
+        return fail(b);
+    rc = pool_put(b, nfd, id);
+    if (rc == -1)
+        close(nfd);
+    return rc;
+}
+
+LONG __bst_Errno(struct Library *lib)
+{
+    return BASE(lib)->last_errno;
+}
+
+void __bst_SetErrnoPtr(struct Library *lib, void *ptr, LONG size)
+{
+    struct bsd_base *b = BASE(lib);
+
+    if (size != 1 && size != 2 && size != 4 && size != (LONG)sizeof(LONG)) {
+        set_errno(b, EINVAL);
+        return;
+    }
+    b->errno_ptr = ptr;
+    b->errno_size = size;
+}
+
+STRPTR __bst_Inet_NtoA(struct Library *lib, ULONG in)
+{
+    struct bsd_base *b = BASE(lib);
+    struct in_addr a;
+
+    a.s_addr = (in_addr_t)in;
+    strncpy(b->ntoa_buf, inet_ntoa(a), sizeof(b->ntoa_buf) - 1);
+    return (STRPTR)b->ntoa_buf;
+}
+
+ULONG __bst_inet_addr(struct Library *lib, const void *cp)
+{
+    (void)lib;
+    return (ULONG)inet_addr((const char *)cp);
+}
+
+ULONG __bst_Inet_LnaOf(struct Library *lib, ULONG in)
+{
+    struct in_addr a;
+
+    (void)lib;
+    a.s_addr = (in_addr_t)in;
+    return (ULONG)inet_lnaof(a);
+}
+
+ULONG __bst_Inet_NetOf(struct Library *lib, ULONG in)
+{
+    struct in_addr a;
+
+    (void)lib;
+    a.s_addr = (in_addr_t)in;
+    return (ULONG)inet_netof(a);
+}
+
+ULONG __bst_Inet_MakeAddr(struct Library *lib, ULONG net, ULONG host)
+{
+    (void)lib;
+    return (ULONG)inet_makeaddr((in_addr_t)net, (in_addr_t)host).s_addr;
+}
+
+ULONG __bst_inet_network(struct Library *lib, const void *cp)
+{
+    (void)lib;
+    return (ULONG)inet_network((const char *)cp);
+}
+
+struct hostent *__bst_gethostbyname(struct Library *lib, const void *name)
+{
+    struct hostent *h = gethostbyname((const char *)name);
+
+    if (!h)
+        set_herrno(BASE(lib), h_errno);
+    return h;
+}
+
+struct hostent *__bst_gethostbyaddr(struct Library *lib, const void *addr,
+                                    LONG len, LONG type)
+{
+    struct hostent *h = gethostbyaddr(addr, (socklen_t)len, (int)type);
+
+    if (!h)
+        set_herrno(BASE(lib), h_errno);
+    return h;
+}
+
+struct netent *__bst_getnetbyname(struct Library *lib, const void *name)
+{
+    (void)lib;
+    return getnetbyname((const char *)name);
+}
+
+struct netent *__bst_getnetbyaddr(struct Library *lib, ULONG net, LONG type)
+{
+    (void)lib;
+    return getnetbyaddr((uint32_t)net, (int)type);
+}
+
+struct servent *__bst_getservbyname(struct Library *lib, const void *name,
+                                    const void *proto)
+{
+    (void)lib;
+    return getservbyname((const char *)name, (const char *)proto);
+}
+
+struct servent *__bst_getservbyport(struct Library *lib, LONG port,
+                                    const void *proto)
+{
+    (void)lib;
+    return getservbyport((int)port, (const char *)proto);
+}
+
+struct protoent *__bst_getprotobyname(struct Library *lib, const void *name)
+{
+    (void)lib;
+    return getprotobyname((const char *)name);
+}
+
+struct protoent *__bst_getprotobynumber(struct Library *lib, LONG proto)
+{
+    (void)lib;
+    return getprotobynumber((int)proto);
+}
+
+/* The Amiga varargs convention passes a ULONG array; the message is
+ * accepted and dropped, there is no syslog daemon to feed. */
+void __bst_vsyslog(struct Library *lib, ULONG level, const void *fmt,
+                   APTR args)
+{
+    (void)lib;
+    (void)level;
+    (void)fmt;
+    (void)args;
+}
+
+LONG __bst_Dup2Socket(struct Library *lib, LONG old, LONG newfd)
+{
+    struct bsd_base *b = BASE(lib);
+    int fd = hfd(b, old), nfd;
+
+    if (fd < 0)
+        return -1;
+    nfd = dup(fd);
+    if (nfd < 0)
+        return fail(b);
+    if (newfd < 0)
+        return slot_alloc(b, nfd);
+    if (newfd >= b->dtsize) {
+        close(nfd);
+        return fail_with(b, EBADF);
+    }
+    if (b->s[newfd].fd >= 0)
+        close(b->s[newfd].fd);
+    b->s[newfd] = b->s[old];
+    b->s[newfd].fd = nfd;
+    b->s[newfd].evmask = 0;
+    b->s[newfd].events = 0;
+    return newfd;
+}
+
+LONG __bst_gethostname(struct Library *lib, void *name, LONG len)
+{
+    if (gethostname((char *)name, (size_t)len) < 0)
+        return fail(BASE(lib));
+    return 0;
+}
+
+ULONG __bst_gethostid(struct Library *lib)
+{
+    (void)lib;
+    return (ULONG)(unsigned int)gethostid();
+}
+
+static void tag_store(struct TagItem *ti, ULONG value)
+{
+    if (ti->ti_Tag & SBTF_REF)
+        *(ULONG *)ti->ti_Data = value;
+    else
+        ti->ti_Data = value;
+}
+
+static ULONG tag_value(const struct TagItem *ti)
+{
+    if (ti->ti_Tag & SBTF_REF)
+        return *(const ULONG *)ti->ti_Data;
+    return ti->ti_Data;
+}
+
+LONG __bst_SocketBaseTagList(struct Library *lib, struct TagItem *tags)
+{
+    struct bsd_base *b = BASE(lib);
+    LONG index = 0;
+    struct TagItem *ti;
+
+    for (ti = tags; ti && ti->ti_Tag != TAG_DONE; ti++) {
+        ULONG tag = ti->ti_Tag;
+        int set = (tag & SBTF_SET) != 0;
+        ULONG *field = NULL;
+        ULONG v;
+
+        index++;
+        if (tag == 1 || tag == 3)       /* TAG_IGNORE, TAG_SKIP */
+            continue;
+        if (tag == 2) {                 /* TAG_MORE */
+            ti = (struct TagItem *)ti->ti_Data - 1;
+            continue;
+        }
+        if (!(tag & TAG_USER))
+            return index;
+
+        switch (SBTM_CODE(tag)) {
+        case SBTC_BREAKMASK:    field = &b->breakmask; break;
+        case SBTC_SIGIOMASK:    field = &b->sigiomask; break;
+        case SBTC_SIGURGMASK:   field = &b->sigurgmask; break;
+        case SBTC_SIGEVENTMASK: field = &b->sigeventmask; break;
+        case SBTC_FDCALLBACK:   field = &b->fdcallback; break;
+        case SBTC_LOGFACILITY:  field = &b->logfacility; break;
+        case SBTC_LOGMASK:      field = &b->logmask; break;
+        case SBTC_LOGSTAT:      field = &b->logstat; break;
+
+        case SBTC_ERRNO:
+            if (set)
+                set_errno(b, (LONG)tag_value(ti));
+            else
+                tag_store(ti, (ULONG)b->last_errno);
+            continue;
+
+        case SBTC_HERRNO:
+            if (set)
+                set_herrno(b, (LONG)tag_value(ti));
+            else
+                tag_store(ti, (ULONG)b->last_herrno);
+            continue;
+
+        case SBTC_DTABLESIZE:
+            if (set) {
+                v = tag_value(ti);
+                if (v < 1 || v > BSD_MAXFD)
+                    return index;
+                if ((LONG)v > b->dtsize)
+                    b->dtsize = (LONG)v;
+            } else {
+                tag_store(ti, (ULONG)b->dtsize);
+            }
+            continue;
+
+        case SBTC_ERRNOBYTEPTR:
+        case SBTC_ERRNOWORDPTR:
+        case SBTC_ERRNOLONGPTR:
+            if (set) {
+                b->errno_ptr = (void *)tag_value(ti);
+                b->errno_size = SBTM_CODE(tag) == SBTC_ERRNOBYTEPTR ? 1 :
+                                SBTM_CODE(tag) == SBTC_ERRNOWORDPTR ? 2 :
+                                (LONG)sizeof(LONG);
+            } else {
+                tag_store(ti, (ULONG)b->errno_ptr);
+            }
+            continue;
+
+        case SBTC_HERRNOLONGPTR:
+            if (set)
+                b->herrno_ptr = (LONG *)tag_value(ti);
+            else
+                tag_store(ti, (ULONG)b->herrno_ptr);
+            continue;
+
+        case SBTC_ERRNOSTRPTR:
+            if (set)
+                return index;
+            tag_store(ti, (ULONG)strerror((int)tag_value(ti)));
+            continue;
+
+        case SBTC_HERRNOSTRPTR:
+            if (set)
+                return index;
+            tag_store(ti, (ULONG)hstrerror((int)tag_value(ti)));
+            continue;
+
+        case SBTC_LOGTAGPTR:
+            if (set)
+                b->logtag = (STRPTR)tag_value(ti);
+            else
+                tag_store(ti, (ULONG)b->logtag);
+            continue;
+
+        case SBTC_RELEASESTRPTR:
+            if (set)
+                return index;
+            tag_store(ti, (ULONG)bsd_release);
+            continue;
+
+        default:
+            return index;
+        }
+
+        if (set)
+            *field = tag_value(ti);
+        else
+            tag_store(ti, *field);
+    }
+    return 0;
+}
+
+LONG __bst_SocketBaseTags(struct Library *lib, ...)
+{
+    struct TagItem tags[32];
+    va_list ap;
+    int n = 0;
+
+    va_start(ap, lib);
+    while (n < 31) {
+        tags[n].ti_Tag = va_arg(ap, ULONG);
+        if (tags[n].ti_Tag == TAG_DONE)
+            break;
+        tags[n].ti_Data = va_arg(ap, ULONG);
+        n++;
+    }
+    va_end(ap);
+    tags[n].ti_Tag = TAG_DONE;
+    tags[n].ti_Data = 0;
+
+    return __bst_SocketBaseTagList(lib, tags);
+}
+
+LONG __bst_GetSocketEvents(struct Library *lib, ULONG *mask)
+{
+    struct bsd_base *b = BASE(lib);
+    int i, s;
+
+    scan_events(b);
+
+    for (i = 0; i < b->dtsize; i++) {
+        s = (b->ev_next + i) % b->dtsize;
+        if (b->s[s].fd >= 0 && b->s[s].events) {
+            *mask = b->s[s].events;
+            b->s[s].events = 0;
+            b->ev_next = s + 1;
+            return s;
+        }
+    }
+    return -1;
+}
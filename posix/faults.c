@@ -0,0 +1,215 @@
+/*
+ * bsdsocktest — POSIX host fault injection
+ *
+ * Faults are drawn from a private generator, so a given seed and a
+ * given run order inject the same faults every time.  Worker processes
+ * inherit the environment and inject their own.
+ */
+
+#define _GNU_SOURCE
+
+#include "faults.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define DEFAULT_STORM 8
+
+struct fault_config {
+    unsigned long latency_us;
+    int partial_pct;
+    int wouldblock_pct;
+    int storm;
+    unsigned long wakeup_us;
+    int dropsignal_pct;
+    unsigned long seed;
+};
+
+struct fault_counts {
+    unsigned long delayed;
+    unsigned long partial;
+    unsigned long storms;
+    unsigned long wouldblock;
+    unsigned long wakeups;
+    unsigned long dropped;
+};
+
+static struct fault_config cfg;
+static struct fault_counts counts;
+static int active;
+static int storm_left;
+static unsigned long rng;
+static char description[160];
+static pthread_mutex_t fault_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* ---- Internal helpers ---- */
+
+/* Park-Miller minimal standard generator; caller holds fault_lock */
+static unsigned long next_random(void)
+{
+    rng = (rng * 48271UL) % 2147483647UL;
+    return rng;
+}
+
+/* Non-zero with the given probability in percent */
+static int chance(int pct)
+{
+    int hit;
+
+    if (pct <= 0)
+        return 0;
+    pthread_mutex_lock(&fault_lock);
+    hit = (int)(next_random() % 100) < pct;
+    pthread_mutex_unlock(&fault_lock);
+    return hit;
+}
+
+static void print_counts(void)
+{
+    fprintf(stderr,
+            "faults: %lu delayed calls, %lu partial sends, "
+            "%lu EWOULDBLOCK storms (%lu calls), %lu delayed wakeups, "
+            "%lu dropped signals\n",
+            counts.delayed, counts.partial, counts.storms,
+            counts.wouldblock, counts.wakeups, counts.dropped);
+}
+
+static int parse_pct(const char *key, const char *value)
+{
+    int v = atoi(value);
+
+    if (v < 0 || v > 100) {
+        fprintf(stderr, "faults: %s=%s out of range (0-100)\n", key, value);
+        return 0;
+    }
+    return v;
+}
+
+/* ---- Public API ---- */
+
+void faults_init(void)
+{
+    const char *env;
+    char spec[256];
+    char *word, *eq, *save;
+
+    env = getenv("BSDSOCKTEST_FAULTS");
+    if (!env || !*env)
+        return;
+
+    cfg.storm = DEFAULT_STORM;
+    cfg.seed = 1;
+    strncpy(spec, env, sizeof(spec) - 1);
+    spec[sizeof(spec) - 1] = '\0';
+
+    for (word = strtok_r(spec, " ,", &save); word;
+         word = strtok_r(NULL, " ,", &save)) {
+        eq = strchr(word, '=');
+        if (!eq) {
+            fprintf(stderr, "faults: ignoring '%s' (expected key=value)\n",
+                    word);
+            continue;
+        }
+        *eq++ = '\0';
+        if (strcmp(word, "latency") == 0)
+            cfg.latency_us = strtoul(eq, NULL, 10);
+        else if (strcmp(word, "partial") == 0)
+            cfg.partial_pct = parse_pct(word, eq);
+        else if (strcmp(word, "wouldblock") == 0)
+            cfg.wouldblock_pct = parse_pct(word, eq);
+        else if (strcmp(word, "storm") == 0)
+            cfg.storm = atoi(eq) > 0 ? atoi(eq) : 1;
+        else if (strcmp(word, "wakeup") == 0)
+            cfg.wakeup_us = strtoul(eq, NULL, 10);
+        else if (strcmp(word, "dropsignal") == 0)
+            cfg.dropsignal_pct = parse_pct(word, eq);
+        else if (strcmp(word, "seed") == 0)
+            cfg.seed = strtoul(eq, NULL, 10);
+        else
+            fprintf(stderr, "faults: ignoring unknown key '%s'\n", word);
+    }
+
+    /* The generator must not start at 0 (or a multiple of the modulus) */
+    rng = cfg.seed % 2147483647UL;
+    if (rng == 0)
+        rng = 1;
+
+    snprintf(description, sizeof(description),
+             "faults: latency=%lu partial=%d wouldblock=%d storm=%d "
+             "wakeup=%lu dropsignal=%d seed=%lu",
+             cfg.latency_us, cfg.partial_pct, cfg.wouldblock_pct,
+             cfg.storm, cfg.wakeup_us, cfg.dropsignal_pct, cfg.seed);
+    active = 1;
+    atexit(print_counts);
+}
+
+const char *faults_describe(void)
+{
+    return description;
+}
+
+void fault_latency(void)
+{
+    if (!active || !cfg.latency_us)
+        return;
+    usleep((useconds_t)cfg.latency_us);
+    __atomic_add_fetch(&counts.delayed, 1, __ATOMIC_RELAXED);
+}
+
+long fault_send_len(long len)
+{
+    long cut;
+
+    if (!active || len < 2 || !chance(cfg.partial_pct))
+        return len;
+    pthread_mutex_lock(&fault_lock);
+    cut = 1 + (long)(next_random() % (unsigned long)(len - 1));
+    counts.partial++;
+    pthread_mutex_unlock(&fault_lock);
+    return cut;
+}
+
+int fault_wouldblock(int fd)
+{
+    int flags, hit = 0;
+
+    if (!active || !cfg.wouldblock_pct)
+        return 0;
+    flags = fcntl(fd, F_GETFL);
+    if (flags < 0 || !(flags & O_NONBLOCK))
+        return 0;
+
+    pthread_mutex_lock(&fault_lock);
+    if (storm_left == 0 &&
+        (int)(next_random() % 100) < cfg.wouldblock_pct) {
+        storm_left = cfg.storm;
+        counts.storms++;
+    }
+    if (storm_left > 0) {
+        storm_left--;
+        counts.wouldblock++;
+        hit = 1;
+    }
+    pthread_mutex_unlock(&fault_lock);
+    return hit;
+}
+
+void fault_wakeup(void)
+{
+    if (!active || !cfg.wakeup_us)
+        return;
+    usleep((useconds_t)cfg.wakeup_us);
+    __atomic_add_fetch(&counts.wakeups, 1, __ATOMIC_RELAXED);
+}
+
+int fault_drop_signal(void)
+{
+    if (!active || !chance(cfg.dropsignal_pct))
+        return 0;
+    __atomic_add_fetch(&counts.dropped, 1, __ATOMIC_RELAXED);
+    return 1;
+}
@@ -0,0 +1,50 @@
+/*
+ * bsdsocktest — POSIX host fault injection
+ *
+ * The host stack is fast and well behaved; a slow or misbehaving
+ * Amiga stack is not.  When BSDSOCKTEST_FAULTS is set, the
+ * compatibility layer makes the host stack misbehave on demand, so the
+ * timeout and slow-stack paths of the suite can be exercised on Linux:
+ *
+ *   BSDSOCKTEST_FAULTS="latency=500 partial=20 wouldblock=5 storm=8
+ *                       wakeup=20000 dropsignal=10 seed=1"
+ *
+ *   latency=<us>       every socket call takes this much longer
+ *   partial=<percent>  stream sends accept only part of the buffer
+ *   wouldblock=<percent>  a non-blocking call starts an EWOULDBLOCK
+ *                      storm of 'storm' calls (default 8)
+ *   wakeup=<us>        WaitSelect() returns this much after it was woken
+ *   dropsignal=<percent>  SO_EVENTMASK events are latched but their
+ *                      signal is not sent
+ *   seed=<n>           random seed (default 1: runs are repeatable)
+ *
+ * Counts of the faults injected are printed to stderr at exit.
+ */
+
+#ifndef BSDSOCKTEST_FAULTS_H
+#define BSDSOCKTEST_FAULTS_H
+
+/* Read BSDSOCKTEST_FAULTS.  Unknown keys are reported and ignored. */
+void faults_init(void);
+
+/* Describe the active faults for the library's release string, or ""
+ * if none are active. */
+const char *faults_describe(void);
+
+/* Delay the calling socket call by the configured latency. */
+void fault_latency(void);
+
+/* Length a stream send of 'len' bytes should pass to the host. */
+long fault_send_len(long len);
+
+/* Non-zero if this call on a non-blocking host descriptor should fail
+ * with EWOULDBLOCK instead of reaching the host stack. */
+int fault_wouldblock(int fd);
+
+/* Delay a WaitSelect() that is about to return. */
+void fault_wakeup(void);
+
+/* Non-zero if an event signal should be dropped. */
+int fault_drop_signal(void);
+
+#endif /* BSDSOCKTEST_FAULTS_H */
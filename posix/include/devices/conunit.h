@@ -0,0 +1,17 @@
+/*
+ * bsdsocktest — POSIX host compatibility layer
+ *
+ * Console unit geometry (only the fields the pager reads).
+ */
+
+#ifndef DEVICES_CONUNIT_H
+#define DEVICES_CONUNIT_H
+
+#include <exec/types.h>
+
+struct ConUnit {
+    WORD cu_XMax;
+    WORD cu_YMax;
+};
+
+#endif /* DEVICES_CONUNIT_H */
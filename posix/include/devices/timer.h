@@ -0,0 +1,30 @@
+/*
+ * bsdsocktest — POSIX host compatibility layer
+ *
+ * timer.device requests. The Amiga field names map onto the host
+ * struct timeval so the same struct is shared with the socket calls.
+ */
+
+#ifndef DEVICES_TIMER_H
+#define DEVICES_TIMER_H
+
+#include <exec/exec.h>
+#include <sys/time.h>
+
+#define tv_secs  tv_sec
+#define tv_micro tv_usec
+
+#define TIMERNAME "timer.device"
+
+#define UNIT_MICROHZ 0
+#define UNIT_VBLANK  1
+
+#define TR_ADDREQUEST 9
+#define TR_GETSYSTIME 10
+
+struct timerequest {
+    struct IORequest tr_node;
+    struct timeval   tr_time;
+};
+
+#endif /* DEVICES_TIMER_H */
@@ -0,0 +1,41 @@
+/*
+ * bsdsocktest — POSIX host compatibility layer
+ *
+ * dos.library constants and argument parsing structures.
+ */
+
+#ifndef DOS_DOS_H
+#define DOS_DOS_H
+
+#include <exec/types.h>
+
+#define DOSTRUE  (-1L)
+#define DOSFALSE 0L
+
+#define RETURN_OK    0
+#define RETURN_WARN  5
+#define RETURN_ERROR 10
+#define RETURN_FAIL  20
+
+#define MODE_OLDFILE 1005
+#define MODE_NEWFILE 1006
+
+#define BADDR(x)  ((APTR)(x))
+#define MKBADDR(x) ((BPTR)(x))
+
+struct CSource {
+    STRPTR CS_Buffer;
+    LONG   CS_Length;
+    LONG   CS_CurChr;
+};
+
+struct RDArgs {
+    struct CSource RDA_Source;
+    APTR           RDA_DAList;
+    STRPTR         RDA_Buffer;
+    LONG           RDA_BufSiz;
+    STRPTR         RDA_ExtHelp;
+    LONG           RDA_Flags;
+};
+
+#endif /* DOS_DOS_H */
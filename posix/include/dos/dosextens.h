@@ -0,0 +1,36 @@
+/*
+ * bsdsocktest — POSIX host compatibility layer
+ *
+ * File handles and packet types. A host FileHandle wraps a Unix file
+ * descriptor in fh_Args; fh_Type (the handler port) is always NULL, so
+ * console packets such as ACTION_DISK_INFO are never sent.
+ */
+
+#ifndef DOS_DOSEXTENS_H
+#define DOS_DOSEXTENS_H
+
+#include <exec/exec.h>
+#include <dos/dos.h>
+
+struct FileHandle {
+    struct Message *fh_Link;
+    struct MsgPort *fh_Port;
+    struct MsgPort *fh_Type;
+    LONG            fh_Args;
+};
+
+struct InfoData {
+    LONG id_NumSoftErrors;
+    LONG id_UnitNumber;
+    LONG id_DiskState;
+    LONG id_NumBlocks;
+    LONG id_NumBlocksUsed;
+    LONG id_BytesPerBlock;
+    LONG id_DiskType;
+    BPTR id_VolumeNode;
+    LONG id_InUse;
+};
+
+#define ACTION_DISK_INFO 25
+
+#endif /* DOS_DOSEXTENS_H */
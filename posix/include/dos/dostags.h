@@ -0,0 +1,24 @@
+/*
+ * bsdsocktest — POSIX host compatibility layer
+ *
+ * SystemTags() and CreateNewProc() tags. The host ignores the ones it
+ * has no use for.
+ */
+
+#ifndef DOS_DOSTAGS_H
+#define DOS_DOSTAGS_H
+
+#include <exec/types.h>
+
+#define SYS_Dummy      (TAG_USER + 32)
+#define SYS_Input      (SYS_Dummy + 1)
+#define SYS_Output     (SYS_Dummy + 2)
+#define SYS_Asynch     (SYS_Dummy + 3)
+
+#define NP_Dummy       (TAG_USER + 1000)
+#define NP_StackSize   (NP_Dummy + 11)
+#define NP_Name        (NP_Dummy + 12)
+#define NP_ExitCode    (NP_Dummy + 16)
+#define NP_ExitData    (NP_Dummy + 17)
+
+#endif /* DOS_DOSTAGS_H */
@@ -0,0 +1,112 @@
+/*
+ * bsdsocktest — POSIX host compatibility layer
+ *
+ * Minimal exec.library structures: nodes, tasks, message ports and
+ * I/O requests, with just the fields the suite touches.
+ */
+
+#ifndef EXEC_EXEC_H
+#define EXEC_EXEC_H
+
+#include <exec/types.h>
+
+struct Node {
+    struct Node *ln_Succ;
+    struct Node *ln_Pred;
+    UBYTE        ln_Type;
+    BYTE         ln_Pri;
+    char        *ln_Name;
+};
+
+struct MinList {
+    struct Node *mlh_Head;
+    struct Node *mlh_Tail;
+    struct Node *mlh_TailPred;
+};
+
+struct Library {
+    struct Node lib_Node;
+    UWORD       lib_Version;
+    UWORD       lib_Revision;
+    APTR        lib_Private;    /* host: per-opener state */
+};
+
+struct Device {
+    struct Library dd_Library;
+};
+
+struct Unit {
+    ULONG unit_Flags;
+};
+
+struct Task {
+    struct Node tc_Node;
+    ULONG       tc_SigAlloc;
+    ULONG       tc_SigWait;
+    ULONG       tc_SigRecvd;
+    APTR        tc_UserData;
+    APTR        tc_Private;     /* host: wakeup pipe and lock */
+};
+
+struct Process {
+    struct Task pr_Task;
+};
+
+struct MsgPort {
+    struct Node  mp_Node;
+    UBYTE        mp_Flags;
+    UBYTE        mp_SigBit;
+    struct Task *mp_SigTask;
+    struct MinList mp_MsgList;
+};
+
+struct Message {
+    struct Node     mn_Node;
+    struct MsgPort *mn_ReplyPort;
+    UWORD           mn_Length;
+};
+
+struct IORequest {
+    struct Message io_Message;
+    struct Device *io_Device;
+    struct Unit   *io_Unit;
+    UWORD          io_Command;
+    UBYTE          io_Flags;
+    BYTE           io_Error;
+};
+
+struct IOStdReq {
+    struct Message io_Message;
+    struct Device *io_Device;
+    struct Unit   *io_Unit;
+    UWORD          io_Command;
+    UBYTE          io_Flags;
+    BYTE           io_Error;
+    ULONG          io_Actual;
+    ULONG          io_Length;
+    APTR           io_Data;
+    ULONG          io_Offset;
+};
+
+/* Signal bits (exec/tasks.h) */
+#define SIGB_ABORT      0
+#define SIGB_CHILD      1
+#define SIGB_SINGLE     4
+#define SIGBREAKB_CTRL_C 12
+#define SIGBREAKB_CTRL_D 13
+#define SIGBREAKB_CTRL_E 14
+#define SIGBREAKB_CTRL_F 15
+#define SIGBREAKF_CTRL_C (1UL << SIGBREAKB_CTRL_C)
+#define SIGBREAKF_CTRL_D (1UL << SIGBREAKB_CTRL_D)
+#define SIGBREAKF_CTRL_E (1UL << SIGBREAKB_CTRL_E)
+#define SIGBREAKF_CTRL_F (1UL << SIGBREAKB_CTRL_F)
+
+/* Message port flags */
+#define PA_SIGNAL 0
+#define PA_IGNORE 2
+
+/* I/O flags and commands */
+#define IOF_QUICK   1
+#define CMD_INVALID 0
+
+#endif /* EXEC_EXEC_H */
@@ -0,0 +1,18 @@
+/*
+ * bsdsocktest — POSIX host compatibility layer
+ *
+ * Memory attribute flags for AllocMem()/AvailMem().
+ */
+
+#ifndef EXEC_MEMORY_H
+#define EXEC_MEMORY_H
+
+#define MEMF_ANY     0UL
+#define MEMF_PUBLIC  (1UL << 0)
+#define MEMF_CHIP    (1UL << 1)
+#define MEMF_FAST    (1UL << 2)
+#define MEMF_CLEAR   (1UL << 16)
+#define MEMF_LARGEST (1UL << 17)
+#define MEMF_TOTAL   (1UL << 19)
+
+#endif /* EXEC_MEMORY_H */
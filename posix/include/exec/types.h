@@ -0,0 +1,53 @@
+/*
+ * bsdsocktest — POSIX host compatibility layer
+ *
+ * Amiga base types for the native Linux build. Sizes follow the host
+ * ABI (LONG is a C long) so that pointers survive the (ULONG) casts
+ * the suite uses for tag values.
+ */
+
+#ifndef EXEC_TYPES_H
+#define EXEC_TYPES_H
+
+#include <stddef.h>
+#include <strings.h>
+
+typedef long            LONG;
+typedef unsigned long   ULONG;
+typedef short           WORD;
+typedef unsigned short  UWORD;
+typedef signed char     BYTE;
+typedef unsigned char   UBYTE;
+typedef void           *APTR;
+typedef unsigned char  *STRPTR;
+typedef const unsigned char *CONST_STRPTR;
+typedef long            BOOL;
+typedef ULONG           Tag;
+typedef long            BPTR;
+
+#ifndef CONST
+#define CONST const
+#endif
+
+#ifndef TRUE
+#define TRUE  1
+#endif
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+/* Tag lists (utility/tagitem.h) */
+#define TAG_DONE  0UL
+#define TAG_END   0UL
+#define TAG_USER  0x80000000UL
+
+struct TagItem {
+    Tag   ti_Tag;
+    ULONG ti_Data;
+};
+
+/* libnix string helper */
+#define stricmp(a, b)     strcasecmp((a), (b))
+#define strnicmp(a, b, n) strncasecmp((a), (b), (n))
+
+#endif /* EXEC_TYPES_H */
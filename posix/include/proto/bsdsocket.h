@@ -0,0 +1,211 @@
+/*
+ * bsdsocktest — POSIX host compatibility layer
+ *
+ * bsdsocket.library on top of the host socket API. Every call is routed
+ * through the library base named by BSDSOCKET_BASE_NAME, exactly like
+ * the m68k inline stubs, so each opener gets its own descriptor table,
+ * errno pointers and signal masks.
+ *
+ * The host headers are pulled in first; the macros below then shadow
+ * the libc names for everything that includes this file.
+ */
+
+#ifndef PROTO_BSDSOCKET_H
+#define PROTO_BSDSOCKET_H
+
+#include <exec/types.h>
+#include <devices/timer.h>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <sys/ioctl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <syslog.h>
+#include <stdarg.h>
+
+#ifndef BSDSOCKET_BASE_NAME
+#define BSDSOCKET_BASE_NAME SocketBase
+#endif
+
+extern struct Library *SocketBase;
+
+/* ---- amitcp/socketbasetags.h ---- */
+
+#define SBTF_VAL  0x0000
+#define SBTF_REF  0x8000
+#define SBTB_CODE 1
+#define SBTS_CODE 0x3FFF
+#define SBTM_CODE(tag) ((((UWORD)(tag)) >> SBTB_CODE) & SBTS_CODE)
+#define SBTF_GET  0x0
+#define SBTF_SET  0x1
+
+#define SBTM_GETREF(code) \
+    (TAG_USER | SBTF_REF | (((code) & SBTS_CODE) << SBTB_CODE))
+#define SBTM_GETVAL(code) \
+    (TAG_USER | (((code) & SBTS_CODE) << SBTB_CODE))
+#define SBTM_SETREF(code) \
+    (TAG_USER | SBTF_REF | (((code) & SBTS_CODE) << SBTB_CODE) | SBTF_SET)
+#define SBTM_SETVAL(code) \
+    (TAG_USER | (((code) & SBTS_CODE) << SBTB_CODE) | SBTF_SET)
+
+#define SBTC_BREAKMASK      1
+#define SBTC_SIGIOMASK      2
+#define SBTC_SIGURGMASK     3
+#define SBTC_SIGEVENTMASK   4
+#define SBTC_ERRNO          6
+#define SBTC_HERRNO         7
+#define SBTC_DTABLESIZE     8
+#define SBTC_FDCALLBACK     9
+#define SBTC_LOGSTAT        10
+#define SBTC_LOGTAGPTR      11
+#define SBTC_LOGFACILITY    12
+#define SBTC_LOGMASK        13
+#define SBTC_ERRNOSTRPTR    14
+#define SBTC_HERRNOSTRPTR   15
+#define SBTC_IOERRNOSTRPTR  16
+#define SBTC_S2ERRNOSTRPTR  17
+#define SBTC_S2WERRNOSTRPTR 18
+#define SBTC_ERRNOBYTEPTR   21
+#define SBTC_ERRNOWORDPTR   22
+#define SBTC_ERRNOLONGPTR   24
+#define SBTC_HERRNOLONGPTR  25
+#define SBTC_RELEASESTRPTR  29
+
+/* ---- socket events (SO_EVENTMASK / GetSocketEvents) ---- */
+
+#define SO_EVENTMASK 0x2001
+
+#define FD_ACCEPT  0x01
+#define FD_CONNECT 0x02
+#define FD_OOB     0x04
+#define FD_READ    0x08
+#define FD_WRITE   0x10
+#define FD_ERROR   0x20
+#define FD_CLOSE   0x40
+
+#define UNIQUE_ID (-1)
+
+/* ---- host implementations ---- */
+
+LONG __bst_socket(struct Library *, LONG, LONG, LONG);
+LONG __bst_bind(struct Library *, LONG, const void *, LONG);
+LONG __bst_listen(struct Library *, LONG, LONG);
+LONG __bst_accept(struct Library *, LONG, void *, void *);
+LONG __bst_connect(struct Library *, LONG, const void *, LONG);
+LONG __bst_send(struct Library *, LONG, const void *, LONG, LONG);
+LONG __bst_recv(struct Library *, LONG, void *, LONG, LONG);
+LONG __bst_sendto(struct Library *, LONG, const void *, LONG, LONG,
+                  const void *, LONG);
+LONG __bst_recvfrom(struct Library *, LONG, void *, LONG, LONG,
+                    void *, void *);
+LONG __bst_sendmsg(struct Library *, LONG, const struct msghdr *, LONG);
+LONG __bst_recvmsg(struct Library *, LONG, struct msghdr *, LONG);
+LONG __bst_shutdown(struct Library *, LONG, LONG);
+LONG __bst_setsockopt(struct Library *, LONG, LONG, LONG,
+                      const void *, LONG);
+LONG __bst_getsockopt(struct Library *, LONG, LONG, LONG, void *, void *);
+LONG __bst_getsockname(struct Library *, LONG, void *, void *);
+LONG __bst_getpeername(struct Library *, LONG, void *, void *);
+LONG __bst_CloseSocket(struct Library *, LONG);
+LONG __bst_IoctlSocket(struct Library *, LONG, ULONG, APTR);
+LONG __bst_WaitSelect(struct Library *, LONG, fd_set *, fd_set *, fd_set *,
+                      struct timeval *, ULONG *);
+void __bst_SetSocketSignals(struct Library *, ULONG, ULONG, ULONG);
+LONG __bst_getdtablesize(struct Library *);
+LONG __bst_ObtainSocket(struct Library *, LONG, LONG, LONG, LONG);
+LONG __bst_ReleaseSocket(struct Library *, LONG, LONG);
+LONG __bst_ReleaseCopyOfSocket(struct Library *, LONG, LONG);
+LONG __bst_Errno(struct Library *);
+void __bst_SetErrnoPtr(struct Library *, void *, LONG);
+STRPTR __bst_Inet_NtoA(struct Library *, ULONG);
+ULONG __bst_inet_addr(struct Library *, const void *);
+ULONG __bst_Inet_LnaOf(struct Library *, ULONG);
+ULONG __bst_Inet_NetOf(struct Library *, ULONG);
+ULONG __bst_Inet_MakeAddr(struct Library *, ULONG, ULONG);
+ULONG __bst_inet_network(struct Library *, const void *);
+struct hostent *__bst_gethostbyname(struct Library *, const void *);
+struct hostent *__bst_gethostbyaddr(struct Library *, const void *,
+                                    LONG, LONG);
+struct netent *__bst_getnetbyname(struct Library *, const void *);
+struct netent *__bst_getnetbyaddr(struct Library *, ULONG, LONG);
+struct servent *__bst_getservbyname(struct Library *, const void *,
+                                    const void *);
+struct servent *__bst_getservbyport(struct Library *, LONG, const void *);
+struct protoent *__bst_getprotobyname(struct Library *, const void *);
+struct protoent *__bst_getprotobynumber(struct Library *, LONG);
+void __bst_vsyslog(struct Library *, ULONG, const void *, APTR);
+LONG __bst_Dup2Socket(struct Library *, LONG, LONG);
+LONG __bst_gethostname(struct Library *, void *, LONG);
+ULONG __bst_gethostid(struct Library *);
+LONG __bst_SocketBaseTagList(struct Library *, struct TagItem *);
+LONG __bst_SocketBaseTags(struct Library *, ...);
+LONG __bst_GetSocketEvents(struct Library *, ULONG *);
+
+/* compat.c implements the calls and must see the host names */
+#ifndef BST_COMPAT_IMPL
+
+#define socket(d, t, p)          __bst_socket(BSDSOCKET_BASE_NAME, d, t, p)
+#define bind(s, a, l)            __bst_bind(BSDSOCKET_BASE_NAME, s, a, l)
+#define listen(s, b)             __bst_listen(BSDSOCKET_BASE_NAME, s, b)
+#define accept(s, a, l)          __bst_accept(BSDSOCKET_BASE_NAME, s, a, l)
+#define connect(s, a, l)         __bst_connect(BSDSOCKET_BASE_NAME, s, a, l)
+#define send(s, b, l, f)         __bst_send(BSDSOCKET_BASE_NAME, s, b, l, f)
+#define recv(s, b, l, f)         __bst_recv(BSDSOCKET_BASE_NAME, s, b, l, f)
+#define sendto(s, b, l, f, a, al) \
+    __bst_sendto(BSDSOCKET_BASE_NAME, s, b, l, f, a, al)
+#define recvfrom(s, b, l, f, a, al) \
+    __bst_recvfrom(BSDSOCKET_BASE_NAME, s, b, l, f, a, al)
+#define sendmsg(s, m, f)         __bst_sendmsg(BSDSOCKET_BASE_NAME, s, m, f)
+#define recvmsg(s, m, f)         __bst_recvmsg(BSDSOCKET_BASE_NAME, s, m, f)
+#define shutdown(s, h)           __bst_shutdown(BSDSOCKET_BASE_NAME, s, h)
+#define setsockopt(s, l, o, v, n) \
+    __bst_setsockopt(BSDSOCKET_BASE_NAME, s, l, o, v, n)
+#define getsockopt(s, l, o, v, n) \
+    __bst_getsockopt(BSDSOCKET_BASE_NAME, s, l, o, v, n)
+#define getsockname(s, a, l)     __bst_getsockname(BSDSOCKET_BASE_NAME, s, a, l)
+#define getpeername(s, a, l)     __bst_getpeername(BSDSOCKET_BASE_NAME, s, a, l)
+#define CloseSocket(s)           __bst_CloseSocket(BSDSOCKET_BASE_NAME, s)
+#define IoctlSocket(s, r, a)     __bst_IoctlSocket(BSDSOCKET_BASE_NAME, s, r, a)
+#define WaitSelect(n, r, w, e, t, m) \
+    __bst_WaitSelect(BSDSOCKET_BASE_NAME, n, r, w, e, t, m)
+#define SetSocketSignals(i, o, u) \
+    __bst_SetSocketSignals(BSDSOCKET_BASE_NAME, i, o, u)
+#define getdtablesize()          __bst_getdtablesize(BSDSOCKET_BASE_NAME)
+#define ObtainSocket(i, d, t, p) \
+    __bst_ObtainSocket(BSDSOCKET_BASE_NAME, i, d, t, p)
+#define ReleaseSocket(s, i)      __bst_ReleaseSocket(BSDSOCKET_BASE_NAME, s, i)
+#define ReleaseCopyOfSocket(s, i) \
+    __bst_ReleaseCopyOfSocket(BSDSOCKET_BASE_NAME, s, i)
+#define Errno()                  __bst_Errno(BSDSOCKET_BASE_NAME)
+#define SetErrnoPtr(p, s)        __bst_SetErrnoPtr(BSDSOCKET_BASE_NAME, p, s)
+#define Inet_NtoA(a)             __bst_Inet_NtoA(BSDSOCKET_BASE_NAME, a)
+#define inet_addr(c)             __bst_inet_addr(BSDSOCKET_BASE_NAME, c)
+#define Inet_LnaOf(a)            __bst_Inet_LnaOf(BSDSOCKET_BASE_NAME, a)
+#define Inet_NetOf(a)            __bst_Inet_NetOf(BSDSOCKET_BASE_NAME, a)
+#define Inet_MakeAddr(n, h)      __bst_Inet_MakeAddr(BSDSOCKET_BASE_NAME, n, h)
+#define inet_network(c)          __bst_inet_network(BSDSOCKET_BASE_NAME, c)
+#define gethostbyname(n)         __bst_gethostbyname(BSDSOCKET_BASE_NAME, n)
+#define gethostbyaddr(a, l, t) \
+    __bst_gethostbyaddr(BSDSOCKET_BASE_NAME, a, l, t)
+#define getnetbyname(n)          __bst_getnetbyname(BSDSOCKET_BASE_NAME, n)
+#define getnetbyaddr(n, t)       __bst_getnetbyaddr(BSDSOCKET_BASE_NAME, n, t)
+#define getservbyname(n, p)      __bst_getservbyname(BSDSOCKET_BASE_NAME, n, p)
+#define getservbyport(n, p)      __bst_getservbyport(BSDSOCKET_BASE_NAME, n, p)
+#define getprotobyname(n)        __bst_getprotobyname(BSDSOCKET_BASE_NAME, n)
+#define getprotobynumber(n)      __bst_getprotobynumber(BSDSOCKET_BASE_NAME, n)
+#define vsyslog(l, f, a)         __bst_vsyslog(BSDSOCKET_BASE_NAME, l, f, a)
+#define Dup2Socket(o, n)         __bst_Dup2Socket(BSDSOCKET_BASE_NAME, o, n)
+#define gethostname(n, l)        __bst_gethostname(BSDSOCKET_BASE_NAME, n, l)
+#define gethostid()              __bst_gethostid(BSDSOCKET_BASE_NAME)
+#define SocketBaseTagList(t)     __bst_SocketBaseTagList(BSDSOCKET_BASE_NAME, t)
+#define SocketBaseTags(...) \
+    __bst_SocketBaseTags(BSDSOCKET_BASE_NAME, __VA_ARGS__)
+#define GetSocketEvents(m)       __bst_GetSocketEvents(BSDSOCKET_BASE_NAME, m)
+
+#endif /* BST_COMPAT_IMPL */
+
+#endif /* PROTO_BSDSOCKET_H */
@@ -0,0 +1,38 @@
+/*
+ * bsdsocktest — POSIX host compatibility layer
+ *
+ * dos.library entry points. ReadArgs() parses the process command line
+ * (or RDA_Source when supplied) against a standard AmigaDOS template.
+ */
+
+#ifndef PROTO_DOS_H
+#define PROTO_DOS_H
+
+#include <exec/types.h>
+#include <dos/dos.h>
+#include <dos/dosextens.h>
+
+struct RDArgs *ReadArgs(CONST_STRPTR arg_template, LONG *array,
+                        struct RDArgs *args);
+void FreeArgs(struct RDArgs *args);
+
+BPTR Input(void);
+BPTR Output(void);
+LONG IsInteractive(BPTR file);
+LONG SetMode(BPTR fh, LONG mode);
+LONG Read(BPTR file, APTR buffer, LONG length);
+LONG DoPkt(struct MsgPort *port, LONG action, LONG arg1, LONG arg2,
+           LONG arg3, LONG arg4, LONG arg5);
+BPTR CurrentDir(BPTR lock);
+void Delay(LONG ticks);
+
+BPTR Open(CONST_STRPTR name, LONG mode);
+LONG Close(BPTR file);
+LONG DeleteFile(CONST_STRPTR name);
+BOOL GetProgramName(STRPTR buf, LONG len);
+STRPTR FilePart(CONST_STRPTR path);
+BOOL AddPart(STRPTR dirname, CONST_STRPTR filename, ULONG size);
+LONG SystemTagList(CONST_STRPTR command, const struct TagItem *tags);
+LONG SystemTags(CONST_STRPTR command, Tag tag1, ...);
+
+#endif /* PROTO_DOS_H */
@@ -0,0 +1,53 @@
+/*
+ * bsdsocktest — POSIX host compatibility layer
+ *
+ * exec.library entry points implemented on top of libc and pthreads.
+ * Task signals are emulated per thread; Signal() also wakes a blocked
+ * WaitSelect() in the target task.
+ */
+
+#ifndef PROTO_EXEC_H
+#define PROTO_EXEC_H
+
+#include <exec/types.h>
+#include <exec/exec.h>
+#include <exec/memory.h>
+
+struct Task *FindTask(CONST_STRPTR name);
+ULONG SetSignal(ULONG new_signals, ULONG signal_mask);
+void Signal(struct Task *task, ULONG signals);
+ULONG Wait(ULONG signal_set);
+BYTE AllocSignal(LONG signal_num);
+void FreeSignal(LONG signal_num);
+
+APTR AllocMem(ULONG size, ULONG attributes);
+void FreeMem(APTR memory, ULONG size);
+APTR AllocVec(ULONG size, ULONG attributes);
+void FreeVec(APTR memory);
+ULONG AvailMem(ULONG attributes);
+
+void Forbid(void);
+void Permit(void);
+
+struct Library *OpenLibrary(CONST_STRPTR name, ULONG version);
+void CloseLibrary(struct Library *library);
+
+struct MsgPort *CreateMsgPort(void);
+void DeleteMsgPort(struct MsgPort *port);
+struct Message *GetMsg(struct MsgPort *port);
+void PutMsg(struct MsgPort *port, struct Message *message);
+void ReplyMsg(struct Message *message);
+struct Message *WaitPort(struct MsgPort *port);
+
+APTR CreateIORequest(struct MsgPort *port, ULONG size);
+void DeleteIORequest(APTR iorequest);
+BYTE OpenDevice(CONST_STRPTR dev_name, ULONG unit,
+                struct IORequest *iorequest, ULONG flags);
+void CloseDevice(struct IORequest *iorequest);
+void SendIO(struct IORequest *iorequest);
+BYTE DoIO(struct IORequest *iorequest);
+struct IORequest *CheckIO(struct IORequest *iorequest);
+BYTE WaitIO(struct IORequest *iorequest);
+void AbortIO(struct IORequest *iorequest);
+
+#endif /* PROTO_EXEC_H */
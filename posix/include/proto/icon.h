@@ -0,0 +1,14 @@
+/*
+ * bsdsocktest — POSIX host compatibility layer
+ */
+
+#ifndef PROTO_ICON_H
+#define PROTO_ICON_H
+
+#include <workbench/workbench.h>
+
+struct DiskObject *GetDiskObject(CONST_STRPTR name);
+void FreeDiskObject(struct DiskObject *diskobj);
+UBYTE *FindToolType(CONST_STRPTR *tool_type_array, CONST_STRPTR type_name);
+
+#endif /* PROTO_ICON_H */
@@ -0,0 +1,12 @@
+/*
+ * bsdsocktest — POSIX host compatibility layer
+ */
+
+#ifndef PROTO_TIMER_H
+#define PROTO_TIMER_H
+
+#include <devices/timer.h>
+
+void GetSysTime(struct timeval *dest);
+
+#endif /* PROTO_TIMER_H */
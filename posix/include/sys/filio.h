@@ -0,0 +1,12 @@
+/*
+ * bsdsocktest — POSIX host compatibility layer
+ *
+ * BSD keeps the FIO* ioctls here; Linux defines them in sys/ioctl.h.
+ */
+
+#ifndef SYS_FILIO_H
+#define SYS_FILIO_H
+
+#include <sys/ioctl.h>
+
+#endif /* SYS_FILIO_H */
@@ -0,0 +1,28 @@
+/*
+ * bsdsocktest — POSIX host compatibility layer
+ *
+ * Workbench startup message. The host build is always started from a
+ * shell (argc > 0), so these are never populated.
+ */
+
+#ifndef WORKBENCH_STARTUP_H
+#define WORKBENCH_STARTUP_H
+
+#include <exec/exec.h>
+#include <workbench/workbench.h>
+
+struct WBArg {
+    BPTR   wa_Lock;
+    STRPTR wa_Name;
+};
+
+struct WBStartup {
+    struct Message sm_Message;
+    struct MsgPort *sm_Process;
+    BPTR           sm_Segment;
+    LONG           sm_NumArgs;
+    char          *sm_ToolWindow;
+    struct WBArg  *sm_ArgList;
+};
+
+#endif /* WORKBENCH_STARTUP_H */
@@ -0,0 +1,14 @@
+/*
+ * bsdsocktest — POSIX host compatibility layer
+ */
+
+#ifndef WORKBENCH_WORKBENCH_H
+#define WORKBENCH_WORKBENCH_H
+
+#include <exec/types.h>
+
+struct DiskObject {
+    STRPTR *do_ToolTypes;
+};
+
+#endif /* WORKBENCH_WORKBENCH_H */
@@ -13,12 +13,20 @@
 
 #include <netinet/in.h>
 #include <netdb.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 /* Internal state */
 static LONG ctrl_fd = -1;
 static struct sockaddr_in resolved_addr;
 static int connected = 0;
+static int port_shift = 0;      /* private service block offset */
+
+/* STREAM: LOG lines waiting to be sent */
+static int stream_open = 0;
+static char stream_buf[1024];
+static int stream_len = 0;
 
 /* Read a line from the control socket.
  * Strips trailing \r and \n.
@@ -42,6 +50,24 @@ static int recv_line(LONG fd, char *buf, int buflen)
     return pos;
 }
 
+/* Parse up to 'max' whitespace-separated unsigned numbers following
+ * a keyword.  Returns the count parsed. */
+static int parse_counts(const char *p, unsigned long *vals, int max)
+{
+    char *end;
+    int n = 0;
+
+    while (n < max) {
+        while (*p == ' ')
+            p++;
+        if (*p < '0' || *p > '9')
+            break;
+        vals[n++] = strtoul(p, &end, 10);
+        p = end;
+    }
+    return n;
+}
+
 int helper_connect(const char *host)
 {
     LONG fd;
@@ -112,6 +138,26 @@ int helper_connect(const char *host)
 
     ctrl_fd = fd;
     connected = 1;
+
+    /* Ask for a private service block.  A helper that predates SESSION
+     * answers FAIL, and so does one with no free blocks; either way the
+     * shared default ports still work. */
+    port_shift = 0;
+    if (send(fd, "SESSION\n", 8, 0) == 8 &&
+        recv_line(fd, line, sizeof(line)) > 0) {
+        unsigned long v[2];
+
+        if (strncmp(line, "SESSION ", 8) == 0 &&
+            parse_counts(line + 8, v, 2) == 2 &&
+            v[1] > HELPER_CTRL_PORT && v[1] < 65536UL - 16) {
+            port_shift = (int)v[1] - HELPER_CTRL_PORT;
+            tap_diagf("helper session %lu: services at ports %d-%d",
+                      v[0], helper_port(HELPER_TCP_ECHO),
+                      helper_port(HELPER_UDP_TIME));
+        } else {
+            tap_diagf("helper session: \"%s\", using shared ports", line);
+        }
+    }
     return 1;
 }
 
@@ -125,6 +171,11 @@ unsigned long helper_addr(void)
     return resolved_addr.sin_addr.s_addr;
 }
 
+int helper_port(int service)
+{
+    return service + port_shift;
+}
+
 long helper_connect_service(int port)
 {
     LONG fd;
@@ -138,11 +189,11 @@ long helper_connect_service(int port)
         return -1;
 
     memcpy(&svc_addr, &resolved_addr, sizeof(svc_addr));
-    svc_addr.sin_port = htons(port);
+    svc_addr.sin_port = htons(helper_port(port));
 
     if (connect(fd, (struct sockaddr *)&svc_addr, sizeof(svc_addr)) < 0) {
         tap_diagf("  helper_connect_service(%d): errno=%ld",
-                  port, (long)get_bsd_errno());
+                  helper_port(port), (long)get_bsd_errno());
         safe_close(fd);
         return -1;
     }
@@ -170,13 +221,346 @@ int helper_request_connect(int amiga_port)
     return (strcmp(line, "GO") == 0);
 }
 
+int helper_impair(const char *spec)
+{
+    char cmd[256];
+    char line[96];
+    int len, rc;
+
+    if (!connected)
+        return 0;
+
+    if (strlen(spec) > sizeof(cmd) - 9) {
+        tap_diag("  helper_impair: specification too long");
+        return 0;
+    }
+
+    len = sprintf(cmd, "IMPAIR %s\n", spec);
+    if (send(ctrl_fd, cmd, len, 0) != len)
+        return 0;
+
+    rc = recv_line(ctrl_fd, line, sizeof(line));
+    if (rc <= 0)
+        return 0;
+
+    if (strcmp(line, "OK") != 0) {
+        tap_diagf("  helper_impair: \"%s\"", line);
+        return 0;
+    }
+    return 1;
+}
+
+int helper_udp_stats(unsigned long run_id, unsigned long sent,
+                     struct helper_udp_stats *stats)
+{
+    char cmd[48];
+    char line[96];
+    unsigned long v[6];
+    int len, rc;
+
+    if (!connected)
+        return 0;
+
+    /* The sink cannot see datagrams lost after the last it received:
+     * tell it how many were sent */
+    len = sprintf(cmd, "UDPSTATS %lu %lu\n", run_id, sent);
+    if (send(ctrl_fd, cmd, len, 0) != len)
+        return 0;
+
+    rc = recv_line(ctrl_fd, line, sizeof(line));
+    if (rc <= 0 || strncmp(line, "STATS ", 6) != 0 ||
+        parse_counts(line + 6, v, 6) != 6) {
+        tap_diagf("  helper_udp_stats: unexpected reply \"%s\"",
+                  rc > 0 ? line : "");
+        return 0;
+    }
+
+    stats->received = v[0];
+    stats->lost = v[1];
+    stats->reordered = v[2];
+    stats->duplicates = v[3];
+    stats->bytes = v[4];
+    stats->elapsed_ms = v[5];
+    stats->intervals = 0;
+
+    /* Per-interval lines, then END */
+    for (;;) {
+        rc = recv_line(ctrl_fd, line, sizeof(line));
+        if (rc <= 0)
+            return 0;
+        if (strcmp(line, "END") == 0)
+            break;
+        if (strncmp(line, "INTERVAL ", 9) == 0 &&
+            parse_counts(line + 9, v, 5) == 5 &&
+            stats->intervals < HELPER_MAX_INTERVALS) {
+            struct helper_udp_interval *iv;
+
+            iv = &stats->interval[stats->intervals++];
+            iv->received = v[1];
+            iv->lost = v[2];
+            iv->reordered = v[3];
+            iv->duplicates = v[4];
+        }
+    }
+    return 1;
+}
+
+int helper_udp_blast(int amiga_port, int count, int size, int rate,
+                     unsigned long run_id)
+{
+    char cmd[64];
+    char line[64];
+    int len, rc;
+
+    if (!connected)
+        return 0;
+
+    len = sprintf(cmd, "BLAST %d %d %d %d %lu\n",
+                  amiga_port, count, size, rate, run_id);
+    if (send(ctrl_fd, cmd, len, 0) != len)
+        return 0;
+
+    rc = recv_line(ctrl_fd, line, sizeof(line));
+    if (rc <= 0)
+        return 0;
+
+    return (strcmp(line, "GO") == 0);
+}
+
+int helper_udp_blast_done(unsigned long *sent, unsigned long *elapsed_ms)
+{
+    char line[64];
+    unsigned long v[2];
+    int rc;
+
+    if (!connected)
+        return 0;
+
+    rc = recv_line(ctrl_fd, line, sizeof(line));
+    if (rc <= 0 || strncmp(line, "DONE ", 5) != 0 ||
+        parse_counts(line + 5, v, 2) != 2)
+        return 0;
+
+    *sent = v[0];
+    *elapsed_ms = v[1];
+    return 1;
+}
+
+int helper_load(const char *mode, int amiga_port, int conns, int rate,
+                int count, int size)
+{
+    char cmd[80];
+    char line[64];
+    int len, rc;
+
+    if (!connected)
+        return 0;
+
+    len = sprintf(cmd, "LOAD %s %d %d %d %d %d\n",
+                  mode, amiga_port, conns, rate, count, size);
+    if (send(ctrl_fd, cmd, len, 0) != len)
+        return 0;
+
+    rc = recv_line(ctrl_fd, line, sizeof(line));
+    if (rc <= 0)
+        return 0;
+
+    return (strcmp(line, "GO") == 0);
+}
+
+int helper_flood(int amiga_port, int conns, int rate)
+{
+    char cmd[64];
+    char line[64];
+    int len, rc;
+
+    if (!connected)
+        return 0;
+
+    len = sprintf(cmd, "FLOOD %d %d %d\n", amiga_port, conns, rate);
+    if (send(ctrl_fd, cmd, len, 0) != len)
+        return 0;
+
+    rc = recv_line(ctrl_fd, line, sizeof(line));
+    if (rc <= 0)
+        return 0;
+
+    return (strcmp(line, "GO") == 0);
+}
+
+int helper_replay(int udp, const long *expect, const long *answer,
+                  int steps)
+{
+    char cmd[512];
+    char line[64];
+    int len, rc, i;
+
+    if (!connected)
+        return 0;
+
+    /* STEP lines go out in batches; the helper answers after the last */
+    len = sprintf(cmd, "REPLAY %s %d\n", udp ? "udp" : "tcp", steps);
+    for (i = 0; i < steps; i++) {
+        if (len > (int)sizeof(cmd) - 32) {
+            if (send(ctrl_fd, cmd, len, 0) != len)
+                return 0;
+            len = 0;
+        }
+        len += sprintf(cmd + len, "STEP %ld %ld\n", expect[i], answer[i]);
+    }
+    if (send(ctrl_fd, cmd, len, 0) != len)
+        return 0;
+
+    rc = recv_line(ctrl_fd, line, sizeof(line));
+    if (rc <= 0)
+        return 0;
+    if (strncmp(line, "PORT ", 5) != 0) {
+        tap_diagf("  helper_replay: unexpected reply \"%s\"", line);
+        return 0;
+    }
+    return atoi(line + 5);
+}
+
+int helper_load_done(struct helper_load_result *res)
+{
+    static const char *const keys[] = {
+        "ok", "failed", "refused", "timeout", "bad", "bytes", "ms",
+        "conn_p50", "conn_p90", "conn_max",
+        "rt_p50", "rt_p90", "rt_p99", "rt_max"
+    };
+    unsigned long *fields[14];
+    char line[256];
+    const char *p;
+    int rc, i, found;
+    size_t klen;
+
+    if (!connected)
+        return 0;
+
+    rc = recv_line(ctrl_fd, line, sizeof(line));
+    if (rc <= 0 || strncmp(line, "RESULT ", 7) != 0) {
+        if (rc > 0)
+            tap_diagf("  helper_load_done: unexpected reply \"%s\"", line);
+        return 0;
+    }
+
+    fields[0] = &res->ok;
+    fields[1] = &res->failed;
+    fields[2] = &res->refused;
+    fields[3] = &res->timeout;
+    fields[4] = &res->bad;
+    fields[5] = &res->bytes;
+    fields[6] = &res->elapsed_ms;
+    fields[7] = &res->conn_p50;
+    fields[8] = &res->conn_p90;
+    fields[9] = &res->conn_max;
+    fields[10] = &res->rt_p50;
+    fields[11] = &res->rt_p90;
+    fields[12] = &res->rt_p99;
+    fields[13] = &res->rt_max;
+    memset(res, 0, sizeof(*res));
+
+    /* key=value tokens; unknown keys are skipped */
+    found = 0;
+    p = line + 7;
+    while (*p) {
+        while (*p == ' ')
+            p++;
+        for (i = 0; i < 14; i++) {
+            klen = strlen(keys[i]);
+            if (strncmp(p, keys[i], klen) == 0 && p[klen] == '=') {
+                *fields[i] = strtoul(p + klen + 1, NULL, 10);
+                found++;
+                break;
+            }
+        }
+        while (*p && *p != ' ')
+            p++;
+    }
+    return found > 0;
+}
+
+int helper_stream_open(void)
+{
+    char line[160];
+    int rc;
+
+    if (!connected)
+        return 0;
+
+    if (send(ctrl_fd, "STREAM\n", 7, 0) != 7)
+        return 0;
+
+    rc = recv_line(ctrl_fd, line, sizeof(line));
+    if (rc <= 0 || strncmp(line, "OK", 2) != 0) {
+        tap_diagf("  helper_stream_open: \"%s\"", rc > 0 ? line : "");
+        return 0;
+    }
+
+    tap_diagf("helper stream: %s", line[2] ? line + 3 : "(no file name)");
+    stream_open = 1;
+    stream_len = 0;
+    return 1;
+}
+
+void helper_stream_line(const char *line)
+{
+    int len;
+
+    if (!stream_open)
+        return;
+
+    /* "LOG " + line + "\n" must fit an empty queue */
+    len = strlen(line);
+    if (len > (int)sizeof(stream_buf) - 6)
+        len = sizeof(stream_buf) - 6;
+    if (stream_len + len + 5 > (int)sizeof(stream_buf) &&
+        !helper_stream_flush())
+        return;
+
+    memcpy(stream_buf + stream_len, "LOG ", 4);
+    memcpy(stream_buf + stream_len + 4, line, len);
+    stream_len += len + 4;
+    stream_buf[stream_len++] = '\n';
+}
+
+int helper_stream_flush(void)
+{
+    LONG n;
+    int pos = 0;
+
+    if (!stream_open)
+        return 0;
+
+    while (pos < stream_len) {
+        n = send(ctrl_fd, stream_buf + pos, stream_len - pos, 0);
+        if (n <= 0) {
+            stream_open = 0;
+            stream_len = 0;
+            return 0;
+        }
+        pos += n;
+    }
+    stream_len = 0;
+    return 1;
+}
+
+long helper_ctrl_socket(void)
+{
+    return connected ? ctrl_fd : -1;
+}
+
 void helper_quit(void)
 {
     if (connected) {
+        helper_stream_flush();
         /* Fire-and-forget — ignore send failure */
         send(ctrl_fd, "QUIT\n", 5, 0);
         safe_close(ctrl_fd);
     }
     ctrl_fd = -1;
     connected = 0;
+    port_shift = 0;
+    stream_open = 0;
+    stream_len = 0;
 }
@@ -2,7 +2,15 @@
  * bsdsocktest — Host helper protocol
  *
  * Communication with the Python host helper script.
- * Control channel protocol: line-based text (CONNECT/GO/QUIT).
+ * Control channel protocol: line-based text (CONNECT/GO/QUIT,
+ * SESSION, BLAST/DONE, UDPSTATS/STATS, IMPAIR, LOAD/FLOOD/RESULT,
+ * REPLAY/STEP/PORT, STREAM/LOG).
+ *
+ * Several Amigas may share one helper.  On connect we ask for a
+ * session; the helper answers with a private block of service ports
+ * (same layout as HELPER_TCP_ECHO..HELPER_UDP_TIME, shifted by a
+ * per-session offset) so concurrent runs cannot mix statistics.  Older
+ * helpers without SESSION leave us on the shared default ports.
  */
 
 #ifndef HELPER_PROTO_H
@@ -14,6 +22,58 @@
 #define HELPER_UDP_ECHO     8702
 #define HELPER_TCP_SINK     8703
 #define HELPER_TCP_SOURCE   8704
+#define HELPER_UDP_SINK     8705
+#define HELPER_UDP_BLAST    8706
+#define HELPER_UDP_TIME     8707
+
+/* Datagrams exchanged with the UDP sink and blaster start with a
+ * sequence header: 4-byte sequence number then 4-byte run id, both
+ * big-endian.  The run id separates one test's datagrams from
+ * stragglers of an earlier run. */
+#define HELPER_SEQ_HDR_SIZE 8
+
+/* The UDP timestamp service returns the first HELPER_TS_REQ_SIZE bytes
+ * of a request unchanged, followed by the helper's receive time and
+ * send time (4-byte seconds, 4-byte microseconds each, big-endian) on
+ * its own monotonic clock. */
+#define HELPER_TS_REQ_SIZE   16
+#define HELPER_TS_REPLY_SIZE 32
+
+/* UDP sink accounting for one run, as reported by UDPSTATS.
+ * Per-second intervals beyond HELPER_MAX_INTERVALS are dropped. */
+#define HELPER_MAX_INTERVALS 16
+
+struct helper_udp_interval {
+    unsigned long received;
+    unsigned long lost;
+    unsigned long reordered;
+    unsigned long duplicates;
+};
+
+struct helper_udp_stats {
+    unsigned long received;     /* unique datagrams */
+    unsigned long lost;         /* of the datagrams sent */
+    unsigned long reordered;    /* arrived below the highest seen */
+    unsigned long duplicates;   /* sequence number already seen */
+    unsigned long bytes;        /* unique datagram bytes */
+    unsigned long elapsed_ms;   /* first to last arrival */
+    int intervals;
+    struct helper_udp_interval interval[HELPER_MAX_INTERVALS];
+};
+
+/* Outcome of a LOAD or FLOOD run, as reported on the RESULT line.
+ * Times are microseconds measured by the helper. */
+struct helper_load_result {
+    unsigned long ok;           /* connections that completed their work */
+    unsigned long failed;       /* reset, closed early or connect error */
+    unsigned long refused;      /* connect() refused */
+    unsigned long timeout;      /* unfinished at the helper's deadline */
+    unsigned long bad;          /* echo reply did not match the request */
+    unsigned long bytes;        /* echoed or sunk payload bytes */
+    unsigned long elapsed_ms;   /* first connect to last completion */
+    unsigned long conn_p50, conn_p90, conn_max;     /* connect latency */
+    unsigned long rt_p50, rt_p90, rt_p99, rt_max;   /* response time */
+};
 
 /* Connect to helper's control channel.
  * host: IP address or hostname of the helper.
@@ -27,7 +87,12 @@ int helper_is_connected(void);
  * Only valid after successful helper_connect(). */
 unsigned long helper_addr(void);
 
-/* Connect to a helper TCP service port.
+/* Map a HELPER_* service port to the port serving this session.
+ * Returns the default port if no private block was granted. */
+int helper_port(int service);
+
+/* Connect to a helper TCP service (HELPER_* constant; mapped through
+ * helper_port()).
  * Returns socket fd on success, -1 on failure. */
 long helper_connect_service(int port);
 
@@ -36,6 +101,80 @@ long helper_connect_service(int port);
  * Returns 1 if helper acknowledged (GO), 0 on failure. */
 int helper_request_connect(int amiga_port);
 
+/* Configure link impairment on helper services (IMPAIR command).
+ * spec is "<service|all> key=value..." or "<service|all> off", with
+ * keys delay, jitter (ms), loss (%), rate (KB/s).
+ * Returns 1 if the helper accepted it, 0 on failure (reason logged). */
+int helper_impair(const char *spec);
+
+/* Fetch the UDP sink's accounting for a run of 'sent' datagrams
+ * (UDPSTATS command).  Returns 1 on success, 0 on failure. */
+int helper_udp_stats(unsigned long run_id, unsigned long sent,
+                     struct helper_udp_stats *stats);
+
+/* Ask the helper to send 'count' sequence-numbered datagrams of 'size'
+ * bytes to the Amiga's UDP port at 'rate' datagrams/s (0 = unpaced).
+ * The helper starts sending 500ms after acknowledging.
+ * Returns 1 if helper acknowledged (GO), 0 on failure. */
+int helper_udp_blast(int amiga_port, int count, int size, int rate,
+                     unsigned long run_id);
+
+/* Wait for the helper's DONE line after a BLAST.
+ * Returns 1 and fills the datagram count and helper-side send time,
+ * or 0 on failure. */
+int helper_udp_blast_done(unsigned long *sent, unsigned long *elapsed_ms);
+
+/* Ask the helper to load a server on the Amiga's TCP port (LOAD
+ * command): 'conns' client connections opened at 'rate' connections/s
+ * (0 = all at once), starting 500ms after acknowledging.  mode "echo":
+ * each client does 'count' round trips of 'size' bytes and checks the
+ * replies; mode "sink": each client sends count * size bytes, then
+ * waits for the Amiga to close.
+ * Returns 1 if helper acknowledged (GO), 0 on failure. */
+int helper_load(const char *mode, int amiga_port, int conns, int rate,
+                int count, int size);
+
+/* Ask the helper to open 'conns' connections to the Amiga's TCP port
+ * (FLOOD command), all at once or at 'rate' connections/s, starting
+ * 500ms after acknowledging.  Nothing is sent on them; established
+ * connections are held open until the helper reports.  Connections
+ * still pending 3s after the last was opened count as timed out.
+ * Returns 1 if helper acknowledged (GO), 0 on failure. */
+int helper_flood(int amiga_port, int conns, int rate);
+
+/* Wait for the helper's RESULT line after a LOAD or FLOOD.  Call once the
+ * control socket is readable; the helper gives up on a run after 30s.
+ * Returns 1 and fills 'res', or 0 on failure. */
+int helper_load_done(struct helper_load_result *res);
+
+/* Set up the remote end of one replayed connection (REPLAY command).
+ * Step i waits for expect[i] more bytes from the Amiga, then answers
+ * with answer[i] bytes (one datagram if 'udp').  The helper listens on
+ * a port of its own for one connection (TCP) or sender (UDP) and
+ * closes it after 30s without traffic.
+ * Returns that port, or 0 on failure. */
+int helper_replay(int udp, const long *expect, const long *answer,
+                  int steps);
+
+/* Control channel socket, for WaitSelect() while serving a LOAD run.
+ * Returns -1 if not connected. */
+long helper_ctrl_socket(void);
+
+/* Ask the helper to record this session's log (STREAM command).  The
+ * helper appends every following LOG line to a file of its own, so
+ * results survive a guest crash.
+ * Returns 1 if the helper opened the file, 0 on failure. */
+int helper_stream_open(void);
+
+/* Queue one log line (without newline) as a LOG command.  Lines are
+ * not answered; queued lines go out when the queue fills or on
+ * helper_stream_flush().  Does nothing unless the stream is open. */
+void helper_stream_line(const char *line);
+
+/* Send queued LOG lines.  Returns 1 on success, 0 if the stream is
+ * not open or the send failed (which closes it). */
+int helper_stream_flush(void);
+
 /* Disconnect from helper. Safe to call if not connected. */
 void helper_quit(void);
 
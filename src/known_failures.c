@@ -4,8 +4,10 @@
  * Auto-detects the running stack from SBTC_RELEASESTRPTR and looks up
  * known issues in a per-stack table.
  *
- * Two types of entries:
+ * Three types of entries:
  *   KNOWN_FAILURE — test runs and fails; framework annotates as "known"
+ *   KNOWN_HANG    — test blocks forever; runs under a short watchdog,
+ *                   and the resulting failure is annotated as "known"
  *   KNOWN_CRASH   — test would crash the emulator; must be skipped
  *
  * Matching: the detected version string (e.g. "UAE 8.0.0") is compared
@@ -23,6 +25,7 @@
 
 enum known_type {
     KNOWN_FAILURE,  /* test runs, fails — annotated as known */
+    KNOWN_HANG,     /* test runs until the watchdog interrupts it */
     KNOWN_CRASH     /* test skipped — would crash emulator */
 };
 
@@ -100,15 +103,16 @@ static const struct known_entry amiberry_711_entries[] = {
 
 static const struct known_entry winuae_entries[] = {
     /* Hangs: SO_EVENTMASK sets up but signal never fires; WaitSelect
-       blocks forever instead of honoring timeout when sigmask is set */
-    { 79, KNOWN_CRASH,   "SO_EVENTMASK hangs (signal never delivered)" },
-    { 80, KNOWN_CRASH,   "SO_EVENTMASK hangs (signal never delivered)" },
-    { 81, KNOWN_CRASH,   "SO_EVENTMASK hangs (signal never delivered)" },
-    { 82, KNOWN_CRASH,   "SO_EVENTMASK hangs (signal never delivered)" },
-    { 83, KNOWN_CRASH,   "SO_EVENTMASK hangs (signal never delivered)" },
-    { 84, KNOWN_CRASH,   "SO_EVENTMASK hangs (signal never delivered)" },
-    { 85, KNOWN_CRASH,   "SO_EVENTMASK hangs (signal never delivered)" },
-    { 87, KNOWN_CRASH,   "SO_EVENTMASK hangs (signal never delivered)" },
+       blocks forever instead of honoring timeout when sigmask is set,
+       until the watchdog breaks it */
+    { 79, KNOWN_HANG,    "SO_EVENTMASK hangs (signal never delivered)" },
+    { 80, KNOWN_HANG,    "SO_EVENTMASK hangs (signal never delivered)" },
+    { 81, KNOWN_HANG,    "SO_EVENTMASK hangs (signal never delivered)" },
+    { 82, KNOWN_HANG,    "SO_EVENTMASK hangs (signal never delivered)" },
+    { 83, KNOWN_HANG,    "SO_EVENTMASK hangs (signal never delivered)" },
+    { 84, KNOWN_HANG,    "SO_EVENTMASK hangs (signal never delivered)" },
+    { 85, KNOWN_HANG,    "SO_EVENTMASK hangs (signal never delivered)" },
+    { 87, KNOWN_HANG,    "SO_EVENTMASK hangs (signal never delivered)" },
     /* Failures: tests run but produce wrong results */
     { 35, KNOWN_FAILURE, "send after peer close returns wrong errno" },
     { 48, KNOWN_FAILURE, "SO_LINGER set/get roundtrip fails" },
@@ -178,7 +182,7 @@ void known_init(const char *version_string)
 }
 
 /* Internal: search entries with optional type filter.
- * filter_type: -1 = any type, KNOWN_FAILURE or KNOWN_CRASH = specific. */
+ * filter_type: -1 = any type, or a specific enum known_type. */
 static const char *lookup(int test_number, int filter_type)
 {
     int i;
@@ -207,6 +211,11 @@ const char *known_crash(int test_number)
     return lookup(test_number, KNOWN_CRASH);
 }
 
+const char *known_hang(int test_number)
+{
+    return lookup(test_number, KNOWN_HANG);
+}
+
 const char *known_stack_name(void)
 {
     if (active_profile)
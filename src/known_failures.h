@@ -16,7 +16,7 @@
  * annotations. */
 void known_init(const char *version_string);
 
-/* Check if a given test number is a known issue (failure or crash)
+/* Check if a given test number is a known issue (failure, hang or crash)
  * for the current stack and version. Returns the reason string if
  * known, NULL if not. Used by the TAP framework to annotate output. */
 const char *known_check(int test_number);
@@ -27,6 +27,11 @@ const char *known_check(int test_number);
  * When non-NULL, emit tap_ok(0, desc) + diagnostic and skip the test. */
 const char *known_crash(int test_number);
 
+/* Check if a given test number is known to hang the current stack.
+ * Returns the reason string if so, NULL otherwise.  The runner gives
+ * such tests a short watchdog instead of skipping them. */
+const char *known_hang(int test_number);
+
 /* Get the detected stack name (e.g. "Roadshow"), or "Unknown" if
  * not recognized. For display purposes. */
 const char *known_stack_name(void);
@@ -9,6 +9,10 @@
 #include "tests.h"
 #include "helper_proto.h"
 #include "known_failures.h"
+#include "report.h"
+#include "parallel.h"
+#include "profile.h"
+#include "trace.h"
 
 #include <proto/exec.h>
 #include <proto/dos.h>
@@ -16,6 +20,7 @@
 #include <workbench/startup.h>
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 /* Ensure sufficient stack for test buffers and nested calls.
@@ -32,7 +37,7 @@ const char *__stdiowin = "CON:0/20/640/180/bsdsocktest/AUTO/CLOSE/WAIT";
 struct Library *IconBase = NULL;
 
 /* ReadArgs template */
-#define TEMPLATE "CATEGORY/K,HOST/K,PORT/N,LOG/K,ALL/S,LOOPBACK/S,NETWORK/S,LIST/S,VERBOSE/S,NOPAGE/S"
+#define TEMPLATE "CATEGORY/K,HOST/K,PORT/N,LOG/K,ALL/S,LOOPBACK/S,NETWORK/S,LIST/S,VERBOSE/S,NOPAGE/S,IMPAIR/K,LOGSYNC/S,FORMAT/K,REPORT/K,STREAM/S,TESTS/K,TIMEOUT/N,PARALLEL/N,RESUME/S,RERUN/K,TIMES/N,REPEAT/N,LEAKCHECK/S,PROFILE/S,TRACE/K,REPLAY/K,WORKER/S"
 
 enum {
     ARG_CATEGORY,
@@ -45,56 +50,109 @@ enum {
     ARG_LIST,
     ARG_VERBOSE,
     ARG_NOPAGE,
+    ARG_IMPAIR,
+    ARG_LOGSYNC,
+    ARG_FORMAT,
+    ARG_REPORT,
+    ARG_STREAM,
+    ARG_TESTS,
+    ARG_TIMEOUT,
+    ARG_PARALLEL,
+    ARG_RESUME,
+    ARG_RERUN,
+    ARG_TIMES,
+    ARG_REPEAT,
+    ARG_LEAKCHECK,
+    ARG_PROFILE,
+    ARG_TRACE,
+    ARG_REPLAY,
+    ARG_WORKER,         /* internal: run as a PARALLEL worker */
     ARG_COUNT
 };
 
-/* Test tier flags */
-#define TIER_LOOPBACK 0x01
-#define TIER_NETWORK  0x02
-#define TIER_BOTH     (TIER_LOOPBACK | TIER_NETWORK)
-
 /* Category table entry */
 struct test_category {
     const char *name;
-    void (*run)(void);
+    const struct test_entry *tests;
     int tier;
     const char *description;
 };
 
+/* Per-test watchdog (seconds): long enough for the 1MB throughput
+ * tests on slow machines; tests known to hang this stack get less */
+#define DEFAULT_TIMEOUT 120
+#define HANG_TIMEOUT    5
+
+static int test_timeout = DEFAULT_TIMEOUT;   /* TIMEOUT, 0 = off */
+static int leak_check;          /* LEAKCHECK */
+
+/* TESTS selection: ranges of test numbers, none = all */
+#define MAX_RANGES 32
+
+static struct {
+    int first;
+    int last;
+} ranges[MAX_RANGES];
+static int range_count;
+
+/* RESUME: tests up to resume_after are in the log already; the one
+ * that crashed the earlier run is failed without running it again */
+static int resume_after;
+static int resume_crashed;
+
+/* RERUN: the unexpected failures of an earlier log, the only tests
+ * selected; each selected test runs 'test_times' times in a row */
+#define MAX_RERUN 160
+
+static int rerun[MAX_RERUN];
+static int rerun_count = -1;    /* -1 = no RERUN */
+static int test_times = 1;
+
 /* Category table — order matches test file structure */
 static const struct test_category categories[] = {
-    { "socket",     run_socket_tests,     TIER_LOOPBACK,
+    { "socket",     socket_tests,         TIER_LOOPBACK,
       "Core socket lifecycle: create, bind, listen, connect, accept, close" },
-    { "sendrecv",   run_sendrecv_tests,   TIER_BOTH,
+    { "sendrecv",   sendrecv_tests,       TIER_BOTH,
       "Data transfer: send, recv, sendto, recvfrom, sendmsg, recvmsg" },
-    { "sockopt",    run_sockopt_tests,    TIER_LOOPBACK,
+    { "sockopt",    sockopt_tests,        TIER_LOOPBACK,
       "Socket options: getsockopt, setsockopt, IoctlSocket" },
-    { "waitselect", run_waitselect_tests, TIER_LOOPBACK,
+    { "waitselect", waitselect_tests,     TIER_LOOPBACK,
       "Async I/O: WaitSelect readiness, timeout, signal integration" },
-    { "signals",    run_signals_tests,    TIER_LOOPBACK,
+    { "signals",    signals_tests,        TIER_LOOPBACK,
       "Signals and events: SetSocketSignals, SocketBaseTags, GetSocketEvents" },
-    { "dns",        run_dns_tests,        TIER_BOTH,
+    { "dns",        dns_tests,            TIER_BOTH,
       "Name resolution: gethostbyname/addr, getservby*, getprotoby*" },
-    { "utility",    run_utility_tests,    TIER_LOOPBACK,
+    { "utility",    utility_tests,        TIER_LOOPBACK,
       "Address utilities: Inet_NtoA, inet_addr, Inet_LnaOf, Inet_NetOf" },
-    { "transfer",   run_transfer_tests,   TIER_LOOPBACK,
+    { "transfer",   transfer_tests,       TIER_LOOPBACK,
       "Descriptor transfer: Dup2Socket, ObtainSocket, ReleaseSocket" },
-    { "errno",      run_errno_tests,      TIER_LOOPBACK,
+    { "errno",      errno_tests,          TIER_LOOPBACK,
       "Error handling: Errno, SetErrnoPtr, SocketBaseTags errno pointers" },
-    { "misc",       run_misc_tests,       TIER_LOOPBACK,
+    { "misc",       misc_tests,           TIER_LOOPBACK,
       "Miscellaneous: getdtablesize, syslog, resource limits" },
-    { "icmp",       run_icmp_tests,       TIER_BOTH,
+    { "icmp",       icmp_tests,           TIER_BOTH,
       "ICMP echo: raw socket ping, RTT measurement" },
-    { "throughput", run_throughput_tests,  TIER_BOTH,
+    { "throughput", throughput_tests,      TIER_BOTH,
       "Throughput benchmarks: TCP/UDP loopback and network transfer" },
+    { "server",     server_tests,         TIER_NETWORK,
+      "Server mode: Amiga listeners under helper-generated client load" },
+    { "replay",     replay_tests,         TIER_BOTH,
+      "Trace replay: a recorded socket workload, achieved vs recorded" },
     { NULL, NULL, 0, NULL }
 };
 
+#define NUM_CATEGORIES (int)(sizeof(categories) / sizeof(categories[0]) - 1)
+
 static void print_usage(void)
 {
     printf("Usage: bsdsocktest [CATEGORY <name>] [ALL] [LOOPBACK] [NETWORK]\n"
            "                   [HOST <ip>] [PORT <num>] [LOG <path>] [VERBOSE]\n"
-           "                   [NOPAGE] [LIST]\n\n"
+           "                   [NOPAGE] [LIST] [IMPAIR <spec>] [LOGSYNC]\n"
+           "                   [FORMAT <TAP|JUNIT|JSON>] [REPORT <path>]\n"
+           "                   [STREAM] [TESTS <list>] [TIMEOUT <secs>]\n"
+           "                   [PARALLEL <n>] [RESUME] [RERUN <log>]\n"
+           "                   [TIMES <n>] [REPEAT <n>] [LEAKCHECK] [PROFILE]\n"
+           "                   [TRACE <path>] [REPLAY <script>]\n\n"
            "  CATEGORY  Run a single test category by name\n"
            "  ALL       Run all test categories (default)\n"
            "  LOOPBACK  Run only loopback (self-contained) tests\n"
@@ -104,36 +162,203 @@ static void print_usage(void)
            "  LOG       Log file path (default: bsdsocktest.log, NIL: to suppress)\n"
            "  VERBOSE   Show individual test results on screen\n"
            "  NOPAGE    Disable pagination (output scrolls freely)\n"
-           "  LIST      List available test categories and exit\n",
-           DEFAULT_BASE_PORT);
+           "  LIST      List available test categories and exit\n"
+           "  IMPAIR    Helper link impairment, e.g. \"all delay=100 loss=1\"\n"
+           "  LOGSYNC   Write the log unbuffered (slower; for crash hunting)\n"
+           "  FORMAT    Also write a JUNIT (XML) or JSON (JSON Lines) report\n"
+           "  REPORT    Report file path (default: bsdsocktest.xml/.jsonl)\n"
+           "  STREAM    Mirror the log to a file on the host helper\n"
+           "  TESTS     Run only these test numbers, e.g. \"40-55,137\"\n"
+           "  TIMEOUT   Per-test watchdog in seconds (default: %d, 0 = off)\n"
+           "  PARALLEL  Run loopback categories in up to n worker processes\n"
+           "  RESUME    Continue the log of a run the machine did not survive\n"
+           "  RERUN     Run only the unexpected failures in this earlier log\n"
+           "  TIMES     Run each selected test n times (flake rates)\n"
+           "  REPEAT    Run the selected categories n times (flake rates)\n"
+           "  LEAKCHECK Report descriptors, signals and memory tests leak\n"
+           "  PROFILE   Count and time every socket call the tests make\n"
+           "  TRACE     Dump recent socket calls here on failure or Ctrl-D\n"
+           "  REPLAY    Script the replay tests play back (see README)\n",
+           DEFAULT_BASE_PORT, DEFAULT_TIMEOUT);
+}
+
+/* Parse a TESTS list such as "40-55,137" into ranges[].
+ * Returns 1 on success, 0 if the list is malformed. */
+static int parse_tests(const char *list)
+{
+    const char *p = list;
+    long first, last;
+    char *end;
+
+    range_count = 0;
+    while (*p) {
+        if (range_count == MAX_RANGES)
+            return 0;
+        first = strtol(p, &end, 10);
+        if (end == p || first < 1)
+            return 0;
+        last = first;
+        p = end;
+        if (*p == '-') {
+            p++;
+            last = strtol(p, &end, 10);
+            if (end == p || last < first)
+                return 0;
+            p = end;
+        }
+        ranges[range_count].first = (int)first;
+        ranges[range_count].last = (int)last;
+        range_count++;
+        if (*p == ',')
+            p++;
+        else if (*p)
+            return 0;
+    }
+    return range_count > 0;
+}
+
+/* Is test 'number' selected by TESTS (all are without it)? */
+static int test_selected(int number)
+{
+    int i;
+
+    if (number <= resume_after)
+        return 0;
+    if (rerun_count >= 0) {
+        for (i = 0; i < rerun_count && rerun[i] != number; i++)
+            ;
+        if (i == rerun_count)
+            return 0;
+    }
+    if (range_count == 0)
+        return 1;
+    for (i = 0; i < range_count; i++) {
+        if (number >= ranges[i].first && number <= ranges[i].last)
+            return 1;
+    }
+    return 0;
+}
+
+/* Append "first-last" (or "first") to a TESTS list being built */
+static int add_range(char *buf, int size, int *count, int first, int last)
+{
+    char range[24];
+    int len = strlen(buf);
+
+    if (first == last)
+        sprintf(range, "%s%d", *count ? "," : "", first);
+    else
+        sprintf(range, "%s%d-%d", *count ? "," : "", first, last);
+    if (++*count > MAX_RANGES || len + (int)strlen(range) >= size)
+        return 0;
+    strcpy(buf + len, range);
+    return 1;
 }
 
-static void list_categories(void)
+/* Write the tests selected by TESTS, RESUME and RERUN as a TESTS
+ * list for the workers, left empty if every test is.  Returns 0 if
+ * the list needs more than MAX_RANGES ranges or 'size' characters. */
+static int selection_list(char *buf, int size)
 {
     const struct test_category *cat;
+    const struct test_entry *t;
+    int first = 0, last = 0, count = 0, all = 1;
+
+    buf[0] = '\0';
+    for (cat = categories; cat->name; cat++) {
+        for (t = cat->tests; t->run; t++) {
+            if (!test_selected(t->number)) {
+                all = 0;
+            } else if (first && t->number == last + 1) {
+                last = t->number;
+            } else {
+                if (first && !add_range(buf, size, &count, first, last))
+                    return 0;
+                first = last = t->number;
+            }
+        }
+    }
+    if (all)
+        buf[0] = '\0';
+    else if (first && !add_range(buf, size, &count, first, last))
+        return 0;
+    return 1;
+}
+
+/* Number of selected tests in a category */
+static int count_selected(const struct test_category *cat)
+{
+    const struct test_entry *t;
+    int n = 0;
+
+    for (t = cat->tests; t->run; t++) {
+        if (test_selected(t->number))
+            n++;
+    }
+    return n;
+}
+
+static const char *tier_name(int tier)
+{
+    if (tier == TIER_BOTH)
+        return "loopback+network";
+    if (tier == TIER_LOOPBACK)
+        return "loopback";
+    return "network";
+}
+
+/* LIST: categories with their test numbers; with TESTS or CATEGORY
+ * also the selected tests themselves. */
+static void list_categories(const char *cat_filter)
+{
+    const struct test_category *cat;
+    const struct test_entry *t;
+    int count;
 
     printf("Available test categories:\n\n");
-    printf("  %-12s  %s\n", "Name", "Tier");
-    printf("  %-12s  %s\n", "----", "----");
+    printf("  %-12s  %-9s  %s\n", "Name", "Tests", "Tier");
+    printf("  %-12s  %-9s  %s\n", "----", "-----", "----");
 
     for (cat = categories; cat->name; cat++) {
-        const char *tier;
-        if (cat->tier == TIER_BOTH)
-            tier = "loopback+network";
-        else if (cat->tier == TIER_LOOPBACK)
-            tier = "loopback";
-        else
-            tier = "network";
-        printf("  %-12s  %s\n", cat->name, tier);
+        for (count = 0; cat->tests[count].run; count++)
+            ;
+        printf("  %-12s  %3d-%-5d  %s\n", cat->name, cat->tests[0].number,
+               cat->tests[count - 1].number, tier_name(cat->tier));
+    }
+
+    if (range_count == 0 && !cat_filter)
+        return;
+
+    printf("\n  %4s  %-12s  %-36s  %-8s  %s\n",
+           "Test", "Category", "Name", "Tier", "Ports");
+    for (cat = categories; cat->name; cat++) {
+        if (cat_filter && stricmp(cat->name, cat_filter) != 0)
+            continue;
+        for (t = cat->tests; t->run; t++) {
+            if (!test_selected(t->number))
+                continue;
+            printf("  %4d  %-12s  %-36s  %-8s  ", t->number, cat->name,
+                   t->name, tier_name(t->tier));
+            if (t->port_first < 0)
+                printf("-\n");
+            else if (t->port_first == t->port_last)
+                printf("%d\n", t->port_first);
+            else
+                printf("%d-%d\n", t->port_first, t->port_last);
+        }
     }
 }
 
 /* Check if a category should be run based on the filter.
  * tier_filter: 0 = all, TIER_LOOPBACK = loopback only, etc.
- * cat_filter: NULL = all, otherwise must match name exactly. */
+ * cat_filter: NULL = all, otherwise must match name exactly.
+ * With TESTS, only categories holding a selected test run. */
 static int should_run(const struct test_category *cat,
                       int tier_filter, const char *cat_filter)
 {
+    if (count_selected(cat) == 0)
+        return 0;
+
     if (cat_filter)
         return (stricmp(cat->name, cat_filter) == 0);
 
@@ -143,20 +368,159 @@ static int should_run(const struct test_category *cat,
     return (cat->tier & tier_filter) != 0;
 }
 
+/* Run one test under the watchdog.  Tests that need the host helper
+ * are skipped here when it is not connected. */
+static void run_test(const struct test_entry *t)
+{
+    char leaked[64];
+    int failed = tap_get_failed();
+    int timed_out = 0;
+    int secs;
+
+    tap_set_next(t->number);
+    port_begin_test(t->number);
+    if (t->number == resume_crashed) {
+        tap_okf(0, "%s: crashed the previous run", t->name);
+    } else if (!(t->tier & TIER_LOOPBACK) && !helper_is_connected()) {
+        tap_skip("host helper not connected");
+    } else {
+        /* A blocking call still pending when the watchdog expires
+         * returns EINTR, so a hang costs seconds, not the run */
+        secs = test_timeout;
+        if (known_hang(t->number) && secs > HANG_TIMEOUT)
+            secs = HANG_TIMEOUT;
+        if (leak_check)
+            leak_check_begin();
+        watchdog_start(secs);
+        /* Only the test's own calls carry its number in the trace */
+        trace_set_test(t->number);
+        t->run();
+        trace_set_test(0);
+        if (watchdog_stop()) {
+            tap_timeout(secs);
+            timed_out = 1;
+        }
+        if (leak_check && leak_check_end(leaked, sizeof(leaked)))
+            tap_leak(leaked);
+    }
+    port_end_test();
+
+    /* TRACE: keep the calls that led up to a failure */
+    if (trace_enabled()) {
+        if (timed_out)
+            trace_dump(TRACE_TIMEOUT, t->number);
+        else if (tap_get_failed() > failed)
+            trace_dump(TRACE_FAILED, t->number);
+        else if (SetSignal(0L, SIGBREAKF_CTRL_D) & SIGBREAKF_CTRL_D)
+            trace_dump(TRACE_REQUEST, t->number);
+    }
+}
+
+/* Run the selected tests of a category in number order, each
+ * test_times times in a row. */
+static void run_category(const struct test_category *cat)
+{
+    const struct test_entry *t;
+    int first = 1;
+    int i;
+
+    for (t = cat->tests; t->run; t++) {
+        if (!test_selected(t->number))
+            continue;
+
+        for (i = 0; i < test_times; i++) {
+            /* Check for Ctrl-C between tests */
+            if (!first &&
+                (SetSignal(0L, SIGBREAKF_CTRL_C) & SIGBREAKF_CTRL_C)) {
+                tap_bail("Interrupted by Ctrl-C");
+                return;
+            }
+            first = 0;
+
+            run_test(t);
+            if (tap_bailed())
+                return;
+        }
+    }
+}
+
+/* Run the selected categories once, loopback-only ones in up to
+ * 'workers' worker processes.  Returns 1 if any category ran; stops
+ * early on a bail out. */
+static int run_categories(int tier_filter, const char *cat_filter,
+                          int workers, const char *worker_args)
+{
+    const struct test_category *cat;
+    int jobs[NUM_CATEGORIES];
+    int ran_any = 0;
+
+    for (cat = categories; cat->name; cat++)
+        jobs[cat - categories] = -1;
+    if (workers > 1 && parallel_init(workers, worker_args) == 0) {
+        for (cat = categories; cat->name; cat++) {
+            /* The test blamed for a crash is recorded here */
+            if (cat->tier == TIER_LOOPBACK &&
+                cat->tests[0].number > resume_crashed &&
+                should_run(cat, tier_filter, cat_filter))
+                jobs[cat - categories] = parallel_queue(cat->name);
+        }
+        parallel_poll();
+    }
+
+    for (cat = categories; cat->name; cat++) {
+        /* Check for Ctrl-C between categories */
+        if (SetSignal(0L, SIGBREAKF_CTRL_C) & SIGBREAKF_CTRL_C) {
+            tap_bail("Interrupted by Ctrl-C");
+            break;
+        }
+
+        if (!should_run(cat, tier_filter, cat_filter))
+            continue;
+
+        /* Categories run here wait for the workers, so benchmarks and
+         * helper tests never share the stack with them */
+        if (jobs[cat - categories] < 0 && parallel_wait_all() < 0)
+            break;
+
+        tap_begin_category(cat->name);
+        if (cat->description)
+            tap_diag(cat->description);
+        ran_any = 1;
+        if (jobs[cat - categories] >= 0)
+            parallel_import(jobs[cat - categories]);
+        else
+            run_category(cat);
+
+        if (tap_bailed())
+            break;
+
+        tap_end_category();
+    }
+
+    parallel_cleanup();
+    return ran_any;
+}
+
 int main(int argc, char **argv)
 {
     struct RDArgs *rdargs;
     LONG args[ARG_COUNT];
     const struct test_category *cat;
+    const struct test_entry *t;
     int tier_filter = 0;
     const char *cat_filter = NULL;
     const char *log_path;
     int exit_code;
     int ran_any = 0;
+    int rounds = 1;
+    int round;
+    int workers = 0;
+    char worker_args[400];
+    char selection[300];
 
     /* Workbench startup variables (C89: declare before any code) */
     struct RDArgs wb_rda;
-    char argbuf[512];
+    char argbuf[768];
 
     memset(args, 0, sizeof(args));
 
@@ -189,6 +553,22 @@ int main(int argc, char **argv)
                     p += sprintf(p, "VERBOSE ");
                 if (FindToolType(tt, (STRPTR)"NOPAGE"))
                     p += sprintf(p, "NOPAGE ");
+                if (FindToolType(tt, (STRPTR)"LOGSYNC"))
+                    p += sprintf(p, "LOGSYNC ");
+                if (FindToolType(tt, (STRPTR)"STREAM"))
+                    p += sprintf(p, "STREAM ");
+                if (FindToolType(tt, (STRPTR)"RESUME"))
+                    p += sprintf(p, "RESUME ");
+                if (FindToolType(tt, (STRPTR)"LEAKCHECK"))
+                    p += sprintf(p, "LEAKCHECK ");
+                if (FindToolType(tt, (STRPTR)"PROFILE"))
+                    p += sprintf(p, "PROFILE ");
+                val = FindToolType(tt, (STRPTR)"TRACE");
+                if (val)
+                    p += sprintf(p, "TRACE \"%.200s\" ", (char *)val);
+                val = FindToolType(tt, (STRPTR)"REPLAY");
+                if (val)
+                    p += sprintf(p, "REPLAY \"%.200s\" ", (char *)val);
                 val = FindToolType(tt, (STRPTR)"LOG");
                 if (val)
                     p += sprintf(p, "LOG %s ", (char *)val);
@@ -198,6 +578,33 @@ int main(int argc, char **argv)
                 val = FindToolType(tt, (STRPTR)"CATEGORY");
                 if (val)
                     p += sprintf(p, "CATEGORY %s ", (char *)val);
+                val = FindToolType(tt, (STRPTR)"TESTS");
+                if (val)
+                    p += sprintf(p, "TESTS %.100s ", (char *)val);
+                val = FindToolType(tt, (STRPTR)"TIMEOUT");
+                if (val)
+                    p += sprintf(p, "TIMEOUT %s ", (char *)val);
+                val = FindToolType(tt, (STRPTR)"PARALLEL");
+                if (val)
+                    p += sprintf(p, "PARALLEL %s ", (char *)val);
+                val = FindToolType(tt, (STRPTR)"TIMES");
+                if (val)
+                    p += sprintf(p, "TIMES %s ", (char *)val);
+                val = FindToolType(tt, (STRPTR)"REPEAT");
+                if (val)
+                    p += sprintf(p, "REPEAT %s ", (char *)val);
+                val = FindToolType(tt, (STRPTR)"RERUN");
+                if (val)
+                    p += sprintf(p, "RERUN \"%.100s\" ", (char *)val);
+                val = FindToolType(tt, (STRPTR)"FORMAT");
+                if (val)
+                    p += sprintf(p, "FORMAT %s ", (char *)val);
+                val = FindToolType(tt, (STRPTR)"REPORT");
+                if (val)
+                    p += sprintf(p, "REPORT \"%.200s\" ", (char *)val);
+                val = FindToolType(tt, (STRPTR)"IMPAIR");
+                if (val)
+                    p += sprintf(p, "IMPAIR \"%.200s\" ", (char *)val);
             }
             if (dobj)
                 FreeDiskObject(dobj);
@@ -222,9 +629,16 @@ int main(int argc, char **argv)
         return RETURN_FAIL;
     }
 
+    if (args[ARG_TESTS] && !parse_tests((const char *)args[ARG_TESTS])) {
+        printf("Invalid TESTS %s (use numbers and ranges, e.g. 40-55,137)\n",
+               (const char *)args[ARG_TESTS]);
+        FreeArgs(rdargs);
+        return RETURN_FAIL;
+    }
+
     /* LIST mode — no library needed */
     if (args[ARG_LIST]) {
-        list_categories();
+        list_categories((const char *)args[ARG_CATEGORY]);
         FreeArgs(rdargs);
         return RETURN_OK;
     }
@@ -233,6 +647,51 @@ int main(int argc, char **argv)
     if (args[ARG_PORT])
         set_base_port(*(LONG *)args[ARG_PORT]);
 
+    if (args[ARG_TIMEOUT])
+        test_timeout = (int)*(LONG *)args[ARG_TIMEOUT];
+
+    if (args[ARG_LEAKCHECK])
+        leak_check = 1;
+    /* Workers mark their notes for the import.  AvailMem() covers the
+     * whole system, and workers run side by side; the main process runs
+     * its own tests once they are done */
+    if (args[ARG_WORKER]) {
+        leak_check_set_memory(0);
+        tap_set_worker(1);
+    }
+
+    if (args[ARG_PROFILE])
+        profile_enable(1);
+
+    if (args[ARG_TIMES] && *(LONG *)args[ARG_TIMES] > 1)
+        test_times = (int)*(LONG *)args[ARG_TIMES];
+    if (args[ARG_REPEAT] && *(LONG *)args[ARG_REPEAT] > 1)
+        rounds = (int)*(LONG *)args[ARG_REPEAT];
+    if (test_times > 1 || rounds > 1)
+        tap_set_tally(test_times * rounds);
+    /* Repeats of a test must not repeat its TAP number */
+    if (test_times > 1 || rounds > 1)
+        tap_set_sequence(1);
+
+    /* RERUN: select the earlier run's unexpected failures */
+    if (args[ARG_RERUN]) {
+        rerun_count = tap_read_failures((const char *)args[ARG_RERUN],
+                                        rerun, MAX_RERUN);
+        if (rerun_count < 0) {
+            printf("Could not read RERUN log %s\n",
+                   (const char *)args[ARG_RERUN]);
+            FreeArgs(rdargs);
+            return RETURN_FAIL;
+        }
+        if (rerun_count == 0) {
+            printf("No unexpected failures in %s, nothing to rerun\n",
+                   (const char *)args[ARG_RERUN]);
+            FreeArgs(rdargs);
+            return RETURN_OK;
+        }
+        tap_set_tally(test_times * rounds);
+    }
+
     if (args[ARG_CATEGORY])
         cat_filter = (const char *)args[ARG_CATEGORY];
 
@@ -248,9 +707,59 @@ int main(int argc, char **argv)
     if (!args[ARG_NOPAGE])
         tap_set_page(1);
 
+    if (args[ARG_LOGSYNC])
+        tap_set_log_sync(1);
+
+    if (args[ARG_FORMAT]) {
+        int format = report_parse_format((const char *)args[ARG_FORMAT]);
+
+        if (format < 0) {
+            printf("Unknown FORMAT %s (use TAP, JUNIT or JSON)\n",
+                   (const char *)args[ARG_FORMAT]);
+            FreeArgs(rdargs);
+            return RETURN_FAIL;
+        }
+        tap_set_report(format, (const char *)args[ARG_REPORT]);
+    }
+
+    if (args[ARG_STREAM] && !args[ARG_HOST]) {
+        printf("STREAM needs a host helper (HOST)\n");
+        FreeArgs(rdargs);
+        return RETURN_FAIL;
+    }
+
     /* Determine log file path (NULL = default "bsdsocktest.log") */
     log_path = args[ARG_LOG] ? (const char *)args[ARG_LOG] : NULL;
 
+    /* RESUME: pick up after the last result in the log.  The test run
+     * next was the one the machine did not survive. */
+    if (args[ARG_RESUME]) {
+        int crashed;
+
+        resume_after = tap_resume(log_path, &crashed);
+        if (resume_after < 0) {
+            printf("%s is complete, nothing to resume\n",
+                   log_path ? log_path : "bsdsocktest.log");
+            FreeArgs(rdargs);
+            return RETURN_OK;
+        }
+        for (cat = categories; crashed && cat->name; cat++) {
+            if (!should_run(cat, tier_filter, cat_filter))
+                continue;
+            for (t = cat->tests; t->run; t++) {
+                /* Only a test run_test() would have started: network
+                 * tests are skipped without a helper, and HOST is
+                 * required to connect */
+                if (test_selected(t->number) &&
+                    ((t->tier & TIER_LOOPBACK) || args[ARG_HOST])) {
+                    resume_crashed = t->number;
+                    crashed = 0;
+                    break;
+                }
+            }
+        }
+    }
+
     /* Open bsdsocket.library */
     if (open_bsdsocket() < 0) {
         tap_init(NULL, log_path);
@@ -280,6 +789,19 @@ int main(int argc, char **argv)
     /* Initialize known-failures table for the detected stack */
     known_init(get_bsdsocket_version());
 
+    /* TRACE: the file is appended to when the run is resumed */
+    if (args[ARG_TRACE])
+        trace_open((const char *)args[ARG_TRACE], args[ARG_RESUME] != 0);
+
+    if (args[ARG_REPLAY])
+        replay_set_script((const char *)args[ARG_REPLAY]);
+
+    /* Size settle delays and drain periods to this machine (not part
+     * of any test's profile) */
+    profile_suspend();
+    calibrate_waits();
+    profile_resume();
+
     /* Connect to host helper if HOST was specified.
      * Bail out on failure — the user explicitly requested network tests. */
     if (args[ARG_HOST]) {
@@ -294,42 +816,88 @@ int main(int argc, char **argv)
             FreeArgs(rdargs);
             return exit_code;
         }
-    }
 
-    /* Dispatch categories */
-    for (cat = categories; cat->name; cat++) {
-        /* Check for Ctrl-C between categories */
-        if (SetSignal(0L, SIGBREAKF_CTRL_C) & SIGBREAKF_CTRL_C) {
-            tap_bail("Interrupted by Ctrl-C");
-            break;
+        /* Degrade the helper's links before any network test runs */
+        if (args[ARG_IMPAIR]) {
+            const char *spec = (const char *)args[ARG_IMPAIR];
+            if (!helper_impair(spec)) {
+                tap_diagf("impair=%s", spec);
+                tap_plan(0);
+                tap_bail("Host helper rejected IMPAIR");
+                exit_code = tap_finish();
+                helper_quit();
+                timer_cleanup();
+                close_bsdsocket();
+                FreeArgs(rdargs);
+                return exit_code;
+            }
+            tap_diagf("helper impairment: %s", spec);
         }
 
-        if (!should_run(cat, tier_filter, cat_filter))
-            continue;
-
-        tap_begin_category(cat->name);
-        if (cat->description)
-            tap_diag(cat->description);
-        ran_any = 1;
-        cat->run();
+        /* Mirror the log before the first result */
+        if (args[ARG_STREAM]) {
+            if (!helper_stream_open()) {
+                tap_plan(0);
+                tap_bail("Host helper rejected STREAM");
+                exit_code = tap_finish();
+                helper_quit();
+                timer_cleanup();
+                close_bsdsocket();
+                FreeArgs(rdargs);
+                return exit_code;
+            }
+            tap_set_stream(1);
+        }
+    }
 
-        if (tap_bailed())
-            break;
+    /* PARALLEL: loopback-only categories go to worker processes, which
+     * need no helper.  Workers share our options that shape a run. */
+    if (args[ARG_PARALLEL] && *(LONG *)args[ARG_PARALLEL] > 1) {
+        if (trace_enabled()) {
+            tap_diag("parallel: TRACE keeps one ring, running alone");
+        } else if (selection_list(selection, sizeof(selection))) {
+            workers = (int)*(LONG *)args[ARG_PARALLEL];
+            sprintf(worker_args, "WORKER PORT %d TIMEOUT %d TIMES %d%s%s%s",
+                    get_base_port(), test_timeout, test_times,
+                    args[ARG_LOGSYNC] ? " LOGSYNC" : "",
+                    leak_check ? " LEAKCHECK" : "",
+                    profile_enabled() ? " PROFILE" : "");
+            if (selection[0])
+                sprintf(worker_args + strlen(worker_args), " TESTS %s",
+                        selection);
+        } else {
+            tap_diag("parallel: selection too fragmented for workers, "
+                     "running alone");
+        }
+    }
 
-        tap_end_category();
+    /* Dispatch categories, REPEAT times over */
+    for (round = 1; round <= rounds && !tap_bailed(); round++) {
+        if (rounds > 1)
+            tap_round(round, rounds);
+        if (run_categories(tier_filter, cat_filter, workers, worker_args))
+            ran_any = 1;
     }
 
-    if (!ran_any && cat_filter) {
+    if (!ran_any && range_count > 0) {
+        tap_diagf("No tests selected by TESTS %s",
+                  (const char *)args[ARG_TESTS]);
+    } else if (!ran_any && cat_filter) {
         tap_diagf("Unknown category: %s", cat_filter);
     }
 
-    /* Disconnect from host helper */
-    helper_quit();
+    if (port_collisions() > 0)
+        tap_diagf("Port collisions: %d (moved to spare ports)",
+                  port_collisions());
 
     /* Emit trailing plan line (TAP v12 "plan at the end") */
     tap_plan(tap_get_total());
 
     exit_code = tap_finish();
+    trace_close();
+
+    /* Disconnect from host helper (after the summary has been streamed) */
+    helper_quit();
 
     timer_cleanup();
     close_bsdsocket();
@@ -0,0 +1,283 @@
+/*
+ * bsdsocktest — Parallel categories (PARALLEL/N)
+ *
+ * A job is one category run by a worker process.  Workers are started
+ * with an asynchronous SystemTags(), which has a new shell load our
+ * executable afresh, so each has its own data segment (SocketBase, TAP
+ * state, test buffers) and needs no special mode: it is an ordinary CLI
+ * run with CATEGORY and LOG set.  The shell runs the command line as
+ * it would one typed at its prompt, handing the arguments to the
+ * program through its Input() buffer, which is where ReadArgs() reads
+ * them.  (CreateNewProc() with NP_Arguments only passes them in A0,
+ * which ReadArgs() never sees.)  NP_ExitCode posts the job's message
+ * to the parent once the shell, and with it the worker, has exited.
+ */
+
+#include "parallel.h"
+#include "tap.h"
+
+#include <proto/exec.h>
+#include <proto/dos.h>
+#include <dos/dostags.h>
+
+#include <stdio.h>
+#include <string.h>
+
+/* NP_ExitCode routines receive NP_ExitData in D1 */
+#ifdef __mc68000__
+#define ASM_D1 __asm("d1")
+#else
+#define ASM_D1
+#endif
+
+#define MAX_JOBS 16
+
+enum job_state {
+    JOB_QUEUED,
+    JOB_RUNNING,
+    JOB_DONE
+};
+
+struct job {
+    struct Message msg;         /* first: posted by job_exited() */
+    const char *category;
+    enum job_state state;
+    struct Process *proc;
+    char log_path[64];
+};
+
+static struct job jobs[MAX_JOBS];
+static int job_count;
+static int max_running;
+static int running;
+static struct MsgPort *done_port;
+static char prog_path[256];
+static char common[400];
+
+/* ---- Internal helpers ---- */
+
+/* Runs in the worker's context as it exits: its log is closed */
+static void job_exited(struct job *j ASM_D1)
+{
+    PutMsg(done_port, &j->msg);
+}
+
+static int job_start(struct job *j)
+{
+    char cmd[768];
+    char name[48];
+    BPTR in, out;
+
+    in = Open((STRPTR)"NIL:", MODE_OLDFILE);
+    out = Open((STRPTR)"NIL:", MODE_NEWFILE);
+    if (!in || !out) {
+        if (in)
+            Close(in);
+        if (out)
+            Close(out);
+        return -1;
+    }
+
+    sprintf(cmd, "\"%s\" CATEGORY %s LOG \"%s\" NOPAGE %s",
+            prog_path, j->category, j->log_path, common);
+    sprintf(name, "bsdsocktest worker (%s)", j->category);
+
+    /* The shell closes in and out when it exits, unless it could not
+     * be started.  The remaining tags are passed to CreateNewProc(). */
+    if (SystemTags((STRPTR)cmd,
+                   SYS_Input, (ULONG)in,
+                   SYS_Output, (ULONG)out,
+                   SYS_Asynch, TRUE,
+                   NP_Name, (ULONG)name,
+                   NP_StackSize, 65536,
+                   NP_ExitCode, (ULONG)job_exited,
+                   NP_ExitData, (ULONG)j,
+                   TAG_DONE) == -1) {
+        Close(in);
+        Close(out);
+        return -1;
+    }
+
+    /* The worker runs in the shell's process; found by its name for
+     * Ctrl-C (NULL if it is already gone) */
+    j->proc = (struct Process *)FindTask((STRPTR)name);
+    j->state = JOB_RUNNING;
+    running++;
+    return 0;
+}
+
+/* Mark posted jobs done and fill free slots from the queue.  A job
+ * that cannot be started is done with an empty log, which its import
+ * reports. */
+static void collect(void)
+{
+    struct Message *msg;
+    int i;
+
+    while ((msg = GetMsg(done_port)) != NULL) {
+        ((struct job *)msg)->state = JOB_DONE;
+        running--;
+    }
+    for (i = 0; i < job_count && running < max_running; i++) {
+        if (jobs[i].state != JOB_QUEUED)
+            continue;
+        if (job_start(&jobs[i]) < 0) {
+            tap_diagf("parallel: could not start worker for %s",
+                      jobs[i].category);
+            jobs[i].state = JOB_DONE;
+        }
+    }
+}
+
+/* Wait for the done port or Ctrl-C.  Returns -1 on Ctrl-C. */
+static int wait_done(void)
+{
+    ULONG sigs;
+
+    sigs = Wait((1UL << done_port->mp_SigBit) | SIGBREAKF_CTRL_C);
+    collect();
+    return (sigs & SIGBREAKF_CTRL_C) ? -1 : 0;
+}
+
+/* ---- Public API ---- */
+
+int parallel_init(int count, const char *common_args)
+{
+    char name[108];
+
+    if (count > MAX_WORKERS)
+        count = MAX_WORKERS;
+    max_running = count;
+    job_count = 0;
+    running = 0;
+
+    /* Workers load the executable we were started from */
+    if (!GetProgramName((STRPTR)name, sizeof(name)))
+        strcpy(name, "bsdsocktest");
+    strcpy(prog_path, "PROGDIR:");
+    AddPart((STRPTR)prog_path, FilePart((STRPTR)name), sizeof(prog_path));
+
+    strncpy(common, common_args, sizeof(common) - 1);
+    common[sizeof(common) - 1] = '\0';
+
+    done_port = CreateMsgPort();
+    if (!done_port) {
+        tap_diag("parallel: could not create message port");
+        return -1;
+    }
+    tap_diagf("parallel: up to %d workers running %s", count, prog_path);
+    return 0;
+}
+
+int parallel_queue(const char *category)
+{
+    struct job *j;
+
+    if (!done_port || job_count == MAX_JOBS)
+        return -1;
+    j = &jobs[job_count];
+    memset(j, 0, sizeof(*j));
+    j->category = category;
+    j->state = JOB_QUEUED;
+    sprintf(j->log_path, "%sbsdsocktest-%lx-%d.log", WORKER_LOG_DIR,
+            (unsigned long)FindTask(NULL), job_count);
+    return job_count++;
+}
+
+void parallel_poll(void)
+{
+    if (done_port)
+        collect();
+}
+
+int parallel_import(int job)
+{
+    struct job *j = &jobs[job];
+    char line[512];
+    char *nl;
+    FILE *fp;
+    int complete;
+
+    while (j->state != JOB_DONE) {
+        if (wait_done() < 0) {
+            tap_bail("Interrupted by Ctrl-C");
+            return -1;
+        }
+    }
+
+    fp = fopen(j->log_path, "r");
+    if (fp) {
+        while (fgets(line, sizeof(line), fp)) {
+            nl = strchr(line, '\n');
+            if (nl)
+                *nl = '\0';
+            tap_import_line(line);
+        }
+        fclose(fp);
+    }
+    complete = tap_import_end();
+    DeleteFile((STRPTR)j->log_path);
+
+    if (!complete) {
+        if (!tap_bailed()) {
+            sprintf(line, "Worker for %s ended early", j->category);
+            tap_bail(line);
+        }
+        return -1;
+    }
+    return 0;
+}
+
+int parallel_wait_all(void)
+{
+    int i;
+
+    if (!done_port)
+        return 0;
+    for (;;) {
+        collect();
+        for (i = 0; i < job_count; i++) {
+            if (jobs[i].state != JOB_DONE)
+                break;
+        }
+        if (i == job_count)
+            return 0;
+        if (wait_done() < 0) {
+            tap_bail("Interrupted by Ctrl-C");
+            return -1;
+        }
+    }
+}
+
+void parallel_cleanup(void)
+{
+    int i;
+
+    if (!done_port)
+        return;
+
+    /* Nothing new starts; a worker that has not posted yet is still
+     * alive, and cannot post while we hold Forbid() */
+    for (i = 0; i < job_count; i++) {
+        if (jobs[i].state == JOB_QUEUED)
+            jobs[i].state = JOB_DONE;
+    }
+    Forbid();
+    collect();
+    for (i = 0; i < job_count; i++) {
+        if (jobs[i].state == JOB_RUNNING && jobs[i].proc)
+            Signal(&jobs[i].proc->pr_Task, SIGBREAKF_CTRL_C);
+    }
+    Permit();
+
+    while (running > 0) {
+        WaitPort(done_port);
+        collect();
+    }
+    for (i = 0; i < job_count; i++)
+        DeleteFile((STRPTR)jobs[i].log_path);
+
+    DeleteMsgPort(done_port);
+    done_port = NULL;
+    job_count = 0;
+}
@@ -0,0 +1,51 @@
+/*
+ * bsdsocktest — Parallel categories (PARALLEL/N)
+ *
+ * Loopback categories can run in worker processes: further instances
+ * of this program, run by an asynchronous SystemTags() shell with the
+ * worker's arguments on its command line.  Each worker opens its own
+ * SocketBase and writes its own TAP log; the parent replays the logs
+ * in category order, so the results read as if the categories had run
+ * one after another.
+ */
+
+#ifndef BSDSOCKTEST_PARALLEL_H
+#define BSDSOCKTEST_PARALLEL_H
+
+/* Worker logs go here, named after the parent task and job number */
+#ifndef WORKER_LOG_DIR
+#define WORKER_LOG_DIR "T:"
+#endif
+
+/* Most workers running at once (PARALLEL/N is clamped to this) */
+#define MAX_WORKERS 8
+
+/* Prepare to run up to 'count' workers at once.  'common_args' is
+ * appended to every worker's command line (PORT, TESTS, TIMEOUT, ...).
+ * Returns 0 on success, -1 if workers cannot be started (diagnostic
+ * emitted); the caller then runs every category itself. */
+int parallel_init(int count, const char *common_args);
+
+/* Queue a category for a worker.  Returns the job number, or -1 if
+ * the job table is full.  Queued jobs start as slots become free;
+ * call parallel_poll() to start the first ones. */
+int parallel_queue(const char *category);
+
+/* Collect finished workers and start queued jobs in free slots,
+ * without waiting. */
+void parallel_poll(void);
+
+/* Wait for a job, then replay its log into the active TAP category.
+ * Returns 0 if the worker's log was complete, -1 on Ctrl-C or if the
+ * worker ended early (a bail out is emitted in either case). */
+int parallel_import(int job);
+
+/* Wait until no worker is running and none is queued.  Returns 0, or
+ * -1 on Ctrl-C. */
+int parallel_wait_all(void);
+
+/* Break any running workers with Ctrl-C, wait for them to exit and
+ * delete their logs.  Safe to call without parallel_init(). */
+void parallel_cleanup(void);
+
+#endif /* BSDSOCKTEST_PARALLEL_H */
@@ -0,0 +1,624 @@
+/*
+ * bsdsocktest — Socket call profile (PROFILE/S)
+ *
+ * Each wrapper takes a timestamp on either side of the library call.
+ * The time includes two timer_now() calls, which is the same for
+ * every call and small next to a stack's own cost.  The wrappers also
+ * feed the call trace (trace.c) with the call's scalar arguments.
+ */
+
+#define PROFILE_IMPL
+
+#include "profile.h"
+#include "testutil.h"
+#include "trace.h"
+
+#include <stdarg.h>
+#include <string.h>
+
+/* Most tags a profiled SocketBaseTags() call can pass */
+#define MAX_PROFILE_TAGS 16
+
+static const char *const call_names[PROF_COUNT] = {
+    "socket", "bind", "listen", "accept", "connect", "send", "recv",
+    "sendto", "recvfrom", "sendmsg", "recvmsg", "shutdown", "setsockopt",
+    "getsockopt", "getsockname", "getpeername", "CloseSocket",
+    "IoctlSocket", "WaitSelect", "SetSocketSignals", "getdtablesize",
+    "ObtainSocket", "ReleaseSocket", "ReleaseCopyOfSocket", "Errno",
+    "SetErrnoPtr", "Inet_NtoA", "inet_addr", "Inet_LnaOf", "Inet_NetOf",
+    "Inet_MakeAddr", "inet_network", "gethostbyname", "gethostbyaddr",
+    "getnetbyname", "getnetbyaddr", "getservbyname", "getservbyport",
+    "getprotobyname", "getprotobynumber", "vsyslog", "Dup2Socket",
+    "gethostname", "gethostid", "SocketBaseTags", "GetSocketEvents"
+};
+
+static struct profile_stat stats[PROF_COUNT];
+static int enabled;
+static int suspended;
+
+/* ---- Internal helpers ---- */
+
+/* Timestamp a call about to be made.  Returns 0 if it is neither
+ * counted nor traced. */
+static int begin(struct bst_timestamp *start)
+{
+    if (suspended || (!enabled && !trace_enabled()))
+        return 0;
+    timer_now(start);
+    return 1;
+}
+
+/* Account for a call: 'result' is its return value (1 or 0 for a
+ * pointer), a0-a3 the arguments the trace keeps. */
+static void end(int call, int counted, const struct bst_timestamp *start,
+                LONG result, int failed, LONG a0, LONG a1, LONG a2, LONG a3)
+{
+    struct bst_timestamp now;
+    ULONG us;
+
+    if (!counted)
+        return;
+    timer_now(&now);
+    us = timer_elapsed_us(start, &now);
+    if (enabled) {
+        stats[call].calls++;
+        if (failed)
+            stats[call].errors++;
+        stats[call].total_us += us;
+        if (us > stats[call].max_us)
+            stats[call].max_us = us;
+    }
+    trace_record(call, start, us, result, failed ? get_bsd_errno() : 0,
+                 a0, a1, a2, a3);
+}
+
+/* ---- Public API ---- */
+
+void profile_enable(int flag)
+{
+    enabled = flag;
+}
+
+int profile_enabled(void)
+{
+    return enabled;
+}
+
+void profile_suspend(void)
+{
+    suspended++;
+}
+
+void profile_resume(void)
+{
+    if (suspended > 0)
+        suspended--;
+}
+
+const char *profile_name(int call)
+{
+    return call_names[call];
+}
+
+int profile_lookup(const char *name)
+{
+    int i;
+
+    for (i = 0; i < PROF_COUNT; i++) {
+        if (strcmp(call_names[i], name) == 0)
+            return i;
+    }
+    return -1;
+}
+
+const struct profile_stat *profile_get(int call)
+{
+    return &stats[call];
+}
+
+void profile_add(int call, const struct profile_stat *st)
+{
+    stats[call].calls += st->calls;
+    stats[call].errors += st->errors;
+    stats[call].total_us += st->total_us;
+    if (st->max_us > stats[call].max_us)
+        stats[call].max_us = st->max_us;
+}
+
+/* ---- Wrappers ---- */
+
+LONG prof_socket(LONG domain, LONG type, LONG protocol)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+    LONG rc = socket(domain, type, protocol);
+
+    end(PROF_SOCKET, counted, &t, rc, rc < 0, domain, type, protocol, 0);
+    return rc;
+}
+
+LONG prof_bind(LONG s, const void *name, LONG namelen)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+    LONG rc = bind(s, name, namelen);
+
+    end(PROF_BIND, counted, &t, rc, rc < 0, s, namelen, 0, 0);
+    return rc;
+}
+
+LONG prof_listen(LONG s, LONG backlog)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+    LONG rc = listen(s, backlog);
+
+    end(PROF_LISTEN, counted, &t, rc, rc < 0, s, backlog, 0, 0);
+    return rc;
+}
+
+LONG prof_accept(LONG s, void *addr, void *addrlen)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+    LONG rc = accept(s, addr, addrlen);
+
+    end(PROF_ACCEPT, counted, &t, rc, rc < 0, s, 0, 0, 0);
+    return rc;
+}
+
+LONG prof_connect(LONG s, const void *name, LONG namelen)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+    LONG rc = connect(s, name, namelen);
+
+    end(PROF_CONNECT, counted, &t, rc, rc < 0, s, namelen, 0, 0);
+    return rc;
+}
+
+LONG prof_send(LONG s, const void *msg, LONG len, LONG flags)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+    LONG rc = send(s, msg, len, flags);
+
+    end(PROF_SEND, counted, &t, rc, rc < 0, s, len, flags, 0);
+    return rc;
+}
+
+LONG prof_recv(LONG s, void *buf, LONG len, LONG flags)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+    LONG rc = recv(s, buf, len, flags);
+
+    end(PROF_RECV, counted, &t, rc, rc < 0, s, len, flags, 0);
+    return rc;
+}
+
+LONG prof_sendto(LONG s, const void *msg, LONG len, LONG flags,
+                 const void *to, LONG tolen)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+    LONG rc = sendto(s, msg, len, flags, to, tolen);
+
+    end(PROF_SENDTO, counted, &t, rc, rc < 0, s, len, flags, tolen);
+    return rc;
+}
+
+LONG prof_recvfrom(LONG s, void *buf, LONG len, LONG flags,
+                   void *from, void *fromlen)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+    LONG rc = recvfrom(s, buf, len, flags, from, fromlen);
+
+    end(PROF_RECVFROM, counted, &t, rc, rc < 0, s, len, flags, 0);
+    return rc;
+}
+
+LONG prof_sendmsg(LONG s, const struct msghdr *msg, LONG flags)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+    LONG rc = sendmsg(s, msg, flags);
+
+    end(PROF_SENDMSG, counted, &t, rc, rc < 0, s, flags, 0, 0);
+    return rc;
+}
+
+LONG prof_recvmsg(LONG s, struct msghdr *msg, LONG flags)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+    LONG rc = recvmsg(s, msg, flags);
+
+    end(PROF_RECVMSG, counted, &t, rc, rc < 0, s, flags, 0, 0);
+    return rc;
+}
+
+LONG prof_shutdown(LONG s, LONG how)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+    LONG rc = shutdown(s, how);
+
+    end(PROF_SHUTDOWN, counted, &t, rc, rc < 0, s, how, 0, 0);
+    return rc;
+}
+
+LONG prof_setsockopt(LONG s, LONG level, LONG optname,
+                     const void *optval, LONG optlen)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+    LONG rc = setsockopt(s, level, optname, optval, optlen);
+
+    end(PROF_SETSOCKOPT, counted, &t, rc, rc < 0, s, level, optname, optlen);
+    return rc;
+}
+
+LONG prof_getsockopt(LONG s, LONG level, LONG optname,
+                     void *optval, void *optlen)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+    LONG rc = getsockopt(s, level, optname, optval, optlen);
+
+    end(PROF_GETSOCKOPT, counted, &t, rc, rc < 0, s, level, optname, 0);
+    return rc;
+}
+
+LONG prof_getsockname(LONG s, void *name, void *namelen)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+    LONG rc = getsockname(s, name, namelen);
+
+    end(PROF_GETSOCKNAME, counted, &t, rc, rc < 0, s, 0, 0, 0);
+    return rc;
+}
+
+LONG prof_getpeername(LONG s, void *name, void *namelen)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+    LONG rc = getpeername(s, name, namelen);
+
+    end(PROF_GETPEERNAME, counted, &t, rc, rc < 0, s, 0, 0, 0);
+    return rc;
+}
+
+LONG prof_CloseSocket(LONG s)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+    LONG rc = CloseSocket(s);
+
+    end(PROF_CLOSESOCKET, counted, &t, rc, rc < 0, s, 0, 0, 0);
+    return rc;
+}
+
+LONG prof_IoctlSocket(LONG s, ULONG request, void *argp)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+    LONG rc = IoctlSocket(s, request, argp);
+
+    end(PROF_IOCTLSOCKET, counted, &t, rc, rc < 0, s, (LONG)request, 0, 0);
+    return rc;
+}
+
+LONG prof_WaitSelect(LONG nfds, fd_set *readfds, fd_set *writefds,
+                     fd_set *exceptfds, struct timeval *timeout,
+                     ULONG *maskp)
+{
+    struct bst_timestamp t;
+    ULONG mask_in = maskp ? *maskp : 0;
+    LONG timeout_ms = timeout ? (LONG)(timeout->tv_sec * 1000 +
+                                       timeout->tv_usec / 1000) : -1;
+    int counted = begin(&t);
+    LONG rc = WaitSelect(nfds, readfds, writefds, exceptfds, timeout,
+                         maskp);
+
+    end(PROF_WAITSELECT, counted, &t, rc, rc < 0, nfds, timeout_ms,
+        (LONG)mask_in, maskp ? (LONG)*maskp : 0);
+    return rc;
+}
+
+void prof_SetSocketSignals(ULONG intr, ULONG io, ULONG urg)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+
+    SetSocketSignals(intr, io, urg);
+    end(PROF_SETSOCKETSIGNALS, counted, &t, 0, 0,
+        (LONG)intr, (LONG)io, (LONG)urg, 0);
+}
+
+LONG prof_getdtablesize(void)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+    LONG rc = getdtablesize();
+
+    end(PROF_GETDTABLESIZE, counted, &t, rc, rc < 0, 0, 0, 0, 0);
+    return rc;
+}
+
+LONG prof_ObtainSocket(LONG id, LONG domain, LONG type, LONG protocol)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+    LONG rc = ObtainSocket(id, domain, type, protocol);
+
+    end(PROF_OBTAINSOCKET, counted, &t, rc, rc < 0,
+        id, domain, type, protocol);
+    return rc;
+}
+
+LONG prof_ReleaseSocket(LONG s, LONG id)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+    LONG rc = ReleaseSocket(s, id);
+
+    end(PROF_RELEASESOCKET, counted, &t, rc, rc == -1, s, id, 0, 0);
+    return rc;
+}
+
+LONG prof_ReleaseCopyOfSocket(LONG s, LONG id)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+    LONG rc = ReleaseCopyOfSocket(s, id);
+
+    end(PROF_RELEASECOPYOFSOCKET, counted, &t, rc, rc == -1, s, id, 0, 0);
+    return rc;
+}
+
+LONG prof_Errno(void)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+    LONG rc = Errno();
+
+    end(PROF_ERRNO, counted, &t, rc, 0, 0, 0, 0, 0);
+    return rc;
+}
+
+void prof_SetErrnoPtr(void *ptr, LONG size)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+
+    SetErrnoPtr(ptr, size);
+    end(PROF_SETERRNOPTR, counted, &t, 0, 0, size, 0, 0, 0);
+}
+
+STRPTR prof_Inet_NtoA(ULONG in)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+    STRPTR rc = Inet_NtoA(in);
+
+    end(PROF_INET_NTOA, counted, &t, rc != NULL, rc == NULL,
+        (LONG)in, 0, 0, 0);
+    return rc;
+}
+
+ULONG prof_inet_addr(const void *cp)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+    ULONG rc = inet_addr(cp);
+
+    end(PROF_INET_ADDR, counted, &t, (LONG)rc, rc == 0xFFFFFFFFUL, 0, 0, 0, 0);
+    return rc;
+}
+
+ULONG prof_Inet_LnaOf(ULONG in)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+    ULONG rc = Inet_LnaOf(in);
+
+    end(PROF_INET_LNAOF, counted, &t, (LONG)rc, 0, (LONG)in, 0, 0, 0);
+    return rc;
+}
+
+ULONG prof_Inet_NetOf(ULONG in)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+    ULONG rc = Inet_NetOf(in);
+
+    end(PROF_INET_NETOF, counted, &t, (LONG)rc, 0, (LONG)in, 0, 0, 0);
+    return rc;
+}
+
+ULONG prof_Inet_MakeAddr(ULONG net, ULONG host)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+    ULONG rc = Inet_MakeAddr(net, host);
+
+    end(PROF_INET_MAKEADDR, counted, &t, (LONG)rc, 0,
+        (LONG)net, (LONG)host, 0, 0);
+    return rc;
+}
+
+ULONG prof_inet_network(const void *cp)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+    ULONG rc = inet_network(cp);
+
+    end(PROF_INET_NETWORK, counted, &t, (LONG)rc, rc == 0xFFFFFFFFUL,
+        0, 0, 0, 0);
+    return rc;
+}
+
+struct hostent *prof_gethostbyname(const void *name)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+    struct hostent *rc = gethostbyname(name);
+
+    end(PROF_GETHOSTBYNAME, counted, &t, rc != NULL, rc == NULL, 0, 0, 0, 0);
+    return rc;
+}
+
+struct hostent *prof_gethostbyaddr(const void *addr, LONG len, LONG type)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+    struct hostent *rc = gethostbyaddr(addr, len, type);
+
+    end(PROF_GETHOSTBYADDR, counted, &t, rc != NULL, rc == NULL,
+        len, type, 0, 0);
+    return rc;
+}
+
+struct netent *prof_getnetbyname(const void *name)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+    struct netent *rc = getnetbyname(name);
+
+    end(PROF_GETNETBYNAME, counted, &t, rc != NULL, rc == NULL, 0, 0, 0, 0);
+    return rc;
+}
+
+struct netent *prof_getnetbyaddr(ULONG net, LONG type)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+    struct netent *rc = getnetbyaddr(net, type);
+
+    end(PROF_GETNETBYADDR, counted, &t, rc != NULL, rc == NULL,
+        (LONG)net, type, 0, 0);
+    return rc;
+}
+
+struct servent *prof_getservbyname(const void *name, const void *proto)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+    struct servent *rc = getservbyname(name, proto);
+
+    end(PROF_GETSERVBYNAME, counted, &t, rc != NULL, rc == NULL, 0, 0, 0, 0);
+    return rc;
+}
+
+struct servent *prof_getservbyport(LONG port, const void *proto)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+    struct servent *rc = getservbyport(port, proto);
+
+    end(PROF_GETSERVBYPORT, counted, &t, rc != NULL, rc == NULL,
+        port, 0, 0, 0);
+    return rc;
+}
+
+struct protoent *prof_getprotobyname(const void *name)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+    struct protoent *rc = getprotobyname(name);
+
+    end(PROF_GETPROTOBYNAME, counted, &t, rc != NULL, rc == NULL, 0, 0, 0, 0);
+    return rc;
+}
+
+struct protoent *prof_getprotobynumber(LONG proto)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+    struct protoent *rc = getprotobynumber(proto);
+
+    end(PROF_GETPROTOBYNUMBER, counted, &t, rc != NULL, rc == NULL,
+        proto, 0, 0, 0);
+    return rc;
+}
+
+void prof_vsyslog(ULONG level, const void *fmt, APTR args)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+
+    vsyslog(level, fmt, args);
+    end(PROF_VSYSLOG, counted, &t, 0, 0, (LONG)level, 0, 0, 0);
+}
+
+LONG prof_Dup2Socket(LONG old, LONG newfd)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+    LONG rc = Dup2Socket(old, newfd);
+
+    end(PROF_DUP2SOCKET, counted, &t, rc, rc < 0, old, newfd, 0, 0);
+    return rc;
+}
+
+LONG prof_gethostname(void *name, LONG len)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+    LONG rc = gethostname(name, len);
+
+    end(PROF_GETHOSTNAME, counted, &t, rc, rc < 0, len, 0, 0, 0);
+    return rc;
+}
+
+ULONG prof_gethostid(void)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+    ULONG rc = gethostid();
+
+    end(PROF_GETHOSTID, counted, &t, (LONG)rc, 0, 0, 0, 0, 0);
+    return rc;
+}
+
+/* The tag list is rebuilt from the arguments, as the stack-based
+ * SocketBaseTags() stubs do; a non-zero result is the index of the
+ * tag the library refused. */
+LONG prof_SocketBaseTags(ULONG tag, ...)
+{
+    struct TagItem tags[MAX_PROFILE_TAGS + 1];
+    struct bst_timestamp t;
+    int counted, n = 0;
+    va_list ap;
+    LONG rc;
+
+    va_start(ap, tag);
+    tags[0].ti_Tag = tag;
+    while (tags[n].ti_Tag != TAG_DONE && n < MAX_PROFILE_TAGS) {
+        tags[n].ti_Data = va_arg(ap, ULONG);
+        tags[++n].ti_Tag = va_arg(ap, ULONG);
+    }
+    va_end(ap);
+    tags[n].ti_Tag = TAG_DONE;
+    tags[n].ti_Data = 0;
+
+    counted = begin(&t);
+    rc = SocketBaseTagList(tags);
+    end(PROF_SOCKETBASETAGS, counted, &t, rc, rc != 0,
+        (LONG)tags[0].ti_Tag, (LONG)tags[0].ti_Data, n, 0);
+    return rc;
+}
+
+LONG prof_GetSocketEvents(ULONG *mask)
+{
+    struct bst_timestamp t;
+    int counted = begin(&t);
+    LONG rc = GetSocketEvents(mask);
+
+    end(PROF_GETSOCKETEVENTS, counted, &t, rc, rc < 0,
+        mask ? (LONG)*mask : 0, 0, 0, 0);
+    return rc;
+}
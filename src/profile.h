@@ -0,0 +1,253 @@
+/*
+ * bsdsocktest — Socket call profile (PROFILE/S)
+ *
+ * Test code calls bsdsocket.library through wrappers that count each
+ * call, its errors and its time with timer_now().  A file opts in by
+ * including this header; it includes <proto/bsdsocket.h> itself and
+ * then redirects the calls, so the include order does not matter.
+ * The wrappers cost one test of a flag while profiling is off.
+ */
+
+#ifndef BSDSOCKTEST_PROFILE_H
+#define BSDSOCKTEST_PROFILE_H
+
+#include <exec/types.h>
+#include <proto/bsdsocket.h>
+
+/* Calls profiled, in the order of the table names */
+enum profile_call {
+    PROF_SOCKET,
+    PROF_BIND,
+    PROF_LISTEN,
+    PROF_ACCEPT,
+    PROF_CONNECT,
+    PROF_SEND,
+    PROF_RECV,
+    PROF_SENDTO,
+    PROF_RECVFROM,
+    PROF_SENDMSG,
+    PROF_RECVMSG,
+    PROF_SHUTDOWN,
+    PROF_SETSOCKOPT,
+    PROF_GETSOCKOPT,
+    PROF_GETSOCKNAME,
+    PROF_GETPEERNAME,
+    PROF_CLOSESOCKET,
+    PROF_IOCTLSOCKET,
+    PROF_WAITSELECT,
+    PROF_SETSOCKETSIGNALS,
+    PROF_GETDTABLESIZE,
+    PROF_OBTAINSOCKET,
+    PROF_RELEASESOCKET,
+    PROF_RELEASECOPYOFSOCKET,
+    PROF_ERRNO,
+    PROF_SETERRNOPTR,
+    PROF_INET_NTOA,
+    PROF_INET_ADDR,
+    PROF_INET_LNAOF,
+    PROF_INET_NETOF,
+    PROF_INET_MAKEADDR,
+    PROF_INET_NETWORK,
+    PROF_GETHOSTBYNAME,
+    PROF_GETHOSTBYADDR,
+    PROF_GETNETBYNAME,
+    PROF_GETNETBYADDR,
+    PROF_GETSERVBYNAME,
+    PROF_GETSERVBYPORT,
+    PROF_GETPROTOBYNAME,
+    PROF_GETPROTOBYNUMBER,
+    PROF_VSYSLOG,
+    PROF_DUP2SOCKET,
+    PROF_GETHOSTNAME,
+    PROF_GETHOSTID,
+    PROF_SOCKETBASETAGS,
+    PROF_GETSOCKETEVENTS,
+    PROF_COUNT
+};
+
+/* One call's totals */
+struct profile_stat {
+    ULONG calls;
+    ULONG errors;       /* -1 (or NULL) returns */
+    ULONG total_us;
+    ULONG max_us;
+};
+
+/* Start or stop counting (PROFILE/S). */
+void profile_enable(int flag);
+
+/* Non-zero if PROFILE is on. */
+int profile_enabled(void);
+
+/* Stop counting the suite's own calls (port probes, leak checks) and
+ * start again.  Calls nest. */
+void profile_suspend(void);
+void profile_resume(void);
+
+/* Name of a call, as in the table. */
+const char *profile_name(int call);
+
+/* Call number for a table name, or -1. */
+int profile_lookup(const char *name);
+
+/* Totals of a call so far. */
+const struct profile_stat *profile_get(int call);
+
+/* Add a worker's totals for a call (PARALLEL import). */
+void profile_add(int call, const struct profile_stat *st);
+
+/* ---- Wrappers ---- */
+
+LONG prof_socket(LONG domain, LONG type, LONG protocol);
+LONG prof_bind(LONG s, const void *name, LONG namelen);
+LONG prof_listen(LONG s, LONG backlog);
+LONG prof_accept(LONG s, void *addr, void *addrlen);
+LONG prof_connect(LONG s, const void *name, LONG namelen);
+LONG prof_send(LONG s, const void *msg, LONG len, LONG flags);
+LONG prof_recv(LONG s, void *buf, LONG len, LONG flags);
+LONG prof_sendto(LONG s, const void *msg, LONG len, LONG flags,
+                 const void *to, LONG tolen);
+LONG prof_recvfrom(LONG s, void *buf, LONG len, LONG flags,
+                   void *from, void *fromlen);
+LONG prof_sendmsg(LONG s, const struct msghdr *msg, LONG flags);
+LONG prof_recvmsg(LONG s, struct msghdr *msg, LONG flags);
+LONG prof_shutdown(LONG s, LONG how);
+LONG prof_setsockopt(LONG s, LONG level, LONG optname,
+                     const void *optval, LONG optlen);
+LONG prof_getsockopt(LONG s, LONG level, LONG optname,
+                     void *optval, void *optlen);
+LONG prof_getsockname(LONG s, void *name, void *namelen);
+LONG prof_getpeername(LONG s, void *name, void *namelen);
+LONG prof_CloseSocket(LONG s);
+LONG prof_IoctlSocket(LONG s, ULONG request, void *argp);
+LONG prof_WaitSelect(LONG nfds, fd_set *readfds, fd_set *writefds,
+                     fd_set *exceptfds, struct timeval *timeout,
+                     ULONG *maskp);
+void prof_SetSocketSignals(ULONG intr, ULONG io, ULONG urg);
+LONG prof_getdtablesize(void);
+LONG prof_ObtainSocket(LONG id, LONG domain, LONG type, LONG protocol);
+LONG prof_ReleaseSocket(LONG s, LONG id);
+LONG prof_ReleaseCopyOfSocket(LONG s, LONG id);
+LONG prof_Errno(void);
+void prof_SetErrnoPtr(void *ptr, LONG size);
+STRPTR prof_Inet_NtoA(ULONG in);
+ULONG prof_inet_addr(const void *cp);
+ULONG prof_Inet_LnaOf(ULONG in);
+ULONG prof_Inet_NetOf(ULONG in);
+ULONG prof_Inet_MakeAddr(ULONG net, ULONG host);
+ULONG prof_inet_network(const void *cp);
+struct hostent *prof_gethostbyname(const void *name);
+struct hostent *prof_gethostbyaddr(const void *addr, LONG len, LONG type);
+struct netent *prof_getnetbyname(const void *name);
+struct netent *prof_getnetbyaddr(ULONG net, LONG type);
+struct servent *prof_getservbyname(const void *name, const void *proto);
+struct servent *prof_getservbyport(LONG port, const void *proto);
+struct protoent *prof_getprotobyname(const void *name);
+struct protoent *prof_getprotobynumber(LONG proto);
+void prof_vsyslog(ULONG level, const void *fmt, APTR args);
+LONG prof_Dup2Socket(LONG old, LONG newfd);
+LONG prof_gethostname(void *name, LONG len);
+ULONG prof_gethostid(void);
+LONG prof_SocketBaseTags(ULONG tag, ...);
+LONG prof_GetSocketEvents(ULONG *mask);
+
+/* profile.c calls the library itself */
+#ifndef PROFILE_IMPL
+
+#undef socket
+#undef bind
+#undef listen
+#undef accept
+#undef connect
+#undef send
+#undef recv
+#undef sendto
+#undef recvfrom
+#undef sendmsg
+#undef recvmsg
+#undef shutdown
+#undef setsockopt
+#undef getsockopt
+#undef getsockname
+#undef getpeername
+#undef CloseSocket
+#undef IoctlSocket
+#undef WaitSelect
+#undef SetSocketSignals
+#undef getdtablesize
+#undef ObtainSocket
+#undef ReleaseSocket
+#undef ReleaseCopyOfSocket
+#undef Errno
+#undef SetErrnoPtr
+#undef Inet_NtoA
+#undef inet_addr
+#undef Inet_LnaOf
+#undef Inet_NetOf
+#undef Inet_MakeAddr
+#undef inet_network
+#undef gethostbyname
+#undef gethostbyaddr
+#undef getnetbyname
+#undef getnetbyaddr
+#undef getservbyname
+#undef getservbyport
+#undef getprotobyname
+#undef getprotobynumber
+#undef vsyslog
+#undef Dup2Socket
+#undef gethostname
+#undef gethostid
+#undef SocketBaseTags
+#undef GetSocketEvents
+
+#define socket(d, t, p)             prof_socket(d, t, p)
+#define bind(s, a, l)               prof_bind(s, a, l)
+#define listen(s, b)                prof_listen(s, b)
+#define accept(s, a, l)             prof_accept(s, a, l)
+#define connect(s, a, l)            prof_connect(s, a, l)
+#define send(s, b, l, f)            prof_send(s, b, l, f)
+#define recv(s, b, l, f)            prof_recv(s, b, l, f)
+#define sendto(s, b, l, f, a, al)   prof_sendto(s, b, l, f, a, al)
+#define recvfrom(s, b, l, f, a, al) prof_recvfrom(s, b, l, f, a, al)
+#define sendmsg(s, m, f)            prof_sendmsg(s, m, f)
+#define recvmsg(s, m, f)            prof_recvmsg(s, m, f)
+#define shutdown(s, h)              prof_shutdown(s, h)
+#define setsockopt(s, l, o, v, n)   prof_setsockopt(s, l, o, v, n)
+#define getsockopt(s, l, o, v, n)   prof_getsockopt(s, l, o, v, n)
+#define getsockname(s, a, l)        prof_getsockname(s, a, l)
+#define getpeername(s, a, l)        prof_getpeername(s, a, l)
+#define CloseSocket(s)              prof_CloseSocket(s)
+#define IoctlSocket(s, r, a)        prof_IoctlSocket(s, r, a)
+#define WaitSelect(n, r, w, e, t, m) prof_WaitSelect(n, r, w, e, t, m)
+#define SetSocketSignals(i, o, u)   prof_SetSocketSignals(i, o, u)
+#define getdtablesize()             prof_getdtablesize()
+#define ObtainSocket(i, d, t, p)    prof_ObtainSocket(i, d, t, p)
+#define ReleaseSocket(s, i)         prof_ReleaseSocket(s, i)
+#define ReleaseCopyOfSocket(s, i)   prof_ReleaseCopyOfSocket(s, i)
+#define Errno()                     prof_Errno()
+#define SetErrnoPtr(p, s)           prof_SetErrnoPtr(p, s)
+#define Inet_NtoA(a)                prof_Inet_NtoA(a)
+#define inet_addr(c)                prof_inet_addr(c)
+#define Inet_LnaOf(a)               prof_Inet_LnaOf(a)
+#define Inet_NetOf(a)               prof_Inet_NetOf(a)
+#define Inet_MakeAddr(n, h)         prof_Inet_MakeAddr(n, h)
+#define inet_network(c)             prof_inet_network(c)
+#define gethostbyname(n)            prof_gethostbyname(n)
+#define gethostbyaddr(a, l, t)      prof_gethostbyaddr(a, l, t)
+#define getnetbyname(n)             prof_getnetbyname(n)
+#define getnetbyaddr(n, t)          prof_getnetbyaddr(n, t)
+#define getservbyname(n, p)         prof_getservbyname(n, p)
+#define getservbyport(n, p)         prof_getservbyport(n, p)
+#define getprotobyname(n)           prof_getprotobyname(n)
+#define getprotobynumber(n)         prof_getprotobynumber(n)
+#define vsyslog(l, f, a)            prof_vsyslog(l, f, a)
+#define Dup2Socket(o, n)            prof_Dup2Socket(o, n)
+#define gethostname(n, l)           prof_gethostname(n, l)
+#define gethostid()                 prof_gethostid()
+#define SocketBaseTags(...)         prof_SocketBaseTags(__VA_ARGS__)
+#define GetSocketEvents(m)          prof_GetSocketEvents(m)
+
+#endif /* PROFILE_IMPL */
+
+#endif /* BSDSOCKTEST_PROFILE_H */
@@ -0,0 +1,316 @@
+/*
+ * bsdsocktest — Machine-readable result reports
+ *
+ * JUnit XML:  one <testsuite> per category, one <testcase> per test.
+ *             Known stack limitations become <skipped type="known">, so
+ *             they do not fail a CI build; metrics become testcase
+ *             <properties>.  A testcase stays open until the next result
+ *             so that metrics reported after tap_ok() still land in it.
+ * JSON Lines: one object per line with a "type" of run, category,
+ *             test, metric, category_end, bail or summary.
+ */
+
+#include "report.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static FILE *rfp;
+static int rformat;
+
+/* JUnit: state of the open <testsuite> / <testcase> */
+static int suite_open;
+static int case_open;
+static int props_open;
+static int case_status;
+static char case_reason[128];
+
+/* JSON: number of the result metrics belong to */
+static int last_test;
+
+static const char *status_names[] = {
+    "pass", "fail", "known", "skip", "timeout"
+};
+
+/* ---- Escaping ---- */
+
+/* Amiga text is Latin-1, whose codes are the Unicode code points; the
+ * reports are UTF-8, so bytes from 0x80 up are written as references */
+
+static void put_xml(const char *s)
+{
+    for (; *s; s++) {
+        switch (*s) {
+        case '&':  fputs("&amp;", rfp); break;
+        case '<':  fputs("&lt;", rfp); break;
+        case '>':  fputs("&gt;", rfp); break;
+        case '"':  fputs("&quot;", rfp); break;
+        default:
+            if ((unsigned char)*s >= 0x80)
+                fprintf(rfp, "&#x%02X;", (unsigned int)(unsigned char)*s);
+            else if ((unsigned char)*s >= 0x20 || *s == '\t')
+                fputc(*s, rfp);
+            break;
+        }
+    }
+}
+
+static void put_json(const char *s)
+{
+    fputc('"', rfp);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\')
+            fprintf(rfp, "\\%c", *s);
+        else if ((unsigned char)*s < 0x20 || (unsigned char)*s >= 0x80)
+            fprintf(rfp, "\\u%04x", (unsigned int)(unsigned char)*s);
+        else
+            fputc(*s, rfp);
+    }
+    fputc('"', rfp);
+}
+
+/* ---- JUnit helpers ---- */
+
+static void junit_close_case(void)
+{
+    if (!case_open)
+        return;
+    if (props_open)
+        fputs("      </properties>\n", rfp);
+    switch (case_status) {
+    case REPORT_FAIL:
+        fputs("      <failure message=\"", rfp);
+        put_xml(case_reason[0] ? case_reason : "failed");
+        fputs("\"/>\n", rfp);
+        break;
+    case REPORT_TIMEOUT:
+        fputs("      <failure type=\"timeout\" message=\"", rfp);
+        put_xml(case_reason);
+        fputs("\"/>\n", rfp);
+        break;
+    case REPORT_KNOWN:
+        fputs("      <skipped type=\"known\" message=\"", rfp);
+        put_xml(case_reason);
+        fputs("\"/>\n", rfp);
+        break;
+    case REPORT_SKIP:
+        fputs("      <skipped message=\"", rfp);
+        put_xml(case_reason);
+        fputs("\"/>\n", rfp);
+        break;
+    }
+    fputs("    </testcase>\n", rfp);
+    case_open = 0;
+    props_open = 0;
+}
+
+static void junit_close_suite(void)
+{
+    junit_close_case();
+    if (suite_open)
+        fputs("  </testsuite>\n", rfp);
+    suite_open = 0;
+}
+
+/* ---- Public API ---- */
+
+int report_parse_format(const char *name)
+{
+    if (stricmp(name, "TAP") == 0)
+        return REPORT_NONE;
+    if (stricmp(name, "JUNIT") == 0)
+        return REPORT_JUNIT;
+    if (stricmp(name, "JSON") == 0)
+        return REPORT_JSON;
+    return -1;
+}
+
+const char *report_default_path(int format)
+{
+    return (format == REPORT_JUNIT) ? "bsdsocktest.xml" : "bsdsocktest.jsonl";
+}
+
+int report_open(int format, const char *path, const char *bsdlib_version)
+{
+    rformat = format;
+    suite_open = 0;
+    case_open = 0;
+    last_test = 0;
+    if (format == REPORT_NONE)
+        return 1;
+
+    rfp = fopen(path, "w");
+    if (!rfp) {
+        rformat = REPORT_NONE;
+        return 0;
+    }
+
+    if (!bsdlib_version)
+        bsdlib_version = "not available";
+    if (rformat == REPORT_JUNIT) {
+        fputs("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n", rfp);
+        fputs("<testsuites name=\"bsdsocktest\">\n", rfp);
+        fputs("  <!-- bsdsocket.library: ", rfp);
+        put_xml(bsdlib_version);
+        fputs(" -->\n", rfp);
+    } else {
+        fputs("{\"type\":\"run\",\"library\":", rfp);
+        put_json(bsdlib_version);
+        fputs("}\n", rfp);
+    }
+    return 1;
+}
+
+void report_begin_category(const char *name)
+{
+    if (!rfp)
+        return;
+
+    if (rformat == REPORT_JUNIT) {
+        junit_close_suite();
+        fputs("  <testsuite name=\"", rfp);
+        put_xml(name);
+        fputs("\">\n", rfp);
+        suite_open = 1;
+    } else {
+        fputs("{\"type\":\"category\",\"name\":", rfp);
+        put_json(name);
+        fputs("}\n", rfp);
+    }
+}
+
+void report_result(const char *category, int test_num,
+                   const char *description, int status,
+                   const char *stack, const char *reason, ULONG us)
+{
+    if (!rfp)
+        return;
+
+    if (rformat == REPORT_JUNIT) {
+        junit_close_case();
+        fputs("    <testcase classname=\"bsdsocktest.", rfp);
+        put_xml(category);
+        fprintf(rfp, "\" name=\"%d - ", test_num);
+        put_xml(description);
+        fprintf(rfp, "\" time=\"%lu.%06lu\">\n", us / 1000000, us % 1000000);
+        case_open = 1;
+        case_status = status;
+        case_reason[0] = '\0';
+        if (reason) {
+            if (status == REPORT_KNOWN)
+                sprintf(case_reason, "KNOWN %.20s: ", stack);
+            strncat(case_reason, reason,
+                    sizeof(case_reason) - strlen(case_reason) - 1);
+        }
+        /* A known issue that passed anyway: worth surfacing */
+        if (status == REPORT_PASS && reason) {
+            fputs("      <properties>\n", rfp);
+            fputs("        <property name=\"known\" value=\"", rfp);
+            put_xml(case_reason);
+            fputs("\"/>\n", rfp);
+            props_open = 1;
+        }
+    } else {
+        fputs("{\"type\":\"test\",\"category\":", rfp);
+        put_json(category);
+        fprintf(rfp, ",\"num\":%d,\"description\":", test_num);
+        put_json(description);
+        fprintf(rfp, ",\"status\":\"%s\"", status_names[status]);
+        if (reason) {
+            fputs(",\"reason\":", rfp);
+            put_json(reason);
+            if (status != REPORT_SKIP) {
+                fputs(",\"stack\":", rfp);
+                put_json(stack);
+            }
+        }
+        fprintf(rfp, ",\"time_ms\":%lu.%03lu}\n", us / 1000, us % 1000);
+    }
+    last_test = test_num;
+}
+
+void report_metric(const char *name, long value, const char *unit)
+{
+    if (!rfp)
+        return;
+
+    if (rformat == REPORT_JUNIT) {
+        if (!case_open)
+            return;
+        if (!props_open) {
+            fputs("      <properties>\n", rfp);
+            props_open = 1;
+        }
+        fputs("        <property name=\"", rfp);
+        put_xml(name);
+        fprintf(rfp, "\" value=\"%ld", value);
+        if (unit && *unit) {
+            fputc(' ', rfp);
+            put_xml(unit);
+        }
+        fputs("\"/>\n", rfp);
+    } else {
+        fprintf(rfp, "{\"type\":\"metric\",\"num\":%d,\"name\":", last_test);
+        put_json(name);
+        fprintf(rfp, ",\"value\":%ld,\"unit\":", value);
+        put_json(unit ? unit : "");
+        fputs("}\n", rfp);
+    }
+}
+
+void report_end_category(ULONG ms)
+{
+    if (!rfp)
+        return;
+
+    if (rformat == REPORT_JUNIT)
+        junit_close_suite();
+    else
+        fprintf(rfp, "{\"type\":\"category_end\",\"time_ms\":%lu}\n", ms);
+    fflush(rfp);
+}
+
+void report_bail(const char *reason)
+{
+    if (!rfp)
+        return;
+
+    if (rformat == REPORT_JUNIT) {
+        junit_close_case();
+        fputs("  <!-- Bail out! ", rfp);
+        put_xml(reason);
+        fputs(" -->\n", rfp);
+    } else {
+        fputs("{\"type\":\"bail\",\"reason\":", rfp);
+        put_json(reason);
+        fputs("}\n", rfp);
+    }
+    fflush(rfp);
+}
+
+void report_flush(void)
+{
+    if (rfp)
+        fflush(rfp);
+}
+
+void report_close(int passed, int failed, int known, int skipped,
+                  int total, ULONG ms)
+{
+    if (!rfp)
+        return;
+
+    if (rformat == REPORT_JUNIT) {
+        junit_close_suite();
+        fprintf(rfp, "  <!-- Results: %d passed, %d failed, %d known, "
+                "%d skipped (%d total) in %lu.%03lus -->\n",
+                passed, failed, known, skipped, total, ms / 1000, ms % 1000);
+        fputs("</testsuites>\n", rfp);
+    } else {
+        fprintf(rfp, "{\"type\":\"summary\",\"passed\":%d,\"failed\":%d,"
+                "\"known\":%d,\"skipped\":%d,\"total\":%d,\"time_ms\":%lu}\n",
+                passed, failed, known, skipped, total, ms);
+    }
+    fclose(rfp);
+    rfp = NULL;
+}
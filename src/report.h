@@ -0,0 +1,64 @@
+/*
+ * bsdsocktest — Machine-readable result reports
+ *
+ * Optional second output next to the TAP log, for CI systems: JUnit
+ * XML or JSON Lines.  Driven by the TAP framework (tap.c), which hands
+ * over every result, skip, known issue and benchmark metric as it is
+ * recorded.  Records are written as they arrive and nothing is kept in
+ * memory, so a run that crashes the emulator leaves everything up to
+ * the last flush.  JSON Lines stays parseable line by line after a
+ * crash; JUnit XML is only well-formed once report_close() has run.
+ */
+
+#ifndef BSDSOCKTEST_REPORT_H
+#define BSDSOCKTEST_REPORT_H
+
+#include <exec/types.h>
+
+/* Report formats */
+#define REPORT_NONE   0
+#define REPORT_JUNIT  1
+#define REPORT_JSON   2
+
+/* Result status */
+#define REPORT_PASS   0
+#define REPORT_FAIL   1
+#define REPORT_KNOWN  2     /* known stack limitation, not a CI failure */
+#define REPORT_SKIP   3
+#define REPORT_TIMEOUT 4    /* failed once the watchdog had expired */
+
+/* Map a FORMAT argument ("TAP", "JUNIT", "JSON") to a REPORT_* value.
+ * Returns -1 if unrecognized. */
+int report_parse_format(const char *name);
+
+/* Default file name for a format ("bsdsocktest.xml" ...). */
+const char *report_default_path(int format);
+
+/* Open the report file and write its header.
+ * Returns 1 on success, 0 if the file could not be opened. */
+int report_open(int format, const char *path, const char *bsdlib_version);
+
+void report_begin_category(const char *name);
+
+/* One test result.  category: "" outside categories.  reason:
+ * known-issue reason (also for a known issue that unexpectedly passed),
+ * skip reason or timeout; NULL otherwise. */
+void report_result(const char *category, int test_num,
+                   const char *description, int status,
+                   const char *stack, const char *reason, ULONG us);
+
+/* Benchmark metric attached to the most recent result. */
+void report_metric(const char *name, long value, const char *unit);
+
+void report_end_category(ULONG ms);
+
+void report_bail(const char *reason);
+
+/* Push buffered output to disk. */
+void report_flush(void);
+
+/* Write totals and close the file.  Safe to call if not open. */
+void report_close(int passed, int failed, int known, int skipped,
+                  int total, ULONG ms);
+
+#endif /* BSDSOCKTEST_REPORT_H */
@@ -6,7 +6,11 @@
  */
 
 #include "tap.h"
+#include "helper_proto.h"
 #include "known_failures.h"
+#include "report.h"
+#include "testutil.h"
+#include "profile.h"
 
 #include <stdio.h>
 #include <stdarg.h>
@@ -27,6 +31,20 @@
 /* Maximum notable results per category */
 #define MAX_NOTES 8
 
+/* Slowest tests listed by tap_finish() */
+#define MAX_SLOWEST 10
+
+/* Highest test number the pass tally can hold, and the most tallied
+ * tests listed on screen in full */
+#define MAX_TALLY        255
+#define MAX_TALLY_SCREEN 20
+
+/* Socket calls listed on screen by the profile (PROFILE) */
+#define MAX_PROFILE_SCREEN 8
+
+/* Buffered log size; the buffer is flushed before each test */
+#define LOG_BUFSIZE  8192
+
 /* CSI bold on / bold off (AmigaOS native, works in all CON: windows) */
 #define CSI_BOLD  "\x9B" "1m"
 #define CSI_RESET "\x9B" "0m"
@@ -34,13 +52,58 @@
 /* ---- Global state ---- */
 
 static int test_number;        /* Global test counter (all tests) */
+static int result_seq;         /* Number in the TAP stream */
+static int sequential;         /* TIMES, REPEAT: numbered in run order */
 static int passed_count;       /* Clean passes + skips */
 static int failed_count;       /* Unexpected failures */
 static int known_count;        /* Known stack limitations */
 static int skipped_count;      /* Skipped tests */
+static int timeout_count;      /* Tests interrupted by the watchdog */
+static int leak_count;         /* Tests that leaked (LEAKCHECK) */
 static int bailed_out;
 static int verbose;
 static FILE *logfp;
+static int log_sync;            /* LOGSYNC: unbuffered log */
+static int worker;              /* WORKER: notes marked for the import */
+static char log_buf[LOG_BUFSIZE];
+static int report_format;       /* FORMAT: REPORT_* */
+static const char *report_path;
+static const char *lib_version;  /* for the stream header */
+static int streaming;           /* STREAM: log mirrored to the helper */
+static char stream_line[256];   /* partial line awaiting its newline */
+static int stream_len;
+
+/* PARALLEL: replay of a worker's log (see tap_import_line) */
+enum import_state {
+    IMPORT_HEADER,      /* worker header, before its category marker */
+    IMPORT_DESC,        /* category description line next */
+    IMPORT_RESULTS,
+    IMPORT_END          /* category end marker or bail out seen */
+};
+static enum import_state import_state;
+static int import_pending;      /* result held until its time line */
+static int import_number;
+static int import_passed;
+static int import_skip;
+static char import_text[256];
+static int import_timeout;      /* held result was marked TIMEOUT */
+static int timeout_next;        /* next result timed out (import) */
+static int import_timed;        /* next result charged import_us */
+static ULONG import_us;
+static int import_cat_timed;    /* category charged import_cat_ms */
+static ULONG import_cat_ms;
+static int import_profile;      /* in the worker's profile table */
+
+/* RESUME: the existing log's totals, carried into the appended run */
+static int resume_last;         /* last result in the log, 0 = none */
+static int resume_seq;          /* its number in the stream */
+static int resume_newline;      /* log ends in a partial line */
+static int resume_passed;       /* results as tap_ok() counts them */
+static int resume_failed;
+static int resume_known;
+static int resume_skipped;
+static int resume_timeouts;
+static ULONG resume_ms;
 
 /* Per-category tracking (reset by tap_begin_category) */
 static char current_category[32];
@@ -56,6 +119,7 @@ static struct {
     char description[128];
 } cat_failures[MAX_FAILURES_DISPLAY];
 static int cat_failure_count;
+static int cat_failures_hidden; /* beyond MAX_FAILURES_DISPLAY */
 
 /* Notable results for screen display under category */
 static char cat_notes[MAX_NOTES][128];
@@ -67,6 +131,32 @@ static int screen_height;   /* detected rows (see detect_screen_size) */
 static int screen_width;    /* detected columns, 0 if unknown */
 static int lines_printed;   /* screen rows since last page break */
 
+/* Timing: each result is charged the time since the previous result
+ * (or the category start).  Only taken inside categories, which run
+ * after timer_init(). */
+static struct bst_timestamp last_mark;
+static struct bst_timestamp cat_start;
+static ULONG total_ms;          /* sum of finished categories */
+static struct {
+    int test_num;
+    ULONG us;
+    char description[64];
+} slowest[MAX_SLOWEST];         /* longest first */
+static int slowest_count;
+
+/* Pass tally per test number (RERUN, TIMES, REPEAT) for the flake
+ * table, with each test's result times */
+static int tally_on;
+static int tally_times;         /* runs per test asked for */
+static struct {
+    UWORD runs;
+    UWORD passes;
+    ULONG total_us;
+    ULONG min_us;
+    ULONG max_us;
+    char description[64];
+} tally[MAX_TALLY + 1];
+
 /* Global screen counters (accumulated from tap_end_category) */
 static int screen_passed;
 static int screen_failed;
@@ -75,27 +165,120 @@ static int screen_skipped;
 
 /* ---- Internal helpers ---- */
 
+/* Send the queued stream lines.  A failed send ends streaming; the
+ * local log notes it, the helper's copy simply stops. */
+static void stream_flush(void)
+{
+    if (!streaming || helper_stream_flush())
+        return;
+    streaming = 0;
+    if (logfp)
+        fputs("# stream: helper connection lost, mirroring stopped\n", logfp);
+}
+
+/* Mirror log text to the helper, one LOG command per complete line.
+ * Lines longer than stream_line are truncated. */
+static void stream_text(const char *text)
+{
+    for (; *text; text++) {
+        if (*text != '\n') {
+            if (stream_len < (int)sizeof(stream_line) - 1)
+                stream_line[stream_len++] = *text;
+            continue;
+        }
+        stream_line[stream_len] = '\0';
+        stream_len = 0;
+        helper_stream_line(stream_line);
+        if (log_sync)
+            stream_flush();
+    }
+}
+
+/* Write text to the log file (and the stream) */
+static void log_write(const char *text)
+{
+    if (logfp)
+        fputs(text, logfp);
+    if (streaming)
+        stream_text(text);
+}
+
 /* Write formatted output to log file only */
 static void log_printf(const char *fmt, ...)
 {
+    char buf[512];
     va_list ap;
 
-    if (!logfp)
+    if (!logfp && !streaming)
         return;
 
     va_start(ap, fmt);
-    vfprintf(logfp, fmt, ap);
+    vsnprintf(buf, sizeof(buf), fmt, ap);
     va_end(ap);
+    log_write(buf);
 }
 
 /* Write a line to log file only (adds newline) */
 static void log_puts(const char *line)
 {
-    if (!logfp)
-        return;
+    log_write(line);
+    log_write("\n");
+}
 
-    fputs(line, logfp);
-    fputc('\n', logfp);
+/* Milliseconds since 'start'; unlike timer_elapsed_ms() this does not
+ * wrap after 71 minutes, so it also serves for category totals. */
+static ULONG since_ms(const struct bst_timestamp *start,
+                      const struct bst_timestamp *now)
+{
+    return (now->ts_secs - start->ts_secs) * 1000UL +
+           now->ts_micro / 1000 - start->ts_micro / 1000;
+}
+
+/* Push buffered log (and report) output to disk, and queued stream
+ * lines to the helper */
+static void log_flush(void)
+{
+    if (logfp)
+        fflush(logfp);
+    report_flush();
+    stream_flush();
+}
+
+/* Log the time taken by the result just written and remember it if it
+ * is among the slowest.  description is NULL for skips, which are not
+ * ranked.  Returns the time in microseconds. */
+static ULONG time_result(const char *description)
+{
+    struct bst_timestamp now;
+    ULONG us;
+    int i;
+
+    timer_now(&now);
+    us = timer_elapsed_us(&last_mark, &now);
+    last_mark = now;
+    if (import_timed) {
+        us = import_us;
+        import_timed = 0;
+    }
+
+    log_printf("# time=%lu.%03lums\n", us / 1000, us % 1000);
+
+    if (!description)
+        return us;
+    if (slowest_count == MAX_SLOWEST && us <= slowest[MAX_SLOWEST - 1].us)
+        return us;
+
+    /* Insertion into the descending list */
+    i = (slowest_count < MAX_SLOWEST) ? slowest_count++ : MAX_SLOWEST - 1;
+    while (i > 0 && slowest[i - 1].us < us) {
+        slowest[i] = slowest[i - 1];
+        i--;
+    }
+    slowest[i].test_num = test_number;
+    slowest[i].us = us;
+    strncpy(slowest[i].description, description, 63);
+    slowest[i].description[63] = '\0';
+    return us;
 }
 
 /* Print category name with dot-padding to screen */
@@ -239,6 +422,177 @@ static void page_check(void)
     page_advance(1);
 }
 
+/* With sequential numbering the description names the test, as
+ * "test N: ..." or "test N # SKIP ..."; 'sep' follows the number. */
+static const char *result_tag(const char *sep)
+{
+    static char tag[24];
+
+    if (!sequential)
+        return "";
+    sprintf(tag, "test %d%s", test_number, sep);
+    return tag;
+}
+
+/* Split a logged result line.  Sets its stream number, the number of
+ * the test it belongs to and where its description starts.  Returns 1
+ * for ok, 0 for not ok, -1 if the line is not a result. */
+static int parse_result(const char *line, int *seq, int *number,
+                        const char **desc)
+{
+    const char *p;
+    int passed, len = 0;
+
+    if (sscanf(line, "ok %d - ", seq) == 1)
+        passed = 1;
+    else if (sscanf(line, "not ok %d - ", seq) == 1)
+        passed = 0;
+    else
+        return -1;
+
+    p = strstr(line, " - ") + 3;
+    *number = *seq;
+    if (sscanf(p, "test %d%n", number, &len) == 1 && len > 0) {
+        p += len;
+        if (*p == ':')
+            p++;
+        if (*p == ' ')
+            p++;
+    }
+    *desc = p;
+    return passed;
+}
+
+/* Add a result to the test's tally */
+static void tally_result(int passed, const char *description, ULONG us)
+{
+    int n = test_number;
+
+    if (tally[n].runs == 0 || us < tally[n].min_us)
+        tally[n].min_us = us;
+    if (us > tally[n].max_us)
+        tally[n].max_us = us;
+    tally[n].total_us += us;
+    tally[n].runs++;
+    if (passed)
+        tally[n].passes++;
+    strncpy(tally[n].description, description, 63);
+    tally[n].description[63] = '\0';
+}
+
+/* Flake table: each tallied test's passes out of its runs and its
+ * result times, in the log.  A test that both passed and failed is
+ * flaky.  The screen gets the whole table for a short list (RERUN),
+ * otherwise only the tests that did not pass every run. */
+static void print_tally(void)
+{
+    const char *verdict;
+    int i, fails, tested = 0, clean = 0, line_len;
+    ULONG mean;
+
+    for (i = 1; i <= MAX_TALLY; i++) {
+        if (tally[i].runs == 0)
+            continue;
+        tested++;
+        if (tally[i].passes == tally[i].runs)
+            clean++;
+    }
+
+    log_printf("# Flake rates (%d run%s per test):\n", tally_times,
+               tally_times == 1 ? "" : "s");
+    log_printf("#   %4s %-7s  %6s  %-6s  %9s %9s %9s  %s\n", "test",
+               "passed", "failed", "", "min ms", "mean ms", "max ms",
+               "description");
+    printf("\nFlake rates (%d run%s per test):\n", tally_times,
+           tally_times == 1 ? "" : "s");
+    page_check();
+    page_check();
+
+    for (i = 1; i <= MAX_TALLY; i++) {
+        if (tally[i].runs == 0)
+            continue;
+        fails = tally[i].runs - tally[i].passes;
+        if (fails == 0)
+            verdict = "passes";
+        else if (tally[i].passes == 0)
+            verdict = "fails";
+        else
+            verdict = "FLAKY";
+        mean = tally[i].total_us / tally[i].runs;
+        log_printf("#   %3d  %3d/%-3d  %5d%%  %-6s  %5lu.%03lu %5lu.%03lu "
+                   "%5lu.%03lu  %s\n", i,
+                   tally[i].passes, tally[i].runs,
+                   fails * 100 / tally[i].runs, verdict,
+                   tally[i].min_us / 1000, tally[i].min_us % 1000,
+                   mean / 1000, mean % 1000,
+                   tally[i].max_us / 1000, tally[i].max_us % 1000,
+                   tally[i].description);
+        if (fails == 0 && tested > MAX_TALLY_SCREEN)
+            continue;
+        line_len = printf("  %3d %3d/%-3d %-6s %s\n", i, tally[i].passes,
+                          tally[i].runs, verdict, tally[i].description);
+        page_advance(wrap_rows(line_len > 1 ? line_len - 1 : 1));
+    }
+    if (tested > MAX_TALLY_SCREEN) {
+        printf("  %d of %d tests passed every run (times in the log)\n",
+               clean, tested);
+        page_check();
+    }
+}
+
+/* Socket call profile: every call made, most total time first, in
+ * the log; the screen gets the most expensive few.  Worker logs are
+ * read back from this table (tap_import_line). */
+static void print_profile(void)
+{
+    const struct profile_stat *st;
+    int order[PROF_COUNT];
+    int i, j, n = 0, line_len;
+    ULONG mean;
+
+    for (i = 0; i < PROF_COUNT; i++) {
+        st = profile_get(i);
+        if (st->calls == 0)
+            continue;
+        for (j = n; j > 0 && profile_get(order[j - 1])->total_us <
+                             st->total_us; j--)
+            order[j] = order[j - 1];
+        order[j] = i;
+        n++;
+    }
+
+    log_puts("# Socket calls (PROFILE):");
+    log_printf("#   %-19s %8s %7s %11s %9s %9s\n", "call", "calls",
+               "errors", "total ms", "mean us", "max us");
+    printf("\nSocket calls (most time first):\n");
+    page_check();
+    page_check();
+
+    for (i = 0; i < n; i++) {
+        st = profile_get(order[i]);
+        mean = st->total_us / st->calls;
+        log_printf("#   %-19s %8lu %7lu %7lu.%03lu %9lu %9lu\n",
+                   profile_name(order[i]), st->calls, st->errors,
+                   st->total_us / 1000, st->total_us % 1000, mean,
+                   st->max_us);
+        if (i >= MAX_PROFILE_SCREEN)
+            continue;
+        line_len = printf("  %-19s %7lu calls %7lu.%03lums  "
+                          "max %lu.%03lums\n", profile_name(order[i]),
+                          st->calls,
+                          st->total_us / 1000, st->total_us % 1000,
+                          st->max_us / 1000, st->max_us % 1000);
+        page_advance(wrap_rows(line_len > 1 ? line_len - 1 : 1));
+    }
+    if (n > MAX_PROFILE_SCREEN) {
+        printf("  %d more calls in the log\n", n - MAX_PROFILE_SCREEN);
+        page_check();
+    } else if (n == 0) {
+        printf("  none\n");
+        page_check();
+    }
+}
+
 /* ---- Public API ---- */
 
 void tap_init(const char *bsdlib_version, const char *log_path)
@@ -247,9 +601,12 @@ void tap_init(const char *bsdlib_version, const char *log_path)
 
     /* Reset all state */
     test_number = 0;
+    result_seq = 0;
     passed_count = 0;
     failed_count = 0;
     known_count = 0;
+    timeout_count = 0;
+    leak_count = 0;
     skipped_count = 0;
     bailed_out = 0;
     current_category[0] = '\0';
@@ -257,6 +614,25 @@ void tap_init(const char *bsdlib_version, const char *log_path)
     screen_failed = 0;
     screen_known = 0;
     screen_skipped = 0;
+    total_ms = 0;
+    slowest_count = 0;
+    lib_version = bsdlib_version;
+
+    /* RESUME: continue the counts and numbering of the existing log */
+    if (resume_last > 0) {
+        test_number = resume_last;
+        result_seq = resume_seq;
+        passed_count = resume_passed + resume_skipped;
+        failed_count = resume_failed;
+        known_count = resume_known;
+        skipped_count = resume_skipped;
+        timeout_count = resume_timeouts;
+        screen_passed = resume_passed;
+        screen_failed = resume_failed;
+        screen_known = resume_known;
+        screen_skipped = resume_skipped;
+        total_ms = resume_ms;
+    }
 
     /* Open log file */
     if (!log_path)
@@ -264,24 +640,55 @@ void tap_init(const char *bsdlib_version, const char *log_path)
 
     is_nil = (stricmp(log_path, "NIL:") == 0);
 
-    logfp = fopen(log_path, "w");
+    logfp = fopen(log_path, resume_last > 0 ? "a" : "w");
     if (!logfp && !is_nil)
         printf("Warning: could not open log file %s\n", log_path);
 
-    /* Unbuffered: every write hits disk immediately. Essential for
-     * crash diagnosis — if the stack under test crashes the emulator,
-     * the log shows exactly which test was last completed. */
-    if (logfp)
-        setbuf(logfp, NULL);
+    /* Crash diagnosis needs the log to show which test was last
+     * completed if the stack under test crashes the emulator.  Fully
+     * unbuffered output turns every line into several DOS Write()
+     * calls, which costs seconds per category on slow volumes, so the
+     * log is buffered and flushed at category boundaries and before
+     * each test starts, so a test that crashes or hangs the machine
+     * finds every earlier result on disk.  LOGSYNC restores unbuffered
+     * writes for crash hunting. */
+    if (logfp) {
+        if (log_sync)
+            setbuf(logfp, NULL);
+        else
+            setvbuf(logfp, log_buf, _IOFBF, LOG_BUFSIZE);
+    }
 
-    /* Log: full TAP header */
-    log_puts("TAP version 12");
+    /* Log: full TAP header.  A resumed run continues the existing
+     * stream, so only its diagnostics are repeated. */
+    if (resume_last > 0) {
+        if (resume_newline)
+            log_puts("");
+        log_printf("# resumed after test %d\n", resume_last);
+    } else {
+        log_puts("TAP version 12");
+    }
     log_printf("# bsdsocktest %s\n", BSDSOCKTEST_VERSION);
     if (bsdlib_version)
         log_printf("# bsdsocket.library: %s\n", bsdlib_version);
     else
         log_puts("# bsdsocket.library: not available");
 
+    if (log_sync)
+        log_puts("# log: unbuffered (LOGSYNC)");
+    else
+        log_printf("# log: buffered %d bytes, flushed per category "
+                   "and before each test\n", LOG_BUFSIZE);
+
+    if (report_format != REPORT_NONE) {
+        if (!report_path)
+            report_path = report_default_path(report_format);
+        if (report_open(report_format, report_path, bsdlib_version))
+            log_printf("# report: %s\n", report_path);
+        else
+            printf("Warning: could not open report file %s\n", report_path);
+    }
+
     /* Log: pagination diagnostics for debugging screen issues */
     if (page_mode)
         log_printf("# page: height=%d width=%d\n", screen_height, screen_width);
@@ -297,7 +704,11 @@ void tap_init(const char *bsdlib_version, const char *log_path)
 
     /* Show log file path (suppress for NIL:) */
     if (!is_nil && logfp) {
-        printf("Log: %s\n", log_path);
+        if (resume_last > 0)
+            printf("Log: %s (resumed after test %d)\n", log_path,
+                   resume_last);
+        else
+            printf("Log: %s\n", log_path);
         page_check();
     }
 
@@ -305,6 +716,108 @@ void tap_init(const char *bsdlib_version, const char *log_path)
     page_check();
 }
 
+int tap_resume(const char *log_path, int *crashed)
+{
+    FILE *fp;
+    char line[512];
+    const char *p;
+    unsigned long whole, frac;
+    int number, seq, len, result, last = 0, last_seq = 0;
+    int bailed = 0, complete = 0, parallel = 0;
+    int passed = 0, failed = 0, known = 0, skipped = 0, timeouts = 0;
+    ULONG ms = 0;
+
+    *crashed = 0;
+    resume_last = 0;
+    resume_newline = 0;
+    if (!log_path)
+        log_path = "bsdsocktest.log";
+    fp = fopen(log_path, "r");
+    if (!fp)
+        return 0;
+
+    while (fgets(line, sizeof(line), fp)) {
+        len = strlen(line);
+        resume_newline = (len > 0 && line[len - 1] != '\n');
+
+        /* Each run (or resumed run) starts with the program header */
+        if (strncmp(line, "# bsdsocktest ", 14) == 0) {
+            parallel = 0;
+        } else if (strncmp(line, "# parallel: ", 12) == 0) {
+            parallel = 1;
+        } else if (strncmp(line, "Bail out!", 9) == 0) {
+            bailed = 1;
+        } else if (strncmp(line, "# Results: ", 11) == 0) {
+            complete = 1;
+        } else if (sscanf(line, "# %d timed out after", &number) == 1) {
+            timeouts++;
+        } else if (strncmp(line, "# --- ", 6) == 0) {
+            p = strrchr(line, ':');
+            if (p && sscanf(p, ": %lu.%lus", &whole, &frac) == 2)
+                ms += whole * 1000UL + frac;
+        } else if ((result = parse_result(line, &seq, &number, &p)) >= 0) {
+            if (result && strncmp(p, "# SKIP not selected", 19) == 0)
+                continue;
+            if (!result && strstr(line, "  # KNOWN "))
+                known++;
+            else if (!result)
+                failed++;
+            else if (strncmp(p, "# SKIP ", 7) == 0)
+                skipped++;
+            else
+                passed++;
+            last = number;
+            last_seq = seq;
+            bailed = complete = 0;
+        }
+    }
+    fclose(fp);
+
+    if (complete && !bailed)
+        return -1;
+    if (last == 0)
+        return 0;
+
+    /* A run that ended without a bail out was taken down by the test
+     * after its last logged result: the log is flushed before each test
+     * starts.  A parallel run interleaves its categories, so cannot say
+     * which. */
+    *crashed = !bailed && !parallel;
+    resume_last = last;
+    resume_seq = last_seq;
+    resume_passed = passed;
+    resume_failed = failed;
+    resume_known = known;
+    resume_skipped = skipped;
+    resume_timeouts = timeouts;
+    resume_ms = ms;
+    return last;
+}
+
+int tap_read_failures(const char *log_path, int *numbers, int max)
+{
+    FILE *fp;
+    char line[512];
+    const char *desc;
+    int number, seq, i, count = 0;
+
+    fp = fopen(log_path, "r");
+    if (!fp)
+        return -1;
+    while (fgets(line, sizeof(line), fp)) {
+        if (parse_result(line, &seq, &number, &desc) != 0 ||
+            strstr(line, "  # KNOWN "))
+            continue;
+        /* A repeated test may have failed more than once */
+        for (i = 0; i < count && numbers[i] != number; i++)
+            ;
+        if (i == count && count < max)
+            numbers[count++] = number;
+    }
+    fclose(fp);
+    return count;
+}
+
 void tap_plan(int count)
 {
     log_printf("1..%d\n", count);
@@ -313,9 +826,12 @@ void tap_plan(int count)
 void tap_ok(int passed, const char *description)
 {
     const char *kr;
-    int in_cat;
+    char reason[48];
+    int in_cat, status, timeout;
+    ULONG us;
 
     test_number++;
+    result_seq++;
     in_cat = (current_category[0] != '\0');
 
     if (in_cat)
@@ -323,15 +839,24 @@ void tap_ok(int passed, const char *description)
 
     kr = known_check(test_number);
 
+    /* A result written after the watchdog fired comes from a call it
+     * interrupted: the test timed out, whatever it concluded */
+    timeout = timeout_next ? timeout_next : watchdog_expired();
+    timeout_next = 0;
+    if (timeout)
+        passed = 0;
+
     if (passed) {
         if (kr) {
             /* Known limitation unexpectedly passed — stack may have
              * been updated.  Log it with annotation for visibility. */
-            log_printf("ok %d - %s  # KNOWN %s: %s\n",
-                       test_number, description, known_stack_name(), kr);
+            log_printf("ok %d - %s%s  # KNOWN %s: %s\n", result_seq,
+                       result_tag(": "), description, known_stack_name(),
+                       kr);
         } else {
             /* Normal pass */
-            log_printf("ok %d - %s\n", test_number, description);
+            log_printf("ok %d - %s%s\n", result_seq, result_tag(": "),
+                       description);
         }
         passed_count++;
         if (in_cat)
@@ -339,29 +864,59 @@ void tap_ok(int passed, const char *description)
     } else {
         if (kr) {
             /* Known stack limitation — expected failure */
-            log_printf("not ok %d - %s  # KNOWN %s: %s\n",
-                       test_number, description, known_stack_name(), kr);
+            log_printf("not ok %d - %s%s  # KNOWN %s: %s\n", result_seq,
+                       result_tag(": "), description, known_stack_name(),
+                       kr);
             known_count++;
             if (in_cat)
                 cat_known++;
+        } else if (timeout) {
+            log_printf("not ok %d - %s%s  # TIMEOUT %ds\n", result_seq,
+                       result_tag(": "), description, timeout);
         } else {
             /* Unexpected failure */
-            log_printf("not ok %d - %s\n",
-                       test_number, description);
+            log_printf("not ok %d - %s%s\n", result_seq,
+                       result_tag(": "), description);
+        }
+        if (!kr) {
             failed_count++;
             if (in_cat) {
                 cat_failed++;
-                if (cat_failure_count < MAX_FAILURES_DISPLAY) {
+                /* A test run several times in a row is listed once */
+                if (cat_failure_count > 0 &&
+                    cat_failures[cat_failure_count - 1].test_num ==
+                    test_number) {
+                    ;
+                } else if (cat_failure_count < MAX_FAILURES_DISPLAY) {
                     cat_failures[cat_failure_count].test_num = test_number;
                     strncpy(cat_failures[cat_failure_count].description,
                             description, 127);
                     cat_failures[cat_failure_count].description[127] = '\0';
                     cat_failure_count++;
+                } else {
+                    cat_failures_hidden++;
                 }
             }
         }
     }
 
+    us = in_cat ? time_result(description) : 0;
+    if (tally_on && test_number <= MAX_TALLY)
+        tally_result(passed, description, us);
+    if (passed) {
+        status = REPORT_PASS;
+    } else if (kr) {
+        status = REPORT_KNOWN;
+    } else if (timeout) {
+        status = REPORT_TIMEOUT;
+        sprintf(reason, "timed out after %ds (watchdog)", timeout);
+        kr = reason;
+    } else {
+        status = REPORT_FAIL;
+    }
+    report_result(current_category, test_number, description, status,
+                  known_stack_name(), kr, us);
+
     /* Verbose: show individual test line on screen (number-first) */
     if (verbose) {
         int line_len;
@@ -378,6 +933,24 @@ void tap_ok(int passed, const char *description)
     }
 }
 
+void tap_set_next(int number)
+{
+    /* The test about to run may take the machine down (known to crash
+     * or hang, or not yet known to): nothing logged so far is lost */
+    log_flush();
+    test_number = number - 1;
+    if (sequential)
+        return;
+
+    /* Placeholders keep the log a complete TAP stream from 1 to the
+     * highest number run; they are not counted or shown. */
+    while (result_seq + 1 < number) {
+        result_seq++;
+        log_printf("ok %d - # SKIP not selected\n", result_seq);
+    }
+    result_seq = number - 1;
+}
+
 void tap_okf(int passed, const char *fmt, ...)
 {
     char buf[256];
@@ -393,8 +966,10 @@ void tap_okf(int passed, const char *fmt, ...)
 void tap_skip(const char *reason)
 {
     int in_cat;
+    ULONG us;
 
     test_number++;
+    result_seq++;
     passed_count++;
     skipped_count++;
     in_cat = (current_category[0] != '\0');
@@ -404,7 +979,11 @@ void tap_skip(const char *reason)
         cat_skipped++;
     }
 
-    log_printf("ok %d - # SKIP %s\n", test_number, reason);
+    log_printf("ok %d - %s# SKIP %s\n", result_seq, result_tag(" "),
+               reason);
+    us = in_cat ? time_result(NULL) : 0;
+    report_result(current_category, test_number, reason, REPORT_SKIP,
+                  known_stack_name(), reason, us);
 
     if (verbose) {
         int line_len;
@@ -433,8 +1012,8 @@ void tap_diagf(const char *fmt, ...)
 
 void tap_note(const char *msg)
 {
-    /* Log: as diagnostic */
-    log_printf("# %s\n", msg);
+    /* Log: as diagnostic; a worker marks it for tap_import_line() */
+    log_printf(worker ? "# note: %s\n" : "# %s\n", msg);
 
     /* Screen: store for display under category summary */
     if (current_category[0] != '\0' && cat_note_count < MAX_NOTES) {
@@ -456,6 +1035,24 @@ void tap_notef(const char *fmt, ...)
     tap_note(buf);
 }
 
+void tap_timeout(int seconds)
+{
+    timeout_count++;
+    tap_notef("%d timed out after %ds (watchdog)", test_number, seconds);
+}
+
+void tap_leak(const char *what)
+{
+    leak_count++;
+    tap_notef("%d leaked %s", test_number, what);
+}
+
+void tap_metric(const char *name, long value, const char *unit)
+{
+    log_printf("# metric %s=%ld %s\n", name, value, unit);
+    report_metric(name, value, unit);
+}
+
 void tap_begin_category(const char *name)
 {
     strncpy(current_category, name, sizeof(current_category) - 1);
@@ -467,10 +1064,16 @@ void tap_begin_category(const char *name)
     cat_skipped = 0;
     cat_total = 0;
     cat_failure_count = 0;
+    cat_failures_hidden = 0;
     cat_note_count = 0;
 
     /* Log: category marker */
     log_printf("# --- %s ---\n", name);
+    report_begin_category(name);
+
+    timer_now(&cat_start);
+    last_mark = cat_start;
+    log_flush();
 
     /* Screen: progress indicator (non-verbose only).
      * Shows category name with dots while tests run.
@@ -483,9 +1086,23 @@ void tap_begin_category(const char *name)
 
 void tap_end_category(void)
 {
+    struct bst_timestamp now;
+    ULONG cat_ms;
     int total_ran;
     int i;
 
+    timer_now(&now);
+    cat_ms = since_ms(&cat_start, &now);
+    if (import_cat_timed) {
+        cat_ms = import_cat_ms;
+        import_cat_timed = 0;
+    }
+    total_ms += cat_ms;
+    log_printf("# --- %s: %lu.%03lus ---\n",
+               current_category, cat_ms / 1000, cat_ms % 1000);
+    report_end_category(cat_ms);
+    log_flush();
+
     /* Accumulate into global screen counters */
     screen_passed += cat_passed;
     screen_failed += cat_failed;
@@ -512,7 +1129,7 @@ void tap_end_category(void)
         printf("passed");
 
     print_detail_suffix(cat_failed, cat_known, cat_skipped);
-    printf("\n");
+    printf(" [%lu.%lus]\n", cat_ms / 1000, (cat_ms % 1000) / 100);
     page_check();
 
     /* Expand unexpected failures */
@@ -524,9 +1141,8 @@ void tap_end_category(void)
                           cat_failures[i].description);
         page_advance(wrap_rows(line_len > 1 ? line_len - 1 : 1));
     }
-    if (cat_failed > cat_failure_count) {
-        printf("  ... and %d more (see log)\n",
-               cat_failed - cat_failure_count);
+    if (cat_failures_hidden > 0) {
+        printf("  ... and %d more (see log)\n", cat_failures_hidden);
         page_check();
     }
 
@@ -542,12 +1158,155 @@ void tap_end_category(void)
     current_category[0] = '\0';
 }
 
+/* ---- Worker log import (PARALLEL) ---- */
+
+/* Record the held result now that its time is known (or never will
+ * be).  tap_ok() looks the known-failure annotation up again. */
+static void import_flush(void)
+{
+    if (!import_pending)
+        return;
+    import_pending = 0;
+    timeout_next = import_timeout;
+    tap_set_next(import_number);
+    if (import_skip)
+        tap_skip(import_text);
+    else
+        tap_ok(import_passed, import_text);
+}
+
+void tap_import_line(const char *line)
+{
+    const char *p;
+    char *annot;
+    unsigned long whole, frac;
+    char name[64], unit[32];
+    struct profile_stat st;
+    long value;
+    int number, seq, call, len = 0;
+
+    /* Past the category, only the worker's profile is of interest */
+    if (import_state == IMPORT_END) {
+        if (strcmp(line, "# Socket calls (PROFILE):") == 0)
+            import_profile = 1;
+        else if (import_profile &&
+                 sscanf(line, "#   %63s %lu %lu %lu.%lu %*s %lu", name,
+                        &st.calls, &st.errors, &whole, &frac,
+                        &st.max_us) == 6 &&
+                 (call = profile_lookup(name)) >= 0) {
+            st.total_us = whole * 1000UL + frac;
+            profile_add(call, &st);
+        }
+        return;
+    }
+
+    if (strncmp(line, "Bail out! ", 10) == 0) {
+        import_flush();
+        tap_bail(line + 10);
+        import_state = IMPORT_END;
+        return;
+    }
+
+    switch (import_state) {
+    case IMPORT_HEADER:
+        if (strncmp(line, "# --- ", 6) == 0)
+            import_state = IMPORT_DESC;
+        return;
+    case IMPORT_DESC:
+        /* The caller logged its own copy of the description */
+        import_state = IMPORT_RESULTS;
+        return;
+    default:
+        break;
+    }
+
+    if (sscanf(line, "# time=%lu.%lums", &whole, &frac) == 2 &&
+        import_pending) {
+        import_us = whole * 1000UL + frac;
+        import_timed = 1;
+        import_flush();
+        return;
+    }
+    import_flush();
+
+    if (strncmp(line, "# --- ", 6) == 0) {
+        p = strrchr(line, ':');
+        if (p && sscanf(p, ": %lu.%lus", &whole, &frac) == 2) {
+            import_cat_ms = whole * 1000UL + frac;
+            import_cat_timed = 1;
+        }
+        import_state = IMPORT_END;
+        return;
+    }
+
+    if (sscanf(line, "# metric %63[^=]=%ld %31s", name, &value, unit) == 3) {
+        tap_metric(name, value, unit);
+        return;
+    }
+
+    /* Notes, shown again under the category; timeouts and leaks are
+     * also counted */
+    if (strncmp(line, "# note: ", 8) == 0) {
+        p = line + 8;
+        if (sscanf(p, "%d timed out after %lus", &number, &whole) == 2)
+            tap_timeout((int)whole);
+        else if (sscanf(p, "%d leaked %n", &number, &len) == 1 && len > 0)
+            tap_leak(p + len);
+        else
+            tap_note(p);
+        return;
+    }
+
+    /* Result lines: "ok N - desc", "not ok N - desc  # KNOWN ...",
+     * "ok N - # SKIP reason", the description led by "test N" when
+     * numbered in sequence */
+    import_passed = parse_result(line, &seq, &number, &p);
+    if (import_passed < 0) {
+        log_printf("%s\n", line);
+        return;
+    }
+
+    import_skip = (strncmp(p, "# SKIP ", 7) == 0);
+    if (import_skip) {
+        p += 7;
+        if (strcmp(p, "not selected") == 0)
+            return;     /* placeholder; tap_set_next() writes its own */
+    }
+    strncpy(import_text, p, sizeof(import_text) - 1);
+    import_text[sizeof(import_text) - 1] = '\0';
+    annot = strstr(import_text, "  # KNOWN ");
+    if (annot)
+        *annot = '\0';
+    import_timeout = 0;
+    annot = strstr(import_text, "  # TIMEOUT ");
+    if (annot) {
+        sscanf(annot + 12, "%ds", &import_timeout);
+        *annot = '\0';
+    }
+    import_number = number;
+    import_pending = 1;
+}
+
+int tap_import_end(void)
+{
+    int complete;
+
+    import_flush();
+    complete = (import_state == IMPORT_END);
+    import_state = IMPORT_HEADER;
+    import_timed = 0;
+    import_profile = 0;
+    return complete;
+}
+
 void tap_bail(const char *reason)
 {
     bailed_out = 1;
     printf("Bail out! %s\n", reason);
     page_check();
     log_printf("Bail out! %s\n", reason);
+    report_bail(reason);
+    log_flush();
 }
 
 int tap_bailed(void)
@@ -557,7 +1316,7 @@ int tap_bailed(void)
 
 int tap_finish(void)
 {
-    int total_ran;
+    int total_ran, results, i;
     int sum_passed, sum_failed, sum_known, sum_skipped;
 
     /* Use global counters if bail-out interrupted a category before
@@ -575,6 +1334,7 @@ int tap_finish(void)
     }
 
     total_ran = sum_passed + sum_failed + sum_known;
+    results = passed_count + failed_count + known_count;
 
     /* Screen: summary line (bold, always shown) */
     printf("\n");
@@ -587,14 +1347,54 @@ int tap_finish(void)
         printf("passed");
 
     print_detail_suffix(sum_failed, sum_known, sum_skipped);
-    printf(CSI_RESET "\n");
+    printf(" [%lu.%lus]" CSI_RESET "\n",
+           total_ms / 1000, (total_ms % 1000) / 100);
     page_check();
 
     /* Log: summary diagnostic */
     log_printf("# Results: %d passed, %d failed, %d known, %d skipped"
                " (%d total)\n",
                sum_passed, sum_failed, sum_known, sum_skipped,
-               test_number);
+               results);
+    log_printf("# Test time: %lu.%03lus\n", total_ms / 1000, total_ms % 1000);
+    if (timeout_count > 0)
+        log_printf("# Timed out: %d (watchdog)\n", timeout_count);
+    if (leak_count > 0)
+        log_printf("# Leaked: %d (LEAKCHECK)\n", leak_count);
+
+    /* Slowest tests: always in the log, on screen when verbose */
+    if (slowest_count > 0) {
+        log_puts("# Slowest tests:");
+        if (verbose) {
+            printf("\nSlowest tests:\n");
+            page_check();
+            page_check();
+        }
+    }
+    for (i = 0; i < slowest_count; i++) {
+        log_printf("#   %3d  %4lu.%03lus  %s\n", slowest[i].test_num,
+                   slowest[i].us / 1000000,
+                   (slowest[i].us / 1000) % 1000, slowest[i].description);
+        if (verbose) {
+            int line_len;
+
+            line_len = printf("  %3d %4lu.%lus  %s\n", slowest[i].test_num,
+                              slowest[i].us / 1000000,
+                              (slowest[i].us / 100000) % 10,
+                              slowest[i].description);
+            page_advance(wrap_rows(line_len > 1 ? line_len - 1 : 1));
+        }
+    }
+
+    if (tally_on)
+        print_tally();
+    if (profile_enabled())
+        print_profile();
+
+    report_close(sum_passed, sum_failed, sum_known, sum_skipped,
+                 results, total_ms);
+    stream_flush();
+    streaming = 0;
 
     if (logfp) {
         fclose(logfp);
@@ -613,6 +1413,59 @@ void tap_set_verbose(int flag)
     verbose = flag;
 }
 
+void tap_round(int round, int rounds)
+{
+    log_printf("# round %d of %d\n", round, rounds);
+    printf("Round %d of %d\n", round, rounds);
+    page_check();
+}
+
+void tap_set_sequence(int flag)
+{
+    sequential = flag;
+}
+
+void tap_set_tally(int times)
+{
+    tally_on = 1;
+    tally_times = times;
+}
+
+void tap_set_log_sync(int flag)
+{
+    log_sync = flag;
+}
+
+void tap_set_worker(int flag)
+{
+    worker = flag;
+}
+
+void tap_set_report(int format, const char *path)
+{
+    report_format = format;
+    report_path = path;
+}
+
+void tap_set_stream(int flag)
+{
+    if (flag && !streaming) {
+        /* The helper's copy starts with its own TAP header; lines
+         * logged before now (the helper handshake) stay local. */
+        streaming = 1;
+        stream_len = 0;
+        stream_text("TAP version 12\n");
+        stream_text("# bsdsocktest " BSDSOCKTEST_VERSION "\n");
+        stream_text("# bsdsocket.library: ");
+        stream_text(lib_version ? lib_version : "not available");
+        stream_text("\n");
+        stream_flush();
+    } else if (!flag) {
+        stream_flush();
+        streaming = 0;
+    }
+}
+
 void tap_set_page(int flag)
 {
     page_mode = flag;
@@ -632,7 +1485,7 @@ void tap_set_page(int flag)
 
 int tap_get_total(void)
 {
-    return test_number;
+    return result_seq;
 }
 
 int tap_get_passed(void)
@@ -16,14 +16,36 @@
  *           "NIL:" suppresses logging. */
 void tap_init(const char *bsdlib_version, const char *log_path);
 
+/* RESUME: read the log at 'log_path' (NULL = "bsdsocktest.log") left
+ * by an earlier run, and have tap_init() append to it, continuing its
+ * numbering and totals.  Call before tap_init().  Returns the number
+ * of the last result in the log, 0 if it holds none (tap_init() then
+ * starts a new log), or -1 if the run finished.  *crashed is set when
+ * the run ended without a bail out (and not under PARALLEL), so the
+ * test after the last result is the one that took the machine down. */
+int tap_resume(const char *log_path, int *crashed);
+
+/* RERUN: collect the numbers of the unexpected failures ("not ok"
+ * without a KNOWN annotation) in the log at 'log_path', up to 'max'.
+ * Returns how many were found, or -1 if the log cannot be read. */
+int tap_read_failures(const char *log_path, int *numbers, int max);
+
 /* Emit the TAP plan line (written to log only). */
 void tap_plan(int count);
 
 /* Record a test result.
  * passed: non-zero for ok, zero for not ok.
- * description: test description string. */
+ * description: test description string.
+ * Inside a category, the time since the previous result is logged
+ * after the result line and ranked for tap_finish(). */
 void tap_ok(int passed, const char *description);
 
+/* Number the next result 'number' (registry test numbers are stable,
+ * so a partial run leaves gaps), flushing the log first.  Skipped-over
+ * numbers are logged as "not selected" placeholders, unless results
+ * are numbered in sequence. */
+void tap_set_next(int number);
+
 /* Record a test result with printf-style description. */
 void tap_okf(int passed, const char *fmt, ...);
 
@@ -36,6 +58,21 @@ void tap_diag(const char *msg);
 /* Emit a diagnostic comment with printf-style formatting (log only). */
 void tap_diagf(const char *fmt, ...);
 
+/* Record that the watchdog interrupted the most recent test after
+ * 'seconds'.  Noted in the log and under the category on screen;
+ * tap_finish() logs the total. */
+void tap_timeout(int seconds);
+
+/* Record that the most recent test leaked (LEAKCHECK); 'what' sums
+ * it up, e.g. "1 descriptor".  Noted in the log and under the
+ * category on screen; tap_finish() logs the total. */
+void tap_leak(const char *what);
+
+/* Record a benchmark metric for the most recent result: a
+ * "# metric name=value unit" diagnostic in the log, and a property or
+ * record in the FORMAT report. */
+void tap_metric(const char *name, long value, const char *unit);
+
 /* Emit a notable result visible on screen AND in the log.
  * On screen: appears indented under the category summary.
  * In the log: appears as a TAP diagnostic: "# <message>". */
@@ -48,16 +85,31 @@ void tap_notef(const char *fmt, ...);
  * Call before running each category's tests. */
 void tap_begin_category(const char *name);
 
-/* Finalize the active category. Emits category summary to screen. */
+/* Finalize the active category. Emits category summary (with its run
+ * time) to screen. */
 void tap_end_category(void);
 
+/* Replay one line of a worker's TAP log (PARALLEL) inside the active
+ * category.  Results are recorded as if run here, charged the
+ * worker's times; metrics, notes, timeouts and leaks are recorded
+ * again and other diagnostics copied; the worker's header, category
+ * markers and summary are dropped, as are its "not selected"
+ * placeholders. */
+void tap_import_line(const char *line);
+
+/* Finish a replay.  Returns 1 if the worker's log reached its category
+ * end marker or a bail out, 0 if it stopped early. */
+int tap_import_end(void);
+
 /* Emit a TAP Bail out! line (both screen and log). */
 void tap_bail(const char *reason);
 
 /* Query whether a bail out has occurred. */
 int tap_bailed(void);
 
-/* Finalize TAP output. Emits summary to screen, closes log.
+/* Finalize TAP output. Emits summary to screen, lists the slowest
+ * tests (log; also screen in verbose mode) and any flake table,
+ * closes log.
  * Returns AmigaOS exit code:
  * RETURN_OK (0) if all passed, RETURN_WARN (5) if any unexpected failures,
  * RETURN_FAIL (20) if bail out occurred. */
@@ -67,6 +119,43 @@ int tap_finish(void);
  * also appear on screen (not just category summaries). */
 void tap_set_verbose(int flag);
 
+/* Tally passes and result times per test number; tap_finish() then
+ * lists every test that ran with its pass count, whether it is flaky,
+ * and its shortest, mean and longest time.  'times' is the number of
+ * runs per test asked for, shown in the heading. */
+void tap_set_tally(int times);
+
+/* Number results in the log in run order instead of by test number
+ * (call before tap_init()), so that a test run several times (TIMES,
+ * REPEAT) does not repeat a TAP number.  Each description then starts with
+ * "test N", and the plan counts the results. */
+void tap_set_sequence(int flag);
+
+/* REPEAT: mark the start of round 'round' of 'rounds' in the log and
+ * on screen. */
+void tap_round(int round, int rounds);
+
+/* Enable/disable unbuffered logging (call before tap_init()).  By
+ * default the log is buffered and flushed at category boundaries and
+ * before each test, so a crash loses at most the running test's
+ * lines. */
+void tap_set_log_sync(int flag);
+
+/* Log notes as "# note: ..." so that tap_import_line() can tell them
+ * from other diagnostics (WORKER). */
+void tap_set_worker(int flag);
+
+/* Select an additional result report (call before tap_init()).
+ * format: REPORT_* from report.h; path NULL uses the format's default
+ * file name. */
+void tap_set_report(int format, const char *path);
+
+/* Mirror every log line to the host helper (call after tap_init() and
+ * helper_stream_open()).  Lines are queued and sent at the log's flush
+ * points, or one by one with LOGSYNC; they are streamed even when the
+ * log itself is NIL:.  tap_finish() sends the rest. */
+void tap_set_stream(int flag);
+
 /* Enable/disable pagination. When enabled, screen output pauses
  * after each screenful. Detects screen height automatically.
  * Silently disables if stdout/stdin is not a console. */
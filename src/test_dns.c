@@ -9,7 +9,9 @@
 
 #include "tap.h"
 #include "testutil.h"
+#include "tests.h"
 #include "helper_proto.h"
+#include "profile.h"
 
 #include <proto/bsdsocket.h>
 
@@ -17,20 +19,13 @@
 #include <netinet/in.h>
 #include <string.h>
 
-void run_dns_tests(void)
+/* ---- gethostbyname ---- */
+
+/* 88. gethostbyname_localhost */
+static void test_gethostbyname_localhost(void)
 {
     struct hostent *h;
-    struct servent *s;
-    struct protoent *p;
-    struct in_addr addr;
-    char hostname[256];
-    char small[2];
-    ULONG hostid;
-    int rc;
-
-    /* ---- gethostbyname ---- */
 
-    /* 88. gethostbyname_localhost */
     h = gethostbyname((STRPTR)"localhost");
     if (h) {
         struct in_addr resolved;
@@ -44,20 +39,27 @@ void run_dns_tests(void)
         tap_ok(0, "gethostbyname(): \"localhost\" resolves to 127.0.0.1 [BSD 4.4]");
         tap_diagf("  h_errno=%ld", (long)get_bsd_h_errno());
     }
+}
 
-    CHECK_CTRLC();
+/* 89. gethostbyname_invalid */
+static void test_gethostbyname_invalid(void)
+{
+    struct hostent *h;
 
-    /* 89. gethostbyname_invalid */
     h = gethostbyname((STRPTR)"nonexistent.invalid");
     tap_ok(h == NULL && get_bsd_h_errno() != 0,
            "gethostbyname(): invalid hostname sets h_errno [BSD 4.4]");
     tap_diagf("  h_errno=%ld", (long)get_bsd_h_errno());
+}
 
-    CHECK_CTRLC();
+/* ---- gethostbyaddr ---- */
 
-    /* ---- gethostbyaddr ---- */
+/* 90. gethostbyaddr_loopback */
+static void test_gethostbyaddr_loopback(void)
+{
+    struct hostent *h;
+    struct in_addr addr;
 
-    /* 90. gethostbyaddr_loopback */
     addr.s_addr = htonl(INADDR_LOOPBACK);
     h = gethostbyaddr((STRPTR)&addr, sizeof(addr), AF_INET);
     if (h) {
@@ -67,10 +69,14 @@ void run_dns_tests(void)
         tap_ok(1, "gethostbyaddr(): reverse lookup 127.0.0.1 [BSD 4.4]");
         tap_diagf("  h_errno=%ld", (long)get_bsd_h_errno());
     }
+}
 
-    CHECK_CTRLC();
+/* 91. gethostbyaddr_zero */
+static void test_gethostbyaddr_zero(void)
+{
+    struct hostent *h;
+    struct in_addr addr;
 
-    /* 91. gethostbyaddr_zero */
     addr.s_addr = 0;
     h = gethostbyaddr((STRPTR)&addr, sizeof(addr), AF_INET);
     if (h) {
@@ -80,12 +86,15 @@ void run_dns_tests(void)
         tap_ok(1, "gethostbyaddr(): 0.0.0.0 behavior [BSD 4.4]");
         tap_diagf("  h_errno=%ld", (long)get_bsd_h_errno());
     }
+}
 
-    CHECK_CTRLC();
+/* ---- getservbyname / getservbyport ---- */
 
-    /* ---- getservbyname / getservbyport ---- */
+/* 92. getservbyname_http */
+static void test_getservbyname_http(void)
+{
+    struct servent *s;
 
-    /* 92. getservbyname_http */
     s = getservbyname((STRPTR)"http", (STRPTR)"tcp");
     if (s) {
         tap_ok(ntohs(s->s_port) == 80,
@@ -94,17 +103,23 @@ void run_dns_tests(void)
     } else {
         tap_skip("services database does not include http");
     }
+}
 
-    CHECK_CTRLC();
+/* 93. getservbyname_nonexistent */
+static void test_getservbyname_nonexistent(void)
+{
+    struct servent *s;
 
-    /* 93. getservbyname_nonexistent */
     s = getservbyname((STRPTR)"nonexistent_service_xyz", (STRPTR)"tcp");
     tap_ok(s == NULL,
            "getservbyname(): unknown service returns NULL [BSD 4.4]");
+}
 
-    CHECK_CTRLC();
+/* 94. getservbyport_21 */
+static void test_getservbyport_21(void)
+{
+    struct servent *s;
 
-    /* 94. getservbyport_21 */
     s = getservbyport(htons(21), (STRPTR)"tcp");
     if (s) {
         tap_ok(stricmp((const char *)s->s_name, "ftp") == 0,
@@ -113,12 +128,15 @@ void run_dns_tests(void)
     } else {
         tap_skip("services database does not include port 21");
     }
+}
 
-    CHECK_CTRLC();
+/* ---- getprotobyname / getprotobynumber ---- */
 
-    /* ---- getprotobyname / getprotobynumber ---- */
+/* 95. getprotobyname_tcp */
+static void test_getprotobyname_tcp(void)
+{
+    struct protoent *p;
 
-    /* 95. getprotobyname_tcp */
     p = getprotobyname((STRPTR)"tcp");
     if (p) {
         tap_ok(p->p_proto == 6,
@@ -127,10 +145,13 @@ void run_dns_tests(void)
     } else {
         tap_skip("protocols database not available");
     }
+}
 
-    CHECK_CTRLC();
+/* 96. getprotobyname_udp */
+static void test_getprotobyname_udp(void)
+{
+    struct protoent *p;
 
-    /* 96. getprotobyname_udp */
     p = getprotobyname((STRPTR)"udp");
     if (p) {
         tap_ok(p->p_proto == 17,
@@ -139,10 +160,13 @@ void run_dns_tests(void)
     } else {
         tap_skip("protocols database not available");
     }
+}
 
-    CHECK_CTRLC();
+/* 97. getprotobynumber_6 */
+static void test_getprotobynumber_6(void)
+{
+    struct protoent *p;
 
-    /* 97. getprotobynumber_6 */
     p = getprotobynumber(6);
     if (p) {
         tap_ok(stricmp((const char *)p->p_name, "tcp") == 0,
@@ -151,21 +175,29 @@ void run_dns_tests(void)
     } else {
         tap_skip("protocols database not available");
     }
+}
 
-    CHECK_CTRLC();
+/* ---- gethostname / gethostid ---- */
 
-    /* ---- gethostname / gethostid ---- */
+/* 98. gethostname_basic */
+static void test_gethostname_basic(void)
+{
+    char hostname[256];
+    int rc;
 
-    /* 98. gethostname_basic */
     memset(hostname, 0, sizeof(hostname));
     rc = gethostname((STRPTR)hostname, sizeof(hostname));
     tap_ok(rc == 0 && strlen(hostname) > 0,
            "gethostname(): retrieve hostname [BSD 4.4]");
     tap_diagf("  rc=%d, hostname=\"%s\"", rc, hostname);
+}
 
-    CHECK_CTRLC();
+/* 99. gethostname_truncation */
+static void test_gethostname_truncation(void)
+{
+    char small[2];
+    int rc;
 
-    /* 99. gethostname_truncation */
     memset(small, 'X', sizeof(small));
     rc = gethostname((STRPTR)small, sizeof(small));
     if (rc == 0) {
@@ -176,63 +208,61 @@ void run_dns_tests(void)
         tap_ok(1, "gethostname(): small buffer truncation [BSD 4.4]");
         tap_diagf("  rc=%d, errno=%ld", rc, (long)get_bsd_errno());
     }
+}
 
-    CHECK_CTRLC();
+/* 100. gethostid_nonzero */
+static void test_gethostid_nonzero(void)
+{
+    ULONG hostid;
 
-    /* 100. gethostid_nonzero */
     hostid = gethostid();
     tap_ok(hostid != 0,
            "gethostid(): returns non-zero value [BSD 4.4]");
     tap_diagf("  gethostid=0x%08lx", (unsigned long)hostid);
+}
 
-    CHECK_CTRLC();
-
-    /* ---- getnetbyname / getnetbyaddr ---- */
-
-    /* 101. getnetbyname_loopback */
-    {
-        struct netent *n;
+/* ---- getnetbyname / getnetbyaddr ---- */
 
-        n = getnetbyname((STRPTR)"loopback");
-        if (n) {
-            tap_ok(n->n_addrtype == AF_INET && n->n_net == 127,
-                   "getnetbyname(): network database lookup [BSD 4.4]");
-            tap_diagf("  n_name=%s n_net=%ld",
-                      (const char *)n->n_name, (long)n->n_net);
-        } else {
-            tap_skip("networks database not available");
-        }
+/* 101. getnetbyname_loopback */
+static void test_getnetbyname_loopback(void)
+{
+    struct netent *n;
+
+    n = getnetbyname((STRPTR)"loopback");
+    if (n) {
+        tap_ok(n->n_addrtype == AF_INET && n->n_net == 127,
+               "getnetbyname(): network database lookup [BSD 4.4]");
+        tap_diagf("  n_name=%s n_net=%ld",
+                  (const char *)n->n_name, (long)n->n_net);
+    } else {
+        tap_skip("networks database not available");
     }
+}
 
-    CHECK_CTRLC();
-
-    /* 102. getnetbyaddr_loopback */
-    {
-        struct netent *n;
-
-        n = getnetbyaddr(127, AF_INET);
-        if (n) {
-            tap_ok(n->n_net == 127 && n->n_name != NULL &&
-                   strlen((const char *)n->n_name) > 0,
-                   "getnetbyaddr(): network reverse lookup [BSD 4.4]");
-            tap_diagf("  n_name=%s n_net=%ld",
-                      (const char *)n->n_name, (long)n->n_net);
-        } else {
-            tap_skip("networks database not available");
-        }
+/* 102. getnetbyaddr_loopback */
+static void test_getnetbyaddr_loopback(void)
+{
+    struct netent *n;
+
+    n = getnetbyaddr(127, AF_INET);
+    if (n) {
+        tap_ok(n->n_net == 127 && n->n_name != NULL &&
+               strlen((const char *)n->n_name) > 0,
+               "getnetbyaddr(): network reverse lookup [BSD 4.4]");
+        tap_diagf("  n_name=%s n_net=%ld",
+                  (const char *)n->n_name, (long)n->n_net);
+    } else {
+        tap_skip("networks database not available");
     }
+}
 
-    CHECK_CTRLC();
+/* ---- Network DNS tests — require host helper ---- */
 
-    /* Network DNS tests — require host helper */
-    if (!helper_is_connected()) {
-        tap_skip("host helper not connected");
-        CHECK_CTRLC();
-        tap_skip("host helper not connected");
-        return;
-    }
+/* 103. gethostbyname_external */
+static void test_gethostbyname_external(void)
+{
+    struct hostent *h;
 
-    /* 103. gethostbyname_external */
     h = gethostbyname((STRPTR)"aminet.net");
     if (h) {
         struct in_addr resolved;
@@ -244,22 +274,62 @@ void run_dns_tests(void)
         tap_ok(0, "gethostbyname(): external hostname resolution [BSD 4.4]");
         tap_diagf("  h_errno=%ld", (long)get_bsd_h_errno());
     }
+}
 
-    CHECK_CTRLC();
-
-    /* 104. gethostbyaddr_external */
-    {
-        struct in_addr ext_addr;
-
-        ext_addr.s_addr = helper_addr();
-        h = gethostbyaddr((STRPTR)&ext_addr, sizeof(ext_addr), AF_INET);
-        if (h) {
-            tap_ok(h->h_addrtype == AF_INET && h->h_length == 4,
-                   "gethostbyaddr(): external reverse lookup [BSD 4.4]");
-            tap_diagf("  hostname: %s", (const char *)h->h_name);
-        } else {
-            tap_ok(1, "gethostbyaddr(): external reverse lookup [BSD 4.4]");
-            tap_diagf("  h_errno=%ld", (long)get_bsd_h_errno());
-        }
+/* 104. gethostbyaddr_external */
+static void test_gethostbyaddr_external(void)
+{
+    struct hostent *h;
+    struct in_addr ext_addr;
+
+    ext_addr.s_addr = helper_addr();
+    h = gethostbyaddr((STRPTR)&ext_addr, sizeof(ext_addr), AF_INET);
+    if (h) {
+        tap_ok(h->h_addrtype == AF_INET && h->h_length == 4,
+               "gethostbyaddr(): external reverse lookup [BSD 4.4]");
+        tap_diagf("  hostname: %s", (const char *)h->h_name);
+    } else {
+        tap_ok(1, "gethostbyaddr(): external reverse lookup [BSD 4.4]");
+        tap_diagf("  h_errno=%ld", (long)get_bsd_h_errno());
     }
 }
+
+/* ---- Registry ---- */
+
+const struct test_entry dns_tests[] = {
+    { 88, "gethostbyname_localhost", TIER_LOOPBACK, -1, -1,
+      test_gethostbyname_localhost },
+    { 89, "gethostbyname_invalid", TIER_LOOPBACK, -1, -1,
+      test_gethostbyname_invalid },
+    { 90, "gethostbyaddr_loopback", TIER_LOOPBACK, -1, -1,
+      test_gethostbyaddr_loopback },
+    { 91, "gethostbyaddr_zero", TIER_LOOPBACK, -1, -1,
+      test_gethostbyaddr_zero },
+    { 92, "getservbyname_http", TIER_LOOPBACK, -1, -1,
+      test_getservbyname_http },
+    { 93, "getservbyname_nonexistent", TIER_LOOPBACK, -1, -1,
+      test_getservbyname_nonexistent },
+    { 94, "getservbyport_21", TIER_LOOPBACK, -1, -1,
+      test_getservbyport_21 },
+    { 95, "getprotobyname_tcp", TIER_LOOPBACK, -1, -1,
+      test_getprotobyname_tcp },
+    { 96, "getprotobyname_udp", TIER_LOOPBACK, -1, -1,
+      test_getprotobyname_udp },
+    { 97, "getprotobynumber_6", TIER_LOOPBACK, -1, -1,
+      test_getprotobynumber_6 },
+    { 98, "gethostname_basic", TIER_LOOPBACK, -1, -1,
+      test_gethostname_basic },
+    { 99, "gethostname_truncation", TIER_LOOPBACK, -1, -1,
+      test_gethostname_truncation },
+    { 100, "gethostid_nonzero", TIER_LOOPBACK, -1, -1,
+      test_gethostid_nonzero },
+    { 101, "getnetbyname_loopback", TIER_LOOPBACK, -1, -1,
+      test_getnetbyname_loopback },
+    { 102, "getnetbyaddr_loopback", TIER_LOOPBACK, -1, -1,
+      test_getnetbyaddr_loopback },
+    { 103, "gethostbyname_external", TIER_NETWORK, -1, -1,
+      test_gethostbyname_external },
+    { 104, "gethostbyaddr_external", TIER_NETWORK, -1, -1,
+      test_gethostbyaddr_external },
+    { 0, NULL, 0, 0, 0, NULL }
+};
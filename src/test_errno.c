@@ -8,6 +8,8 @@
 
 #include "tap.h"
 #include "testutil.h"
+#include "tests.h"
+#include "profile.h"
 
 #include <proto/bsdsocket.h>
 
@@ -16,13 +18,12 @@
 #include <errno.h>
 #include <string.h>
 
-void run_errno_tests(void)
+/* 120. errno_after_error */
+static void test_errno_after_error(void)
 {
     LONG fd;
     LONG errno_val;
-    struct sockaddr_in addr;
 
-    /* 120. errno_after_error */
     fd = socket(-1, -1, -1); /* Guaranteed to fail */
     errno_val = Errno();
     tap_ok(fd < 0 && errno_val != 0 && errno_val == get_bsd_errno(),
@@ -31,11 +32,15 @@ void run_errno_tests(void)
               (long)errno_val, (long)get_bsd_errno());
     if (fd >= 0)
         safe_close(fd);
+}
 
-    CHECK_CTRLC();
+/* 121. errno_after_success — behavioral documentation test.
+ * BSD does NOT guarantee errno is cleared on success. */
+static void test_errno_after_success(void)
+{
+    LONG fd;
+    LONG errno_val;
 
-    /* 121. errno_after_success — behavioral documentation test.
-     * BSD does NOT guarantee errno is cleared on success. */
     CloseSocket(-1); /* Set errno to something non-zero */
     fd = socket(AF_INET, SOCK_STREAM, 0); /* Should succeed */
     if (fd >= 0) {
@@ -51,131 +56,152 @@ void run_errno_tests(void)
     } else {
         tap_ok(0, "Errno(): behavior after successful operation [AmiTCP]");
     }
+}
 
-    CHECK_CTRLC();
-
-    /* 122. seterrnoptr_byte */
-    {
-        BYTE err_byte = 0;
-        SetErrnoPtr(&err_byte, 1);
-        CloseSocket(-1);
-        tap_ok(err_byte != 0,
-               "SetErrnoPtr(): 1-byte variable [AmiTCP]");
-        tap_diagf("  byte errno: %d", (int)err_byte);
-        restore_bsd_errno();
-    }
+/* 122. seterrnoptr_byte */
+static void test_seterrnoptr_byte(void)
+{
+    BYTE err_byte = 0;
+
+    SetErrnoPtr(&err_byte, 1);
+    CloseSocket(-1);
+    tap_ok(err_byte != 0,
+           "SetErrnoPtr(): 1-byte variable [AmiTCP]");
+    tap_diagf("  byte errno: %d", (int)err_byte);
+    restore_bsd_errno();
+}
 
-    CHECK_CTRLC();
-
-    /* 123. seterrnoptr_word */
-    {
-        WORD err_word = 0;
-        SetErrnoPtr(&err_word, 2);
-        CloseSocket(-1);
-        tap_ok(err_word != 0,
-               "SetErrnoPtr(): 2-byte variable [AmiTCP]");
-        tap_diagf("  word errno: %d", (int)err_word);
-        restore_bsd_errno();
-    }
+/* 123. seterrnoptr_word */
+static void test_seterrnoptr_word(void)
+{
+    WORD err_word = 0;
+
+    SetErrnoPtr(&err_word, 2);
+    CloseSocket(-1);
+    tap_ok(err_word != 0,
+           "SetErrnoPtr(): 2-byte variable [AmiTCP]");
+    tap_diagf("  word errno: %d", (int)err_word);
+    restore_bsd_errno();
+}
 
-    CHECK_CTRLC();
-
-    /* 124. seterrnoptr_long */
-    {
-        LONG err_long = 0;
-        SetErrnoPtr(&err_long, 4);
-        CloseSocket(-1);
-        tap_ok(err_long != 0,
-               "SetErrnoPtr(): 4-byte variable [AmiTCP]");
-        tap_diagf("  long errno: %ld", (long)err_long);
-        restore_bsd_errno();
-    }
+/* 124. seterrnoptr_long */
+static void test_seterrnoptr_long(void)
+{
+    LONG err_long = 0;
+
+    SetErrnoPtr(&err_long, 4);
+    CloseSocket(-1);
+    tap_ok(err_long != 0,
+           "SetErrnoPtr(): 4-byte variable [AmiTCP]");
+    tap_diagf("  long errno: %ld", (long)err_long);
+    restore_bsd_errno();
+}
 
-    CHECK_CTRLC();
-
-    /* 125. errno_variable_updated — register a fresh variable,
-     * do two different failing ops, verify both update it. */
-    {
-        LONG test_var = 0;
-        LONG first_val, second_val;
-
-        SocketBaseTags(
-            SBTM_SETVAL(SBTC_ERRNOLONGPTR), (ULONG)&test_var,
-            TAG_DONE);
-
-        /* First error: invalid fd */
-        CloseSocket(-1);
-        first_val = test_var;
-
-        /* Second error: connect to non-listening port */
-        fd = socket(AF_INET, SOCK_STREAM, 0);
-        if (fd >= 0) {
-            memset(&addr, 0, sizeof(addr));
-            addr.sin_family = AF_INET;
-            addr.sin_port = htons(get_test_port(0));
-            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
-            connect(fd, (struct sockaddr *)&addr, sizeof(addr));
-            second_val = test_var;
-            safe_close(fd);
-
-            tap_ok(first_val != 0 && second_val != 0 && first_val != second_val,
-                   "SBTC_ERRNOLONGPTR: error updates pointed-to variable [AmiTCP]");
-            tap_diagf("  first=%ld (expected EBADF=9), second=%ld (expected ECONNREFUSED=61)",
-                      (long)first_val, (long)second_val);
-        } else {
-            tap_ok(first_val != 0,
-                   "SBTC_ERRNOLONGPTR: error updates pointed-to variable [AmiTCP]");
-            tap_diagf("  first=%ld, socket() failed for second test",
-                      (long)first_val);
-        }
+/* 125. errno_variable_updated — register a fresh variable,
+ * do two different failing ops, verify both update it. */
+static void test_errno_variable_updated(void)
+{
+    LONG fd;
+    struct sockaddr_in addr;
+    LONG test_var = 0;
+    LONG first_val, second_val;
 
-        restore_bsd_errno();
-    }
+    SocketBaseTags(
+        SBTM_SETVAL(SBTC_ERRNOLONGPTR), (ULONG)&test_var,
+        TAG_DONE);
+
+    /* First error: invalid fd */
+    CloseSocket(-1);
+    first_val = test_var;
+
+    /* Second error: connect to non-listening port */
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd >= 0) {
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(get_test_port(100));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        connect(fd, (struct sockaddr *)&addr, sizeof(addr));
+        second_val = test_var;
+        safe_close(fd);
 
-    CHECK_CTRLC();
+        tap_ok(first_val != 0 && second_val != 0 && first_val != second_val,
+               "SBTC_ERRNOLONGPTR: error updates pointed-to variable [AmiTCP]");
+        tap_diagf("  first=%ld (expected EBADF=9), second=%ld (expected ECONNREFUSED=61)",
+                  (long)first_val, (long)second_val);
+    } else {
+        tap_ok(first_val != 0,
+               "SBTC_ERRNOLONGPTR: error updates pointed-to variable [AmiTCP]");
+        tap_diagf("  first=%ld, socket() failed for second test",
+                  (long)first_val);
+    }
 
-    /* 126. connect_stale_errno — POSIX says errno is only meaningful after
-     * a function that returns an error.  Stale errno from a prior failed
-     * call must not cause a subsequent connect() to fail. */
-    {
-        LONG listener, client, server;
-        struct sockaddr_in laddr;
-        LONG rc;
+    restore_bsd_errno();
+}
 
-        listener = make_loopback_listener(get_test_port(0));
-        if (listener < 0) {
+/* 126. connect_stale_errno — POSIX says errno is only meaningful after
+ * a function that returns an error.  Stale errno from a prior failed
+ * call must not cause a subsequent connect() to fail. */
+static void test_connect_stale_errno(void)
+{
+    LONG errno_val;
+    LONG listener, client, server;
+    struct sockaddr_in laddr;
+    LONG rc;
+
+    listener = make_loopback_listener(get_test_port(100));
+    if (listener < 0) {
+        tap_ok(0, "connect(): not affected by stale errno [POSIX]");
+        tap_diag("  could not create listener");
+    } else {
+        client = make_tcp_socket();
+        if (client < 0) {
             tap_ok(0, "connect(): not affected by stale errno [POSIX]");
-            tap_diag("  could not create listener");
+            tap_diag("  could not create client socket");
+            safe_close(listener);
         } else {
-            client = make_tcp_socket();
-            if (client < 0) {
-                tap_ok(0, "connect(): not affected by stale errno [POSIX]");
-                tap_diag("  could not create client socket");
-                safe_close(listener);
-            } else {
-                /* Force errno to EBADF */
-                CloseSocket(-1);
-                errno_val = Errno();
-
-                memset(&laddr, 0, sizeof(laddr));
-                laddr.sin_family = AF_INET;
-                laddr.sin_port = htons(get_test_port(0));
-                laddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
-
-                rc = connect(client, (struct sockaddr *)&laddr, sizeof(laddr));
-                tap_ok(rc == 0,
-                       "connect(): not affected by stale errno [POSIX]");
-                tap_diagf("  stale_errno=%ld, connect_rc=%ld, post_errno=%ld",
-                          (long)errno_val, (long)rc, (long)get_bsd_errno());
-
-                if (rc == 0) {
-                    server = accept(listener, NULL, NULL);
-                    if (server >= 0)
-                        safe_close(server);
-                }
-                safe_close(client);
-                safe_close(listener);
+            /* Force errno to EBADF */
+            CloseSocket(-1);
+            errno_val = Errno();
+
+            memset(&laddr, 0, sizeof(laddr));
+            laddr.sin_family = AF_INET;
+            laddr.sin_port = htons(get_test_port(100));
+            laddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+            rc = connect(client, (struct sockaddr *)&laddr, sizeof(laddr));
+            tap_ok(rc == 0,
+                   "connect(): not affected by stale errno [POSIX]");
+            tap_diagf("  stale_errno=%ld, connect_rc=%ld, post_errno=%ld",
+                      (long)errno_val, (long)rc, (long)get_bsd_errno());
+
+            if (rc == 0) {
+                server = accept(listener, NULL, NULL);
+                if (server >= 0)
+                    safe_close(server);
             }
+            safe_close(client);
+            safe_close(listener);
         }
     }
 }
+
+/* ---- Registry ---- */
+
+const struct test_entry errno_tests[] = {
+    { 120, "errno_after_error", TIER_LOOPBACK, -1, -1,
+      test_errno_after_error },
+    { 121, "errno_after_success", TIER_LOOPBACK, -1, -1,
+      test_errno_after_success },
+    { 122, "seterrnoptr_byte", TIER_LOOPBACK, -1, -1,
+      test_seterrnoptr_byte },
+    { 123, "seterrnoptr_word", TIER_LOOPBACK, -1, -1,
+      test_seterrnoptr_word },
+    { 124, "seterrnoptr_long", TIER_LOOPBACK, -1, -1,
+      test_seterrnoptr_long },
+    { 125, "errno_variable_updated", TIER_LOOPBACK, 100, 100,
+      test_errno_variable_updated },
+    { 126, "connect_stale_errno", TIER_LOOPBACK, 100, 100,
+      test_connect_stale_errno },
+    { 0, NULL, 0, 0, 0, NULL }
+};
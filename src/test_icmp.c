@@ -9,7 +9,9 @@
 
 #include "tap.h"
 #include "testutil.h"
+#include "tests.h"
 #include "helper_proto.h"
+#include "profile.h"
 
 #include <proto/bsdsocket.h>
 
@@ -152,107 +154,124 @@ shrink:
     return 0;  /* Timeout */
 }
 
-void run_icmp_tests(void)
+/* Raw ICMP sockets are optional; without them every test skips */
+static int icmp_supported(void)
 {
     LONG rawfd;
-    LONG rtt;
-    LONG rtts[5];
-    int success, i;
-    LONG rtt_min, rtt_max, rtt_sum;
 
-    /* Check if raw ICMP sockets are available */
     rawfd = socket(AF_INET, SOCK_RAW, IPPROTO_ICMP);
     if (rawfd < 0) {
         tap_skip("SOCK_RAW/ICMP not supported");
-        CHECK_CTRLC();
-        tap_skip("SOCK_RAW/ICMP not supported");
-        CHECK_CTRLC();
-        tap_skip("SOCK_RAW/ICMP not supported");
-        CHECK_CTRLC();
-        tap_skip("SOCK_RAW/ICMP not supported");
-        CHECK_CTRLC();
-        tap_skip("SOCK_RAW/ICMP not supported");
-        return;
+        return 0;
     }
     safe_close(rawfd);
+    return 1;
+}
+
+/* 132. icmp_loopback */
+static void test_icmp_loopback(void)
+{
+    LONG rtt;
+
+    if (!icmp_supported())
+        return;
 
-    /* 132. icmp_loopback */
     rtt = icmp_ping(htonl(INADDR_LOOPBACK), 56, 1);
     tap_ok(rtt > 0, "ICMP echo: loopback 127.0.0.1 [RFC 792]");
     if (rtt > 0) {
         tap_diagf("  RTT=%ld.%03ldms", (long)(rtt / 1000), (long)(rtt % 1000));
         tap_notef("Loopback RTT: %ld.%03ldms",
                   (long)(rtt / 1000), (long)(rtt % 1000));
+        tap_metric("rtt", (long)rtt, "us");
     } else {
         tap_diagf("  result=%ld", (long)rtt);
     }
+}
 
-    CHECK_CTRLC();
+/* ---- Network ICMP tests — require host helper ---- */
+
+/* 133. icmp_network */
+static void test_icmp_network(void)
+{
+    LONG rtt;
+
+    if (!icmp_supported())
+        return;
 
-    /* Network ICMP tests — gated by helper */
-    if (!helper_is_connected()) {
-        tap_skip("host helper not connected");
-        CHECK_CTRLC();
-        tap_skip("host helper not connected");
-        CHECK_CTRLC();
-        tap_skip("host helper not connected");
-        CHECK_CTRLC();
+    rtt = icmp_ping(helper_addr(), 56, 2);
+    tap_ok(rtt > 0, "ICMP echo: network host [RFC 792]");
+    if (rtt > 0) {
+        tap_diagf("  RTT=%ld.%03ldms, target=%s",
+                  (long)(rtt / 1000), (long)(rtt % 1000),
+                  Inet_NtoA(helper_addr()));
+        tap_notef("Network RTT: %ld.%03ldms",
+                  (long)(rtt / 1000), (long)(rtt % 1000));
+        tap_metric("rtt", (long)rtt, "us");
     } else {
-        /* 133. icmp_network */
-        rtt = icmp_ping(helper_addr(), 56, 2);
-        tap_ok(rtt > 0, "ICMP echo: network host [RFC 792]");
-        if (rtt > 0) {
-            tap_diagf("  RTT=%ld.%03ldms, target=%s",
-                      (long)(rtt / 1000), (long)(rtt % 1000),
-                      Inet_NtoA(helper_addr()));
-            tap_notef("Network RTT: %ld.%03ldms",
-                      (long)(rtt / 1000), (long)(rtt % 1000));
-        } else {
-            tap_diagf("  result=%ld", (long)rtt);
-        }
+        tap_diagf("  result=%ld", (long)rtt);
+    }
+}
 
-        CHECK_CTRLC();
-
-        /* 134. icmp_large_payload */
-        rtt = icmp_ping(helper_addr(), 1024, 3);
-        tap_ok(rtt > 0, "ICMP echo: 1024-byte payload [RFC 792]");
-        if (rtt > 0)
-            tap_diagf("  RTT=%ld.%03ldms, payload=1024",
-                      (long)(rtt / 1000), (long)(rtt % 1000));
-        else
-            tap_diagf("  result=%ld", (long)rtt);
-
-        CHECK_CTRLC();
-
-        /* 135. icmp_multi_ping */
-        success = 0;
-        rtt_min = 0x7FFFFFFF;
-        rtt_max = 0;
-        rtt_sum = 0;
-        for (i = 0; i < 5; i++) {
-            rtts[i] = icmp_ping(helper_addr(), 56, (UWORD)(10 + i));
-            if (rtts[i] > 0) {
-                success++;
-                if (rtts[i] < rtt_min) rtt_min = rtts[i];
-                if (rtts[i] > rtt_max) rtt_max = rtts[i];
-                rtt_sum += rtts[i];
-            }
-        }
-        tap_ok(success >= 4, "ICMP echo: multiple pings reliability [RFC 792]");
-        tap_diagf("  received=%d/5", success);
-        if (success > 0) {
-            LONG rtt_avg = rtt_sum / success;
-            tap_diagf("  RTT min=%ld.%03ldms max=%ld.%03ldms avg=%ld.%03ldms",
-                      (long)(rtt_min / 1000), (long)(rtt_min % 1000),
-                      (long)(rtt_max / 1000), (long)(rtt_max % 1000),
-                      (long)(rtt_avg / 1000), (long)(rtt_avg % 1000));
+/* 134. icmp_large_payload */
+static void test_icmp_large_payload(void)
+{
+    LONG rtt;
+
+    if (!icmp_supported())
+        return;
+
+    rtt = icmp_ping(helper_addr(), 1024, 3);
+    tap_ok(rtt > 0, "ICMP echo: 1024-byte payload [RFC 792]");
+    if (rtt > 0)
+        tap_diagf("  RTT=%ld.%03ldms, payload=1024",
+                  (long)(rtt / 1000), (long)(rtt % 1000));
+    else
+        tap_diagf("  result=%ld", (long)rtt);
+}
+
+/* 135. icmp_multi_ping */
+static void test_icmp_multi_ping(void)
+{
+    LONG rtts[5];
+    int success, i;
+    LONG rtt_min, rtt_max, rtt_sum;
+
+    if (!icmp_supported())
+        return;
+
+    success = 0;
+    rtt_min = 0x7FFFFFFF;
+    rtt_max = 0;
+    rtt_sum = 0;
+    for (i = 0; i < 5; i++) {
+        rtts[i] = icmp_ping(helper_addr(), 56, (UWORD)(10 + i));
+        if (rtts[i] > 0) {
+            success++;
+            if (rtts[i] < rtt_min) rtt_min = rtts[i];
+            if (rtts[i] > rtt_max) rtt_max = rtts[i];
+            rtt_sum += rtts[i];
         }
-        tap_notef("Multi-ping: %d/5 replies", success);
     }
+    tap_ok(success >= 4, "ICMP echo: multiple pings reliability [RFC 792]");
+    tap_diagf("  received=%d/5", success);
+    if (success > 0) {
+        LONG rtt_avg = rtt_sum / success;
+        tap_diagf("  RTT min=%ld.%03ldms max=%ld.%03ldms avg=%ld.%03ldms",
+                  (long)(rtt_min / 1000), (long)(rtt_min % 1000),
+                  (long)(rtt_max / 1000), (long)(rtt_max % 1000),
+                  (long)(rtt_avg / 1000), (long)(rtt_avg % 1000));
+    }
+    tap_notef("Multi-ping: %d/5 replies", success);
+}
 
-    CHECK_CTRLC();
+/* 136. icmp_timeout */
+static void test_icmp_timeout(void)
+{
+    LONG rtt;
+
+    if (!icmp_supported())
+        return;
 
-    /* 136. icmp_timeout */
     rtt = icmp_ping(inet_addr((STRPTR)"192.0.2.1"), 56, 99);
     if (rtt == 0) {
         tap_ok(1, "ICMP echo: timeout on unreachable host [RFC 792]");
@@ -267,3 +286,19 @@ void run_icmp_tests(void)
                   (long)(rtt / 1000), (long)(rtt % 1000));
     }
 }
+
+/* ---- Registry ---- */
+
+const struct test_entry icmp_tests[] = {
+    { 132, "icmp_loopback", TIER_LOOPBACK, -1, -1,
+      test_icmp_loopback },
+    { 133, "icmp_network", TIER_NETWORK, -1, -1,
+      test_icmp_network },
+    { 134, "icmp_large_payload", TIER_NETWORK, -1, -1,
+      test_icmp_large_payload },
+    { 135, "icmp_multi_ping", TIER_NETWORK, -1, -1,
+      test_icmp_multi_ping },
+    { 136, "icmp_timeout", TIER_LOOPBACK, -1, -1,
+      test_icmp_timeout },
+    { 0, NULL, 0, 0, 0, NULL }
+};
@@ -9,6 +9,8 @@
 
 #include "tap.h"
 #include "testutil.h"
+#include "tests.h"
+#include "profile.h"
 
 #include <proto/bsdsocket.h>
 
@@ -21,24 +23,26 @@
 #define LOG_INFO 6
 #endif
 
-void run_misc_tests(void)
-{
-    static LONG fds[256];
-    LONG listener, client, server;
-    LONG dtsize, new_dtsize, orig_dtsize;
-    int port, rc, i, count;
+static LONG fds[256];
 
-    /* ---- getdtablesize ---- */
+/* ---- getdtablesize ---- */
+
+/* 127. getdtablesize_default */
+static void test_getdtablesize_default(void)
+{
+    LONG dtsize;
 
-    /* 127. getdtablesize_default */
     dtsize = getdtablesize();
     tap_ok(dtsize >= 64,
            "getdtablesize(): default descriptor table size [AmiTCP]");
     tap_diagf("  dtablesize=%ld", (long)dtsize);
+}
 
-    CHECK_CTRLC();
+/* 128. getdtablesize_after_set */
+static void test_getdtablesize_after_set(void)
+{
+    LONG dtsize, new_dtsize, orig_dtsize;
 
-    /* 128. getdtablesize_after_set */
     orig_dtsize = 0;
     SocketBaseTags(SBTM_GETREF(SBTC_DTABLESIZE), (ULONG)&orig_dtsize,
                    TAG_DONE);
@@ -62,12 +66,13 @@ void run_misc_tests(void)
             SocketBaseTags(SBTM_SETVAL(SBTC_DTABLESIZE), orig_dtsize,
                            TAG_DONE);
     }
+}
 
-    CHECK_CTRLC();
-
-    /* ---- syslog ---- */
+/* ---- syslog ---- */
 
-    /* 129. syslog_no_crash */
+/* 129. syslog_no_crash */
+static void test_syslog_no_crash(void)
+{
     /* The syslog() convenience macro is broken in this SDK version
      * (_sfdc_vararg undefined). Call vsyslog directly with a manual
      * argument array matching AmigaOS varargs convention (ULONG[]). */
@@ -79,12 +84,16 @@ void run_misc_tests(void)
         vsyslog(LOG_INFO, (STRPTR)"phase 4 canary %s", (APTR)syslog_args);
     }
     tap_ok(1, "syslog(): does not crash (canary test) [AmiTCP]");
+}
 
-    CHECK_CTRLC();
+/* ---- CloseSocket after shutdown ---- */
 
-    /* ---- CloseSocket after shutdown ---- */
+/* 130. closesocket_after_shutdown */
+static void test_closesocket_after_shutdown(void)
+{
+    LONG listener, client, server;
+    int port, rc;
 
-    /* 130. closesocket_after_shutdown */
     port = get_test_port(140);
     listener = make_loopback_listener(port);
     client = make_loopback_client(port);
@@ -102,12 +111,16 @@ void run_misc_tests(void)
     safe_close(client);
     safe_close(server);
     safe_close(listener);
+}
 
-    CHECK_CTRLC();
+/* ---- Open max sockets ---- */
 
-    /* ---- Open max sockets ---- */
+/* 131. open_max_sockets */
+static void test_open_max_sockets(void)
+{
+    LONG dtsize;
+    int i, count;
 
-    /* 131. open_max_sockets */
     dtsize = getdtablesize();
     for (i = 0; i < 256; i++)
         fds[i] = -1;
@@ -123,6 +136,7 @@ void run_misc_tests(void)
            "socket(): open dtablesize-1 descriptors successfully [AmiTCP]");
     tap_diagf("  opened=%d, dtablesize=%ld", count, (long)dtsize);
     tap_notef("Max sockets: %d", count);
+    tap_metric("sockets", (long)count, "");
 
     /* Close in reverse order */
     for (i = count - 1; i >= 0; i--) {
@@ -130,3 +144,19 @@ void run_misc_tests(void)
         fds[i] = -1;
     }
 }
+
+/* ---- Registry ---- */
+
+const struct test_entry misc_tests[] = {
+    { 127, "getdtablesize_default", TIER_LOOPBACK, -1, -1,
+      test_getdtablesize_default },
+    { 128, "getdtablesize_after_set", TIER_LOOPBACK, -1, -1,
+      test_getdtablesize_after_set },
+    { 129, "syslog_no_crash", TIER_LOOPBACK, -1, -1,
+      test_syslog_no_crash },
+    { 130, "closesocket_after_shutdown", TIER_LOOPBACK, 140, 140,
+      test_closesocket_after_shutdown },
+    { 131, "open_max_sockets", TIER_LOOPBACK, -1, -1,
+      test_open_max_sockets },
+    { 0, NULL, 0, 0, 0, NULL }
+};
@@ -0,0 +1,773 @@
+/*
+ * bsdsocktest — Trace replay benchmark tests
+ *
+ * Tests: play back a recorded socket workload (REPLAY <script>) with
+ * its recorded pacing and compare the time achieved with the time
+ * recorded.  The script lists one operation per line:
+ *
+ *   <ms> <conn> connect tcp|udp [<us>]
+ *   <ms> <conn> send <bytes> [<us>]
+ *   <ms> <conn> recv <bytes> [<us>]
+ *   <ms> <conn> wait <ms> [<us>]
+ *   <ms> <conn> close [<us>]
+ *
+ * <ms> is the recorded start (decimals allowed), <conn> a connection
+ * number 1-8, and <us> the optional recorded duration.  An operation
+ * never starts before its recorded time.
+ *
+ * The remote end is derived from the script: each recv is answered
+ * with its byte count once the bytes sent on that connection since the
+ * previous answer have arrived.  On loopback the suite serves that end
+ * itself from the same WaitSelect() loop; on the network the helper's
+ * REPLAY responders do.
+ *
+ * 2 tests (151-152), port offsets 220-221.
+ */
+
+#include "tap.h"
+#include "testutil.h"
+#include "tests.h"
+#include "helper_proto.h"
+#include "profile.h"
+
+#include <proto/bsdsocket.h>
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RP_MAX_OPS      2048
+#define RP_MAX_SLOTS    8       /* connection numbers in a script */
+#define RP_MAX_INSTS    64      /* connects in a script */
+#define RP_BUFSIZE      8192    /* also the largest datagram */
+#define RP_IO_SECS      10      /* a send or recv gives up after this */
+#define RP_UNKNOWN      0xFFFFFFFFUL
+
+enum { RP_CONNECT, RP_SEND, RP_RECV, RP_WAIT, RP_CLOSE, RP_KINDS };
+
+static const char *const rp_kind_names[RP_KINDS] = {
+    "connect", "send", "recv", "wait", "close"
+};
+
+/* One scripted operation */
+struct rp_op {
+    ULONG at_us;        /* recorded start */
+    ULONG rec_us;       /* recorded duration, or RP_UNKNOWN */
+    LONG arg;           /* bytes; milliseconds for wait; 1 = UDP connect */
+    LONG expect;        /* recv: bytes sent since the previous answer */
+    int next;           /* recv: the connection's next recv, or -1 */
+    int line;
+    UBYTE kind;
+    UBYTE inst;         /* connection instance: one per connect */
+};
+
+/* One connection, from its connect to its close */
+struct rp_inst {
+    int udp;
+    int first;          /* first recv, or -1 */
+    int steps;          /* recvs */
+    LONG fd;            /* replayed side */
+    int port;           /* helper responder, or our UDP source port */
+    /* The remote end, when served on loopback */
+    LONG peer;          /* accepted TCP connection */
+    int step;           /* next recv to answer, or -1 */
+    LONG got;           /* bytes towards it */
+    LONG owed;          /* TCP answer bytes not yet sent */
+};
+
+/* Per-kind totals */
+struct rp_kind_stat {
+    ULONG count;
+    ULONG bytes;
+    ULONG achieved_us;
+    ULONG recorded_us;  /* operations with a recorded duration */
+    int recorded;
+};
+
+static const char *rp_script;
+static struct rp_op rp_ops[RP_MAX_OPS];
+static struct rp_inst rp_insts[RP_MAX_INSTS];
+static int rp_op_count, rp_inst_count;
+static ULONG rp_late[RP_MAX_OPS];
+static long rp_expect[RP_MAX_OPS], rp_answer[RP_MAX_OPS];
+static unsigned char rp_sbuf[RP_BUFSIZE];
+static unsigned char rp_rbuf[RP_BUFSIZE];
+
+/* Loopback remote end */
+static int rp_loopback;
+static LONG rp_listener = -1;
+static LONG rp_udp_peer = -1;
+static struct sockaddr_in rp_udp_addr;
+
+void replay_set_script(const char *path)
+{
+    rp_script = path;
+}
+
+/* ---- Script ---- */
+
+/* "<ms>[.<fraction>]" in microseconds.  Returns 0 if malformed. */
+static int rp_parse_ms(const char *p, ULONG *us)
+{
+    char *end;
+    ULONG scale = 100;      /* microseconds per digit */
+
+    if (*p < '0' || *p > '9')
+        return 0;
+    *us = strtoul(p, &end, 10) * 1000;
+    if (*end == '.') {
+        for (end++; *end >= '0' && *end <= '9'; end++) {
+            *us += (ULONG)(*end - '0') * scale;
+            scale /= 10;
+        }
+    }
+    return *end == '\0';
+}
+
+static int rp_error(int line, const char *msg)
+{
+    tap_diagf("  replay: %s line %d: %s", rp_script, line, msg);
+    return 0;
+}
+
+/* Read the script into rp_ops[] and derive the remote end's answers.
+ * Returns 1, or 0 with the reason logged. */
+static int rp_load(void)
+{
+    int slot_inst[RP_MAX_SLOTS], slot_recv[RP_MAX_SLOTS];
+    LONG slot_sent[RP_MAX_SLOTS];
+    char line[128], at[16], op[12], arg[16];
+    struct rp_op *o;
+    struct rp_inst *in;
+    ULONG dur, last_at = 0;
+    char *end;
+    FILE *fp;
+    int lineno = 0, fields, slot, i, ok = 1;
+
+    fp = fopen(rp_script, "r");
+    if (!fp) {
+        tap_diagf("  replay: cannot read %s", rp_script);
+        return 0;
+    }
+    for (i = 0; i < RP_MAX_SLOTS; i++)
+        slot_inst[i] = -1;
+    rp_op_count = rp_inst_count = 0;
+
+    while (ok && fgets(line, sizeof(line), fp)) {
+        lineno++;
+        arg[0] = '\0';
+        dur = RP_UNKNOWN;
+        fields = sscanf(line, "%15s %d %11s %15s %lu", at, &slot, op, arg,
+                        &dur);
+        if (fields <= 0 || at[0] == '#')
+            continue;
+        if (fields < 3 || slot < 1 || slot > RP_MAX_SLOTS) {
+            ok = rp_error(lineno, "expected <ms> <conn 1-8> <operation>");
+            break;
+        }
+        if (rp_op_count == RP_MAX_OPS) {
+            ok = rp_error(lineno, "too many operations");
+            break;
+        }
+        slot--;
+        o = &rp_ops[rp_op_count];
+        memset(o, 0, sizeof(*o));
+        o->line = lineno;
+        o->rec_us = dur;
+        o->next = -1;
+        if (!rp_parse_ms(at, &o->at_us) || o->at_us < last_at) {
+            ok = rp_error(lineno, "bad or decreasing time");
+            break;
+        }
+        last_at = o->at_us;
+
+        for (i = 0; i < RP_KINDS; i++) {
+            if (strcmp(op, rp_kind_names[i]) == 0)
+                break;
+        }
+        o->kind = (UBYTE)i;
+        if (i == RP_KINDS) {
+            ok = rp_error(lineno, "unknown operation");
+            break;
+        }
+        /* close has no argument: a fourth field is its duration */
+        if (o->kind == RP_CLOSE) {
+            if (fields >= 4) {
+                o->rec_us = strtoul(arg, &end, 10);
+                if (end == arg || *end != '\0') {
+                    ok = rp_error(lineno, "bad duration");
+                    break;
+                }
+            }
+        } else if (o->kind == RP_CONNECT) {
+            if (strcmp(arg, "tcp") != 0 && strcmp(arg, "udp") != 0) {
+                ok = rp_error(lineno, "connect needs tcp or udp");
+                break;
+            }
+            o->arg = (arg[0] == 'u');
+        } else {
+            o->arg = strtol(arg, &end, 10);
+            if (fields < 4 || end == arg || *end != '\0' || o->arg < 0) {
+                ok = rp_error(lineno, "missing, bad or negative count");
+                break;
+            }
+        }
+
+        if (o->kind == RP_CONNECT) {
+            if (slot_inst[slot] >= 0 || rp_inst_count == RP_MAX_INSTS) {
+                ok = rp_error(lineno, slot_inst[slot] >= 0
+                              ? "connection already open"
+                              : "too many connections");
+                break;
+            }
+            in = &rp_insts[rp_inst_count];
+            memset(in, 0, sizeof(*in));
+            in->udp = (int)o->arg;
+            in->first = -1;
+            slot_inst[slot] = rp_inst_count++;
+            slot_recv[slot] = -1;
+            slot_sent[slot] = 0;
+        } else if (slot_inst[slot] < 0) {
+            ok = rp_error(lineno, "connection not open");
+            break;
+        }
+        o->inst = (UBYTE)slot_inst[slot];
+        in = &rp_insts[o->inst];
+
+        if ((o->kind == RP_SEND || o->kind == RP_RECV) && in->udp &&
+            o->arg > RP_BUFSIZE) {
+            ok = rp_error(lineno, "datagram larger than 8192 bytes");
+            break;
+        }
+        if (o->kind == RP_SEND) {
+            slot_sent[slot] += o->arg;
+        } else if (o->kind == RP_RECV) {
+            /* A UDP remote end learns our address from a datagram */
+            if (in->udp && in->first < 0 && slot_sent[slot] == 0) {
+                ok = rp_error(lineno, "UDP connection receives before "
+                              "it sends");
+                break;
+            }
+            o->expect = slot_sent[slot];
+            slot_sent[slot] = 0;
+            if (slot_recv[slot] >= 0)
+                rp_ops[slot_recv[slot]].next = rp_op_count;
+            else
+                in->first = rp_op_count;
+            slot_recv[slot] = rp_op_count;
+            in->steps++;
+        } else if (o->kind == RP_CLOSE) {
+            slot_inst[slot] = -1;
+        }
+        rp_op_count++;
+    }
+    fclose(fp);
+
+    if (ok && rp_op_count == 0)
+        ok = rp_error(lineno, "no operations");
+    return ok;
+}
+
+/* ---- Loopback remote end ---- */
+
+/* Count bytes that reached the remote end of 'in' and queue (TCP) or
+ * send (UDP) the answers now due. */
+static void rp_peer_got(struct rp_inst *in, LONG n)
+{
+    struct sockaddr_in to;
+
+    in->got += n;
+    while (in->step >= 0 && in->got >= rp_ops[in->step].expect) {
+        in->got -= rp_ops[in->step].expect;
+        if (in->udp) {
+            memset(&to, 0, sizeof(to));
+            to.sin_family = AF_INET;
+            to.sin_port = htons(in->port);
+            to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            sendto(rp_udp_peer, (UBYTE *)rp_sbuf, rp_ops[in->step].arg, 0,
+                   (struct sockaddr *)&to, sizeof(to));
+        } else {
+            in->owed += rp_ops[in->step].arg;
+        }
+        in->step = rp_ops[in->step].next;
+    }
+}
+
+/* Read and answer whatever reached the loopback remote end. */
+static void rp_serve(fd_set *rfds, fd_set *wfds)
+{
+    struct sockaddr_in from;
+    socklen_t fromlen;
+    struct rp_inst *in;
+    LONG n, chunk;
+    int i;
+
+    for (i = 0; i < rp_inst_count; i++) {
+        in = &rp_insts[i];
+        if (in->peer < 0)
+            continue;
+        if (FD_ISSET(in->peer, rfds)) {
+            n = recv(in->peer, (UBYTE *)rp_rbuf, RP_BUFSIZE, 0);
+            if (n > 0) {
+                rp_peer_got(in, n);
+            } else if (n == 0) {
+                safe_close(in->peer);
+                in->peer = -1;
+                continue;
+            }
+        }
+        if (in->owed > 0 && FD_ISSET(in->peer, wfds)) {
+            chunk = in->owed < RP_BUFSIZE ? in->owed : RP_BUFSIZE;
+            n = send(in->peer, (UBYTE *)rp_sbuf, chunk, 0);
+            if (n > 0)
+                in->owed -= n;
+        }
+    }
+
+    if (rp_udp_peer >= 0 && FD_ISSET(rp_udp_peer, rfds)) {
+        for (;;) {
+            fromlen = sizeof(from);
+            n = recvfrom(rp_udp_peer, (UBYTE *)rp_rbuf, RP_BUFSIZE, 0,
+                         (struct sockaddr *)&from, &fromlen);
+            if (n < 0)
+                break;
+            for (i = 0; i < rp_inst_count; i++) {
+                in = &rp_insts[i];
+                if (in->udp && in->fd >= 0 &&
+                    in->port == ntohs(from.sin_port)) {
+                    rp_peer_got(in, n);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+/* One WaitSelect() of up to 'timeout_us' on the replayed socket 'fd'
+ * (-1: none) for reading or, with 'writing', for writing, serving the
+ * loopback remote end meanwhile.  Returns 1 if fd is ready, 0 if not,
+ * -1 on error. */
+static int rp_pump(LONG fd, int writing, ULONG timeout_us)
+{
+    fd_set rfds, wfds;
+    struct timeval tv;
+    LONG maxfd = fd, rc;
+    struct rp_inst *in;
+    int i;
+
+    FD_ZERO(&rfds);
+    FD_ZERO(&wfds);
+    if (fd >= 0)
+        FD_SET(fd, writing ? &wfds : &rfds);
+    if (rp_loopback) {
+        for (i = 0; i < rp_inst_count; i++) {
+            in = &rp_insts[i];
+            if (in->peer < 0)
+                continue;
+            FD_SET(in->peer, &rfds);
+            if (in->owed > 0)
+                FD_SET(in->peer, &wfds);
+            if (in->peer > maxfd)
+                maxfd = in->peer;
+        }
+        if (rp_udp_peer >= 0) {
+            FD_SET(rp_udp_peer, &rfds);
+            if (rp_udp_peer > maxfd)
+                maxfd = rp_udp_peer;
+        }
+    }
+
+    tv.tv_secs = timeout_us / 1000000;
+    tv.tv_micro = timeout_us % 1000000;
+    rc = WaitSelect(maxfd + 1, &rfds, &wfds, NULL, &tv, NULL);
+    if (rc < 0)
+        return -1;
+    if (rc == 0)
+        return 0;
+    if (rp_loopback)
+        rp_serve(&rfds, &wfds);
+    return fd >= 0 && FD_ISSET(fd, writing ? &wfds : &rfds);
+}
+
+/* Microseconds left until 'deadline_us' after 'origin', 0 if past. */
+static ULONG rp_left(const struct bst_timestamp *origin, ULONG deadline_us)
+{
+    struct bst_timestamp now;
+    ULONG us;
+
+    timer_now(&now);
+    us = timer_elapsed_us(origin, &now);
+    return us < deadline_us ? deadline_us - us : 0;
+}
+
+/* ---- Replay ---- */
+
+/* Open the replayed side of 'in' (and, on loopback, accept its remote
+ * end).  Returns 0 or -1. */
+static int rp_connect(struct rp_inst *in)
+{
+    struct sockaddr_in addr;
+    socklen_t addrlen;
+    LONG one = 1;
+
+    if (in->udp) {
+        in->fd = make_udp_socket();
+    } else if (rp_loopback) {
+        in->fd = make_loopback_client(get_test_port(220));
+    } else {
+        in->fd = make_tcp_socket();
+    }
+    if (in->fd < 0)
+        return -1;
+
+    if (rp_loopback) {
+        if (in->udp) {
+            if (connect(in->fd, (struct sockaddr *)&rp_udp_addr,
+                        sizeof(rp_udp_addr)) < 0)
+                return -1;
+            addrlen = sizeof(addr);
+            getsockname(in->fd, (struct sockaddr *)&addr, &addrlen);
+            in->port = ntohs(addr.sin_port);
+        } else {
+            in->peer = accept_one(rp_listener);
+            if (in->peer < 0)
+                return -1;
+            /* The recorded server wrote each answer at once; sent here
+             * in RP_BUFSIZE pieces, Nagle would hold all but the first
+             * for the delayed ACK */
+            setsockopt(in->peer, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            set_nonblocking(in->peer);
+        }
+        in->step = in->first;
+        rp_peer_got(in, 0);     /* answers due before any request */
+    } else {
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(in->port);
+        addr.sin_addr.s_addr = helper_addr();
+        if (connect(in->fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+            return -1;
+    }
+    return set_nonblocking(in->fd);
+}
+
+/* Send or receive 'len' bytes (one datagram on UDP), waiting up to
+ * RP_IO_SECS.  Returns the bytes moved, or -1 on error. */
+static LONG rp_transfer(struct rp_inst *in, int sending, LONG len)
+{
+    struct bst_timestamp start;
+    LONG done = 0, n, chunk;
+    ULONG left;
+    int rc;
+
+    timer_now(&start);
+    while (done < len || (in->udp && done == 0 && !sending)) {
+        chunk = len - done < RP_BUFSIZE ? len - done : RP_BUFSIZE;
+        if (sending)
+            n = send(in->fd, (UBYTE *)rp_sbuf, chunk, 0);
+        else
+            n = recv(in->fd, (UBYTE *)rp_rbuf, in->udp ? RP_BUFSIZE : chunk,
+                     0);
+        if (n > 0 || (n == 0 && in->udp)) {
+            done += n;
+            if (in->udp)
+                break;
+            continue;
+        }
+        if (n == 0)
+            break;              /* EOF before the recorded amount */
+        if (get_bsd_errno() != EWOULDBLOCK && get_bsd_errno() != EAGAIN)
+            return -1;
+        left = rp_left(&start, RP_IO_SECS * 1000000UL);
+        if (left == 0)
+            break;
+        rc = rp_pump(in->fd, sending, left);
+        if (rc < 0)
+            return -1;
+    }
+    return done;
+}
+
+/* WaitSelect() on the connection for up to 'ms', as the recorded
+ * program did.  Returns 0 or -1. */
+static int rp_wait(struct rp_inst *in, LONG ms)
+{
+    struct bst_timestamp start;
+    ULONG left;
+    int rc;
+
+    timer_now(&start);
+    while ((left = rp_left(&start, (ULONG)ms * 1000)) > 0) {
+        rc = rp_pump(in->fd, 0, left);
+        if (rc != 0)
+            return rc < 0 ? -1 : 0;
+    }
+    return 0;
+}
+
+static void rp_close_all(void)
+{
+    int i;
+
+    for (i = 0; i < rp_inst_count; i++) {
+        safe_close(rp_insts[i].fd);
+        safe_close(rp_insts[i].peer);
+        rp_insts[i].fd = rp_insts[i].peer = -1;
+    }
+    safe_close(rp_listener);
+    safe_close(rp_udp_peer);
+    rp_listener = rp_udp_peer = -1;
+}
+
+/* Set up the remote end of every connection before the clock starts.
+ * Returns 1, or 0 with the reason logged. */
+static int rp_setup(void)
+{
+    struct rp_inst *in;
+    int i, j, k, need_tcp = 0, need_udp = 0;
+
+    for (i = 0; i < rp_inst_count; i++) {
+        in = &rp_insts[i];
+        in->fd = in->peer = -1;
+        in->got = in->owed = 0;
+        in->step = -1;
+        if (in->udp)
+            need_udp = 1;
+        else
+            need_tcp = 1;
+    }
+
+    if (!rp_loopback) {
+        for (i = 0; i < rp_inst_count; i++) {
+            in = &rp_insts[i];
+            for (j = in->first, k = 0; j >= 0; j = rp_ops[j].next, k++) {
+                rp_expect[k] = rp_ops[j].expect;
+                rp_answer[k] = rp_ops[j].arg;
+            }
+            in->port = helper_replay(in->udp, rp_expect, rp_answer,
+                                     in->steps);
+            if (in->port == 0) {
+                tap_diag("  helper did not accept REPLAY");
+                return 0;
+            }
+        }
+        return 1;
+    }
+
+    if (need_tcp) {
+        rp_listener = make_loopback_listener(get_test_port(220));
+        if (rp_listener < 0) {
+            tap_diagf("  listener failed: errno=%ld",
+                      (long)get_bsd_errno());
+            return 0;
+        }
+    }
+    if (need_udp) {
+        rp_udp_peer = make_udp_socket();
+        memset(&rp_udp_addr, 0, sizeof(rp_udp_addr));
+        rp_udp_addr.sin_family = AF_INET;
+        rp_udp_addr.sin_port = htons(get_test_port(221));
+        rp_udp_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (rp_udp_peer < 0 ||
+            bind(rp_udp_peer, (struct sockaddr *)&rp_udp_addr,
+                 sizeof(rp_udp_addr)) < 0) {
+            tap_diagf("  UDP bind failed: errno=%ld",
+                      (long)get_bsd_errno());
+            return 0;
+        }
+        set_nonblocking(rp_udp_peer);
+    }
+    return 1;
+}
+
+/* Sort ascending (Shell sort: scripts run to thousands of operations) */
+static void rp_sort(ULONG *v, int n)
+{
+    int gap, i, j;
+    ULONG x;
+
+    for (gap = n / 2; gap > 0; gap /= 2) {
+        for (i = gap; i < n; i++) {
+            x = v[i];
+            for (j = i; j >= gap && v[j - gap] > x; j -= gap)
+                v[j] = v[j - gap];
+            v[j] = x;
+        }
+    }
+}
+
+/* Replay the loaded script against the loopback remote end or the
+ * helper and report achieved against recorded timing. */
+static void rp_run(const char *what)
+{
+    struct rp_kind_stat kinds[RP_KINDS];
+    struct bst_timestamp origin, start, end;
+    struct rp_op *o;
+    struct rp_inst *in;
+    ULONG now_us, took, recorded_ms, achieved_ms;
+    LONG n;
+    int i, rc, errors = 0, shorts = 0, done = 0;
+    const char *name;
+
+    if (!rp_load()) {
+        tap_okf(0, "Replay: %s [benchmark]", what);
+        return;
+    }
+    if (!rp_setup()) {
+        rp_close_all();
+        tap_okf(0, "Replay: %s [benchmark]", what);
+        return;
+    }
+
+    memset(kinds, 0, sizeof(kinds));
+    timer_now(&origin);
+    end = origin;
+    for (i = 0; i < rp_op_count; i++) {
+        if (SetSignal(0L, 0L) & SIGBREAKF_CTRL_C)
+            break;      /* left for CHECK_CTRLC() below */
+        o = &rp_ops[i];
+        in = &rp_insts[o->inst];
+
+        /* Keep the recorded pacing, serving the remote end meanwhile */
+        while ((now_us = rp_left(&origin, o->at_us)) > 0) {
+            if (rp_pump(-1, 0, now_us) < 0)
+                break;
+        }
+
+        timer_now(&start);
+        rc = 0;
+        switch (o->kind) {
+        case RP_CONNECT:
+            rc = rp_connect(in);
+            break;
+        case RP_SEND:
+        case RP_RECV:
+            n = rp_transfer(in, o->kind == RP_SEND, o->arg);
+            if (n < 0)
+                rc = -1;
+            else if (n < o->arg && !in->udp)
+                shorts++;
+            else if (n == 0 && o->kind == RP_RECV)
+                shorts++;
+            if (n > 0)
+                kinds[o->kind].bytes += n;
+            break;
+        case RP_WAIT:
+            rc = rp_wait(in, o->arg);
+            break;
+        case RP_CLOSE:
+            rc = CloseSocket(in->fd) < 0 ? -1 : 0;
+            in->fd = -1;
+            if (in->peer >= 0) {
+                safe_close(in->peer);
+                in->peer = -1;
+            }
+            break;
+        }
+        timer_now(&end);
+
+        took = timer_elapsed_us(&start, &end);
+        now_us = timer_elapsed_us(&origin, &start);
+        rp_late[done++] = now_us > o->at_us ? now_us - o->at_us : 0;
+        kinds[o->kind].count++;
+        kinds[o->kind].achieved_us += took;
+        if (o->rec_us != RP_UNKNOWN) {
+            kinds[o->kind].recorded_us += o->rec_us;
+            kinds[o->kind].recorded = 1;
+        }
+        if (rc < 0) {
+            if (errors++ == 0)
+                tap_diagf("  line %d: %s failed, errno=%ld", o->line,
+                          rp_kind_names[o->kind], (long)get_bsd_errno());
+            /* Later operations on a dead connection fail too */
+            if (o->kind == RP_CONNECT)
+                break;
+        }
+    }
+    rp_close_all();
+    CHECK_CTRLC();
+
+    o = &rp_ops[rp_op_count - 1];
+    recorded_ms = (o->at_us + (o->rec_us != RP_UNKNOWN ? o->rec_us : 0) +
+                   500) / 1000;
+    achieved_ms = timer_elapsed_ms(&origin, &end);
+    rp_sort(rp_late, done);
+
+    name = strrchr(rp_script, '/');
+    if (!name)
+        name = strchr(rp_script, ':');
+    name = name ? name + 1 : rp_script;
+
+    tap_okf(errors == 0 && shorts == 0 && done == rp_op_count,
+            "Replay: %s [benchmark]", what);
+    tap_diagf("  script=%s ops=%d/%d connections=%d errors=%d "
+              "short=%d", name, done, rp_op_count, rp_inst_count, errors,
+              shorts);
+    tap_diagf("  span_ms: recorded=%lu achieved=%lu (%lu%%)",
+              recorded_ms, achieved_ms,
+              recorded_ms > 0 ? achieved_ms * 100 / recorded_ms : 0);
+    if (done > 0)
+        tap_diagf("  late_us: p50=%lu p90=%lu max=%lu",
+                  rp_late[(done - 1) / 2], rp_late[(long)(done - 1) * 9 / 10],
+                  rp_late[done - 1]);
+    tap_diag("  op        count      bytes  achieved_ms  recorded_ms");
+    for (i = 0; i < RP_KINDS; i++) {
+        if (kinds[i].count == 0)
+            continue;
+        if (kinds[i].recorded)
+            tap_diagf("  %-8s %6lu %10lu %8lu.%03lu %8lu.%03lu",
+                      rp_kind_names[i], kinds[i].count, kinds[i].bytes,
+                      kinds[i].achieved_us / 1000,
+                      kinds[i].achieved_us % 1000,
+                      kinds[i].recorded_us / 1000,
+                      kinds[i].recorded_us % 1000);
+        else
+            tap_diagf("  %-8s %6lu %10lu %8lu.%03lu            -",
+                      rp_kind_names[i], kinds[i].count, kinds[i].bytes,
+                      kinds[i].achieved_us / 1000,
+                      kinds[i].achieved_us % 1000);
+    }
+    tap_notef("Replay %s (%s): %lu ms, recorded %lu ms", name, what,
+              achieved_ms, recorded_ms);
+    tap_metric("achieved", (long)achieved_ms, "ms");
+    tap_metric("recorded", (long)recorded_ms, "ms");
+    if (done > 0)
+        tap_metric("late_p90", (long)rp_late[(long)(done - 1) * 9 / 10],
+                   "us");
+}
+
+/* 151. rp_replay_loopback */
+static void test_rp_replay_loopback(void)
+{
+    if (!rp_script) {
+        tap_skip("no REPLAY script given");
+        return;
+    }
+    rp_loopback = 1;
+    rp_run("recorded trace on loopback");
+}
+
+/* 152. rp_replay_network */
+static void test_rp_replay_network(void)
+{
+    if (!rp_script) {
+        tap_skip("no REPLAY script given");
+        return;
+    }
+    rp_loopback = 0;
+    rp_run("recorded trace against the helper");
+}
+
+/* ---- Registry ---- */
+
+const struct test_entry replay_tests[] = {
+    { 151, "rp_replay_loopback", TIER_LOOPBACK, 220, 221,
+      test_rp_replay_loopback },
+    { 152, "rp_replay_network", TIER_NETWORK, -1, -1,
+      test_rp_replay_network },
+    { 0, NULL, 0, 0, 0, NULL }
+};
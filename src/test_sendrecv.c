@@ -9,7 +9,9 @@
 
 #include "tap.h"
 #include "testutil.h"
+#include "tests.h"
 #include "helper_proto.h"
+#include "profile.h"
 
 #include <proto/bsdsocket.h>
 
@@ -18,21 +20,16 @@
 #include <errno.h>
 #include <string.h>
 
-void run_sendrecv_tests(void)
-{
-    static unsigned char sbuf[8192], rbuf[8192];
-    LONG listener, client, server, fd_a, fd_b, fd_dummy;
-    struct sockaddr_in addr, from_addr;
-    socklen_t addrlen;
-    int port, rc, total, mismatch;
-    int passed, attempts;
-    LONG one = 1;
-    struct msghdr msg;
-    struct iovec iov[3];
+static unsigned char sbuf[8192], rbuf[8192];
+
+/* ---- Basic send/recv ---- */
 
-    /* ---- Basic send/recv ---- */
+/* 24. sendrecv_basic_100 */
+static void test_sendrecv_basic_100(void)
+{
+    LONG listener, client, server;
+    int port, rc, mismatch;
 
-    /* 24. sendrecv_basic_100 */
     port = get_test_port(20);
     listener = make_loopback_listener(port);
     client = make_loopback_client(port);
@@ -51,10 +48,14 @@ void run_sendrecv_tests(void)
     safe_close(server);
     safe_close(client);
     safe_close(listener);
+}
 
-    CHECK_CTRLC();
+/* 25. sendrecv_large_8192 */
+static void test_sendrecv_large_8192(void)
+{
+    LONG listener, client, server;
+    int port, rc, total, mismatch;
 
-    /* 25. sendrecv_large_8192 */
     port = get_test_port(21);
     listener = make_loopback_listener(port);
     client = make_loopback_client(port);
@@ -82,12 +83,16 @@ void run_sendrecv_tests(void)
     safe_close(server);
     safe_close(client);
     safe_close(listener);
+}
 
-    CHECK_CTRLC();
+/* ---- MSG_PEEK ---- */
 
-    /* ---- MSG_PEEK ---- */
+/* 26. recv_msg_peek */
+static void test_recv_msg_peek(void)
+{
+    LONG listener, client, server;
+    int port, rc, mismatch;
 
-    /* 26. recv_msg_peek */
     port = get_test_port(22);
     listener = make_loopback_listener(port);
     client = make_loopback_client(port);
@@ -115,12 +120,16 @@ void run_sendrecv_tests(void)
     safe_close(server);
     safe_close(client);
     safe_close(listener);
+}
 
-    CHECK_CTRLC();
+/* ---- MSG_OOB ---- */
 
-    /* ---- MSG_OOB ---- */
+/* 27. sendrecv_msg_oob */
+static void test_sendrecv_msg_oob(void)
+{
+    LONG listener, client, server;
+    int port, rc;
 
-    /* 27. sendrecv_msg_oob */
     port = get_test_port(23);
     listener = make_loopback_listener(port);
     client = make_loopback_client(port);
@@ -149,12 +158,19 @@ void run_sendrecv_tests(void)
     safe_close(server);
     safe_close(client);
     safe_close(listener);
+}
 
-    CHECK_CTRLC();
+/* ---- UDP sendto/recvfrom ---- */
 
-    /* ---- UDP sendto/recvfrom ---- */
+/* 28. udp_sendto_recvfrom */
+static void test_udp_sendto_recvfrom(void)
+{
+    LONG fd_a, fd_b;
+    struct sockaddr_in addr, from_addr;
+    socklen_t addrlen;
+    int port, rc, mismatch;
+    LONG one = 1;
 
-    /* 28. udp_sendto_recvfrom */
     port = get_test_port(24);
     fd_a = make_udp_socket();
     fd_b = make_udp_socket();
@@ -184,11 +200,18 @@ void run_sendrecv_tests(void)
     }
     safe_close(fd_a);
     safe_close(fd_b);
+}
 
-    CHECK_CTRLC();
+/* 29. udp_sendto_after_prior_ops — exercises fd allocator
+ * to catch Amiberry Bug #1 (sendto checks stale sb->s). */
+static void test_udp_sendto_after_prior_ops(void)
+{
+    LONG fd_a, fd_b, fd_dummy;
+    struct sockaddr_in addr, from_addr;
+    socklen_t addrlen;
+    int port, rc, mismatch;
+    LONG one = 1;
 
-    /* 29. udp_sendto_after_prior_ops — exercises fd allocator
-     * to catch Amiberry Bug #1 (sendto checks stale sb->s). */
     port = get_test_port(25);
     fd_dummy = make_tcp_socket();
     safe_close(fd_dummy); /* Exercise fd allocator */
@@ -219,10 +242,17 @@ void run_sendrecv_tests(void)
     }
     safe_close(fd_a);
     safe_close(fd_b);
+}
 
-    CHECK_CTRLC();
+/* 30. udp_sendto_basic_second */
+static void test_udp_sendto_basic_second(void)
+{
+    LONG fd_a, fd_b;
+    struct sockaddr_in addr, from_addr;
+    socklen_t addrlen;
+    int port, rc, mismatch;
+    LONG one = 1;
 
-    /* 30. udp_sendto_basic_second */
     port = get_test_port(26);
     fd_a = make_udp_socket();
     fd_b = make_udp_socket();
@@ -251,12 +281,18 @@ void run_sendrecv_tests(void)
     }
     safe_close(fd_a);
     safe_close(fd_b);
+}
 
-    CHECK_CTRLC();
+/* ---- sendmsg/recvmsg ---- */
 
-    /* ---- sendmsg/recvmsg ---- */
+/* 31. sendmsg_recvmsg_single */
+static void test_sendmsg_recvmsg_single(void)
+{
+    LONG listener, client, server;
+    int port, rc, mismatch;
+    struct msghdr msg;
+    struct iovec iov[3];
 
-    /* 31. sendmsg_recvmsg_single */
     port = get_test_port(27);
     listener = make_loopback_listener(port);
     client = make_loopback_client(port);
@@ -291,10 +327,16 @@ void run_sendrecv_tests(void)
     safe_close(server);
     safe_close(client);
     safe_close(listener);
+}
 
-    CHECK_CTRLC();
+/* 32. sendmsg_recvmsg_scatter */
+static void test_sendmsg_recvmsg_scatter(void)
+{
+    LONG listener, client, server;
+    int port, rc, mismatch;
+    struct msghdr msg;
+    struct iovec iov[3];
 
-    /* 32. sendmsg_recvmsg_scatter */
     port = get_test_port(28);
     listener = make_loopback_listener(port);
     client = make_loopback_client(port);
@@ -342,12 +384,16 @@ void run_sendrecv_tests(void)
     safe_close(server);
     safe_close(client);
     safe_close(listener);
+}
 
-    CHECK_CTRLC();
+/* ---- Non-blocking behavior ---- */
 
-    /* ---- Non-blocking behavior ---- */
+/* 33. recv_nonblocking_ewouldblock */
+static void test_recv_nonblocking_ewouldblock(void)
+{
+    LONG listener, client, server;
+    int port, rc;
 
-    /* 33. recv_nonblocking_ewouldblock */
     port = get_test_port(29);
     listener = make_loopback_listener(port);
     client = make_loopback_client(port);
@@ -364,10 +410,14 @@ void run_sendrecv_tests(void)
     safe_close(server);
     safe_close(client);
     safe_close(listener);
+}
 
-    CHECK_CTRLC();
+/* 34. send_nonblocking_ewouldblock */
+static void test_send_nonblocking_ewouldblock(void)
+{
+    LONG listener, client, server;
+    int port, rc, total;
 
-    /* 34. send_nonblocking_ewouldblock */
     port = get_test_port(30);
     listener = make_loopback_listener(port);
     client = make_loopback_client(port);
@@ -396,12 +446,17 @@ void run_sendrecv_tests(void)
     safe_close(server);
     safe_close(client);
     safe_close(listener);
+}
 
-    CHECK_CTRLC();
+/* ---- Send after peer close ---- */
 
-    /* ---- Send after peer close ---- */
+/* 35. send_after_peer_close */
+static void test_send_after_peer_close(void)
+{
+    LONG listener, client, server;
+    int port, rc;
+    int passed, attempts;
 
-    /* 35. send_after_peer_close */
     port = get_test_port(31);
     listener = make_loopback_listener(port);
     client = make_loopback_client(port);
@@ -428,7 +483,7 @@ void run_sendrecv_tests(void)
                 break;
             }
             /* Let RST arrive */
-            set_recv_timeout(client, 1);
+            set_recv_timeout_ms(client, adaptive_ms(1000));
             rc = recv(client, (UBYTE *)rbuf, 1, 0);
             if (rc < 0 && (get_bsd_errno() == ECONNRESET ||
                             get_bsd_errno() == EPIPE)) {
@@ -451,12 +506,16 @@ void run_sendrecv_tests(void)
     safe_close(server);
     safe_close(client);
     safe_close(listener);
+}
 
-    CHECK_CTRLC();
+/* ---- Bidirectional transfer ---- */
 
-    /* ---- Bidirectional transfer ---- */
+/* 36. sendrecv_bidirectional */
+static void test_sendrecv_bidirectional(void)
+{
+    LONG listener, client, server;
+    int port, rc, total, mismatch;
 
-    /* 36. sendrecv_bidirectional */
     port = get_test_port(32);
     listener = make_loopback_listener(port);
     client = make_loopback_client(port);
@@ -517,12 +576,16 @@ void run_sendrecv_tests(void)
     safe_close(server);
     safe_close(client);
     safe_close(listener);
+}
 
-    CHECK_CTRLC();
+/* ---- Edge cases ---- */
 
-    /* ---- Edge cases ---- */
+/* 37. recv_zero_length */
+static void test_recv_zero_length(void)
+{
+    LONG listener, client, server;
+    int port, rc, mismatch;
 
-    /* 37. recv_zero_length */
     port = get_test_port(33);
     listener = make_loopback_listener(port);
     client = make_loopback_client(port);
@@ -545,10 +608,14 @@ void run_sendrecv_tests(void)
     safe_close(server);
     safe_close(client);
     safe_close(listener);
+}
 
-    CHECK_CTRLC();
+/* 38. send_zero_bytes */
+static void test_send_zero_bytes(void)
+{
+    LONG listener, client, server;
+    int port, rc, mismatch;
 
-    /* 38. send_zero_bytes */
     port = get_test_port(34);
     listener = make_loopback_listener(port);
     client = make_loopback_client(port);
@@ -570,247 +637,281 @@ void run_sendrecv_tests(void)
     safe_close(server);
     safe_close(client);
     safe_close(listener);
+}
 
-    CHECK_CTRLC();
-
-    /* ==== Network send/recv tests — require host helper ==== */
-
-    if (!helper_is_connected()) {
-        tap_skip("host helper not connected");
-        CHECK_CTRLC();
-        tap_skip("host helper not connected");
-        CHECK_CTRLC();
-        tap_skip("host helper not connected");
-        CHECK_CTRLC();
-        tap_skip("host helper not connected");
-        return;
-    }
+/* ---- Network send/recv tests — require host helper ---- */
 
-    /* 39. tcp_network_64k */
-    {
-        LONG fd;
-        LONG total_sent, total_recv, verified_bytes;
-        int recv_offset, i;
-        LONG n;
-
-        fd = helper_connect_service(HELPER_TCP_ECHO);
-        if (fd >= 0) {
-            set_recv_timeout(fd, 10);
-            fill_test_pattern(sbuf, 8192, 0);
-
-            /* Send 64KB (8 x 8KB) */
-            total_sent = 0;
-            for (i = 0; i < 8; i++) {
-                n = send(fd, (UBYTE *)sbuf, 8192, 0);
-                if (n <= 0) break;
-                total_sent += n;
-            }
+/* 39. tcp_network_64k */
+static void test_tcp_network_64k(void)
+{
+    LONG fd;
+    LONG total_sent, total_recv, verified_bytes;
+    int recv_offset, i;
+    LONG n;
+
+    fd = helper_connect_service(HELPER_TCP_ECHO);
+    if (fd >= 0) {
+        set_recv_timeout(fd, 10);
+        fill_test_pattern(sbuf, 8192, 0);
+
+        /* Send 64KB (8 x 8KB) */
+        total_sent = 0;
+        for (i = 0; i < 8; i++) {
+            n = send(fd, (UBYTE *)sbuf, 8192, 0);
+            if (n <= 0) break;
+            total_sent += n;
+        }
 
-            /* Receive with incremental chunk verification */
-            total_recv = 0;
-            verified_bytes = 0;
-            recv_offset = 0;
-            while (total_recv < 65536) {
-                n = recv(fd, (UBYTE *)rbuf + recv_offset,
-                         8192 - recv_offset, 0);
-                if (n <= 0) break;
-                total_recv += n;
-                recv_offset += n;
-                if (recv_offset >= 8192) {
-                    if (verify_test_pattern(rbuf, 8192, 0) == 0)
-                        verified_bytes += 8192;
-                    recv_offset = 0;
-                }
-            }
-            if (recv_offset > 0) {
-                if (verify_test_pattern(rbuf, recv_offset, 0) == 0)
-                    verified_bytes += recv_offset;
+        /* Receive with incremental chunk verification */
+        total_recv = 0;
+        verified_bytes = 0;
+        recv_offset = 0;
+        while (total_recv < 65536) {
+            n = recv(fd, (UBYTE *)rbuf + recv_offset,
+                     8192 - recv_offset, 0);
+            if (n <= 0) break;
+            total_recv += n;
+            recv_offset += n;
+            if (recv_offset >= 8192) {
+                if (verify_test_pattern(rbuf, 8192, 0) == 0)
+                    verified_bytes += 8192;
+                recv_offset = 0;
             }
-
-            tap_ok(verified_bytes >= 65536,
-                   "send()/recv(): 64KB TCP integrity via network [BSD 4.4]");
-            tap_diagf("  sent=%ld recv=%ld verified=%ld",
-                      (long)total_sent, (long)total_recv,
-                      (long)verified_bytes);
-            safe_close(fd);
-        } else {
-            tap_ok(0, "send()/recv(): 64KB TCP integrity via network [BSD 4.4]");
         }
-    }
-
-    CHECK_CTRLC();
-
-    /* 40. udp_network_datagram */
-    {
-        LONG fd;
-        struct sockaddr_in echo_addr;
-        socklen_t fromlen;
-        LONG n;
-
-        fd = make_udp_socket();
-        if (fd >= 0) {
-            memset(&echo_addr, 0, sizeof(echo_addr));
-            echo_addr.sin_family = AF_INET;
-            echo_addr.sin_port = htons(HELPER_UDP_ECHO);
-            echo_addr.sin_addr.s_addr = helper_addr();
+        if (recv_offset > 0) {
+            if (verify_test_pattern(rbuf, recv_offset, 0) == 0)
+                verified_bytes += recv_offset;
+        }
 
-            fill_test_pattern(sbuf, 512, 0x55);
-            n = sendto(fd, (UBYTE *)sbuf, 512, 0,
-                       (struct sockaddr *)&echo_addr, sizeof(echo_addr));
+        tap_ok(verified_bytes >= 65536,
+               "send()/recv(): 64KB TCP integrity via network [BSD 4.4]");
+        tap_diagf("  sent=%ld recv=%ld verified=%ld",
+                  (long)total_sent, (long)total_recv,
+                  (long)verified_bytes);
+        safe_close(fd);
+    } else {
+        tap_ok(0, "send()/recv(): 64KB TCP integrity via network [BSD 4.4]");
+    }
+}
 
+/* 40. udp_network_datagram */
+static void test_udp_network_datagram(void)
+{
+    struct sockaddr_in from_addr;
+    int mismatch;
+    LONG fd;
+    struct sockaddr_in echo_addr;
+    socklen_t fromlen;
+    LONG n;
+
+    fd = make_udp_socket();
+    if (fd >= 0) {
+        memset(&echo_addr, 0, sizeof(echo_addr));
+        echo_addr.sin_family = AF_INET;
+        echo_addr.sin_port = htons(helper_port(HELPER_UDP_ECHO));
+        echo_addr.sin_addr.s_addr = helper_addr();
+
+        fill_test_pattern(sbuf, 512, 0x55);
+        n = sendto(fd, (UBYTE *)sbuf, 512, 0,
+                   (struct sockaddr *)&echo_addr, sizeof(echo_addr));
+
+        if (n == 512) {
+            set_recv_timeout(fd, 5);
+            fromlen = sizeof(from_addr);
+            n = recvfrom(fd, (UBYTE *)rbuf, sizeof(rbuf), 0,
+                         (struct sockaddr *)&from_addr, &fromlen);
             if (n == 512) {
-                set_recv_timeout(fd, 5);
-                fromlen = sizeof(from_addr);
-                n = recvfrom(fd, (UBYTE *)rbuf, sizeof(rbuf), 0,
-                             (struct sockaddr *)&from_addr, &fromlen);
-                if (n == 512) {
-                    mismatch = verify_test_pattern(rbuf, 512, 0x55);
-                    tap_ok(mismatch == 0,
-                           "sendto()/recvfrom(): UDP datagram via network [RFC 768]");
-                    tap_diagf("  sent=512 recv=%ld", (long)n);
-                } else {
-                    tap_ok(0, "sendto()/recvfrom(): UDP datagram via network [RFC 768]");
-                    tap_diagf("  recv=%ld errno=%ld",
-                              (long)n, (long)get_bsd_errno());
-                }
+                mismatch = verify_test_pattern(rbuf, 512, 0x55);
+                tap_ok(mismatch == 0,
+                       "sendto()/recvfrom(): UDP datagram via network [RFC 768]");
+                tap_diagf("  sent=512 recv=%ld", (long)n);
             } else {
                 tap_ok(0, "sendto()/recvfrom(): UDP datagram via network [RFC 768]");
-                tap_diagf("  sendto=%ld errno=%ld",
+                tap_diagf("  recv=%ld errno=%ld",
                           (long)n, (long)get_bsd_errno());
             }
-            safe_close(fd);
         } else {
             tap_ok(0, "sendto()/recvfrom(): UDP datagram via network [RFC 768]");
+            tap_diagf("  sendto=%ld errno=%ld",
+                      (long)n, (long)get_bsd_errno());
         }
+        safe_close(fd);
+    } else {
+        tap_ok(0, "sendto()/recvfrom(): UDP datagram via network [RFC 768]");
     }
+}
 
-    CHECK_CTRLC();
-
-    /* 41. accept_external */
-    {
-        LONG ext_listener, accepted;
-        struct sockaddr_in bind_addr;
-        fd_set readfds;
-        struct timeval tv;
-        LONG n;
-
-        ext_listener = make_tcp_socket();
-        if (ext_listener >= 0) {
-            one = 1;
-            setsockopt(ext_listener, SOL_SOCKET, SO_REUSEADDR,
-                       &one, sizeof(one));
-            memset(&bind_addr, 0, sizeof(bind_addr));
-            bind_addr.sin_family = AF_INET;
-            bind_addr.sin_port = htons(get_test_port(161));
-            bind_addr.sin_addr.s_addr = htonl(INADDR_ANY);
-            bind(ext_listener, (struct sockaddr *)&bind_addr,
-                 sizeof(bind_addr));
-            listen(ext_listener, 5);
-
-            if (helper_request_connect(get_test_port(161))) {
-                /* WaitSelect for incoming connection */
-                FD_ZERO(&readfds);
-                FD_SET(ext_listener, &readfds);
-                tv.tv_secs = 5;
-                tv.tv_micro = 0;
-                rc = WaitSelect(ext_listener + 1, &readfds, NULL, NULL,
-                                &tv, NULL);
-                if (rc > 0) {
-                    accepted = accept(ext_listener, NULL, NULL);
-                    if (accepted >= 0) {
-                        set_recv_timeout(accepted, 5);
-                        total = 0;
-                        while (total < 30) {
-                            n = recv(accepted, (UBYTE *)rbuf + total,
-                                     30 - total, 0);
-                            if (n <= 0) break;
-                            total += n;
-                        }
-                        tap_ok(total == 30 &&
-                               memcmp(rbuf,
-                                      "BSDSOCKTEST HELLO FROM HELPER\n",
-                                      30) == 0,
-                               "accept(): incoming connection from remote host [BSD 4.4]");
-                        if (total != 30)
-                            tap_diagf("  received %d of 30 bytes", total);
-                        safe_close(accepted);
-                    } else {
-                        tap_ok(0, "accept(): incoming connection from remote host [BSD 4.4]");
+/* 41. accept_external */
+static void test_accept_external(void)
+{
+    int rc, total;
+    LONG one = 1;
+    LONG ext_listener, accepted;
+    struct sockaddr_in bind_addr;
+    fd_set readfds;
+    struct timeval tv;
+    LONG n;
+
+    ext_listener = make_tcp_socket();
+    if (ext_listener >= 0) {
+        one = 1;
+        setsockopt(ext_listener, SOL_SOCKET, SO_REUSEADDR,
+                   &one, sizeof(one));
+        memset(&bind_addr, 0, sizeof(bind_addr));
+        bind_addr.sin_family = AF_INET;
+        bind_addr.sin_port = htons(get_test_port(161));
+        bind_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        bind(ext_listener, (struct sockaddr *)&bind_addr,
+             sizeof(bind_addr));
+        listen(ext_listener, 5);
+
+        if (helper_request_connect(get_test_port(161))) {
+            /* WaitSelect for incoming connection */
+            FD_ZERO(&readfds);
+            FD_SET(ext_listener, &readfds);
+            tv.tv_secs = 5;
+            tv.tv_micro = 0;
+            rc = WaitSelect(ext_listener + 1, &readfds, NULL, NULL,
+                            &tv, NULL);
+            if (rc > 0) {
+                accepted = accept(ext_listener, NULL, NULL);
+                if (accepted >= 0) {
+                    set_recv_timeout(accepted, 5);
+                    total = 0;
+                    while (total < 30) {
+                        n = recv(accepted, (UBYTE *)rbuf + total,
+                                 30 - total, 0);
+                        if (n <= 0) break;
+                        total += n;
                     }
+                    tap_ok(total == 30 &&
+                           memcmp(rbuf,
+                                  "BSDSOCKTEST HELLO FROM HELPER\n",
+                                  30) == 0,
+                           "accept(): incoming connection from remote host [BSD 4.4]");
+                    if (total != 30)
+                        tap_diagf("  received %d of 30 bytes", total);
+                    safe_close(accepted);
                 } else {
                     tap_ok(0, "accept(): incoming connection from remote host [BSD 4.4]");
                 }
             } else {
                 tap_ok(0, "accept(): incoming connection from remote host [BSD 4.4]");
             }
-            safe_close(ext_listener);
         } else {
             tap_ok(0, "accept(): incoming connection from remote host [BSD 4.4]");
         }
+        safe_close(ext_listener);
+    } else {
+        tap_ok(0, "accept(): incoming connection from remote host [BSD 4.4]");
     }
+}
 
-    CHECK_CTRLC();
-
-    /* 42. tcp_network_large */
-    {
-        LONG fd;
-        LONG total_sent, total_recv, verified_bytes;
-        int recv_offset, i;
-        LONG n;
-        struct bst_timestamp ts_before, ts_after;
-        LONG elapsed_ms, kbps;
-
-        fd = helper_connect_service(HELPER_TCP_ECHO);
-        if (fd >= 0) {
-            set_recv_timeout(fd, 30);
-            fill_test_pattern(sbuf, 8192, 0);
-
-            timer_now(&ts_before);
-
-            /* Send 256KB (32 x 8KB) */
-            total_sent = 0;
-            for (i = 0; i < 32; i++) {
-                n = send(fd, (UBYTE *)sbuf, 8192, 0);
-                if (n <= 0) break;
-                total_sent += n;
-            }
+/* 42. tcp_network_large */
+static void test_tcp_network_large(void)
+{
+    LONG fd;
+    LONG total_sent, total_recv, verified_bytes;
+    int recv_offset, i;
+    LONG n;
+    struct bst_timestamp ts_before, ts_after;
+    LONG elapsed_ms, kbps;
+
+    fd = helper_connect_service(HELPER_TCP_ECHO);
+    if (fd >= 0) {
+        set_recv_timeout(fd, 30);
+        fill_test_pattern(sbuf, 8192, 0);
+
+        timer_now(&ts_before);
+
+        /* Send 256KB (32 x 8KB) */
+        total_sent = 0;
+        for (i = 0; i < 32; i++) {
+            n = send(fd, (UBYTE *)sbuf, 8192, 0);
+            if (n <= 0) break;
+            total_sent += n;
+        }
 
-            /* Receive with incremental chunk verification */
-            total_recv = 0;
-            verified_bytes = 0;
-            recv_offset = 0;
-            while (total_recv < 262144) {
-                n = recv(fd, (UBYTE *)rbuf + recv_offset,
-                         8192 - recv_offset, 0);
-                if (n <= 0) break;
-                total_recv += n;
-                recv_offset += n;
-                if (recv_offset >= 8192) {
-                    if (verify_test_pattern(rbuf, 8192, 0) == 0)
-                        verified_bytes += 8192;
-                    recv_offset = 0;
-                }
-            }
-            if (recv_offset > 0) {
-                if (verify_test_pattern(rbuf, recv_offset, 0) == 0)
-                    verified_bytes += recv_offset;
+        /* Receive with incremental chunk verification */
+        total_recv = 0;
+        verified_bytes = 0;
+        recv_offset = 0;
+        while (total_recv < 262144) {
+            n = recv(fd, (UBYTE *)rbuf + recv_offset,
+                     8192 - recv_offset, 0);
+            if (n <= 0) break;
+            total_recv += n;
+            recv_offset += n;
+            if (recv_offset >= 8192) {
+                if (verify_test_pattern(rbuf, 8192, 0) == 0)
+                    verified_bytes += 8192;
+                recv_offset = 0;
             }
-
-            timer_now(&ts_after);
-            elapsed_ms = (LONG)timer_elapsed_ms(&ts_before, &ts_after);
-            kbps = (elapsed_ms > 0)
-                 ? (verified_bytes / 1024L) * 1000L / elapsed_ms
-                 : 0;
-
-            tap_ok(verified_bytes >= 262144,
-                   "send()/recv(): 256KB+ TCP integrity via network [BSD 4.4]");
-            tap_diagf("  sent=%ld recv=%ld verified=%ld ms=%ld KB/s=%ld",
-                      (long)total_sent, (long)total_recv,
-                      (long)verified_bytes, (long)elapsed_ms, (long)kbps);
-            tap_notef("Network 256KB echo: %ld KB/s", (long)kbps);
-            safe_close(fd);
-        } else {
-            tap_ok(0, "send()/recv(): 256KB+ TCP integrity via network [BSD 4.4]");
         }
+        if (recv_offset > 0) {
+            if (verify_test_pattern(rbuf, recv_offset, 0) == 0)
+                verified_bytes += recv_offset;
+        }
+
+        timer_now(&ts_after);
+        elapsed_ms = (LONG)timer_elapsed_ms(&ts_before, &ts_after);
+        kbps = (elapsed_ms > 0)
+             ? (verified_bytes / 1024L) * 1000L / elapsed_ms
+             : 0;
+
+        tap_ok(verified_bytes >= 262144,
+               "send()/recv(): 256KB+ TCP integrity via network [BSD 4.4]");
+        tap_diagf("  sent=%ld recv=%ld verified=%ld ms=%ld KB/s=%ld",
+                  (long)total_sent, (long)total_recv,
+                  (long)verified_bytes, (long)elapsed_ms, (long)kbps);
+        tap_notef("Network 256KB echo: %ld KB/s", (long)kbps);
+        tap_metric("throughput", (long)kbps, "KB/s");
+        safe_close(fd);
+    } else {
+        tap_ok(0, "send()/recv(): 256KB+ TCP integrity via network [BSD 4.4]");
     }
 }
+
+/* ---- Registry ---- */
+
+const struct test_entry sendrecv_tests[] = {
+    { 24, "sendrecv_basic_100", TIER_LOOPBACK, 20, 20,
+      test_sendrecv_basic_100 },
+    { 25, "sendrecv_large_8192", TIER_LOOPBACK, 21, 21,
+      test_sendrecv_large_8192 },
+    { 26, "recv_msg_peek", TIER_LOOPBACK, 22, 22,
+      test_recv_msg_peek },
+    { 27, "sendrecv_msg_oob", TIER_LOOPBACK, 23, 23,
+      test_sendrecv_msg_oob },
+    { 28, "udp_sendto_recvfrom", TIER_LOOPBACK, 24, 24,
+      test_udp_sendto_recvfrom },
+    { 29, "udp_sendto_after_prior_ops", TIER_LOOPBACK, 25, 25,
+      test_udp_sendto_after_prior_ops },
+    { 30, "udp_sendto_basic_second", TIER_LOOPBACK, 26, 26,
+      test_udp_sendto_basic_second },
+    { 31, "sendmsg_recvmsg_single", TIER_LOOPBACK, 27, 27,
+      test_sendmsg_recvmsg_single },
+    { 32, "sendmsg_recvmsg_scatter", TIER_LOOPBACK, 28, 28,
+      test_sendmsg_recvmsg_scatter },
+    { 33, "recv_nonblocking_ewouldblock", TIER_LOOPBACK, 29, 29,
+      test_recv_nonblocking_ewouldblock },
+    { 34, "send_nonblocking_ewouldblock", TIER_LOOPBACK, 30, 30,
+      test_send_nonblocking_ewouldblock },
+    { 35, "send_after_peer_close", TIER_LOOPBACK, 31, 31,
+      test_send_after_peer_close },
+    { 36, "sendrecv_bidirectional", TIER_LOOPBACK, 32, 32,
+      test_sendrecv_bidirectional },
+    { 37, "recv_zero_length", TIER_LOOPBACK, 33, 33,
+      test_recv_zero_length },
+    { 38, "send_zero_bytes", TIER_LOOPBACK, 34, 34,
+      test_send_zero_bytes },
+    { 39, "tcp_network_64k", TIER_NETWORK, -1, -1,
+      test_tcp_network_64k },
+    { 40, "udp_network_datagram", TIER_NETWORK, -1, -1,
+      test_udp_network_datagram },
+    { 41, "accept_external", TIER_NETWORK, 161, 161,
+      test_accept_external },
+    { 42, "tcp_network_large", TIER_NETWORK, -1, -1,
+      test_tcp_network_large },
+    { 0, NULL, 0, 0, 0, NULL }
+};
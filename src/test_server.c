@@ -0,0 +1,479 @@
+/*
+ * bsdsocktest — Server-mode benchmark tests
+ *
+ * Tests: the Amiga serves echo and sink listeners while the host helper
+ * (LOAD command) opens client connections against them at a set rate.
+ * The helper measures connect latency and response times and reports
+ * them back over the control channel; they appear as TAP diagnostics.
+ *
+ * The serve loop is a single WaitSelect() over the listener, every
+ * accepted client and the control socket, so the numbers cover the
+ * stack's accept path and the suite's own event handling together.
+ *
+ * The flood tests (FLOOD command) open connections without sending
+ * anything, to see how many a listen() backlog absorbs and how fast
+ * the stack hands them to accept().
+ *
+ * 5 tests (146-150), port offsets 200-219.
+ */
+
+#include "tap.h"
+#include "testutil.h"
+#include "tests.h"
+#include "helper_proto.h"
+#include "profile.h"
+
+#include <proto/bsdsocket.h>
+
+#include <netinet/in.h>
+#include <stdio.h>
+#include <string.h>
+
+#define SV_MAX_CLIENTS  32      /* concurrently served connections */
+#define SV_BACKLOG      16
+#define SV_WAIT_SECS    40      /* helper gives up after 30s */
+#define SV_BUFSIZE      8192
+
+#define SV_ECHO_CONNS   8       /* 146: concurrent echo clients */
+#define SV_ECHO_COUNT   50      /* round trips per client */
+#define SV_ECHO_SIZE    64
+#define SV_SINK_CONNS   4       /* 147: concurrent sink clients */
+#define SV_SINK_SIZE    4096
+#define SV_SINK_COUNT   64      /* 256KB per client */
+#define SV_RATE_CONNS   50      /* 148: connections opened ... */
+#define SV_RATE         25      /* ... at this many per second */
+#define SV_RATE_SIZE    32
+#define SV_FLOOD_CONNS  32      /* 149: connections left in the backlog */
+#define SV_ACCEPT_CONNS 64      /* 150: connections accepted under flood */
+#define SV_NUM_BACKLOGS 3
+
+static UBYTE sv_buf[SV_BUFSIZE];
+static const int sv_backlogs[SV_NUM_BACKLOGS] = { 1, 4, 16 };
+
+/* What the Amiga side saw while serving one LOAD run */
+struct sv_stats {
+    LONG accepted;
+    LONG bytes;
+    int max_active;
+};
+
+/* Accept counts for one FLOOD run */
+struct sv_flood {
+    LONG accepted;      /* while the flood ran */
+    LONG queued;        /* still in the backlog when RESULT arrived */
+    ULONG span_us;      /* first to last accept while the flood ran */
+};
+
+/* TCP listener on all interfaces, so the helper can reach it */
+static LONG sv_listener(int port, int backlog)
+{
+    struct sockaddr_in addr;
+    LONG fd, one;
+
+    fd = make_tcp_socket();
+    if (fd < 0)
+        return -1;
+    one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(fd, backlog) < 0) {
+        safe_close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* Start a LOAD run against a fresh listener and serve it until the
+ * helper's RESULT arrives.  echo: every byte received is sent back;
+ * otherwise data is discarded.  Clients are closed on EOF.
+ * Returns 1 with 'res' filled, 0 on failure (reason logged). */
+static int sv_run(const char *mode, int offset, int conns, int rate,
+                  int count, int size, struct helper_load_result *res,
+                  struct sv_stats *st)
+{
+    LONG clients[SV_MAX_CLIENTS];
+    LONG listener, ctrl, fd, maxfd, n, sent, rc;
+    struct bst_timestamp start, now;
+    struct timeval tv;
+    fd_set readfds;
+    int i, active, echo, got;
+
+    memset(st, 0, sizeof(*st));
+    echo = (strcmp(mode, "echo") == 0);
+    ctrl = helper_ctrl_socket();
+
+    listener = sv_listener(get_test_port(offset), SV_BACKLOG);
+    if (listener < 0) {
+        tap_diagf("  listener failed: errno=%ld", (long)get_bsd_errno());
+        return 0;
+    }
+    if (!helper_load(mode, get_test_port(offset), conns, rate, count,
+                     size)) {
+        tap_diag("  helper did not acknowledge LOAD");
+        safe_close(listener);
+        return 0;
+    }
+
+    for (i = 0; i < SV_MAX_CLIENTS; i++)
+        clients[i] = -1;
+    active = 0;
+    got = 0;
+    timer_now(&start);
+
+    for (;;) {
+        timer_now(&now);
+        if (timer_elapsed_ms(&start, &now) > SV_WAIT_SECS * 1000UL) {
+            tap_diag("  no RESULT from helper");
+            break;
+        }
+        if (SetSignal(0L, 0L) & SIGBREAKF_CTRL_C)
+            break;      /* left for the caller's CHECK_CTRLC() */
+
+        FD_ZERO(&readfds);
+        FD_SET(ctrl, &readfds);
+        maxfd = ctrl;
+        /* Full: leave further clients in the listen backlog */
+        if (active < SV_MAX_CLIENTS) {
+            FD_SET(listener, &readfds);
+            if (listener > maxfd) maxfd = listener;
+        }
+        for (i = 0; i < SV_MAX_CLIENTS; i++) {
+            if (clients[i] >= 0) {
+                FD_SET(clients[i], &readfds);
+                if (clients[i] > maxfd) maxfd = clients[i];
+            }
+        }
+        tv.tv_secs = 1;
+        tv.tv_micro = 0;
+        rc = WaitSelect(maxfd + 1, &readfds, NULL, NULL, &tv, NULL);
+        if (rc < 0) {
+            tap_diagf("  WaitSelect failed: errno=%ld",
+                      (long)get_bsd_errno());
+            break;
+        }
+        if (rc == 0)
+            continue;
+
+        if (FD_ISSET(ctrl, &readfds)) {
+            got = helper_load_done(res);
+            break;
+        }
+
+        if (active < SV_MAX_CLIENTS && FD_ISSET(listener, &readfds)) {
+            fd = accept(listener, NULL, NULL);
+            if (fd >= 0) {
+                for (i = 0; clients[i] >= 0; i++)
+                    ;
+                clients[i] = fd;
+                active++;
+                st->accepted++;
+                if (active > st->max_active)
+                    st->max_active = active;
+            }
+        }
+
+        for (i = 0; i < SV_MAX_CLIENTS; i++) {
+            fd = clients[i];
+            if (fd < 0 || !FD_ISSET(fd, &readfds))
+                continue;
+            n = recv(fd, sv_buf, SV_BUFSIZE, 0);
+            if (n > 0) {
+                st->bytes += n;
+                sent = 0;
+                while (echo && sent < n) {
+                    rc = send(fd, sv_buf + sent, n - sent, 0);
+                    if (rc <= 0)
+                        break;
+                    sent += rc;
+                }
+                if (sent == n || !echo)
+                    continue;
+            }
+            /* EOF, error or failed echo: drop the client */
+            safe_close(fd);
+            clients[i] = -1;
+            active--;
+        }
+    }
+
+    for (i = 0; i < SV_MAX_CLIENTS; i++)
+        safe_close(clients[i]);
+    safe_close(listener);
+    return got;
+}
+
+/* Flood a fresh listener with 'conns' helper connections.  With 'serve'
+ * set, connections are accepted (and closed at once) while the flood
+ * runs; otherwise they are left in the backlog.  Either way the backlog
+ * is drained once the helper's RESULT arrives.
+ * Returns 1 with 'res' and 'fl' filled, 0 on failure (reason logged). */
+static int sv_flood(int offset, int backlog, int conns, int serve,
+                    struct helper_load_result *res, struct sv_flood *fl)
+{
+    LONG listener, ctrl, fd, maxfd, rc;
+    struct bst_timestamp start, now, first, last;
+    struct timeval tv;
+    fd_set readfds;
+    int got;
+
+    memset(fl, 0, sizeof(*fl));
+    ctrl = helper_ctrl_socket();
+
+    listener = sv_listener(get_test_port(offset), backlog);
+    if (listener < 0) {
+        tap_diagf("  listener failed: errno=%ld", (long)get_bsd_errno());
+        return 0;
+    }
+    if (!helper_flood(get_test_port(offset), conns, 0)) {
+        tap_diag("  helper did not acknowledge FLOOD");
+        safe_close(listener);
+        return 0;
+    }
+
+    got = 0;
+    timer_now(&start);
+    first = start;
+    last = start;
+    for (;;) {
+        timer_now(&now);
+        if (timer_elapsed_ms(&start, &now) > SV_WAIT_SECS * 1000UL) {
+            tap_diag("  no RESULT from helper");
+            break;
+        }
+        if (SetSignal(0L, 0L) & SIGBREAKF_CTRL_C)
+            break;
+
+        FD_ZERO(&readfds);
+        FD_SET(ctrl, &readfds);
+        maxfd = ctrl;
+        if (serve) {
+            FD_SET(listener, &readfds);
+            if (listener > maxfd) maxfd = listener;
+        }
+        tv.tv_secs = 1;
+        tv.tv_micro = 0;
+        rc = WaitSelect(maxfd + 1, &readfds, NULL, NULL, &tv, NULL);
+        if (rc < 0) {
+            tap_diagf("  WaitSelect failed: errno=%ld",
+                      (long)get_bsd_errno());
+            break;
+        }
+        if (rc == 0)
+            continue;
+
+        if (FD_ISSET(ctrl, &readfds)) {
+            got = helper_load_done(res);
+            break;
+        }
+        if (serve && FD_ISSET(listener, &readfds)) {
+            fd = accept(listener, NULL, NULL);
+            if (fd >= 0) {
+                timer_now(&last);
+                if (fl->accepted == 0)
+                    first = last;
+                fl->accepted++;
+                safe_close(fd);
+            }
+        }
+    }
+
+    /* Whatever the backlog still holds */
+    for (;;) {
+        FD_ZERO(&readfds);
+        FD_SET(listener, &readfds);
+        tv.tv_secs = 0;
+        tv.tv_micro = 200000;
+        if (WaitSelect(listener + 1, &readfds, NULL, NULL, &tv, NULL) <= 0)
+            break;
+        fd = accept(listener, NULL, NULL);
+        if (fd < 0)
+            break;
+        fl->queued++;
+        safe_close(fd);
+    }
+
+    if (fl->accepted > 1)
+        fl->span_us = timer_elapsed_us(&first, &last);
+    safe_close(listener);
+    return got;
+}
+
+static void sv_diag_result(const struct helper_load_result *res,
+                           const struct sv_stats *st, int conns,
+                           const char *rt_name)
+{
+    tap_diagf("  conns=%d ok=%lu failed=%lu refused=%lu timeout=%lu bad=%lu",
+              conns, res->ok, res->failed, res->refused, res->timeout,
+              res->bad);
+    tap_diagf("  amiga: accepted=%ld bytes=%ld max_concurrent=%d",
+              (long)st->accepted, (long)st->bytes, st->max_active);
+    tap_diagf("  connect_us: p50=%lu p90=%lu max=%lu",
+              res->conn_p50, res->conn_p90, res->conn_max);
+    tap_diagf("  %s_us: p50=%lu p90=%lu p99=%lu max=%lu", rt_name,
+              res->rt_p50, res->rt_p90, res->rt_p99, res->rt_max);
+}
+
+/* 146. sv_echo_load */
+static void test_sv_echo_load(void)
+{
+    struct helper_load_result res;
+    struct sv_stats st;
+    unsigned long rate;
+
+    if (sv_run("echo", 200, SV_ECHO_CONNS, 0, SV_ECHO_COUNT,
+               SV_ECHO_SIZE, &res, &st)) {
+        rate = (res.elapsed_ms > 0)
+             ? (res.bytes / SV_ECHO_SIZE) * 1000UL / res.elapsed_ms : 0;
+        tap_ok(res.ok == SV_ECHO_CONNS && res.bad == 0,
+               "Server: TCP echo under 8 concurrent clients [benchmark]");
+        sv_diag_result(&res, &st, SV_ECHO_CONNS, "response");
+        tap_diagf("  requests=%lu elapsed_ms=%lu requests/s=%lu",
+                  res.bytes / SV_ECHO_SIZE, res.elapsed_ms, rate);
+        tap_notef("Server echo: %lu requests/s, p99 %lu us",
+                  rate, res.rt_p99);
+        tap_metric("requests", (long)rate, "/s");
+        tap_metric("response_p99", (long)res.rt_p99, "us");
+    } else {
+        tap_ok(0, "Server: TCP echo under 8 concurrent clients [benchmark]");
+    }
+}
+
+/* 147. sv_sink_load */
+static void test_sv_sink_load(void)
+{
+    struct helper_load_result res;
+    struct sv_stats st;
+    unsigned long rate;
+
+    if (sv_run("sink", 201, SV_SINK_CONNS, 0, SV_SINK_COUNT,
+               SV_SINK_SIZE, &res, &st)) {
+        rate = (res.elapsed_ms > 0)
+             ? (res.bytes / 1024UL) * 1000UL / res.elapsed_ms : 0;
+        tap_ok(res.ok == SV_SINK_CONNS && res.bad == 0,
+               "Server: TCP sink under 4 concurrent streams [benchmark]");
+        sv_diag_result(&res, &st, SV_SINK_CONNS, "transfer");
+        tap_diagf("  bytes=%lu elapsed_ms=%lu KB/s=%lu",
+                  res.bytes, res.elapsed_ms, rate);
+        tap_notef("Server sink: %lu KB/s (4 streams)", rate);
+        tap_metric("throughput", (long)rate, "KB/s");
+    } else {
+        tap_ok(0, "Server: TCP sink under 4 concurrent streams [benchmark]");
+    }
+}
+
+/* 148. sv_accept_rate */
+static void test_sv_accept_rate(void)
+{
+    struct helper_load_result res;
+    struct sv_stats st;
+    unsigned long rate;
+
+    if (sv_run("echo", 202, SV_RATE_CONNS, SV_RATE, 1,
+               SV_RATE_SIZE, &res, &st)) {
+        rate = (res.elapsed_ms > 0)
+             ? res.ok * 1000UL / res.elapsed_ms : 0;
+        tap_ok(res.ok == SV_RATE_CONNS && res.bad == 0,
+               "Server: accept 50 connections at 25/s [benchmark]");
+        sv_diag_result(&res, &st, SV_RATE_CONNS, "response");
+        tap_diagf("  elapsed_ms=%lu completed/s=%lu",
+                  res.elapsed_ms, rate);
+        tap_notef("Server accept: %lu conn/s, connect p90 %lu us",
+                  rate, res.conn_p90);
+        tap_metric("connections", (long)rate, "/s");
+        tap_metric("connect_p90", (long)res.conn_p90, "us");
+    } else {
+        tap_ok(0, "Server: accept 50 connections at 25/s [benchmark]");
+    }
+}
+
+/* 149. sv_backlog_absorb */
+static void test_sv_backlog_absorb(void)
+{
+    struct helper_load_result fr[SV_NUM_BACKLOGS];
+    struct sv_flood fl[SV_NUM_BACKLOGS];
+    char name[32];
+    int b, pass;
+
+    pass = 1;
+    for (b = 0; b < SV_NUM_BACKLOGS; b++) {
+        if (!sv_flood(203 + b, sv_backlogs[b], SV_FLOOD_CONNS, 0,
+                      &fr[b], &fl[b]) || fl[b].queued == 0) {
+            pass = 0;
+            break;
+        }
+    }
+    tap_ok(pass, "Server: listen() backlog absorbs a connection flood [benchmark]");
+    for (b = 0; pass && b < SV_NUM_BACKLOGS; b++) {
+        tap_diagf("  backlog=%d flood=%d established=%lu refused=%lu "
+                  "timeout=%lu queued=%ld",
+                  sv_backlogs[b], SV_FLOOD_CONNS, fr[b].ok,
+                  fr[b].refused, fr[b].timeout, (long)fl[b].queued);
+        tap_diagf("    connect_us: p50=%lu p90=%lu max=%lu",
+                  fr[b].conn_p50, fr[b].conn_p90, fr[b].conn_max);
+        sprintf(name, "backlog%d_queued", sv_backlogs[b]);
+        tap_metric(name, (long)fl[b].queued, "connections");
+    }
+    if (pass)
+        tap_notef("Backlog 1/4/16 absorbed: %ld/%ld/%ld of %d",
+                  (long)fl[0].queued, (long)fl[1].queued,
+                  (long)fl[2].queued, SV_FLOOD_CONNS);
+}
+
+/* 150. sv_accept_flood */
+static void test_sv_accept_flood(void)
+{
+    struct helper_load_result fr[SV_NUM_BACKLOGS];
+    struct sv_flood fl[SV_NUM_BACKLOGS];
+    unsigned long accept_rate[SV_NUM_BACKLOGS];
+    char name[32];
+    int b, pass;
+
+    pass = 1;
+    for (b = 0; b < SV_NUM_BACKLOGS; b++) {
+        if (!sv_flood(206 + b, sv_backlogs[b], SV_ACCEPT_CONNS, 1,
+                      &fr[b], &fl[b]) ||
+            fl[b].accepted + fl[b].queued == 0) {
+            pass = 0;
+            break;
+        }
+        accept_rate[b] = (fl[b].span_us > 0)
+            ? (unsigned long)(fl[b].accepted - 1) * 1000000UL /
+              fl[b].span_us
+            : 0;
+    }
+    tap_ok(pass, "Server: accept() rate under a connection flood [benchmark]");
+    for (b = 0; pass && b < SV_NUM_BACKLOGS; b++) {
+        tap_diagf("  backlog=%d flood=%d established=%lu refused=%lu "
+                  "timeout=%lu accepted=%ld late=%ld accepts/s=%lu",
+                  sv_backlogs[b], SV_ACCEPT_CONNS, fr[b].ok,
+                  fr[b].refused, fr[b].timeout, (long)fl[b].accepted,
+                  (long)fl[b].queued, accept_rate[b]);
+        tap_diagf("    connect_us: p50=%lu p90=%lu max=%lu",
+                  fr[b].conn_p50, fr[b].conn_p90, fr[b].conn_max);
+        sprintf(name, "backlog%d_accepts", sv_backlogs[b]);
+        tap_metric(name, (long)accept_rate[b], "/s");
+    }
+    if (pass)
+        tap_notef("Accept flood, backlog 1/4/16: %lu/%lu/%lu accepts/s",
+                  accept_rate[0], accept_rate[1], accept_rate[2]);
+}
+
+/* ---- Registry ---- */
+
+const struct test_entry server_tests[] = {
+    { 146, "sv_echo_load", TIER_NETWORK, 200, 200,
+      test_sv_echo_load },
+    { 147, "sv_sink_load", TIER_NETWORK, 201, 201,
+      test_sv_sink_load },
+    { 148, "sv_accept_rate", TIER_NETWORK, 202, 202,
+      test_sv_accept_rate },
+    { 149, "sv_backlog_absorb", TIER_NETWORK, 203, 205,
+      test_sv_backlog_absorb },
+    { 150, "sv_accept_flood", TIER_NETWORK, 206, 208,
+      test_sv_accept_flood },
+    { 0, NULL, 0, 0, 0, NULL }
+};
@@ -9,7 +9,9 @@
 
 #include "tap.h"
 #include "testutil.h"
+#include "tests.h"
 #include "known_failures.h"
+#include "profile.h"
 
 #include <proto/bsdsocket.h>
 #include <proto/exec.h>
@@ -17,27 +19,13 @@
 #include <errno.h>
 #include <string.h>
 
-void run_signals_tests(void)
+/* ---- SetSocketSignals legacy API ---- */
+
+/* 73. setsocketsignals_basic */
+static void test_setsocketsignals_basic(void)
 {
     BYTE sigbit;
-    ULONG sigmask, orig, retrieved, pending;
-    ULONG evmask, evmask1, evmask2;
-    LONG evfd, evfd1, evfd2;
-    LONG listener, client, server;
-    LONG listener2, client2, server2;
-    LONG mask;
-    LONG fd;
-    LONG dtsize, new_dtsize;
-    ULONG ptr;
-    struct timeval tv;
-    struct sockaddr_in addr;
-    unsigned char sbuf[100], rbuf[100];
-    int port, rc, i, passed;
-    const char *cr;
 
-    /* ---- SetSocketSignals legacy API ---- */
-
-    /* 73. setsocketsignals_basic */
     sigbit = alloc_signal();
     if (sigbit >= 0) {
         SetSocketSignals(1UL << sigbit, 0, 0);
@@ -47,12 +35,16 @@ void run_signals_tests(void)
     } else {
         tap_skip("could not allocate signal");
     }
+}
 
-    CHECK_CTRLC();
+/* ---- SocketBaseTagList roundtrips ---- */
 
-    /* ---- SocketBaseTagList roundtrips ---- */
+/* 74. sbt_breakmask */
+static void test_sbt_breakmask(void)
+{
+    BYTE sigbit;
+    ULONG orig, retrieved;
 
-    /* 74. sbt_breakmask */
     sigbit = alloc_signal();
     if (sigbit >= 0) {
         orig = 0;
@@ -70,10 +62,14 @@ void run_signals_tests(void)
     } else {
         tap_skip("could not allocate signal");
     }
+}
 
-    CHECK_CTRLC();
+/* 75. sbt_sigeventmask */
+static void test_sbt_sigeventmask(void)
+{
+    BYTE sigbit;
+    ULONG orig, retrieved;
 
-    /* 75. sbt_sigeventmask */
     sigbit = alloc_signal();
     if (sigbit >= 0) {
         orig = 0;
@@ -94,28 +90,37 @@ void run_signals_tests(void)
     } else {
         tap_skip("could not allocate signal");
     }
+}
 
-    CHECK_CTRLC();
+/* 76. sbt_errnolongptr_get */
+static void test_sbt_errnolongptr_get(void)
+{
+    ULONG ptr;
 
-    /* 76. sbt_errnolongptr_get */
     ptr = 0;
     SocketBaseTags(SBTM_GETREF(SBTC_ERRNOLONGPTR), (ULONG)&ptr, TAG_DONE);
     tap_ok(ptr != 0,
            "SocketBaseTags(SBTC_ERRNOLONGPTR): get errno pointer [AmiTCP]");
     tap_diagf("  pointer: 0x%08lx", (unsigned long)ptr);
+}
 
-    CHECK_CTRLC();
+/* 77. sbt_herrnolongptr_get */
+static void test_sbt_herrnolongptr_get(void)
+{
+    ULONG ptr;
 
-    /* 77. sbt_herrnolongptr_get */
     ptr = 0;
     SocketBaseTags(SBTM_GETREF(SBTC_HERRNOLONGPTR), (ULONG)&ptr, TAG_DONE);
     tap_ok(ptr != 0,
            "SocketBaseTags(SBTC_HERRNOLONGPTR): get h_errno pointer [AmiTCP]");
     tap_diagf("  pointer: 0x%08lx", (unsigned long)ptr);
+}
 
-    CHECK_CTRLC();
+/* 78. sbt_dtablesize */
+static void test_sbt_dtablesize(void)
+{
+    LONG dtsize, new_dtsize;
 
-    /* 78. sbt_dtablesize */
     dtsize = 0;
     SocketBaseTags(SBTM_GETREF(SBTC_DTABLESIZE), (ULONG)&dtsize, TAG_DONE);
     tap_diagf("  current dtablesize: %ld", (long)dtsize);
@@ -137,28 +142,54 @@ void run_signals_tests(void)
         if (dtsize > 0)
             SocketBaseTags(SBTM_SETVAL(SBTC_DTABLESIZE), dtsize, TAG_DONE);
     }
+}
+
+/* ---- SO_EVENTMASK + GetSocketEvents ---- */
+
+/*
+
+* Each event test follows the signal testing pattern:
+
+* 1. Allocate signal, set SIGEVENTMASK
+
+* 2. Set SO_EVENTMASK on target socket
+
+* 3. Trigger event
+
+* 4. WaitSelect for signal (2s safety timeout)
+
+* 5. GetSocketEvents to check result
+
+*
+
+* Cleanup order (critical — prevents signal races):
+
+* a. Clear SO_EVENTMASK to 0 on each socket
+
+* b. SBTM_SETVAL(SBTC_SIGEVENTMASK, 0)
+
+* c. Close all sockets
+
+* d. SetSignal(0, 1UL << sigbit)
+
+* e. free_signal(sigbit)
+
+*/
+
+/* 79. eventmask_fd_read */
+static void test_eventmask_fd_read(void)
+{
+    BYTE sigbit;
+    ULONG sigmask;
+    ULONG evmask;
+    LONG evfd;
+    LONG listener, client, server;
+    LONG mask;
+    struct timeval tv;
+    unsigned char sbuf[100];
+    int port;
+    const char *cr;
 
-    CHECK_CTRLC();
-
-    /* ---- SO_EVENTMASK + GetSocketEvents ---- */
-
-    /*
-     * Each event test follows the signal testing pattern:
-     * 1. Allocate signal, set SIGEVENTMASK
-     * 2. Set SO_EVENTMASK on target socket
-     * 3. Trigger event
-     * 4. WaitSelect for signal (2s safety timeout)
-     * 5. GetSocketEvents to check result
-     *
-     * Cleanup order (critical — prevents signal races):
-     * a. Clear SO_EVENTMASK to 0 on each socket
-     * b. SBTM_SETVAL(SBTC_SIGEVENTMASK, 0)
-     * c. Close all sockets
-     * d. SetSignal(0, 1UL << sigbit)
-     * e. free_signal(sigbit)
-     */
-
-    /* 79. eventmask_fd_read */
     cr = known_crash(79);
     if (cr) {
         tap_ok(0, "SO_EVENTMASK FD_READ: signal on data arrival [AmiTCP]");
@@ -205,10 +236,22 @@ void run_signals_tests(void)
             tap_skip("could not allocate signal");
         }
     }
+}
 
-    CHECK_CTRLC();
+/* 80. eventmask_fd_connect */
+static void test_eventmask_fd_connect(void)
+{
+    BYTE sigbit;
+    ULONG sigmask;
+    ULONG evmask;
+    LONG evfd;
+    LONG listener, client, server;
+    LONG mask;
+    struct timeval tv;
+    struct sockaddr_in addr;
+    int port, rc;
+    const char *cr;
 
-    /* 80. eventmask_fd_connect */
     cr = known_crash(80);
     if (cr) {
         tap_ok(0, "SO_EVENTMASK FD_CONNECT: signal on connect [AmiTCP]");
@@ -278,10 +321,19 @@ void run_signals_tests(void)
             tap_skip("could not allocate signal");
         }
     }
+}
 
-    CHECK_CTRLC();
+/* 81. eventmask_no_spurious */
+static void test_eventmask_no_spurious(void)
+{
+    BYTE sigbit;
+    ULONG pending;
+    ULONG evmask;
+    LONG evfd;
+    LONG mask;
+    LONG fd;
+    const char *cr;
 
-    /* 81. eventmask_no_spurious */
     cr = known_crash(81);
     if (cr) {
         tap_ok(0, "SO_EVENTMASK: no spurious events on idle socket [AmiTCP]");
@@ -296,9 +348,7 @@ void run_signals_tests(void)
                 mask = FD_READ | FD_WRITE | FD_CONNECT;
                 setsockopt(fd, SOL_SOCKET, SO_EVENTMASK, &mask, sizeof(mask));
                 /* Brief delay */
-                tv.tv_secs = 0;
-                tv.tv_micro = 100000;
-                WaitSelect(0, NULL, NULL, NULL, &tv, NULL);
+                settle_wait(100);
                 /* Check for spurious signal */
                 pending = SetSignal(0, 0); /* Read without clearing */
                 evmask = 0;
@@ -322,10 +372,21 @@ void run_signals_tests(void)
             tap_skip("could not allocate signal");
         }
     }
+}
 
-    CHECK_CTRLC();
+/* 82. eventmask_fd_accept */
+static void test_eventmask_fd_accept(void)
+{
+    BYTE sigbit;
+    ULONG sigmask;
+    ULONG evmask;
+    LONG evfd;
+    LONG listener, client, server;
+    LONG mask;
+    struct timeval tv;
+    int port;
+    const char *cr;
 
-    /* 82. eventmask_fd_accept */
     cr = known_crash(82);
     if (cr) {
         tap_ok(0, "SO_EVENTMASK FD_ACCEPT: signal on incoming [AmiTCP]");
@@ -376,10 +437,21 @@ void run_signals_tests(void)
             tap_skip("could not allocate signal");
         }
     }
+}
 
-    CHECK_CTRLC();
+/* 83. eventmask_fd_close */
+static void test_eventmask_fd_close(void)
+{
+    BYTE sigbit;
+    ULONG sigmask;
+    ULONG evmask;
+    LONG evfd;
+    LONG listener, client, server;
+    LONG mask;
+    struct timeval tv;
+    int port;
+    const char *cr;
 
-    /* 83. eventmask_fd_close */
     cr = known_crash(83);
     if (cr) {
         tap_ok(0, "SO_EVENTMASK FD_CLOSE: signal on peer disconnect [AmiTCP]");
@@ -426,12 +498,24 @@ void run_signals_tests(void)
             tap_skip("could not allocate signal");
         }
     }
+}
 
-    CHECK_CTRLC();
+/* ---- GetSocketEvents behavior ---- */
 
-    /* ---- GetSocketEvents behavior ---- */
+/* 84. getsocketevents_clears */
+static void test_getsocketevents_clears(void)
+{
+    BYTE sigbit;
+    ULONG sigmask;
+    ULONG evmask1, evmask2;
+    LONG evfd1, evfd2;
+    LONG listener, client, server;
+    LONG mask;
+    struct timeval tv;
+    unsigned char sbuf[100];
+    int port;
+    const char *cr;
 
-    /* 84. getsocketevents_clears */
     cr = known_crash(84);
     if (cr) {
         tap_ok(0, "GetSocketEvents(): event consumed after retrieval [AmiTCP]");
@@ -480,10 +564,23 @@ void run_signals_tests(void)
             tap_skip("could not allocate signal");
         }
     }
+}
 
-    CHECK_CTRLC();
+/* 85. getsocketevents_multiple */
+static void test_getsocketevents_multiple(void)
+{
+    BYTE sigbit;
+    ULONG sigmask;
+    ULONG evmask, evmask1, evmask2;
+    LONG evfd, evfd1, evfd2;
+    LONG listener, client, server;
+    LONG listener2, client2, server2;
+    LONG mask;
+    struct timeval tv;
+    unsigned char sbuf[100];
+    int port, passed;
+    const char *cr;
 
-    /* 85. getsocketevents_multiple */
     cr = known_crash(85);
     if (cr) {
         tap_ok(0, "GetSocketEvents(): round-robin across sockets [AmiTCP]");
@@ -520,9 +617,7 @@ void run_signals_tests(void)
                 tv.tv_micro = 0;
                 WaitSelect(0, NULL, NULL, NULL, &tv, &sigmask);
                 /* Brief delay for second event to propagate */
-                tv.tv_secs = 0;
-                tv.tv_micro = 100000;
-                WaitSelect(0, NULL, NULL, NULL, &tv, NULL);
+                settle_wait(100);
 
                 evmask1 = 0;
                 evfd1 = GetSocketEvents(&evmask1);
@@ -569,21 +664,37 @@ void run_signals_tests(void)
             tap_skip("could not allocate signal");
         }
     }
+}
 
-    CHECK_CTRLC();
+/* 86. getsocketevents_empty */
+static void test_getsocketevents_empty(void)
+{
+    ULONG evmask;
+    LONG evfd;
 
-    /* 86. getsocketevents_empty */
     evmask = 0;
     evfd = GetSocketEvents(&evmask);
     tap_ok(evfd == -1,
            "GetSocketEvents(): -1 when no events pending [AmiTCP]");
     tap_diagf("  returned: %ld", (long)evfd);
+}
 
-    CHECK_CTRLC();
+/* ---- Stress test ---- */
 
-    /* ---- Stress test ---- */
+/* 87. rapid_waitselect_signal */
+static void test_rapid_waitselect_signal(void)
+{
+    BYTE sigbit;
+    ULONG sigmask;
+    ULONG evmask;
+    LONG evfd;
+    LONG listener, client, server;
+    LONG mask;
+    struct timeval tv;
+    unsigned char sbuf[100], rbuf[100];
+    int port, rc, i, passed;
+    const char *cr;
 
-    /* 87. rapid_waitselect_signal */
     cr = known_crash(87);
     if (cr) {
         tap_ok(0, "WaitSelect + signals: stress test (50 iterations) [AmiTCP]");
@@ -661,3 +772,39 @@ void run_signals_tests(void)
         }
     }
 }
+
+/* ---- Registry ---- */
+
+const struct test_entry signals_tests[] = {
+    { 73, "setsocketsignals_basic", TIER_LOOPBACK, -1, -1,
+      test_setsocketsignals_basic },
+    { 74, "sbt_breakmask", TIER_LOOPBACK, -1, -1,
+      test_sbt_breakmask },
+    { 75, "sbt_sigeventmask", TIER_LOOPBACK, -1, -1,
+      test_sbt_sigeventmask },
+    { 76, "sbt_errnolongptr_get", TIER_LOOPBACK, -1, -1,
+      test_sbt_errnolongptr_get },
+    { 77, "sbt_herrnolongptr_get", TIER_LOOPBACK, -1, -1,
+      test_sbt_herrnolongptr_get },
+    { 78, "sbt_dtablesize", TIER_LOOPBACK, -1, -1,
+      test_sbt_dtablesize },
+    { 79, "eventmask_fd_read", TIER_LOOPBACK, 80, 80,
+      test_eventmask_fd_read },
+    { 80, "eventmask_fd_connect", TIER_LOOPBACK, 81, 81,
+      test_eventmask_fd_connect },
+    { 81, "eventmask_no_spurious", TIER_LOOPBACK, -1, -1,
+      test_eventmask_no_spurious },
+    { 82, "eventmask_fd_accept", TIER_LOOPBACK, 82, 82,
+      test_eventmask_fd_accept },
+    { 83, "eventmask_fd_close", TIER_LOOPBACK, 83, 83,
+      test_eventmask_fd_close },
+    { 84, "getsocketevents_clears", TIER_LOOPBACK, 84, 84,
+      test_getsocketevents_clears },
+    { 85, "getsocketevents_multiple", TIER_LOOPBACK, 85, 86,
+      test_getsocketevents_multiple },
+    { 86, "getsocketevents_empty", TIER_LOOPBACK, -1, -1,
+      test_getsocketevents_empty },
+    { 87, "rapid_waitselect_signal", TIER_LOOPBACK, 87, 87,
+      test_rapid_waitselect_signal },
+    { 0, NULL, 0, 0, 0, NULL }
+};
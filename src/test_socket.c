@@ -9,6 +9,8 @@
 
 #include "tap.h"
 #include "testutil.h"
+#include "tests.h"
+#include "profile.h"
 
 #include <proto/bsdsocket.h>
 
@@ -17,33 +19,33 @@
 #include <errno.h>
 #include <string.h>
 
-void run_socket_tests(void)
-{
-    LONG fd, fd2, listener, client, server;
-    struct sockaddr_in addr;
-    socklen_t addrlen;
-    LONG one = 1;
-    int port;
-    int rc;
-    unsigned char buf[16];
+/* ---- socket() creation ---- */
 
-    /* ---- socket() creation ---- */
+/* 1. socket_create_tcp */
+static void test_socket_create_tcp(void)
+{
+    LONG fd;
 
-    /* 1. socket_create_tcp */
     fd = socket(AF_INET, SOCK_STREAM, 0);
     tap_ok(fd >= 0, "socket(): create SOCK_STREAM (TCP) [BSD 4.4]");
     safe_close(fd);
+}
 
-    CHECK_CTRLC();
+/* 2. socket_create_udp */
+static void test_socket_create_udp(void)
+{
+    LONG fd;
 
-    /* 2. socket_create_udp */
     fd = socket(AF_INET, SOCK_DGRAM, 0);
     tap_ok(fd >= 0, "socket(): create SOCK_DGRAM (UDP) [BSD 4.4]");
     safe_close(fd);
+}
 
-    CHECK_CTRLC();
+/* 3. socket_create_raw */
+static void test_socket_create_raw(void)
+{
+    LONG fd;
 
-    /* 3. socket_create_raw */
     fd = socket(AF_INET, SOCK_RAW, IPPROTO_ICMP);
     if (fd >= 0) {
         tap_ok(1, "socket(): create SOCK_RAW (ICMP) [BSD 4.4]");
@@ -53,30 +55,42 @@ void run_socket_tests(void)
     } else {
         tap_ok(fd >= 0, "socket(): create SOCK_RAW (ICMP) [BSD 4.4]");
     }
+}
 
-    CHECK_CTRLC();
+/* 4. socket_invalid_domain */
+static void test_socket_invalid_domain(void)
+{
+    LONG fd;
 
-    /* 4. socket_invalid_domain */
     fd = socket(-1, SOCK_STREAM, 0);
     tap_ok(fd == -1 && get_bsd_errno() != 0,
            "socket(): reject invalid domain (errno) [BSD 4.4]");
     if (fd >= 0)
         safe_close(fd);
+}
 
-    CHECK_CTRLC();
+/* 5. socket_invalid_type */
+static void test_socket_invalid_type(void)
+{
+    LONG fd;
 
-    /* 5. socket_invalid_type */
     fd = socket(AF_INET, 999, 0);
     tap_ok(fd == -1 && get_bsd_errno() != 0,
            "socket(): reject invalid type (errno) [BSD 4.4]");
     if (fd >= 0)
         safe_close(fd);
+}
 
-    CHECK_CTRLC();
+/* ---- bind() ---- */
 
-    /* ---- bind() ---- */
+/* 6. bind_any_port_zero */
+static void test_bind_any_port_zero(void)
+{
+    LONG fd;
+    struct sockaddr_in addr;
+    socklen_t addrlen;
+    int rc;
 
-    /* 6. bind_any_port_zero */
     fd = make_tcp_socket();
     if (fd >= 0) {
         memset(&addr, 0, sizeof(addr));
@@ -94,10 +108,18 @@ void run_socket_tests(void)
         tap_ok(0, "bind(): INADDR_ANY port 0 auto-assigns ephemeral port [BSD 4.4]");
     }
     safe_close(fd);
+}
 
-    CHECK_CTRLC();
+/* 7. bind_specific_port */
+static void test_bind_specific_port(void)
+{
+    LONG fd;
+    struct sockaddr_in addr;
+    socklen_t addrlen;
+    LONG one = 1;
+    int port;
+    int rc;
 
-    /* 7. bind_specific_port */
     port = get_test_port(0);
     fd = make_tcp_socket();
     if (fd >= 0) {
@@ -117,10 +139,16 @@ void run_socket_tests(void)
         tap_ok(0, "bind(): specific port assignment [BSD 4.4]");
     }
     safe_close(fd);
+}
 
-    CHECK_CTRLC();
+/* 8. bind_eaddrinuse */
+static void test_bind_eaddrinuse(void)
+{
+    LONG fd, fd2;
+    struct sockaddr_in addr;
+    int port;
+    int rc;
 
-    /* 8. bind_eaddrinuse */
     port = get_test_port(1);
     fd = make_tcp_socket();
     fd2 = make_tcp_socket();
@@ -139,12 +167,19 @@ void run_socket_tests(void)
     }
     safe_close(fd);
     safe_close(fd2);
+}
 
-    CHECK_CTRLC();
+/* ---- listen() ---- */
 
-    /* ---- listen() ---- */
+/* 9. listen_bound */
+static void test_listen_bound(void)
+{
+    LONG fd;
+    struct sockaddr_in addr;
+    LONG one = 1;
+    int port;
+    int rc;
 
-    /* 9. listen_bound */
     port = get_test_port(2);
     fd = make_tcp_socket();
     if (fd >= 0) {
@@ -161,10 +196,14 @@ void run_socket_tests(void)
         tap_ok(0, "listen(): on bound socket [BSD 4.4]");
     }
     safe_close(fd);
+}
 
-    CHECK_CTRLC();
+/* 10. listen_unbound */
+static void test_listen_unbound(void)
+{
+    LONG fd;
+    int rc;
 
-    /* 10. listen_unbound */
     fd = make_tcp_socket();
     if (fd >= 0) {
         rc = listen(fd, 5);
@@ -179,12 +218,16 @@ void run_socket_tests(void)
         tap_ok(0, "listen(): on unbound socket (auto-bind behavior) [BSD 4.4]");
     }
     safe_close(fd);
+}
 
-    CHECK_CTRLC();
+/* ---- connect() ---- */
 
-    /* ---- connect() ---- */
+/* 11. connect_loopback */
+static void test_connect_loopback(void)
+{
+    LONG listener, client, server;
+    int port;
 
-    /* 11. connect_loopback */
     port = get_test_port(3);
     listener = make_loopback_listener(port);
     client = make_loopback_client(port);
@@ -194,10 +237,16 @@ void run_socket_tests(void)
     safe_close(server);
     safe_close(client);
     safe_close(listener);
+}
 
-    CHECK_CTRLC();
+/* 12. connect_refused */
+static void test_connect_refused(void)
+{
+    LONG fd;
+    struct sockaddr_in addr;
+    int port;
+    int rc;
 
-    /* 12. connect_refused */
     port = get_test_port(4);
     fd = make_tcp_socket();
     if (fd >= 0) {
@@ -212,12 +261,16 @@ void run_socket_tests(void)
         tap_ok(0, "connect(): ECONNREFUSED to closed port [BSD 4.4]");
     }
     safe_close(fd);
+}
 
-    CHECK_CTRLC();
+/* ---- accept() ---- */
 
-    /* ---- accept() ---- */
+/* 13. accept_basic */
+static void test_accept_basic(void)
+{
+    LONG listener, client, server;
+    int port;
 
-    /* 13. accept_basic */
     port = get_test_port(5);
     listener = make_loopback_listener(port);
     client = make_loopback_client(port);
@@ -227,10 +280,16 @@ void run_socket_tests(void)
     safe_close(server);
     safe_close(client);
     safe_close(listener);
+}
 
-    CHECK_CTRLC();
+/* 14. accept_addr */
+static void test_accept_addr(void)
+{
+    LONG listener, client, server;
+    struct sockaddr_in addr;
+    socklen_t addrlen;
+    int port;
 
-    /* 14. accept_addr */
     port = get_test_port(6);
     listener = make_loopback_listener(port);
     client = make_loopback_client(port);
@@ -249,10 +308,14 @@ void run_socket_tests(void)
     }
     safe_close(client);
     safe_close(listener);
+}
 
-    CHECK_CTRLC();
+/* 15. accept_nonblocking_ewouldblock */
+static void test_accept_nonblocking_ewouldblock(void)
+{
+    LONG listener, server;
+    int port;
 
-    /* 15. accept_nonblocking_ewouldblock */
     port = get_test_port(7);
     listener = make_loopback_listener(port);
     if (listener >= 0) {
@@ -265,12 +328,17 @@ void run_socket_tests(void)
         tap_ok(0, "accept(): EWOULDBLOCK when non-blocking, no pending [BSD 4.4]");
     }
     safe_close(listener);
+}
 
-    CHECK_CTRLC();
+/* ---- shutdown() ---- */
 
-    /* ---- shutdown() ---- */
+/* 16. shutdown_rd */
+static void test_shutdown_rd(void)
+{
+    LONG listener, client, server;
+    int port;
+    int rc;
 
-    /* 16. shutdown_rd */
     port = get_test_port(8);
     listener = make_loopback_listener(port);
     client = make_loopback_client(port);
@@ -284,10 +352,16 @@ void run_socket_tests(void)
     safe_close(server);
     safe_close(client);
     safe_close(listener);
+}
 
-    CHECK_CTRLC();
+/* 17. shutdown_wr */
+static void test_shutdown_wr(void)
+{
+    LONG listener, client, server;
+    int port;
+    int rc;
+    unsigned char buf[16];
 
-    /* 17. shutdown_wr */
     port = get_test_port(9);
     listener = make_loopback_listener(port);
     client = make_loopback_client(port);
@@ -309,10 +383,15 @@ void run_socket_tests(void)
     safe_close(server);
     safe_close(client);
     safe_close(listener);
+}
 
-    CHECK_CTRLC();
+/* 18. shutdown_rdwr */
+static void test_shutdown_rdwr(void)
+{
+    LONG listener, client, server;
+    int port;
+    int rc;
 
-    /* 18. shutdown_rdwr */
     port = get_test_port(10);
     listener = make_loopback_listener(port);
     client = make_loopback_client(port);
@@ -326,28 +405,41 @@ void run_socket_tests(void)
     safe_close(server);
     safe_close(client);
     safe_close(listener);
+}
 
-    CHECK_CTRLC();
+/* ---- CloseSocket() ---- */
 
-    /* ---- CloseSocket() ---- */
+/* 19. closesocket_valid */
+static void test_closesocket_valid(void)
+{
+    LONG fd;
 
-    /* 19. closesocket_valid */
     fd = make_tcp_socket();
     tap_ok(fd >= 0 && CloseSocket(fd) == 0,
            "CloseSocket(): valid descriptor [AmiTCP]");
+}
 
-    CHECK_CTRLC();
+/* 20. closesocket_invalid */
+static void test_closesocket_invalid(void)
+{
+    int rc;
 
-    /* 20. closesocket_invalid */
     rc = CloseSocket(-1);
     tap_ok(rc != 0,
            "CloseSocket(): invalid descriptor returns error [AmiTCP]");
+}
 
-    CHECK_CTRLC();
+/* ---- getsockname() ---- */
 
-    /* ---- getsockname() ---- */
+/* 21. getsockname_after_bind */
+static void test_getsockname_after_bind(void)
+{
+    LONG fd;
+    struct sockaddr_in addr;
+    socklen_t addrlen;
+    LONG one = 1;
+    int port;
 
-    /* 21. getsockname_after_bind */
     port = get_test_port(11);
     fd = make_tcp_socket();
     if (fd >= 0) {
@@ -370,12 +462,19 @@ void run_socket_tests(void)
         tap_ok(0, "getsockname(): returns bound address [BSD 4.4]");
     }
     safe_close(fd);
+}
 
-    CHECK_CTRLC();
+/* ---- getpeername() ---- */
 
-    /* ---- getpeername() ---- */
+/* 22. getpeername_connected */
+static void test_getpeername_connected(void)
+{
+    LONG listener, client, server;
+    struct sockaddr_in addr;
+    socklen_t addrlen;
+    int port;
+    int rc;
 
-    /* 22. getpeername_connected */
     port = get_test_port(12);
     listener = make_loopback_listener(port);
     client = make_loopback_client(port);
@@ -394,10 +493,16 @@ void run_socket_tests(void)
     safe_close(server);
     safe_close(client);
     safe_close(listener);
+}
 
-    CHECK_CTRLC();
+/* 23. getpeername_unconnected */
+static void test_getpeername_unconnected(void)
+{
+    LONG fd;
+    struct sockaddr_in addr;
+    socklen_t addrlen;
+    int rc;
 
-    /* 23. getpeername_unconnected */
     fd = make_tcp_socket();
     if (fd >= 0) {
         addrlen = sizeof(addr);
@@ -409,3 +514,55 @@ void run_socket_tests(void)
     }
     safe_close(fd);
 }
+
+/* ---- Registry ---- */
+
+const struct test_entry socket_tests[] = {
+    { 1, "socket_create_tcp", TIER_LOOPBACK, -1, -1,
+      test_socket_create_tcp },
+    { 2, "socket_create_udp", TIER_LOOPBACK, -1, -1,
+      test_socket_create_udp },
+    { 3, "socket_create_raw", TIER_LOOPBACK, -1, -1,
+      test_socket_create_raw },
+    { 4, "socket_invalid_domain", TIER_LOOPBACK, -1, -1,
+      test_socket_invalid_domain },
+    { 5, "socket_invalid_type", TIER_LOOPBACK, -1, -1,
+      test_socket_invalid_type },
+    { 6, "bind_any_port_zero", TIER_LOOPBACK, -1, -1,
+      test_bind_any_port_zero },
+    { 7, "bind_specific_port", TIER_LOOPBACK, 0, 0,
+      test_bind_specific_port },
+    { 8, "bind_eaddrinuse", TIER_LOOPBACK, 1, 1,
+      test_bind_eaddrinuse },
+    { 9, "listen_bound", TIER_LOOPBACK, 2, 2,
+      test_listen_bound },
+    { 10, "listen_unbound", TIER_LOOPBACK, -1, -1,
+      test_listen_unbound },
+    { 11, "connect_loopback", TIER_LOOPBACK, 3, 3,
+      test_connect_loopback },
+    { 12, "connect_refused", TIER_LOOPBACK, 4, 4,
+      test_connect_refused },
+    { 13, "accept_basic", TIER_LOOPBACK, 5, 5,
+      test_accept_basic },
+    { 14, "accept_addr", TIER_LOOPBACK, 6, 6,
+      test_accept_addr },
+    { 15, "accept_nonblocking_ewouldblock", TIER_LOOPBACK, 7, 7,
+      test_accept_nonblocking_ewouldblock },
+    { 16, "shutdown_rd", TIER_LOOPBACK, 8, 8,
+      test_shutdown_rd },
+    { 17, "shutdown_wr", TIER_LOOPBACK, 9, 9,
+      test_shutdown_wr },
+    { 18, "shutdown_rdwr", TIER_LOOPBACK, 10, 10,
+      test_shutdown_rdwr },
+    { 19, "closesocket_valid", TIER_LOOPBACK, -1, -1,
+      test_closesocket_valid },
+    { 20, "closesocket_invalid", TIER_LOOPBACK, -1, -1,
+      test_closesocket_invalid },
+    { 21, "getsockname_after_bind", TIER_LOOPBACK, 11, 11,
+      test_getsockname_after_bind },
+    { 22, "getpeername_connected", TIER_LOOPBACK, 12, 12,
+      test_getpeername_connected },
+    { 23, "getpeername_unconnected", TIER_LOOPBACK, -1, -1,
+      test_getpeername_unconnected },
+    { 0, NULL, 0, 0, 0, NULL }
+};
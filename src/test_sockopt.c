@@ -10,6 +10,8 @@
 
 #include "tap.h"
 #include "testutil.h"
+#include "tests.h"
+#include "profile.h"
 
 #include <proto/bsdsocket.h>
 
@@ -20,19 +22,16 @@
 #include <errno.h>
 #include <string.h>
 
-void run_sockopt_tests(void)
+/* ---- SO_TYPE ---- */
+
+/* 43. getsockopt_so_type */
+static void test_getsockopt_so_type(void)
 {
-    LONG fd, fd_tcp, fd_udp, listener, client, server;
-    LONG optval, one = 1;
+    LONG fd_tcp, fd_udp;
+    LONG optval;
     socklen_t optlen;
-    struct linger ling;
-    struct timeval tv;
-    struct sockaddr_in addr;
-    int port, rc;
+    int rc;
 
-    /* ---- SO_TYPE ---- */
-
-    /* 43. getsockopt_so_type */
     fd_tcp = make_tcp_socket();
     fd_udp = make_udp_socket();
     if (fd_tcp >= 0 && fd_udp >= 0) {
@@ -48,12 +47,17 @@ void run_sockopt_tests(void)
     }
     safe_close(fd_tcp);
     safe_close(fd_udp);
+}
 
-    CHECK_CTRLC();
+/* ---- SO_REUSEADDR ---- */
 
-    /* ---- SO_REUSEADDR ---- */
+/* 44. so_reuseaddr_default */
+static void test_so_reuseaddr_default(void)
+{
+    LONG fd;
+    LONG optval;
+    socklen_t optlen;
 
-    /* 44. so_reuseaddr_default */
     fd = make_tcp_socket();
     if (fd >= 0) {
         optval = -1;
@@ -65,10 +69,16 @@ void run_sockopt_tests(void)
         tap_ok(0, "SO_REUSEADDR: query default value [BSD 4.4]");
     }
     safe_close(fd);
+}
 
-    CHECK_CTRLC();
+/* 45. so_reuseaddr_set */
+static void test_so_reuseaddr_set(void)
+{
+    LONG fd;
+    LONG optval, one = 1;
+    socklen_t optlen;
+    int rc;
 
-    /* 45. so_reuseaddr_set */
     fd = make_tcp_socket();
     if (fd >= 0) {
         one = 1;
@@ -82,10 +92,15 @@ void run_sockopt_tests(void)
         tap_ok(0, "SO_REUSEADDR: enable address reuse [BSD 4.4]");
     }
     safe_close(fd);
+}
 
-    CHECK_CTRLC();
+/* 46. so_reuseaddr_get */
+static void test_so_reuseaddr_get(void)
+{
+    LONG fd;
+    LONG optval;
+    socklen_t optlen;
 
-    /* 46. so_reuseaddr_get */
     fd = make_tcp_socket();
     if (fd >= 0) {
         optval = 0;
@@ -103,12 +118,18 @@ void run_sockopt_tests(void)
         tap_ok(0, "SO_REUSEADDR: clear and read-back behavior [BSD 4.4]");
     }
     safe_close(fd);
+}
 
-    CHECK_CTRLC();
+/* ---- SO_KEEPALIVE ---- */
 
-    /* ---- SO_KEEPALIVE ---- */
+/* 47. so_keepalive */
+static void test_so_keepalive(void)
+{
+    LONG fd;
+    LONG optval, one = 1;
+    socklen_t optlen;
+    int rc;
 
-    /* 47. so_keepalive */
     fd = make_tcp_socket();
     if (fd >= 0) {
         one = 1;
@@ -122,12 +143,18 @@ void run_sockopt_tests(void)
         tap_ok(0, "SO_KEEPALIVE: enable keepalive probes [RFC 1122]");
     }
     safe_close(fd);
+}
 
-    CHECK_CTRLC();
+/* ---- SO_LINGER ---- */
 
-    /* ---- SO_LINGER ---- */
+/* 48. so_linger */
+static void test_so_linger(void)
+{
+    LONG fd;
+    socklen_t optlen;
+    struct linger ling;
+    int rc;
 
-    /* 48. so_linger */
     fd = make_tcp_socket();
     if (fd >= 0) {
         memset(&ling, 0, sizeof(ling));
@@ -143,16 +170,22 @@ void run_sockopt_tests(void)
         tap_ok(0, "SO_LINGER: set and read back linger struct [BSD 4.4]");
     }
     safe_close(fd);
+}
 
-    CHECK_CTRLC();
+/* ---- SO_RCVTIMEO ---- */
 
-    /* ---- SO_RCVTIMEO ---- */
+/* 49. so_rcvtimeo
+ * Set/get roundtrip only. Actual timeout enforcement (blocking recv
+ * returning EWOULDBLOCK after the timeout) cannot be safely tested
+ * because stacks that accept SO_RCVTIMEO but don't enforce it will
+ * hang indefinitely on recv(). Enforcement validated on Roadshow. */
+static void test_so_rcvtimeo(void)
+{
+    LONG fd;
+    socklen_t optlen;
+    struct timeval tv;
+    int rc;
 
-    /* 49. so_rcvtimeo
-     * Set/get roundtrip only. Actual timeout enforcement (blocking recv
-     * returning EWOULDBLOCK after the timeout) cannot be safely tested
-     * because stacks that accept SO_RCVTIMEO but don't enforce it will
-     * hang indefinitely on recv(). Enforcement validated on Roadshow. */
     fd = make_tcp_socket();
     if (fd >= 0) {
         tv.tv_secs = 1;
@@ -171,12 +204,18 @@ void run_sockopt_tests(void)
         tap_ok(0, "SO_RCVTIMEO: set receive timeout [BSD 4.4]");
     }
     safe_close(fd);
+}
 
-    CHECK_CTRLC();
+/* ---- SO_SNDTIMEO ---- */
 
-    /* ---- SO_SNDTIMEO ---- */
+/* 50. so_sndtimeo */
+static void test_so_sndtimeo(void)
+{
+    LONG fd;
+    socklen_t optlen;
+    struct timeval tv;
+    int rc;
 
-    /* 50. so_sndtimeo */
     fd = make_tcp_socket();
     if (fd >= 0) {
         tv.tv_secs = 1;
@@ -195,12 +234,18 @@ void run_sockopt_tests(void)
         tap_ok(0, "SO_SNDTIMEO: set send timeout [BSD 4.4]");
     }
     safe_close(fd);
+}
 
-    CHECK_CTRLC();
+/* ---- TCP_NODELAY ---- */
 
-    /* ---- TCP_NODELAY ---- */
+/* 51. tcp_nodelay */
+static void test_tcp_nodelay(void)
+{
+    LONG fd;
+    LONG optval, one = 1;
+    socklen_t optlen;
+    int rc;
 
-    /* 51. tcp_nodelay */
     fd = make_tcp_socket();
     if (fd >= 0) {
         one = 1;
@@ -214,12 +259,19 @@ void run_sockopt_tests(void)
         tap_ok(0, "TCP_NODELAY: disable Nagle algorithm [RFC 896/1122]");
     }
     safe_close(fd);
+}
 
-    CHECK_CTRLC();
+/* ---- SO_ERROR ---- */
 
-    /* ---- SO_ERROR ---- */
+/* 52. so_error_after_failed_connect */
+static void test_so_error_after_failed_connect(void)
+{
+    LONG fd;
+    LONG optval;
+    socklen_t optlen;
+    struct sockaddr_in addr;
+    int port, rc;
 
-    /* 52. so_error_after_failed_connect */
     port = get_test_port(41);
     fd = make_tcp_socket();
     if (fd >= 0) {
@@ -262,12 +314,18 @@ void run_sockopt_tests(void)
         tap_ok(0, "SO_ERROR: pending error after failed connect [BSD 4.4]");
     }
     safe_close(fd);
+}
 
-    CHECK_CTRLC();
+/* ---- SO_RCVBUF / SO_SNDBUF ---- */
 
-    /* ---- SO_RCVBUF / SO_SNDBUF ---- */
+/* 53. so_rcvbuf */
+static void test_so_rcvbuf(void)
+{
+    LONG fd;
+    LONG optval;
+    socklen_t optlen;
+    int rc;
 
-    /* 53. so_rcvbuf */
     fd = make_tcp_socket();
     if (fd >= 0) {
         optval = 32768;
@@ -282,10 +340,16 @@ void run_sockopt_tests(void)
         tap_ok(0, "SO_RCVBUF: set receive buffer size [BSD 4.4]");
     }
     safe_close(fd);
+}
 
-    CHECK_CTRLC();
+/* 54. so_sndbuf */
+static void test_so_sndbuf(void)
+{
+    LONG fd;
+    LONG optval;
+    socklen_t optlen;
+    int rc;
 
-    /* 54. so_sndbuf */
     fd = make_tcp_socket();
     if (fd >= 0) {
         optval = 32768;
@@ -300,12 +364,18 @@ void run_sockopt_tests(void)
         tap_ok(0, "SO_SNDBUF: set send buffer size [BSD 4.4]");
     }
     safe_close(fd);
+}
 
-    CHECK_CTRLC();
+/* ---- IoctlSocket ---- */
 
-    /* ---- IoctlSocket ---- */
+/* 55. ioctl_fionbio */
+static void test_ioctl_fionbio(void)
+{
+    LONG fd;
+    LONG one = 1;
+    struct sockaddr_in addr;
+    int port, rc;
 
-    /* 55. ioctl_fionbio */
     port = get_test_port(42);
     fd = make_tcp_socket();
     if (fd >= 0) {
@@ -329,10 +399,15 @@ void run_sockopt_tests(void)
         tap_ok(0, "IoctlSocket(FIONBIO): set non-blocking mode [AmiTCP]");
     }
     safe_close(fd);
+}
 
-    CHECK_CTRLC();
+/* 56. ioctl_fionread */
+static void test_ioctl_fionread(void)
+{
+    LONG listener, client, server;
+    LONG optval;
+    int port, rc;
 
-    /* 56. ioctl_fionread */
     port = get_test_port(43);
     listener = make_loopback_listener(port);
     client = make_loopback_client(port);
@@ -365,10 +440,15 @@ void run_sockopt_tests(void)
     safe_close(server);
     safe_close(client);
     safe_close(listener);
+}
 
-    CHECK_CTRLC();
+/* 57. ioctl_fioasync */
+static void test_ioctl_fioasync(void)
+{
+    LONG fd;
+    LONG one = 1;
+    int rc;
 
-    /* 57. ioctl_fioasync */
     fd = make_tcp_socket();
     if (fd >= 0) {
         one = 1;
@@ -383,3 +463,39 @@ void run_sockopt_tests(void)
     }
     safe_close(fd);
 }
+
+/* ---- Registry ---- */
+
+const struct test_entry sockopt_tests[] = {
+    { 43, "getsockopt_so_type", TIER_LOOPBACK, -1, -1,
+      test_getsockopt_so_type },
+    { 44, "so_reuseaddr_default", TIER_LOOPBACK, -1, -1,
+      test_so_reuseaddr_default },
+    { 45, "so_reuseaddr_set", TIER_LOOPBACK, -1, -1,
+      test_so_reuseaddr_set },
+    { 46, "so_reuseaddr_get", TIER_LOOPBACK, -1, -1,
+      test_so_reuseaddr_get },
+    { 47, "so_keepalive", TIER_LOOPBACK, -1, -1,
+      test_so_keepalive },
+    { 48, "so_linger", TIER_LOOPBACK, -1, -1,
+      test_so_linger },
+    { 49, "so_rcvtimeo", TIER_LOOPBACK, -1, -1,
+      test_so_rcvtimeo },
+    { 50, "so_sndtimeo", TIER_LOOPBACK, -1, -1,
+      test_so_sndtimeo },
+    { 51, "tcp_nodelay", TIER_LOOPBACK, -1, -1,
+      test_tcp_nodelay },
+    { 52, "so_error_after_failed_connect", TIER_LOOPBACK, 41, 41,
+      test_so_error_after_failed_connect },
+    { 53, "so_rcvbuf", TIER_LOOPBACK, -1, -1,
+      test_so_rcvbuf },
+    { 54, "so_sndbuf", TIER_LOOPBACK, -1, -1,
+      test_so_sndbuf },
+    { 55, "ioctl_fionbio", TIER_LOOPBACK, 42, 42,
+      test_ioctl_fionbio },
+    { 56, "ioctl_fionread", TIER_LOOPBACK, 43, 43,
+      test_ioctl_fionread },
+    { 57, "ioctl_fioasync", TIER_LOOPBACK, -1, -1,
+      test_ioctl_fioasync },
+    { 0, NULL, 0, 0, 0, NULL }
+};
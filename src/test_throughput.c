@@ -5,12 +5,18 @@
  * Results reported as TAP diagnostics. Tests pass as long as data
  * was transferred; throughput numbers are informational.
  *
- * 6 tests (137-142), port offsets 180-199.
+ * The UDP sink/blaster tests carry a sequence header in every datagram
+ * so loss, reordering and duplication can be told apart.  The timestamp
+ * test splits round-trip time into its two one-way halves.
+ *
+ * 9 tests (137-145), port offsets 180-199.
  */
 
 #include "tap.h"
 #include "testutil.h"
+#include "tests.h"
 #include "helper_proto.h"
+#include "profile.h"
 
 #include <proto/bsdsocket.h>
 
@@ -26,10 +32,90 @@
 #define TP_SEGMENT_SIZE (100L * 1024)
 #define TP_NUM_SEGMENTS 10
 
+#define TP_SEQ_COUNT    500             /* sequenced UDP datagrams */
+#define TP_SEQ_RATE     1000            /* blaster rate, datagrams/s */
+#define TP_TS_COUNT     200             /* timestamp exchanges */
+
 static unsigned char tp_sbuf[TP_BUFSIZE];
 static unsigned char tp_rbuf[TP_BUFSIZE];
+static unsigned char tp_seen[(TP_SEQ_COUNT + 7) / 8];
+
+/* Timestamp exchange samples, microseconds relative to the first reply:
+ * a = Amiga send, b = helper receive, c = helper send, d = Amiga receive */
+static LONG tp_ts_a[TP_TS_COUNT], tp_ts_b[TP_TS_COUNT];
+static LONG tp_ts_c[TP_TS_COUNT], tp_ts_d[TP_TS_COUNT];
+static LONG tp_fwd[TP_TS_COUNT], tp_rev[TP_TS_COUNT], tp_rtt[TP_TS_COUNT];
+
+static void tp_put_be32(unsigned char *p, ULONG v)
+{
+    p[0] = (unsigned char)(v >> 24);
+    p[1] = (unsigned char)(v >> 16);
+    p[2] = (unsigned char)(v >> 8);
+    p[3] = (unsigned char)v;
+}
+
+static ULONG tp_get_be32(const unsigned char *p)
+{
+    return ((ULONG)p[0] << 24) | ((ULONG)p[1] << 16) |
+           ((ULONG)p[2] << 8) | (ULONG)p[3];
+}
+
+/* Signed difference a - b in microseconds; runs are far shorter than
+ * the ~35 minutes a LONG can span. */
+static LONG tp_diff_us(ULONG a_secs, ULONG a_micro, ULONG b_secs, ULONG b_micro)
+{
+    return (LONG)(a_secs - b_secs) * 1000000L +
+           ((LONG)a_micro - (LONG)b_micro);
+}
+
+static void tp_sort(LONG *v, int n)
+{
+    int i, j;
+    LONG x;
+
+    for (i = 1; i < n; i++) {
+        x = v[i];
+        for (j = i; j > 0 && v[j - 1] > x; j--)
+            v[j] = v[j - 1];
+        v[j] = x;
+    }
+}
 
-void run_throughput_tests(void)
+/* KB/s for 'bytes' moved in 'us' microseconds.  Whole milliseconds
+ * are too coarse for a fast stack (a 512KB transfer can take 1ms), so
+ * the time is kept in microseconds as far as a 32-bit product allows. */
+static LONG tp_kbps(ULONG bytes, ULONG us)
+{
+    ULONG kb = bytes / 1024UL;
+    ULONG scale = 1000000UL;
+
+    while (scale > 1 && kb > 0xFFFFFFFFUL / scale) {
+        scale /= 10;
+        us /= 10;
+    }
+    if (us == 0)
+        return 0;
+    return (LONG)(kb * scale / us);
+}
+
+/* Percentile of a sorted array (nearest rank, rounding down). */
+static LONG tp_pct(const LONG *v, int n, int pct)
+{
+    return v[(long)(n - 1) * pct / 100];
+}
+
+/* Run id for sequenced UDP tests: distinguishes this run's datagrams
+ * from late arrivals of a previous one. */
+static ULONG tp_run_id(void)
+{
+    struct bst_timestamp ts;
+
+    timer_now(&ts);
+    return ((ts.ts_secs << 16) ^ ts.ts_micro) & 0x7FFFFFFFUL;
+}
+
+/* 137. tp_tcp_loopback */
+static void test_tp_tcp_loopback(void)
 {
     LONG listener, client, server;
     int port;
@@ -39,11 +125,11 @@ void run_throughput_tests(void)
     fd_set readfds, writefds;
     struct timeval tv;
     struct bst_timestamp ts_before, ts_after;
-    LONG ms, kbps;
+    LONG kbps;
+    ULONG us;
 
     fill_test_pattern(tp_sbuf, TP_BUFSIZE, 0);
 
-    /* ---- 137. tp_tcp_loopback ---- */
     port = get_test_port(180);
     listener = make_loopback_listener(port);
     client = make_loopback_client(port);
@@ -89,199 +175,229 @@ void run_throughput_tests(void)
         }
         timer_now(&ts_after);
 
-        ms = (LONG)timer_elapsed_ms(&ts_before, &ts_after);
-        kbps = (ms > 0) ? (total_recv / 1024L) * 1000L / ms : 0;
+        us = timer_elapsed_us(&ts_before, &ts_after);
+        kbps = tp_kbps((ULONG)total_recv, us);
         tap_ok(total_recv >= TP_TCP_BYTES * 90 / 100,
                "Throughput: TCP loopback send/recv [benchmark]");
-        tap_diagf("  sent=%ld recv=%ld ms=%ld KB/s=%ld",
-                  (long)total_sent, (long)total_recv, (long)ms, (long)kbps);
+        tap_diagf("  sent=%ld recv=%ld ms=%lu.%03lu KB/s=%ld",
+                  (long)total_sent, (long)total_recv, us / 1000,
+                  us % 1000, (long)kbps);
         tap_notef("TCP loopback: %ld KB/s", (long)kbps);
+        tap_metric("throughput", (long)kbps, "KB/s");
     } else {
         tap_ok(0, "Throughput: TCP loopback send/recv [benchmark]");
     }
     safe_close(server);
     safe_close(client);
     safe_close(listener);
+}
 
-    CHECK_CTRLC();
+/* 138. tp_tcp_network */
+static void test_tp_tcp_network(void)
+{
+    LONG total_sent;
+    LONG n, chunk;
+    struct bst_timestamp ts_before, ts_after;
+    LONG kbps;
+    ULONG us;
+    LONG fd;
 
-    /* ---- 138. tp_tcp_network ---- */
-    if (!helper_is_connected()) {
-        tap_skip("host helper not connected");
-    } else {
-        LONG fd;
+    fill_test_pattern(tp_sbuf, TP_BUFSIZE, 0);
 
-        fd = helper_connect_service(HELPER_TCP_SINK);
-        if (fd >= 0) {
-            total_sent = 0;
-            timer_now(&ts_before);
-            while (total_sent < TP_TCP_BYTES) {
-                chunk = TP_TCP_BYTES - total_sent;
-                if (chunk > TP_BUFSIZE) chunk = TP_BUFSIZE;
-                n = send(fd, (UBYTE *)tp_sbuf, chunk, 0);
-                if (n <= 0) break;
-                total_sent += n;
-            }
-            timer_now(&ts_after);
-
-            ms = (LONG)timer_elapsed_ms(&ts_before, &ts_after);
-            kbps = (ms > 0) ? (total_sent / 1024L) * 1000L / ms : 0;
-            tap_ok(total_sent > 0,
-                   "Throughput: TCP via network to host [benchmark]");
-            tap_diagf("  sent=%ld ms=%ld KB/s=%ld",
-                      (long)total_sent, (long)ms, (long)kbps);
-            tap_notef("TCP network: %ld KB/s", (long)kbps);
-            safe_close(fd);
-        } else {
-            tap_ok(0, "Throughput: TCP via network to host [benchmark]");
+    fd = helper_connect_service(HELPER_TCP_SINK);
+    if (fd >= 0) {
+        total_sent = 0;
+        timer_now(&ts_before);
+        while (total_sent < TP_TCP_BYTES) {
+            chunk = TP_TCP_BYTES - total_sent;
+            if (chunk > TP_BUFSIZE) chunk = TP_BUFSIZE;
+            n = send(fd, (UBYTE *)tp_sbuf, chunk, 0);
+            if (n <= 0) break;
+            total_sent += n;
         }
+        timer_now(&ts_after);
+
+        us = timer_elapsed_us(&ts_before, &ts_after);
+        kbps = tp_kbps((ULONG)total_sent, us);
+        tap_ok(total_sent > 0,
+               "Throughput: TCP via network to host [benchmark]");
+        tap_diagf("  sent=%ld ms=%lu.%03lu KB/s=%ld",
+                  (long)total_sent, us / 1000, us % 1000, (long)kbps);
+        tap_notef("TCP network: %ld KB/s", (long)kbps);
+        tap_metric("throughput", (long)kbps, "KB/s");
+        safe_close(fd);
+    } else {
+        tap_ok(0, "Throughput: TCP via network to host [benchmark]");
     }
+}
 
-    CHECK_CTRLC();
-
-    /* ---- 139. tp_udp_loopback ---- */
-    {
-        LONG sock_a, sock_b;
-        struct sockaddr_in addr_a, addr_b;
-        int i, received;
-
-        sock_a = make_udp_socket();
-        sock_b = make_udp_socket();
-        if (sock_a >= 0 && sock_b >= 0) {
-            memset(&addr_a, 0, sizeof(addr_a));
-            addr_a.sin_family = AF_INET;
-            addr_a.sin_port = htons(get_test_port(181));
-            addr_a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
-            bind(sock_a, (struct sockaddr *)&addr_a, sizeof(addr_a));
-
-            memset(&addr_b, 0, sizeof(addr_b));
-            addr_b.sin_family = AF_INET;
-            addr_b.sin_port = htons(get_test_port(182));
-            addr_b.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
-            bind(sock_b, (struct sockaddr *)&addr_b, sizeof(addr_b));
-
-            timer_now(&ts_before);
-            for (i = 0; i < TP_UDP_COUNT; i++) {
-                fill_test_pattern(tp_sbuf, TP_UDP_SIZE, i);
-                sendto(sock_a, (UBYTE *)tp_sbuf, TP_UDP_SIZE, 0,
-                       (struct sockaddr *)&addr_b, sizeof(addr_b));
-            }
+/* 139. tp_udp_loopback */
+static void test_tp_udp_loopback(void)
+{
+    LONG rc, n;
+    struct timeval tv;
+    struct bst_timestamp ts_before, ts_after;
+    LONG kbps;
+    ULONG us;
+    LONG sock_a, sock_b;
+    struct sockaddr_in addr_a, addr_b;
+    ULONG quiet_ms;
+    int i, received;
+
+    sock_a = make_udp_socket();
+    sock_b = make_udp_socket();
+    if (sock_a >= 0 && sock_b >= 0) {
+        memset(&addr_a, 0, sizeof(addr_a));
+        addr_a.sin_family = AF_INET;
+        addr_a.sin_port = htons(get_test_port(181));
+        addr_a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(sock_a, (struct sockaddr *)&addr_a, sizeof(addr_a));
+
+        memset(&addr_b, 0, sizeof(addr_b));
+        addr_b.sin_family = AF_INET;
+        addr_b.sin_port = htons(get_test_port(182));
+        addr_b.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(sock_b, (struct sockaddr *)&addr_b, sizeof(addr_b));
 
-            /* Recv all available (WaitSelect for readability) */
-            set_nonblocking(sock_b);
-            received = 0;
-            {
-                fd_set rdfds;
+        timer_now(&ts_before);
+        for (i = 0; i < TP_UDP_COUNT; i++) {
+            fill_test_pattern(tp_sbuf, TP_UDP_SIZE, i);
+            sendto(sock_a, (UBYTE *)tp_sbuf, TP_UDP_SIZE, 0,
+                   (struct sockaddr *)&addr_b, sizeof(addr_b));
+        }
 
+        /* Recv all available (WaitSelect for readability) until the
+         * socket stays quiet; the quiet period is not timed */
+        set_nonblocking(sock_b);
+        received = 0;
+        ts_after = ts_before;
+        quiet_ms = adaptive_ms(1000);
+        {
+            fd_set rdfds;
+
+            while (1) {
+                FD_ZERO(&rdfds);
+                FD_SET(sock_b, &rdfds);
+                tv.tv_secs = quiet_ms / 1000;
+                tv.tv_micro = (quiet_ms % 1000) * 1000;
+                rc = WaitSelect(sock_b + 1, &rdfds, NULL, NULL,
+                                &tv, NULL);
+                if (rc <= 0) break;
                 while (1) {
-                    FD_ZERO(&rdfds);
-                    FD_SET(sock_b, &rdfds);
-                    tv.tv_secs = 1;
-                    tv.tv_micro = 0;
-                    rc = WaitSelect(sock_b + 1, &rdfds, NULL, NULL,
-                                    &tv, NULL);
-                    if (rc <= 0) break;
-                    while (1) {
-                        n = recv(sock_b, (UBYTE *)tp_rbuf, TP_BUFSIZE, 0);
-                        if (n <= 0) break;
-                        received++;
-                    }
+                    n = recv(sock_b, (UBYTE *)tp_rbuf, TP_BUFSIZE, 0);
+                    if (n <= 0) break;
+                    received++;
                 }
+                timer_now(&ts_after);
             }
-            timer_now(&ts_after);
-
-            ms = (LONG)timer_elapsed_ms(&ts_before, &ts_after);
-            kbps = (ms > 0)
-                 ? ((long)received * TP_UDP_SIZE / 1024L) * 1000L / ms
-                 : 0;
-            tap_ok(received > 0,
-                   "Throughput: UDP loopback [benchmark]");
-            tap_diagf("  sent=%d recv=%d loss=%ld%% ms=%ld KB/s=%ld",
-                      TP_UDP_COUNT, received,
-                      (long)(TP_UDP_COUNT - received) * 100 / TP_UDP_COUNT,
-                      (long)ms, (long)kbps);
-            tap_notef("UDP loopback: %ld KB/s (%d/%d received)",
-                      (long)kbps, received, TP_UDP_COUNT);
-        } else {
-            tap_ok(0, "Throughput: UDP loopback [benchmark]");
         }
-        safe_close(sock_a);
-        safe_close(sock_b);
-    }
-
-    CHECK_CTRLC();
 
-    /* ---- 140. tp_udp_network ---- */
-    if (!helper_is_connected()) {
-        tap_skip("host helper not connected");
+        us = timer_elapsed_us(&ts_before, &ts_after);
+        kbps = tp_kbps((ULONG)received * TP_UDP_SIZE, us);
+        tap_ok(received > 0,
+               "Throughput: UDP loopback [benchmark]");
+        tap_diagf("  sent=%d recv=%d loss=%ld%% ms=%lu.%03lu KB/s=%ld",
+                  TP_UDP_COUNT, received,
+                  (long)(TP_UDP_COUNT - received) * 100 / TP_UDP_COUNT,
+                  us / 1000, us % 1000, (long)kbps);
+        tap_notef("UDP loopback: %ld KB/s (%d/%d received)",
+                  (long)kbps, received, TP_UDP_COUNT);
+        tap_metric("throughput", (long)kbps, "KB/s");
+        tap_metric("received", (long)received, "datagrams");
     } else {
-        LONG fd;
-        struct sockaddr_in echo_addr;
-        int i, received;
-
-        fd = make_udp_socket();
-        if (fd >= 0) {
-            memset(&echo_addr, 0, sizeof(echo_addr));
-            echo_addr.sin_family = AF_INET;
-            echo_addr.sin_port = htons(HELPER_UDP_ECHO);
-            echo_addr.sin_addr.s_addr = helper_addr();
-
-            timer_now(&ts_before);
-            for (i = 0; i < TP_UDP_COUNT; i++) {
-                fill_test_pattern(tp_sbuf, TP_UDP_SIZE, i);
-                sendto(fd, (UBYTE *)tp_sbuf, TP_UDP_SIZE, 0,
-                       (struct sockaddr *)&echo_addr, sizeof(echo_addr));
-            }
+        tap_ok(0, "Throughput: UDP loopback [benchmark]");
+    }
+    safe_close(sock_a);
+    safe_close(sock_b);
+}
 
-            /* Wait briefly then recv echoed replies */
-            received = 0;
-            set_nonblocking(fd);
-            {
-                fd_set rdfds;
+/* 140. tp_udp_network */
+static void test_tp_udp_network(void)
+{
+    LONG rc, n;
+    struct timeval tv;
+    struct bst_timestamp ts_before, ts_after;
+    LONG kbps;
+    ULONG us;
+    LONG fd;
+    struct sockaddr_in echo_addr;
+    int i, received;
+
+    fd = make_udp_socket();
+    if (fd >= 0) {
+        memset(&echo_addr, 0, sizeof(echo_addr));
+        echo_addr.sin_family = AF_INET;
+        echo_addr.sin_port = htons(helper_port(HELPER_UDP_ECHO));
+        echo_addr.sin_addr.s_addr = helper_addr();
 
+        timer_now(&ts_before);
+        for (i = 0; i < TP_UDP_COUNT; i++) {
+            fill_test_pattern(tp_sbuf, TP_UDP_SIZE, i);
+            sendto(fd, (UBYTE *)tp_sbuf, TP_UDP_SIZE, 0,
+                   (struct sockaddr *)&echo_addr, sizeof(echo_addr));
+        }
+
+        /* Wait briefly then recv echoed replies */
+        received = 0;
+        set_nonblocking(fd);
+        {
+            fd_set rdfds;
+
+            while (1) {
+                FD_ZERO(&rdfds);
+                FD_SET(fd, &rdfds);
+                tv.tv_secs = 1;
+                tv.tv_micro = 0;
+                rc = WaitSelect(fd + 1, &rdfds, NULL, NULL, &tv, NULL);
+                if (rc <= 0) break;
                 while (1) {
-                    FD_ZERO(&rdfds);
-                    FD_SET(fd, &rdfds);
-                    tv.tv_secs = 1;
-                    tv.tv_micro = 0;
-                    rc = WaitSelect(fd + 1, &rdfds, NULL, NULL, &tv, NULL);
-                    if (rc <= 0) break;
-                    while (1) {
-                        n = recv(fd, (UBYTE *)tp_rbuf, TP_BUFSIZE, 0);
-                        if (n <= 0) break;
-                        received++;
-                    }
+                    n = recv(fd, (UBYTE *)tp_rbuf, TP_BUFSIZE, 0);
+                    if (n <= 0) break;
+                    received++;
                 }
             }
-            timer_now(&ts_after);
-
-            ms = (LONG)timer_elapsed_ms(&ts_before, &ts_after);
-            kbps = (ms > 0)
-                 ? ((long)received * TP_UDP_SIZE / 1024L) * 1000L / ms
-                 : 0;
-            tap_ok(received > 0,
-                   "Throughput: UDP via network to host [benchmark]");
-            tap_diagf("  sent=%d echoed=%d loss=%ld%% ms=%ld KB/s=%ld",
-                      TP_UDP_COUNT, received,
-                      (long)(TP_UDP_COUNT - received) * 100 / TP_UDP_COUNT,
-                      (long)ms, (long)kbps);
-            tap_notef("UDP network: %ld KB/s (%d/%d echoed)",
-                      (long)kbps, received, TP_UDP_COUNT);
-            safe_close(fd);
-        } else {
-            tap_ok(0, "Throughput: UDP via network to host [benchmark]");
         }
+        timer_now(&ts_after);
+
+        us = timer_elapsed_us(&ts_before, &ts_after);
+        kbps = tp_kbps((ULONG)received * TP_UDP_SIZE, us);
+        tap_ok(received > 0,
+               "Throughput: UDP via network to host [benchmark]");
+        tap_diagf("  sent=%d echoed=%d loss=%ld%% ms=%lu.%03lu KB/s=%ld",
+                  TP_UDP_COUNT, received,
+                  (long)(TP_UDP_COUNT - received) * 100 / TP_UDP_COUNT,
+                  us / 1000, us % 1000, (long)kbps);
+        tap_notef("UDP network: %ld KB/s (%d/%d echoed)",
+                  (long)kbps, received, TP_UDP_COUNT);
+        tap_metric("throughput", (long)kbps, "KB/s");
+        tap_metric("echoed", (long)received, "datagrams");
+        safe_close(fd);
+    } else {
+        tap_ok(0, "Throughput: UDP via network to host [benchmark]");
     }
+}
+
+/* 141. tp_tcp_sustained_loopback */
+static void test_tp_tcp_sustained_loopback(void)
+{
+    LONG listener, client, server;
+    int port;
+    LONG total_sent, total_recv;
+    int send_done;
+    LONG maxfd, rc, n, chunk;
+    fd_set readfds, writefds;
+    struct timeval tv;
+    LONG kbps;
+    ULONG us;
 
-    CHECK_CTRLC();
+    fill_test_pattern(tp_sbuf, TP_BUFSIZE, 0);
 
-    /* ---- 141. tp_tcp_sustained_loopback ---- */
     port = get_test_port(183);
     listener = make_loopback_listener(port);
     client = make_loopback_client(port);
     server = accept_one(listener);
     if (client >= 0 && server >= 0) {
-        LONG seg_ms[TP_NUM_SEGMENTS];
+        ULONG seg_us[TP_NUM_SEGMENTS];
         int cur_seg;
         struct bst_timestamp seg_start, seg_now, total_before, total_after;
         LONG seg_kbps;
@@ -321,7 +437,7 @@ void run_throughput_tests(void)
                     while (total_sent >= (cur_seg + 1) * TP_SEGMENT_SIZE &&
                            cur_seg < TP_NUM_SEGMENTS) {
                         timer_now(&seg_now);
-                        seg_ms[cur_seg] = (LONG)timer_elapsed_ms(
+                        seg_us[cur_seg] = timer_elapsed_us(
                             &seg_start, &seg_now);
                         seg_start = seg_now;
                         cur_seg++;
@@ -340,33 +456,36 @@ void run_throughput_tests(void)
         }
         timer_now(&total_after);
 
-        ms = (LONG)timer_elapsed_ms(&total_before, &total_after);
-        kbps = (ms > 0) ? (total_recv / 1024L) * 1000L / ms : 0;
+        us = timer_elapsed_us(&total_before, &total_after);
+        kbps = tp_kbps((ULONG)total_recv, us);
         tap_ok(total_recv >= TP_SUSTAINED,
                "Throughput: TCP sustained 1MB+ loopback [benchmark]");
-        tap_diagf("  sent=%ld recv=%ld total_ms=%ld overall_KB/s=%ld",
-                  (long)total_sent, (long)total_recv, (long)ms, (long)kbps);
+        tap_diagf("  sent=%ld recv=%ld total_ms=%lu.%03lu "
+                  "overall_KB/s=%ld", (long)total_sent, (long)total_recv,
+                  us / 1000, us % 1000, (long)kbps);
         tap_notef("TCP sustained loopback: %ld KB/s", (long)kbps);
+        tap_metric("throughput", (long)kbps, "KB/s");
 
         /* Per-segment diagnostics */
         if (cur_seg > 0) {
-            LONG seg_min, seg_max;
+            ULONG seg_min, seg_max;
             int si;
 
-            seg_min = seg_ms[0];
-            seg_max = seg_ms[0];
+            seg_min = seg_us[0];
+            seg_max = seg_us[0];
             for (si = 1; si < cur_seg; si++) {
-                if (seg_ms[si] < seg_min) seg_min = seg_ms[si];
-                if (seg_ms[si] > seg_max) seg_max = seg_ms[si];
+                if (seg_us[si] < seg_min) seg_min = seg_us[si];
+                if (seg_us[si] > seg_max) seg_max = seg_us[si];
             }
-            tap_diagf("  segments=%d seg_min=%ldms seg_max=%ldms",
-                      cur_seg, (long)seg_min, (long)seg_max);
+            tap_diagf("  segments=%d seg_min=%lu.%03lums "
+                      "seg_max=%lu.%03lums", cur_seg,
+                      seg_min / 1000, seg_min % 1000,
+                      seg_max / 1000, seg_max % 1000);
             for (si = 0; si < cur_seg; si++) {
-                seg_kbps = (seg_ms[si] > 0)
-                         ? (TP_SEGMENT_SIZE / 1024L) * 1000L / seg_ms[si]
-                         : 0;
-                tap_diagf("    seg[%d]: %ldms %ldKB/s",
-                          si, (long)seg_ms[si], (long)seg_kbps);
+                seg_kbps = tp_kbps(TP_SEGMENT_SIZE, seg_us[si]);
+                tap_diagf("    seg[%d]: %lu.%03lums %ldKB/s", si,
+                          seg_us[si] / 1000, seg_us[si] % 1000,
+                          (long)seg_kbps);
             }
         }
     } else {
@@ -375,78 +494,436 @@ void run_throughput_tests(void)
     safe_close(server);
     safe_close(client);
     safe_close(listener);
+}
+
+/* 142. tp_tcp_sustained_network */
+static void test_tp_tcp_sustained_network(void)
+{
+    LONG total_sent;
+    LONG n, chunk;
+    LONG kbps;
+    ULONG us;
+    LONG fd;
+    ULONG seg_us[TP_NUM_SEGMENTS];
+    int cur_seg;
+    struct bst_timestamp seg_start, seg_now, total_before, total_after;
+    LONG seg_kbps;
+
+    fill_test_pattern(tp_sbuf, TP_BUFSIZE, 0);
+
+    fd = helper_connect_service(HELPER_TCP_SINK);
+    if (fd >= 0) {
+        total_sent = 0;
+        cur_seg = 0;
+
+        timer_now(&total_before);
+        timer_now(&seg_start);
+
+        while (total_sent < TP_SUSTAINED) {
+            chunk = TP_SUSTAINED - total_sent;
+            if (chunk > TP_BUFSIZE) chunk = TP_BUFSIZE;
+            n = send(fd, (UBYTE *)tp_sbuf, chunk, 0);
+            if (n <= 0) break;
+            total_sent += n;
+
+            /* Checkpoint at segment boundaries */
+            while (total_sent >= (cur_seg + 1) * TP_SEGMENT_SIZE &&
+                   cur_seg < TP_NUM_SEGMENTS) {
+                timer_now(&seg_now);
+                seg_us[cur_seg] = timer_elapsed_us(
+                    &seg_start, &seg_now);
+                seg_start = seg_now;
+                cur_seg++;
+            }
+        }
+        timer_now(&total_after);
 
-    CHECK_CTRLC();
+        us = timer_elapsed_us(&total_before, &total_after);
+        kbps = tp_kbps((ULONG)total_sent, us);
+        tap_ok(total_sent >= TP_SUSTAINED,
+               "Throughput: TCP sustained 1MB+ via network [benchmark]");
+        tap_diagf("  sent=%ld total_ms=%lu.%03lu overall_KB/s=%ld",
+                  (long)total_sent, us / 1000, us % 1000, (long)kbps);
+        tap_notef("TCP sustained network: %ld KB/s", (long)kbps);
+        tap_metric("throughput", (long)kbps, "KB/s");
 
-    /* ---- 142. tp_tcp_sustained_network ---- */
-    if (!helper_is_connected()) {
-        tap_skip("host helper not connected");
+        /* Per-segment diagnostics */
+        if (cur_seg > 0) {
+            ULONG seg_min, seg_max;
+            int si;
+
+            seg_min = seg_us[0];
+            seg_max = seg_us[0];
+            for (si = 1; si < cur_seg; si++) {
+                if (seg_us[si] < seg_min) seg_min = seg_us[si];
+                if (seg_us[si] > seg_max) seg_max = seg_us[si];
+            }
+            tap_diagf("  segments=%d seg_min=%lu.%03lums "
+                      "seg_max=%lu.%03lums", cur_seg,
+                      seg_min / 1000, seg_min % 1000,
+                      seg_max / 1000, seg_max % 1000);
+            for (si = 0; si < cur_seg; si++) {
+                seg_kbps = tp_kbps(TP_SEGMENT_SIZE, seg_us[si]);
+                tap_diagf("    seg[%d]: %lu.%03lums %ldKB/s", si,
+                          seg_us[si] / 1000, seg_us[si] % 1000,
+                          (long)seg_kbps);
+            }
+        }
+        safe_close(fd);
     } else {
-        LONG fd;
-        LONG seg_ms[TP_NUM_SEGMENTS];
-        int cur_seg;
-        struct bst_timestamp seg_start, seg_now, total_before, total_after;
-        LONG seg_kbps;
+        tap_ok(0, "Throughput: TCP sustained 1MB+ via network [benchmark]");
+    }
+}
 
-        fd = helper_connect_service(HELPER_TCP_SINK);
-        if (fd >= 0) {
-            total_sent = 0;
-            cur_seg = 0;
+/* 143. tp_udp_sink_network */
+static void test_tp_udp_sink_network(void)
+{
+    struct timeval tv;
+    struct bst_timestamp ts_before, ts_after;
+    LONG ms, kbps;
+    LONG fd;
+    struct sockaddr_in sink_addr;
+    struct helper_udp_stats st;
+    ULONG run_id;
+    int i, sent;
+
+    fd = make_udp_socket();
+    if (fd >= 0) {
+        memset(&sink_addr, 0, sizeof(sink_addr));
+        sink_addr.sin_family = AF_INET;
+        sink_addr.sin_port = htons(helper_port(HELPER_UDP_SINK));
+        sink_addr.sin_addr.s_addr = helper_addr();
+
+        run_id = tp_run_id();
+        sent = 0;
+        timer_now(&ts_before);
+        for (i = 0; i < TP_SEQ_COUNT; i++) {
+            fill_test_pattern(tp_sbuf, TP_UDP_SIZE, i);
+            tp_put_be32(tp_sbuf, (ULONG)i);
+            tp_put_be32(tp_sbuf + 4, run_id);
+            if (sendto(fd, (UBYTE *)tp_sbuf, TP_UDP_SIZE, 0,
+                       (struct sockaddr *)&sink_addr,
+                       sizeof(sink_addr)) == TP_UDP_SIZE)
+                sent++;
+        }
+        timer_now(&ts_after);
 
-            timer_now(&total_before);
-            timer_now(&seg_start);
+        /* Let the last datagrams reach the sink before asking */
+        tv.tv_secs = 0;
+        tv.tv_micro = 500000;
+        WaitSelect(0, NULL, NULL, NULL, &tv, NULL);
 
-            while (total_sent < TP_SUSTAINED) {
-                chunk = TP_SUSTAINED - total_sent;
-                if (chunk > TP_BUFSIZE) chunk = TP_BUFSIZE;
-                n = send(fd, (UBYTE *)tp_sbuf, chunk, 0);
+        ms = (LONG)timer_elapsed_ms(&ts_before, &ts_after);
+        if (helper_udp_stats(run_id, (unsigned long)sent, &st)) {
+            kbps = (st.elapsed_ms > 0)
+                 ? (LONG)((st.bytes / 1024UL) * 1000UL / st.elapsed_ms)
+                 : 0;
+            tap_ok(st.received > 0,
+                   "Throughput: UDP to helper sink [benchmark]");
+            tap_diagf("  sent=%d send_ms=%ld received=%lu lost=%lu "
+                      "reordered=%lu dup=%lu sink_ms=%lu KB/s=%ld",
+                      sent, (long)ms, st.received, st.lost,
+                      st.reordered, st.duplicates, st.elapsed_ms,
+                      (long)kbps);
+            for (i = 0; i < st.intervals; i++)
+                tap_diagf("    interval[%d]: rx=%lu lost=%lu "
+                          "reorder=%lu dup=%lu", i,
+                          st.interval[i].received, st.interval[i].lost,
+                          st.interval[i].reordered,
+                          st.interval[i].duplicates);
+            tap_notef("UDP sink: %ld KB/s (%lu/%d received, "
+                      "%lu lost, %lu reordered)",
+                      (long)kbps, st.received, sent, st.lost,
+                      st.reordered);
+            tap_metric("throughput", (long)kbps, "KB/s");
+            tap_metric("lost", (long)st.lost, "datagrams");
+            tap_metric("reordered", (long)st.reordered, "datagrams");
+        } else {
+            tap_ok(0, "Throughput: UDP to helper sink [benchmark]");
+            tap_diag("  helper did not report sink statistics");
+        }
+        safe_close(fd);
+    } else {
+        tap_ok(0, "Throughput: UDP to helper sink [benchmark]");
+    }
+}
+
+/* 144. tp_udp_blast_network */
+static void test_tp_udp_blast_network(void)
+{
+    int port;
+    LONG rc, n;
+    fd_set readfds;
+    struct timeval tv;
+    struct bst_timestamp ts_before, ts_after;
+    LONG kbps;
+    ULONG us;
+    LONG fd;
+    struct sockaddr_in local;
+    ULONG run_id, seq, highest;
+    unsigned long helper_sent, helper_ms;
+    int received, reordered, dups, foreign, any;
+    LONG lost;
+
+    fd = make_udp_socket();
+    port = get_test_port(184);
+    if (fd >= 0) {
+        memset(&local, 0, sizeof(local));
+        local.sin_family = AF_INET;
+        local.sin_port = htons(port);
+        local.sin_addr.s_addr = htonl(INADDR_ANY);
+        if (bind(fd, (struct sockaddr *)&local, sizeof(local)) < 0) {
+            tap_diagf("  bind port %d: errno=%ld", port, (long)Errno());
+            safe_close(fd);
+            fd = -1;
+        }
+    }
+
+    run_id = tp_run_id();
+    if (fd >= 0 &&
+        helper_udp_blast(port, TP_SEQ_COUNT, TP_UDP_SIZE,
+                         TP_SEQ_RATE, run_id)) {
+        memset(tp_seen, 0, sizeof(tp_seen));
+        received = reordered = dups = foreign = any = 0;
+        highest = 0;
+        set_nonblocking(fd);
+
+        /* Drain until the stream has been quiet for a second */
+        timer_now(&ts_before);
+        ts_after = ts_before;
+        while (1) {
+            FD_ZERO(&readfds);
+            FD_SET(fd, &readfds);
+            tv.tv_secs = any ? 1 : 3;
+            tv.tv_micro = 0;
+            rc = WaitSelect(fd + 1, &readfds, NULL, NULL, &tv, NULL);
+            if (rc <= 0) break;
+            while (1) {
+                n = recv(fd, (UBYTE *)tp_rbuf, TP_BUFSIZE, 0);
                 if (n <= 0) break;
-                total_sent += n;
-
-                /* Checkpoint at segment boundaries */
-                while (total_sent >= (cur_seg + 1) * TP_SEGMENT_SIZE &&
-                       cur_seg < TP_NUM_SEGMENTS) {
-                    timer_now(&seg_now);
-                    seg_ms[cur_seg] = (LONG)timer_elapsed_ms(
-                        &seg_start, &seg_now);
-                    seg_start = seg_now;
-                    cur_seg++;
+                if (n < HELPER_SEQ_HDR_SIZE ||
+                    tp_get_be32(tp_rbuf + 4) != run_id) {
+                    foreign++;
+                    continue;
+                }
+                seq = tp_get_be32(tp_rbuf);
+                if (seq >= TP_SEQ_COUNT) {
+                    foreign++;
+                    continue;
                 }
+                if (!any) {
+                    timer_now(&ts_before);
+                    any = 1;
+                }
+                timer_now(&ts_after);
+                if (tp_seen[seq >> 3] & (1 << (seq & 7))) {
+                    dups++;
+                    continue;
+                }
+                tp_seen[seq >> 3] |= (unsigned char)(1 << (seq & 7));
+                if (received > 0 && seq < highest)
+                    reordered++;
+                else
+                    highest = seq;
+                received++;
             }
-            timer_now(&total_after);
-
-            ms = (LONG)timer_elapsed_ms(&total_before, &total_after);
-            kbps = (ms > 0) ? (total_sent / 1024L) * 1000L / ms : 0;
-            tap_ok(total_sent >= TP_SUSTAINED,
-                   "Throughput: TCP sustained 1MB+ via network [benchmark]");
-            tap_diagf("  sent=%ld total_ms=%ld overall_KB/s=%ld",
-                      (long)total_sent, (long)ms, (long)kbps);
-            tap_notef("TCP sustained network: %ld KB/s", (long)kbps);
-
-            /* Per-segment diagnostics */
-            if (cur_seg > 0) {
-                LONG seg_min, seg_max;
-                int si;
-
-                seg_min = seg_ms[0];
-                seg_max = seg_ms[0];
-                for (si = 1; si < cur_seg; si++) {
-                    if (seg_ms[si] < seg_min) seg_min = seg_ms[si];
-                    if (seg_ms[si] > seg_max) seg_max = seg_ms[si];
+        }
+
+        lost = received > 0 ? (LONG)highest + 1 - received : 0;
+        if (!helper_udp_blast_done(&helper_sent, &helper_ms)) {
+            helper_sent = TP_SEQ_COUNT;
+            helper_ms = 0;
+        }
+
+        us = timer_elapsed_us(&ts_before, &ts_after);
+        kbps = tp_kbps((ULONG)received * TP_UDP_SIZE, us);
+        tap_ok(received > 0,
+               "Throughput: UDP from helper blaster [benchmark]");
+        tap_diagf("  helper_sent=%lu helper_ms=%lu received=%d "
+                  "lost=%ld tail_lost=%ld reordered=%d dup=%d foreign=%d",
+                  helper_sent, helper_ms, received, (long)lost,
+                  (long)helper_sent - (received > 0 ? (long)highest + 1 : 0),
+                  reordered, dups, foreign);
+        tap_diagf("  rx_ms=%lu.%03lu KB/s=%ld",
+                  us / 1000, us % 1000, (long)kbps);
+        tap_notef("UDP blaster: %ld KB/s (%d/%lu received, "
+                  "%ld lost, %d reordered)",
+                  (long)kbps, received, helper_sent, (long)lost,
+                  reordered);
+        tap_metric("throughput", (long)kbps, "KB/s");
+        tap_metric("lost", (long)lost, "datagrams");
+        tap_metric("reordered", (long)reordered, "datagrams");
+    } else {
+        tap_ok(0, "Throughput: UDP from helper blaster [benchmark]");
+        if (fd >= 0)
+            tap_diag("  helper did not accept BLAST");
+    }
+    safe_close(fd);
+}
+
+/* 145. tp_udp_oneway_network */
+static void test_tp_udp_oneway_network(void)
+{
+    LONG rc, n;
+    fd_set readfds;
+    struct timeval tv;
+    LONG fd;
+    struct sockaddr_in ts_addr;
+    struct bst_timestamp t1, t4, base_a;
+    ULONG run_id, base_b_secs, base_b_micro;
+    LONG theta, best_rtt;
+    int i, samples, timeouts, best;
+
+    fd = make_udp_socket();
+    if (fd >= 0) {
+        memset(&ts_addr, 0, sizeof(ts_addr));
+        ts_addr.sin_family = AF_INET;
+        ts_addr.sin_port = htons(helper_port(HELPER_UDP_TIME));
+        ts_addr.sin_addr.s_addr = helper_addr();
+
+        run_id = tp_run_id();
+        samples = timeouts = 0;
+        base_b_secs = base_b_micro = 0;
+        memset(&base_a, 0, sizeof(base_a));
+
+        /* One exchange in flight at a time, so no request queues
+         * behind another */
+        for (i = 0; i < TP_TS_COUNT; i++) {
+            memset(tp_sbuf, 0, HELPER_TS_REQ_SIZE);
+            tp_put_be32(tp_sbuf, (ULONG)i);
+            tp_put_be32(tp_sbuf + 4, run_id);
+            timer_now(&t1);
+            if (sendto(fd, (UBYTE *)tp_sbuf, HELPER_TS_REQ_SIZE, 0,
+                       (struct sockaddr *)&ts_addr,
+                       sizeof(ts_addr)) != HELPER_TS_REQ_SIZE)
+                break;
+
+            /* Wait for this exchange's reply; drop stale ones */
+            while (1) {
+                FD_ZERO(&readfds);
+                FD_SET(fd, &readfds);
+                tv.tv_secs = 0;
+                tv.tv_micro = 500000;
+                rc = WaitSelect(fd + 1, &readfds, NULL, NULL, &tv, NULL);
+                if (rc <= 0) {
+                    timeouts++;
+                    break;
                 }
-                tap_diagf("  segments=%d seg_min=%ldms seg_max=%ldms",
-                          cur_seg, (long)seg_min, (long)seg_max);
-                for (si = 0; si < cur_seg; si++) {
-                    seg_kbps = (seg_ms[si] > 0)
-                             ? (TP_SEGMENT_SIZE / 1024L) * 1000L / seg_ms[si]
-                             : 0;
-                    tap_diagf("    seg[%d]: %ldms %ldKB/s",
-                              si, (long)seg_ms[si], (long)seg_kbps);
+                n = recv(fd, (UBYTE *)tp_rbuf, TP_BUFSIZE, 0);
+                timer_now(&t4);
+                if (n < HELPER_TS_REPLY_SIZE ||
+                    tp_get_be32(tp_rbuf) != (ULONG)i ||
+                    tp_get_be32(tp_rbuf + 4) != run_id)
+                    continue;
+
+                /* First reply fixes the origin of both clocks */
+                if (samples == 0) {
+                    base_a = t1;
+                    base_b_secs = tp_get_be32(tp_rbuf + 16);
+                    base_b_micro = tp_get_be32(tp_rbuf + 20);
                 }
+                tp_ts_a[samples] = tp_diff_us(t1.ts_secs, t1.ts_micro,
+                                              base_a.ts_secs,
+                                              base_a.ts_micro);
+                tp_ts_b[samples] = tp_diff_us(
+                    tp_get_be32(tp_rbuf + 16), tp_get_be32(tp_rbuf + 20),
+                    base_b_secs, base_b_micro);
+                tp_ts_c[samples] = tp_diff_us(
+                    tp_get_be32(tp_rbuf + 24), tp_get_be32(tp_rbuf + 28),
+                    base_b_secs, base_b_micro);
+                tp_ts_d[samples] = tp_diff_us(t4.ts_secs, t4.ts_micro,
+                                              base_a.ts_secs,
+                                              base_a.ts_micro);
+                samples++;
+                break;
             }
-            safe_close(fd);
-        } else {
-            tap_ok(0, "Throughput: TCP sustained 1MB+ via network [benchmark]");
+            CHECK_CTRLC();
+        }
+
+        if (samples > 0) {
+            /* NTP-style estimate: the exchange with the lowest
+             * round trip is assumed symmetric and fixes the clock
+             * offset; every other exchange is split using it. */
+            best = 0;
+            best_rtt = 0;
+            for (i = 0; i < samples; i++) {
+                tp_rtt[i] = (tp_ts_d[i] - tp_ts_a[i]) -
+                            (tp_ts_c[i] - tp_ts_b[i]);
+                if (i == 0 || tp_rtt[i] < best_rtt) {
+                    best = i;
+                    best_rtt = tp_rtt[i];
+                }
+            }
+            theta = ((tp_ts_b[best] - tp_ts_a[best]) +
+                     (tp_ts_c[best] - tp_ts_d[best])) / 2;
+            for (i = 0; i < samples; i++) {
+                tp_fwd[i] = tp_ts_b[i] - tp_ts_a[i] - theta;
+                tp_rev[i] = tp_ts_d[i] - tp_ts_c[i] + theta;
+            }
+            tp_sort(tp_fwd, samples);
+            tp_sort(tp_rev, samples);
+            tp_sort(tp_rtt, samples);
+        }
+
+        tap_ok(samples > 0,
+               "Latency: UDP one-way delay via timestamp service [benchmark]");
+        tap_diagf("  exchanges=%d replies=%d timeouts=%d",
+                  TP_TS_COUNT, samples, timeouts);
+        if (samples > 0) {
+            tap_diagf("  rtt_us:     min=%ld p50=%ld p90=%ld p99=%ld max=%ld",
+                      (long)tp_rtt[0], (long)tp_pct(tp_rtt, samples, 50),
+                      (long)tp_pct(tp_rtt, samples, 90),
+                      (long)tp_pct(tp_rtt, samples, 99),
+                      (long)tp_rtt[samples - 1]);
+            tap_diagf("  to_host_us: min=%ld p50=%ld p90=%ld p99=%ld max=%ld",
+                      (long)tp_fwd[0], (long)tp_pct(tp_fwd, samples, 50),
+                      (long)tp_pct(tp_fwd, samples, 90),
+                      (long)tp_pct(tp_fwd, samples, 99),
+                      (long)tp_fwd[samples - 1]);
+            tap_diagf("  to_amiga_us: min=%ld p50=%ld p90=%ld p99=%ld max=%ld",
+                      (long)tp_rev[0], (long)tp_pct(tp_rev, samples, 50),
+                      (long)tp_pct(tp_rev, samples, 90),
+                      (long)tp_pct(tp_rev, samples, 99),
+                      (long)tp_rev[samples - 1]);
+            tap_diagf("  offset_us=%ld (relative to first exchange)",
+                      (long)theta);
+            tap_notef("UDP one-way p50: to host %ld us, to Amiga %ld us "
+                      "(rtt %ld us)",
+                      (long)tp_pct(tp_fwd, samples, 50),
+                      (long)tp_pct(tp_rev, samples, 50),
+                      (long)tp_pct(tp_rtt, samples, 50));
+            tap_metric("to_host_p50", (long)tp_pct(tp_fwd, samples, 50),
+                       "us");
+            tap_metric("to_amiga_p50", (long)tp_pct(tp_rev, samples, 50),
+                       "us");
+            tap_metric("rtt_p50", (long)tp_pct(tp_rtt, samples, 50), "us");
         }
+        safe_close(fd);
+    } else {
+        tap_ok(0, "Latency: UDP one-way delay via timestamp service [benchmark]");
     }
 }
+
+/* ---- Registry ---- */
+
+const struct test_entry throughput_tests[] = {
+    { 137, "tp_tcp_loopback", TIER_LOOPBACK, 180, 180,
+      test_tp_tcp_loopback },
+    { 138, "tp_tcp_network", TIER_NETWORK, -1, -1,
+      test_tp_tcp_network },
+    { 139, "tp_udp_loopback", TIER_LOOPBACK, 181, 182,
+      test_tp_udp_loopback },
+    { 140, "tp_udp_network", TIER_NETWORK, -1, -1,
+      test_tp_udp_network },
+    { 141, "tp_tcp_sustained_loopback", TIER_LOOPBACK, 183, 183,
+      test_tp_tcp_sustained_loopback },
+    { 142, "tp_tcp_sustained_network", TIER_NETWORK, -1, -1,
+      test_tp_tcp_sustained_network },
+    { 143, "tp_udp_sink_network", TIER_NETWORK, -1, -1,
+      test_tp_udp_sink_network },
+    { 144, "tp_udp_blast_network", TIER_NETWORK, 184, 184,
+      test_tp_udp_blast_network },
+    { 145, "tp_udp_oneway_network", TIER_NETWORK, -1, -1,
+      test_tp_udp_oneway_network },
+    { 0, NULL, 0, 0, 0, NULL }
+};
@@ -8,24 +8,21 @@
 
 #include "tap.h"
 #include "testutil.h"
+#include "tests.h"
+#include "profile.h"
 
 #include <proto/bsdsocket.h>
 
 #include <netinet/in.h>
 #include <string.h>
 
-void run_transfer_tests(void)
-{
-    LONG listener, client, server;
-    LONG fd1, fd2, target;
-    LONG dup_fd, obtained;
-    LONG unique_id, released_id, copy_id;
-    unsigned char sbuf[100], rbuf[100];
-    int port, rc, mismatch;
+/* ---- Dup2Socket ---- */
 
-    /* ---- Dup2Socket ---- */
+/* 115. dup2socket_dup */
+static void test_dup2socket_dup(void)
+{
+    LONG fd1, fd2;
 
-    /* 115. dup2socket_dup */
     fd1 = make_tcp_socket();
     if (fd1 >= 0) {
         fd2 = Dup2Socket(fd1, -1);
@@ -37,10 +34,13 @@ void run_transfer_tests(void)
         tap_ok(0, "Dup2Socket(fd, -1): duplicate to new descriptor [AmiTCP]");
     }
     safe_close(fd1);
+}
 
-    CHECK_CTRLC();
+/* 116. dup2socket_specific */
+static void test_dup2socket_specific(void)
+{
+    LONG fd1, fd2, target;
 
-    /* 116. dup2socket_specific */
     fd1 = make_tcp_socket();
     if (fd1 >= 0) {
         target = fd1 + 10;
@@ -63,10 +63,16 @@ void run_transfer_tests(void)
         tap_ok(0, "Dup2Socket(fd, target): duplicate to specific slot [AmiTCP]");
     }
     safe_close(fd1);
+}
 
-    CHECK_CTRLC();
+/* 117. dup2socket_send_recv */
+static void test_dup2socket_send_recv(void)
+{
+    LONG listener, client, server;
+    LONG dup_fd;
+    unsigned char sbuf[100], rbuf[100];
+    int port, rc, mismatch;
 
-    /* 117. dup2socket_send_recv */
     port = get_test_port(120);
     listener = make_loopback_listener(port);
     client = make_loopback_client(port);
@@ -93,12 +99,19 @@ void run_transfer_tests(void)
     safe_close(server);
     safe_close(client);
     safe_close(listener);
+}
 
-    CHECK_CTRLC();
+/* ---- ObtainSocket / ReleaseSocket ---- */
 
-    /* ---- ObtainSocket / ReleaseSocket ---- */
+/* 118. release_obtain_roundtrip */
+static void test_release_obtain_roundtrip(void)
+{
+    LONG listener, client, server;
+    LONG obtained;
+    LONG unique_id, released_id;
+    unsigned char sbuf[100], rbuf[100];
+    int port, rc, mismatch;
 
-    /* 118. release_obtain_roundtrip */
     port = get_test_port(121);
     listener = make_loopback_listener(port);
     client = make_loopback_client(port);
@@ -135,10 +148,16 @@ void run_transfer_tests(void)
     safe_close(server);
     safe_close(client);
     safe_close(listener);
+}
 
-    CHECK_CTRLC();
+/* 119. releasecopy_original_usable */
+static void test_releasecopy_original_usable(void)
+{
+    LONG listener, client, server;
+    LONG copy_id;
+    unsigned char sbuf[100], rbuf[100];
+    int port, rc, mismatch;
 
-    /* 119. releasecopy_original_usable */
     port = get_test_port(122);
     listener = make_loopback_listener(port);
     client = make_loopback_client(port);
@@ -167,3 +186,19 @@ void run_transfer_tests(void)
     safe_close(client);
     safe_close(listener);
 }
+
+/* ---- Registry ---- */
+
+const struct test_entry transfer_tests[] = {
+    { 115, "dup2socket_dup", TIER_LOOPBACK, -1, -1,
+      test_dup2socket_dup },
+    { 116, "dup2socket_specific", TIER_LOOPBACK, -1, -1,
+      test_dup2socket_specific },
+    { 117, "dup2socket_send_recv", TIER_LOOPBACK, 120, 120,
+      test_dup2socket_send_recv },
+    { 118, "release_obtain_roundtrip", TIER_LOOPBACK, 121, 121,
+      test_release_obtain_roundtrip },
+    { 119, "releasecopy_original_usable", TIER_LOOPBACK, 122, 122,
+      test_releasecopy_original_usable },
+    { 0, NULL, 0, 0, 0, NULL }
+};
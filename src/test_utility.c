@@ -9,89 +9,114 @@
 
 #include "tap.h"
 #include "testutil.h"
+#include "tests.h"
+#include "profile.h"
 
 #include <proto/bsdsocket.h>
 #include <netinet/in.h>
 
 #include <string.h>
 
-void run_utility_tests(void)
+/* ---- Inet_NtoA ---- */
+
+/* 105. inet_ntoa_loopback */
+static void test_inet_ntoa_loopback(void)
 {
     const char *result;
-    in_addr_t addr_val, net, host, rebuilt;
-
-    /* ---- Inet_NtoA ---- */
 
-    /* 105. inet_ntoa_loopback */
     result = (const char *)Inet_NtoA(htonl(0x7f000001));
     tap_ok(result && strcmp(result, "127.0.0.1") == 0,
            "Inet_NtoA(): 127.0.0.1 formatting [AmiTCP]");
     if (result)
         tap_diagf("  returned: \"%s\"", result);
+}
 
-    CHECK_CTRLC();
+/* 106. inet_ntoa_broadcast */
+static void test_inet_ntoa_broadcast(void)
+{
+    const char *result;
 
-    /* 106. inet_ntoa_broadcast */
     result = (const char *)Inet_NtoA(htonl(0xffffffff));
     tap_ok(result && strcmp(result, "255.255.255.255") == 0,
            "Inet_NtoA(): 255.255.255.255 formatting [AmiTCP]");
     if (result)
         tap_diagf("  returned: \"%s\"", result);
+}
 
-    CHECK_CTRLC();
+/* 107. inet_ntoa_zero */
+static void test_inet_ntoa_zero(void)
+{
+    const char *result;
 
-    /* 107. inet_ntoa_zero */
     result = (const char *)Inet_NtoA(0);
     tap_ok(result && strcmp(result, "0.0.0.0") == 0,
            "Inet_NtoA(): 0.0.0.0 formatting [AmiTCP]");
     if (result)
         tap_diagf("  returned: \"%s\"", result);
+}
 
-    CHECK_CTRLC();
+/* ---- inet_addr ---- */
 
-    /* ---- inet_addr ---- */
+/* 108. inet_addr_valid */
+static void test_inet_addr_valid(void)
+{
+    in_addr_t addr_val;
 
-    /* 108. inet_addr_valid */
     addr_val = inet_addr((STRPTR)"127.0.0.1");
     tap_ok(addr_val == htonl(0x7f000001),
            "inet_addr(): parse \"127.0.0.1\" [BSD 4.4]");
+}
 
-    CHECK_CTRLC();
+/* 109. inet_addr_invalid */
+static void test_inet_addr_invalid(void)
+{
+    in_addr_t addr_val;
 
-    /* 109. inet_addr_invalid */
     addr_val = inet_addr((STRPTR)"not.an.ip");
     tap_ok(addr_val == INADDR_NONE,
            "inet_addr(): invalid string returns INADDR_NONE [BSD 4.4]");
+}
 
-    CHECK_CTRLC();
+/* 110. inet_addr_broadcast */
+static void test_inet_addr_broadcast(void)
+{
+    in_addr_t addr_val;
 
-    /* 110. inet_addr_broadcast */
     addr_val = inet_addr((STRPTR)"255.255.255.255");
     tap_ok(addr_val == 0xffffffff,
            "inet_addr(): \"255.255.255.255\" [BSD 4.4]");
     tap_diag("  note: INADDR_NONE ambiguity with broadcast address");
+}
 
-    CHECK_CTRLC();
+/* ---- Inet_LnaOf / Inet_NetOf / Inet_MakeAddr ---- */
 
-    /* ---- Inet_LnaOf / Inet_NetOf / Inet_MakeAddr ---- */
+/* 111. inet_lnaof — Class A (10.x.x.x), host part is 0x010203 */
+static void test_inet_lnaof(void)
+{
+    in_addr_t host;
 
-    /* 111. inet_lnaof — Class A (10.x.x.x), host part is 0x010203 */
     host = Inet_LnaOf(htonl(0x0a010203));
     tap_ok(host == 0x010203,
            "Inet_LnaOf(): extract host part [AmiTCP]");
     tap_diagf("  host part: 0x%06lx (expected 0x010203)", (unsigned long)host);
+}
 
-    CHECK_CTRLC();
+/* 112. inet_netof — Class A (10.x.x.x), network part is 0x0a */
+static void test_inet_netof(void)
+{
+    in_addr_t net;
 
-    /* 112. inet_netof — Class A (10.x.x.x), network part is 0x0a */
     net = Inet_NetOf(htonl(0x0a010203));
     tap_ok(net == 0x0a,
            "Inet_NetOf(): extract network part [AmiTCP]");
     tap_diagf("  net part: 0x%02lx (expected 0x0a)", (unsigned long)net);
+}
 
-    CHECK_CTRLC();
+/* 113. inet_makeaddr_roundtrip */
+static void test_inet_makeaddr_roundtrip(void)
+{
+    in_addr_t net, host, rebuilt;
 
-    /* 113. inet_makeaddr_roundtrip */
     net = Inet_NetOf(htonl(0x0a010203));
     host = Inet_LnaOf(htonl(0x0a010203));
     rebuilt = Inet_MakeAddr(net, host);
@@ -99,14 +124,43 @@ void run_utility_tests(void)
            "Inet_MakeAddr(): round-trip with LnaOf/NetOf [AmiTCP]");
     tap_diagf("  rebuilt: 0x%08lx (expected 0x%08lx)",
               (unsigned long)rebuilt, (unsigned long)htonl(0x0a010203));
+}
 
-    CHECK_CTRLC();
+/* ---- inet_network ---- */
 
-    /* ---- inet_network ---- */
+/* 114. inet_network */
+static void test_inet_network(void)
+{
+    in_addr_t addr_val;
 
-    /* 114. inet_network */
     addr_val = inet_network((STRPTR)"10.0.0.0");
     tap_ok(addr_val == 0x0a000000,
            "inet_network(): host byte order conversion [BSD 4.4]");
     tap_diagf("  returned: 0x%08lx (expected 0x0a000000)", (unsigned long)addr_val);
 }
+
+/* ---- Registry ---- */
+
+const struct test_entry utility_tests[] = {
+    { 105, "inet_ntoa_loopback", TIER_LOOPBACK, -1, -1,
+      test_inet_ntoa_loopback },
+    { 106, "inet_ntoa_broadcast", TIER_LOOPBACK, -1, -1,
+      test_inet_ntoa_broadcast },
+    { 107, "inet_ntoa_zero", TIER_LOOPBACK, -1, -1,
+      test_inet_ntoa_zero },
+    { 108, "inet_addr_valid", TIER_LOOPBACK, -1, -1,
+      test_inet_addr_valid },
+    { 109, "inet_addr_invalid", TIER_LOOPBACK, -1, -1,
+      test_inet_addr_invalid },
+    { 110, "inet_addr_broadcast", TIER_LOOPBACK, -1, -1,
+      test_inet_addr_broadcast },
+    { 111, "inet_lnaof", TIER_LOOPBACK, -1, -1,
+      test_inet_lnaof },
+    { 112, "inet_netof", TIER_LOOPBACK, -1, -1,
+      test_inet_netof },
+    { 113, "inet_makeaddr_roundtrip", TIER_LOOPBACK, -1, -1,
+      test_inet_makeaddr_roundtrip },
+    { 114, "inet_network", TIER_LOOPBACK, -1, -1,
+      test_inet_network },
+    { 0, NULL, 0, 0, 0, NULL }
+};
@@ -10,7 +10,9 @@
 
 #include "tap.h"
 #include "testutil.h"
+#include "tests.h"
 #include "known_failures.h"
+#include "profile.h"
 
 #include <proto/bsdsocket.h>
 #include <proto/exec.h>
@@ -18,29 +20,17 @@
 #include <errno.h>
 #include <string.h>
 
-void run_waitselect_tests(void)
+/* ---- Read/write readiness ---- */
+
+/* 58. ws_read_ready */
+static void test_ws_read_ready(void)
 {
     LONG listener, client, server;
-    LONG list3[3], cli3[3], srv3[3];
-    LONG fds[65];
-    LONG closed_fd;
-    fd_set readfds, writefds, exceptfds;
+    fd_set readfds;
     struct timeval tv;
-    struct bst_timestamp ts_before, ts_after;
-    LONG elapsed_ms;
-    LONG dtsize;
-    LONG optval;
-    socklen_t optlen;
-    struct sockaddr_in addr;
-    BYTE sigbit;
-    ULONG sigmask;
-    int port, rc, i, nfds, ready_count;
-    int result_a, result_b;
+    int port, rc;
     unsigned char buf[100];
 
-    /* ---- Read/write readiness ---- */
-
-    /* 58. ws_read_ready */
     port = get_test_port(60);
     listener = make_loopback_listener(port);
     client = make_loopback_client(port);
@@ -61,10 +51,16 @@ void run_waitselect_tests(void)
     safe_close(server);
     safe_close(client);
     safe_close(listener);
+}
 
-    CHECK_CTRLC();
+/* 59. ws_write_ready */
+static void test_ws_write_ready(void)
+{
+    LONG listener, client, server;
+    fd_set writefds;
+    struct timeval tv;
+    int port, rc;
 
-    /* 59. ws_write_ready */
     port = get_test_port(61);
     listener = make_loopback_listener(port);
     client = make_loopback_client(port);
@@ -83,12 +79,20 @@ void run_waitselect_tests(void)
     safe_close(server);
     safe_close(client);
     safe_close(listener);
+}
 
-    CHECK_CTRLC();
+/* ---- Timeout behavior ---- */
 
-    /* ---- Timeout behavior ---- */
+/* 60. ws_timeout_zero */
+static void test_ws_timeout_zero(void)
+{
+    LONG listener, client, server;
+    fd_set readfds;
+    struct timeval tv;
+    struct bst_timestamp ts_before, ts_after;
+    LONG elapsed_ms;
+    int port, rc;
 
-    /* 60. ws_timeout_zero */
     port = get_test_port(62);
     listener = make_loopback_listener(port);
     client = make_loopback_client(port);
@@ -112,10 +116,18 @@ void run_waitselect_tests(void)
     safe_close(server);
     safe_close(client);
     safe_close(listener);
+}
 
-    CHECK_CTRLC();
+/* 61. ws_timeout_expires */
+static void test_ws_timeout_expires(void)
+{
+    LONG listener, client, server;
+    fd_set readfds;
+    struct timeval tv;
+    struct bst_timestamp ts_before, ts_after;
+    LONG elapsed_ms;
+    int port, rc;
 
-    /* 61. ws_timeout_expires */
     port = get_test_port(63);
     listener = make_loopback_listener(port);
     client = make_loopback_client(port);
@@ -145,10 +157,15 @@ void run_waitselect_tests(void)
     safe_close(server);
     safe_close(client);
     safe_close(listener);
+}
 
-    CHECK_CTRLC();
+/* 62. ws_null_timeout */
+static void test_ws_null_timeout(void)
+{
+    LONG listener, client, server;
+    fd_set readfds;
+    int port, rc;
 
-    /* 62. ws_null_timeout */
     port = get_test_port(64);
     listener = make_loopback_listener(port);
     client = make_loopback_client(port);
@@ -169,12 +186,18 @@ void run_waitselect_tests(void)
     }
     safe_close(client);
     safe_close(listener);
+}
 
-    CHECK_CTRLC();
+/* ---- Pure delay ---- */
 
-    /* ---- Pure delay ---- */
+/* 63. ws_null_fdsets */
+static void test_ws_null_fdsets(void)
+{
+    struct timeval tv;
+    struct bst_timestamp ts_before, ts_after;
+    LONG elapsed_ms;
+    int rc;
 
-    /* 63. ws_null_fdsets */
     tv.tv_secs = 0;
     tv.tv_micro = 250000;
     timer_now(&ts_before);
@@ -187,12 +210,19 @@ void run_waitselect_tests(void)
               (long)elapsed_ms,
               (long)(elapsed_ms / 1000),
               (long)(elapsed_ms % 1000));
+}
 
-    CHECK_CTRLC();
+/* ---- Exception fd ---- */
 
-    /* ---- Exception fd ---- */
+/* 64. ws_exceptfds_oob */
+static void test_ws_exceptfds_oob(void)
+{
+    LONG listener, client, server;
+    fd_set exceptfds;
+    struct timeval tv;
+    int port, rc;
+    unsigned char buf[100];
 
-    /* 64. ws_exceptfds_oob */
     port = get_test_port(65);
     listener = make_loopback_listener(port);
     client = make_loopback_client(port);
@@ -223,12 +253,19 @@ void run_waitselect_tests(void)
     safe_close(server);
     safe_close(client);
     safe_close(listener);
+}
 
-    CHECK_CTRLC();
+/* ---- Multiple file descriptors ---- */
 
-    /* ---- Multiple file descriptors ---- */
+/* 65. ws_multiple_fds */
+static void test_ws_multiple_fds(void)
+{
+    LONG list3[3], cli3[3], srv3[3];
+    fd_set readfds;
+    struct timeval tv;
+    int port, rc, i, nfds, ready_count;
+    unsigned char buf[100];
 
-    /* 65. ws_multiple_fds */
     for (i = 0; i < 3; i++) {
         list3[i] = cli3[i] = srv3[i] = -1;
     }
@@ -269,12 +306,19 @@ void run_waitselect_tests(void)
     close_all(srv3, 3);
     close_all(cli3, 3);
     close_all(list3, 3);
+}
 
-    CHECK_CTRLC();
+/* ---- Signal interaction ---- */
 
-    /* ---- Signal interaction ---- */
+/* 66. ws_signal_interrupt */
+static void test_ws_signal_interrupt(void)
+{
+    LONG listener;
+    fd_set readfds;
+    BYTE sigbit;
+    ULONG sigmask;
+    int port, rc;
 
-    /* 66. ws_signal_interrupt */
     sigbit = alloc_signal();
     if (sigbit >= 0) {
         port = get_test_port(69);
@@ -303,10 +347,19 @@ void run_waitselect_tests(void)
     } else {
         tap_skip("could not allocate signal");
     }
+}
 
-    CHECK_CTRLC();
+/* 67. ws_sigmask_passthrough */
+static void test_ws_sigmask_passthrough(void)
+{
+    LONG listener, client, server;
+    fd_set readfds;
+    struct timeval tv;
+    BYTE sigbit;
+    ULONG sigmask;
+    int port, rc;
+    unsigned char buf[100];
 
-    /* 67. ws_sigmask_passthrough */
     sigbit = alloc_signal();
     if (sigbit >= 0) {
         port = get_test_port(70);
@@ -340,12 +393,19 @@ void run_waitselect_tests(void)
     } else {
         tap_skip("could not allocate signal");
     }
+}
 
-    CHECK_CTRLC();
+/* ---- Edge cases ---- */
 
-    /* ---- Edge cases ---- */
+/* 68. ws_invalid_fd */
+static void test_ws_invalid_fd(void)
+{
+    LONG client;
+    LONG closed_fd;
+    fd_set readfds;
+    struct timeval tv;
+    int rc;
 
-    /* 68. ws_invalid_fd */
     client = make_tcp_socket();
     if (client >= 0) {
         closed_fd = client;
@@ -366,10 +426,18 @@ void run_waitselect_tests(void)
     } else {
         tap_ok(0, "WaitSelect(): invalid descriptor handling [AmiTCP]");
     }
+}
 
-    CHECK_CTRLC();
+/* 69. ws_nfds_boundary */
+static void test_ws_nfds_boundary(void)
+{
+    LONG listener, client, server;
+    fd_set readfds;
+    struct timeval tv;
+    int port;
+    int result_a, result_b;
+    unsigned char buf[100];
 
-    /* 69. ws_nfds_boundary */
     port = get_test_port(71);
     listener = make_loopback_listener(port);
     client = make_loopback_client(port);
@@ -392,9 +460,7 @@ void run_waitselect_tests(void)
         fill_test_pattern(buf, 10, 82);
         send(client, (UBYTE *)buf, 10, 0);
         /* Delay so data arrives before the poll */
-        tv.tv_secs = 0;
-        tv.tv_micro = 250000;
-        WaitSelect(0, NULL, NULL, NULL, &tv, NULL);
+        settle_wait(250);
 
         FD_ZERO(&readfds);
         FD_SET(server, &readfds);
@@ -412,10 +478,17 @@ void run_waitselect_tests(void)
     safe_close(server);
     safe_close(client);
     safe_close(listener);
+}
 
-    CHECK_CTRLC();
+/* 70. ws_many_descriptors */
+static void test_ws_many_descriptors(void)
+{
+    LONG fds[65];
+    fd_set readfds;
+    struct timeval tv;
+    LONG dtsize;
+    int rc, i;
 
-    /* 70. ws_many_descriptors */
     {
         const char *cr = known_crash(70);
         if (cr) {
@@ -472,12 +545,21 @@ ws70_done:
     if (dtsize < 66 && dtsize > 0) {
         SocketBaseTags(SBTM_SETVAL(SBTC_DTABLESIZE), dtsize, TAG_DONE);
     }
+}
 
-    CHECK_CTRLC();
+/* ---- Async connect and peer close ---- */
 
-    /* ---- Async connect and peer close ---- */
+/* 71. ws_connect_ready */
+static void test_ws_connect_ready(void)
+{
+    LONG listener, client, server;
+    fd_set writefds;
+    struct timeval tv;
+    LONG optval;
+    socklen_t optlen;
+    struct sockaddr_in addr;
+    int port, rc;
 
-    /* 71. ws_connect_ready */
     port = get_test_port(72);
     listener = make_loopback_listener(port);
     if (listener >= 0) {
@@ -523,10 +605,17 @@ ws70_done:
         tap_ok(0, "WaitSelect(): non-blocking connect completion [AmiTCP]");
     }
     safe_close(listener);
+}
 
-    CHECK_CTRLC();
+/* 72. ws_peer_close */
+static void test_ws_peer_close(void)
+{
+    LONG listener, client, server;
+    fd_set readfds;
+    struct timeval tv;
+    int port, rc;
+    unsigned char buf[100];
 
-    /* 72. ws_peer_close */
     port = get_test_port(73);
     listener = make_loopback_listener(port);
     client = make_loopback_client(port);
@@ -557,3 +646,39 @@ ws70_done:
     safe_close(client);
     safe_close(listener);
 }
+
+/* ---- Registry ---- */
+
+const struct test_entry waitselect_tests[] = {
+    { 58, "ws_read_ready", TIER_LOOPBACK, 60, 60,
+      test_ws_read_ready },
+    { 59, "ws_write_ready", TIER_LOOPBACK, 61, 61,
+      test_ws_write_ready },
+    { 60, "ws_timeout_zero", TIER_LOOPBACK, 62, 62,
+      test_ws_timeout_zero },
+    { 61, "ws_timeout_expires", TIER_LOOPBACK, 63, 63,
+      test_ws_timeout_expires },
+    { 62, "ws_null_timeout", TIER_LOOPBACK, 64, 64,
+      test_ws_null_timeout },
+    { 63, "ws_null_fdsets", TIER_LOOPBACK, -1, -1,
+      test_ws_null_fdsets },
+    { 64, "ws_exceptfds_oob", TIER_LOOPBACK, 65, 65,
+      test_ws_exceptfds_oob },
+    { 65, "ws_multiple_fds", TIER_LOOPBACK, -1, -1,
+      test_ws_multiple_fds },
+    { 66, "ws_signal_interrupt", TIER_LOOPBACK, 69, 69,
+      test_ws_signal_interrupt },
+    { 67, "ws_sigmask_passthrough", TIER_LOOPBACK, 70, 70,
+      test_ws_sigmask_passthrough },
+    { 68, "ws_invalid_fd", TIER_LOOPBACK, -1, -1,
+      test_ws_invalid_fd },
+    { 69, "ws_nfds_boundary", TIER_LOOPBACK, 71, 71,
+      test_ws_nfds_boundary },
+    { 70, "ws_many_descriptors", TIER_LOOPBACK, -1, -1,
+      test_ws_many_descriptors },
+    { 71, "ws_connect_ready", TIER_LOOPBACK, 72, 72,
+      test_ws_connect_ready },
+    { 72, "ws_peer_close", TIER_LOOPBACK, 73, 73,
+      test_ws_peer_close },
+    { 0, NULL, 0, 0, 0, NULL }
+};
@@ -1,24 +1,47 @@
 /*
- * bsdsocktest — Test category function declarations
+ * bsdsocktest — Test registry
  *
- * Each test_*.c file implements one of these. They are called from
- * the category dispatch table in main.c.
+ * Each test_*.c file implements one category as a table of numbered
+ * tests.  The tables are listed in the category dispatch table in
+ * main.c, which runs the selected entries in order.
  */
 
 #ifndef BSDSOCKTEST_TESTS_H
 #define BSDSOCKTEST_TESTS_H
 
-void run_socket_tests(void);
-void run_sendrecv_tests(void);
-void run_sockopt_tests(void);
-void run_waitselect_tests(void);
-void run_signals_tests(void);
-void run_dns_tests(void);
-void run_utility_tests(void);
-void run_transfer_tests(void);
-void run_errno_tests(void);
-void run_misc_tests(void);
-void run_icmp_tests(void);
-void run_throughput_tests(void);
+/* Test tier flags */
+#define TIER_LOOPBACK 0x01
+#define TIER_NETWORK  0x02
+#define TIER_BOTH     (TIER_LOOPBACK | TIER_NETWORK)
+
+/* One numbered test.  Numbers are stable (see docs/TESTS.md) and
+ * ascend through a table; every code path of run() emits exactly one
+ * tap_ok() or tap_skip().  Tables end with an entry whose run is NULL. */
+struct test_entry {
+    int number;
+    const char *name;       /* identifier, e.g. "socket_create_tcp" */
+    int tier;               /* TIER_NETWORK: skipped without host helper */
+    int port_first;         /* get_test_port() offsets used, */
+    int port_last;          /* or -1, -1 for none */
+    void (*run)(void);
+};
+
+extern const struct test_entry socket_tests[];
+extern const struct test_entry sendrecv_tests[];
+extern const struct test_entry sockopt_tests[];
+extern const struct test_entry waitselect_tests[];
+extern const struct test_entry signals_tests[];
+extern const struct test_entry dns_tests[];
+extern const struct test_entry utility_tests[];
+extern const struct test_entry transfer_tests[];
+extern const struct test_entry errno_tests[];
+extern const struct test_entry misc_tests[];
+extern const struct test_entry icmp_tests[];
+extern const struct test_entry throughput_tests[];
+extern const struct test_entry server_tests[];
+extern const struct test_entry replay_tests[];
+
+/* The script the replay tests play back (REPLAY/K); unset, they skip. */
+void replay_set_script(const char *path);
 
 #endif /* BSDSOCKTEST_TESTS_H */
@@ -4,17 +4,21 @@
 
 #include "testutil.h"
 #include "tap.h"
+#include "profile.h"
 
 #include <proto/exec.h>
+#include <exec/memory.h>
 #include <proto/bsdsocket.h>
 
 #include <sys/socket.h>
 #include <sys/filio.h>
 #include <netinet/in.h>
+#include <errno.h>
 
 #include <devices/timer.h>
 #include <proto/timer.h>
 
+#include <stdio.h>
 #include <string.h>
 
 /* ---- Library state ---- */
@@ -101,10 +105,12 @@ void reset_socket_state(void)
 
     /* Close any leftover sockets from previous runs.
      * On a clean library open this is a no-op (all CloseSocket fail). */
+    profile_suspend();
     for (i = 0; i < 64; i++) {
         if (CloseSocket(i) == 0)
             cleaned++;
     }
+    profile_resume();
 
     if (cleaned > 0)
         tap_diagf("  reset: closed %d leftover socket(s)", cleaned);
@@ -203,6 +209,16 @@ int set_recv_timeout(LONG fd, int seconds)
     return setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
 }
 
+int set_recv_timeout_ms(LONG fd, ULONG ms)
+{
+    struct timeval tv;
+
+    tv.tv_secs = ms / 1000;
+    tv.tv_micro = (ms % 1000) * 1000;
+
+    return setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+}
+
 void safe_close(LONG fd)
 {
     if (fd >= 0)
@@ -223,14 +239,134 @@ void close_all(LONG *fds, int count)
 
 /* ---- Port allocation ---- */
 
+/* Ports a test has been given, so that every get_test_port() call
+ * with the same offset during the test returns the same port */
+#define MAX_TEST_PORTS 16
+
+/* A port found in use is replaced by the next spare, counted from
+ * base + PORT_SPARE_FIRST, past every registry offset */
+#define PORT_SPARE_FIRST 500
+#define PORT_SPARE_COUNT 400
+#define PORT_PROBES      8
+
+static struct {
+    int offset;
+    int port;
+} test_ports[MAX_TEST_PORTS];
+static int test_port_count;
+static int test_port_moved;     /* the test was given a spare */
+static int port_test;           /* test the ports belong to */
+static int next_spare = -1;     /* -1: not yet chosen */
+static int collisions;
+
+/* Can 'port' be bound the way the tests bind it?  TCP is probed as
+ * make_loopback_listener() binds, on the loopback address with
+ * SO_REUSEADDR, so a port left in TIME_WAIT by an earlier run is not
+ * taken for a collision; UDP on any address, as the datagram tests
+ * bind.  errno is preserved, and the probe is not profiled. */
+static int port_free(int port)
+{
+    static const LONG types[2] = { SOCK_STREAM, SOCK_DGRAM };
+    struct sockaddr_in addr;
+    LONG saved_errno = bsd_errno;
+    LONG fd, one = 1;
+    int i, ok = 1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+
+    profile_suspend();
+    for (i = 0; i < 2 && ok; i++) {
+        fd = socket(AF_INET, types[i], 0);
+        if (fd < 0)
+            break;      /* cannot tell; let the test find out */
+        if (types[i] == SOCK_STREAM) {
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        } else {
+            addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        }
+        if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 &&
+            bsd_errno == EADDRINUSE)
+            ok = 0;
+        CloseSocket(fd);
+    }
+    profile_resume();
+    bsd_errno = saved_errno;
+    return ok;
+}
+
 void set_base_port(int port)
 {
     base_port = port;
 }
 
+int get_base_port(void)
+{
+    return base_port;
+}
+
+void port_begin_test(int number)
+{
+    port_test = number;
+    test_port_count = 0;
+    test_port_moved = 0;
+}
+
+void port_end_test(void)
+{
+    char list[MAX_TEST_PORTS * 6 + 1];
+    int i;
+
+    if (test_port_moved) {
+        list[0] = '\0';
+        for (i = 0; i < test_port_count; i++)
+            sprintf(list + strlen(list), " %d", test_ports[i].port);
+        tap_diagf("  ports:%s", list);
+    }
+    test_port_count = 0;
+    test_port_moved = 0;
+}
+
 int get_test_port(int offset)
 {
-    return base_port + offset;
+    struct bst_timestamp now;
+    int i, port, probe;
+
+    for (i = 0; i < test_port_count; i++) {
+        if (test_ports[i].offset == offset)
+            return test_ports[i].port;
+    }
+
+    port = base_port + offset;
+    for (probe = 0; probe < PORT_PROBES && !port_free(port); probe++) {
+        /* Instances that collide once tend to collide again; start
+         * each one's spares somewhere else */
+        if (next_spare < 0) {
+            timer_now(&now);
+            next_spare = (int)((now.ts_micro ^ (ULONG)FindTask(NULL) >> 4) %
+                               PORT_SPARE_COUNT);
+        }
+        collisions++;
+        test_port_moved = 1;
+        tap_diagf("  port: %d in use (test %d), trying %d", port,
+                  port_test, base_port + PORT_SPARE_FIRST + next_spare);
+        port = base_port + PORT_SPARE_FIRST + next_spare;
+        next_spare = (next_spare + 1) % PORT_SPARE_COUNT;
+    }
+
+    if (test_port_count < MAX_TEST_PORTS) {
+        test_ports[test_port_count].offset = offset;
+        test_ports[test_port_count].port = port;
+        test_port_count++;
+    }
+    return port;
+}
+
+int port_collisions(void)
+{
+    return collisions;
 }
 
 /* ---- Signal helpers ---- */
@@ -250,6 +386,12 @@ void free_signal(BYTE sigbit)
 
 static struct MsgPort *timer_port;
 static struct timerequest *timer_req;
+static struct MsgPort *watchdog_port;
+static struct timerequest *watchdog_req;   /* clone of timer_req */
+static int watchdog_pending;
+static int watchdog_secs;
+static ULONG watchdog_breakmask;    /* break mask to restore, if changed */
+static int watchdog_masked;
 
 int timer_init(void)
 {
@@ -279,11 +421,36 @@ int timer_init(void)
     }
 
     TimerBase = timer_req->tr_node.io_Device;
+
+    /* The watchdog shares the device but has its own request, since it
+     * stays outstanding while the test runs, and its own reply port:
+     * its signal goes into the break mask, where the replies of timer
+     * requests made during the test must not interrupt WaitSelect() */
+    watchdog_port = CreateMsgPort();
+    if (watchdog_port)
+        watchdog_req = (struct timerequest *)CreateIORequest(watchdog_port,
+                           sizeof(struct timerequest));
+    if (!watchdog_req) {
+        timer_cleanup();
+        tap_diag("Could not create watchdog I/O request");
+        return -1;
+    }
+    *watchdog_req = *timer_req;
+    watchdog_req->tr_node.io_Message.mn_ReplyPort = watchdog_port;
     return 0;
 }
 
 void timer_cleanup(void)
 {
+    if (watchdog_req) {
+        watchdog_stop();
+        DeleteIORequest((struct IORequest *)watchdog_req);
+        watchdog_req = NULL;
+    }
+    if (watchdog_port) {
+        DeleteMsgPort(watchdog_port);
+        watchdog_port = NULL;
+    }
     if (timer_req) {
         CloseDevice((struct IORequest *)timer_req);
         DeleteIORequest((struct IORequest *)timer_req);
@@ -330,6 +497,310 @@ ULONG timer_elapsed_ms(const struct bst_timestamp *start,
     return us / 1000 + ((us % 1000) >= 500 ? 1 : 0);
 }
 
+/* ---- Adaptive waits ---- */
+
+/* Calibration: round trips and short timeouts measured; the worst of
+ * each counts, so a slow or jittery stack keeps long waits */
+#define CAL_ROUNDS      16
+#define CAL_WAKE_ROUNDS 4
+#define CAL_WAKE_US     10000UL
+#define CAL_FACTOR      8       /* adaptive wait = latency x factor */
+#define WAIT_MIN_MS     20
+
+static ULONG cal_latency_us;    /* 0: not calibrated, fixed bounds */
+
+void calibrate_waits(void)
+{
+    LONG fd;
+    struct sockaddr_in addr;
+    socklen_t addrlen;
+    fd_set rdfds;
+    struct timeval tv;
+    struct bst_timestamp t0, t1;
+    ULONG us, rtt_us, wake_us;
+    unsigned char c;
+    int i;
+
+    cal_latency_us = 0;
+
+    /* One UDP socket bound to an ephemeral loopback port, sending to
+     * itself: no test port is taken */
+    fd = make_udp_socket();
+    if (fd < 0) {
+        tap_diag("calibration: no UDP socket, fixed waits");
+        return;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = 0;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addrlen = sizeof(addr);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        getsockname(fd, (struct sockaddr *)&addr, &addrlen) < 0) {
+        safe_close(fd);
+        tap_diag("calibration: loopback bind failed, fixed waits");
+        return;
+    }
+
+    rtt_us = 0;
+    for (i = 0; i < CAL_ROUNDS; i++) {
+        c = (unsigned char)i;
+        timer_now(&t0);
+        if (sendto(fd, (UBYTE *)&c, 1, 0, (struct sockaddr *)&addr,
+                   sizeof(addr)) != 1)
+            break;
+        FD_ZERO(&rdfds);
+        FD_SET(fd, &rdfds);
+        tv.tv_secs = 1;
+        tv.tv_micro = 0;
+        if (WaitSelect(fd + 1, &rdfds, NULL, NULL, &tv, NULL) != 1 ||
+            recv(fd, (UBYTE *)&c, 1, 0) != 1)
+            break;
+        timer_now(&t1);
+        us = timer_elapsed_us(&t0, &t1);
+        if (us > rtt_us)
+            rtt_us = us;
+    }
+    safe_close(fd);
+    if (i < CAL_ROUNDS) {
+        tap_diagf("calibration: loopback round trip %d failed, fixed waits",
+                  i + 1);
+        return;
+    }
+
+    /* Timer granularity: how late a short timeout wakes us */
+    wake_us = 0;
+    for (i = 0; i < CAL_WAKE_ROUNDS; i++) {
+        tv.tv_secs = 0;
+        tv.tv_micro = CAL_WAKE_US;
+        timer_now(&t0);
+        WaitSelect(0, NULL, NULL, NULL, &tv, NULL);
+        timer_now(&t1);
+        us = timer_elapsed_us(&t0, &t1);
+        us = us > CAL_WAKE_US ? us - CAL_WAKE_US : 0;
+        if (us > wake_us)
+            wake_us = us;
+    }
+
+    cal_latency_us = rtt_us + wake_us;
+    if (cal_latency_us == 0)
+        cal_latency_us = 1;
+    tap_diagf("calibration: loopback rtt %luus, wakeup +%luus, "
+              "settle %lums, 1s drain %lums",
+              (unsigned long)rtt_us, (unsigned long)wake_us,
+              (unsigned long)adaptive_ms(250),
+              (unsigned long)adaptive_ms(1000));
+}
+
+ULONG adaptive_ms(ULONG bound_ms)
+{
+    ULONG ms, floor_ms;
+
+    if (cal_latency_us == 0)
+        return bound_ms;
+
+    ms = (cal_latency_us * CAL_FACTOR + 999) / 1000;
+    floor_ms = bound_ms / 10;
+    if (floor_ms < WAIT_MIN_MS)
+        floor_ms = WAIT_MIN_MS;
+    if (ms < floor_ms)
+        ms = floor_ms;
+    if (ms > bound_ms)
+        ms = bound_ms;
+    return ms;
+}
+
+void settle_wait(ULONG bound_ms)
+{
+    struct timeval tv;
+    ULONG ms;
+
+    ms = adaptive_ms(bound_ms);
+    tv.tv_secs = ms / 1000;
+    tv.tv_micro = (ms % 1000) * 1000;
+    WaitSelect(0, NULL, NULL, NULL, &tv, NULL);
+}
+
+/* ---- Watchdog ---- */
+
+void watchdog_start(int seconds)
+{
+    ULONG sigmask, breakmask;
+
+    if (!watchdog_req || seconds <= 0)
+        return;
+
+    /* Tests may replace the break mask (and restore it); make sure the
+     * watchdog signal is part of it for this test.  watchdog_stop()
+     * puts the mask back as it was.  These calls are the suite's, not
+     * the test's: keep them out of PROFILE and TRACE. */
+    sigmask = 1UL << watchdog_port->mp_SigBit;
+    breakmask = 0;
+    profile_suspend();
+    SocketBaseTags(SBTM_GETREF(SBTC_BREAKMASK), (ULONG)&breakmask, TAG_DONE);
+    watchdog_masked = !(breakmask & sigmask);
+    if (watchdog_masked) {
+        watchdog_breakmask = breakmask;
+        SocketBaseTags(SBTM_SETVAL(SBTC_BREAKMASK), breakmask | sigmask,
+                       TAG_DONE);
+    }
+    profile_resume();
+    SetSignal(0, sigmask);
+
+    watchdog_req->tr_node.io_Command = TR_ADDREQUEST;
+    watchdog_req->tr_time.tv_secs = seconds;
+    watchdog_req->tr_time.tv_micro = 0;
+    SendIO((struct IORequest *)watchdog_req);
+    watchdog_pending = 1;
+    watchdog_secs = seconds;
+}
+
+int watchdog_expired(void)
+{
+    if (!watchdog_pending || !CheckIO((struct IORequest *)watchdog_req))
+        return 0;
+    return watchdog_secs;
+}
+
+int watchdog_stop(void)
+{
+    int expired;
+
+    if (!watchdog_pending)
+        return 0;
+
+    if (!CheckIO((struct IORequest *)watchdog_req))
+        AbortIO((struct IORequest *)watchdog_req);
+    /* io_Error is 0 only if the request ran to completion */
+    expired = WaitIO((struct IORequest *)watchdog_req) == 0;
+    watchdog_pending = 0;
+    SetSignal(0, 1UL << watchdog_port->mp_SigBit);
+    if (watchdog_masked) {
+        profile_suspend();
+        SocketBaseTags(SBTM_SETVAL(SBTC_BREAKMASK), watchdog_breakmask,
+                       TAG_DONE);
+        profile_resume();
+        watchdog_masked = 0;
+    }
+    return expired;
+}
+
+/* ---- Leak check ---- */
+
+/* Most descriptors probed; SBTC_DTABLESIZE tests raise the table */
+#define LEAK_MAX_FDS 256
+
+struct leak_state {
+    ULONG mem;
+    ULONG sigs;
+    ULONG fds[LEAK_MAX_FDS / 32];
+};
+
+static struct leak_state leak_before;
+static int leak_memory = 1;
+
+/* The stack allocates some memory on first use and keeps it (resolver
+ * buffers, protocol control blocks, mbuf clusters it grows into), as
+ * does the C library: an AvailMem() drop up to this size is logged but
+ * not counted as a leak */
+#define LEAK_MEM_SLACK 8192
+
+static void leak_snapshot(struct leak_state *st)
+{
+    LONG saved_errno = bsd_errno;
+    LONG fd, size, type;
+    socklen_t len;
+
+    memset(st->fds, 0, sizeof(st->fds));
+    size = getdtablesize();
+    if (size > LEAK_MAX_FDS)
+        size = LEAK_MAX_FDS;
+
+    /* getsockopt() fails with EBADF on a free descriptor and touches
+     * nothing on a valid one; the test after us must not see its
+     * errno either */
+    for (fd = 0; fd < size; fd++) {
+        len = sizeof(type);
+        if (getsockopt(fd, SOL_SOCKET, SO_TYPE, &type, &len) == 0)
+            st->fds[fd / 32] |= 1UL << (fd % 32);
+    }
+    bsd_errno = saved_errno;
+
+    st->sigs = FindTask(NULL)->tc_SigAlloc;
+    st->mem = AvailMem(MEMF_ANY);
+}
+
+void leak_check_set_memory(int flag)
+{
+    leak_memory = flag;
+}
+
+/* The checks' own calls are not profiled */
+void leak_check_begin(void)
+{
+    profile_suspend();
+    leak_snapshot(&leak_before);
+    profile_resume();
+}
+
+int leak_check_end(char *summary, int size)
+{
+    struct leak_state after;
+    ULONG extra;
+    char part[40];
+    int fd, bit, nfds = 0, nsigs = 0;
+
+    profile_suspend();
+    leak_snapshot(&after);
+    summary[0] = '\0';
+
+    /* Release what the test left behind, so that the next test (and
+     * the memory figure below) starts from the same baseline */
+    for (fd = 0; fd < LEAK_MAX_FDS; fd++) {
+        if ((after.fds[fd / 32] & ~leak_before.fds[fd / 32]) &
+            (1UL << (fd % 32))) {
+            tap_diagf("  leak: descriptor %d left open, closed", fd);
+            CloseSocket(fd);
+            nfds++;
+        }
+    }
+    extra = after.sigs & ~leak_before.sigs;
+    for (bit = 0; bit < 32; bit++) {
+        if (extra & (1UL << bit)) {
+            tap_diagf("  leak: signal %d left allocated, freed", bit);
+            FreeSignal(bit);
+            nsigs++;
+        }
+    }
+    after.mem = AvailMem(MEMF_ANY);
+
+    if (nfds > 0) {
+        sprintf(part, "%d descriptor%s", nfds, nfds == 1 ? "" : "s");
+        strncat(summary, part, size - strlen(summary) - 1);
+    }
+    if (nsigs > 0) {
+        sprintf(part, "%s%d signal%s", summary[0] ? ", " : "", nsigs,
+                nsigs == 1 ? "" : "s");
+        strncat(summary, part, size - strlen(summary) - 1);
+    }
+
+    if (leak_memory && after.mem < leak_before.mem &&
+        leak_before.mem - after.mem <= LEAK_MEM_SLACK) {
+        tap_diagf("  mem: AvailMem() down %lu bytes, within %d, "
+                  "not counted",
+                  (unsigned long)(leak_before.mem - after.mem),
+                  LEAK_MEM_SLACK);
+    } else if (leak_memory && after.mem < leak_before.mem) {
+        tap_diagf("  leak: AvailMem() down %lu bytes",
+                  (unsigned long)(leak_before.mem - after.mem));
+        sprintf(part, "%s%lu bytes", summary[0] ? ", " : "",
+                (unsigned long)(leak_before.mem - after.mem));
+        strncat(summary, part, size - strlen(summary) - 1);
+    }
+    profile_resume();
+    return summary[0] != '\0';
+}
+
 /* ---- Data patterns ---- */
 
 void fill_test_pattern(unsigned char *buf, int len, unsigned int seed)
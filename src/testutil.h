@@ -84,6 +84,10 @@ int set_nonblocking(LONG fd);
  * Returns 0 on success, -1 on failure. */
 int set_recv_timeout(LONG fd, int seconds);
 
+/* Set a receive timeout in milliseconds, for waits sized by
+ * adaptive_ms().  Returns 0 on success, -1 on failure. */
+int set_recv_timeout_ms(LONG fd, ULONG ms);
+
 /* Close a socket safely (ignores fd == -1). */
 void safe_close(LONG fd);
 
@@ -95,9 +99,28 @@ void close_all(LONG *fds, int count);
 /* Set the base port (from ReadArgs PORT/N parameter). */
 void set_base_port(int port);
 
-/* Get a test port: base + offset. */
+/* Get the base port. */
+int get_base_port(void);
+
+/* Start a test's port allocations; the runner calls this before each
+ * test. */
+void port_begin_test(int number);
+
+/* Log the ports the test was given ("# ports: ..."), if one of them
+ * is a spare. */
+void port_end_test(void);
+
+/* Get a test port: base + offset, unless that port cannot be bound as
+ * the tests bind it (another program or suite instance holds it; a
+ * port in TIME_WAIT is fine with SO_REUSEADDR).  Then a spare port
+ * past the registry offsets is probed instead, up to a few times, and
+ * the collision is logged.  Within a
+ * test the same offset always yields the same port. */
 int get_test_port(int offset);
 
+/* Number of ports found in use so far. */
+int port_collisions(void);
+
 /* ---- Signal helpers ---- */
 
 /* Allocate a signal bit. Returns the bit number (0-31) or -1 on failure. */
@@ -135,6 +158,62 @@ ULONG timer_elapsed_us(const struct bst_timestamp *start,
 ULONG timer_elapsed_ms(const struct bst_timestamp *start,
                        const struct bst_timestamp *end);
 
+/* ---- Adaptive waits ---- */
+
+/* Measure the loopback UDP round trip (send, WaitSelect() wakeup,
+ * recv) and how late a short WaitSelect() timeout returns, and log
+ * both.  Call once after timer_init().  If calibration fails every
+ * adaptive wait keeps its fixed bound. */
+void calibrate_waits(void);
+
+/* Length of an idle wait that normally runs to its end, such as a
+ * settle delay before polling or the quiet period ending a drain loop:
+ * a multiple of the calibrated latency, at least a tenth of 'bound_ms'
+ * (and 20ms) and at most 'bound_ms'. */
+ULONG adaptive_ms(ULONG bound_ms);
+
+/* Sleep in WaitSelect() for adaptive_ms(bound_ms), to let loopback
+ * data or events arrive. */
+void settle_wait(ULONG bound_ms);
+
+/* ---- Watchdog (timer.device) ---- */
+
+/* Arm the per-test watchdog: an asynchronous timer.device request due
+ * in 'seconds' (<= 0: not armed), replied to a port of its own.  Its
+ * signal is added to the bsdsocket break mask (SBTC_BREAKMASK), so when
+ * it expires a blocking call returns EINTR as it would for Ctrl-C.
+ * Requires timer_init(). */
+void watchdog_start(int seconds);
+
+/* Returns the armed timeout in seconds if the watchdog has expired
+ * (and not yet been stopped), 0 otherwise.  The TAP layer marks the
+ * results written after that as timed out. */
+int watchdog_expired(void);
+
+/* Disarm the watchdog (AbortIO if still pending), clear its signal and
+ * restore the break mask watchdog_start() found.  Returns 1 if it
+ * expired since watchdog_start(), 0 otherwise. */
+int watchdog_stop(void);
+
+/* ---- Leak check (LEAKCHECK) ---- */
+
+/* Snapshot AvailMem(), the valid descriptors (probed with
+ * getsockopt(SO_TYPE), errno preserved) and the task's allocated
+ * signals before a test. */
+void leak_check_begin(void);
+
+/* Compare with the snapshot after the test.  Each descriptor or signal
+ * the test left behind is logged and released, then a drop in
+ * AvailMem() is logged.  A drop of up to a few KB is logged but not
+ * counted, since the stack allocates some memory on first use.  Returns 1 and a summary such as "1 descriptor, 96 bytes"
+ * in 'summary' if anything leaked, else 0. */
+int leak_check_end(char *summary, int size);
+
+/* Enable/disable the AvailMem() check (default on).  Off in PARALLEL
+ * workers, where AvailMem() also moves with the other processes'
+ * allocations. */
+void leak_check_set_memory(int flag);
+
 /* ---- Data patterns ---- */
 
 /* Fill a buffer with a deterministic test pattern seeded by 'seed'. */
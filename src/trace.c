@@ -0,0 +1,178 @@
+/*
+ * bsdsocktest — Socket call trace (TRACE/K)
+ *
+ * The ring is a static array indexed by the number of calls since the
+ * last dump; a full ring overwrites its oldest records.
+ */
+
+#include "trace.h"
+#include "profile.h"
+#include "tap.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static struct trace_record ring[TRACE_RECORDS];
+static ULONG ring_next;         /* records since the last dump */
+static int current_test;
+static FILE *trace_fp;
+static const char *trace_path;
+
+/* ---- Internal helpers ---- */
+
+static UBYTE *put_word(UBYTE *p, UWORD v)
+{
+    p[0] = (UBYTE)(v >> 8);
+    p[1] = (UBYTE)v;
+    return p + 2;
+}
+
+static UBYTE *put_long(UBYTE *p, ULONG v)
+{
+    p[0] = (UBYTE)(v >> 24);
+    p[1] = (UBYTE)(v >> 16);
+    p[2] = (UBYTE)(v >> 8);
+    p[3] = (UBYTE)v;
+    return p + 4;
+}
+
+static int write_header(void)
+{
+    static const char pad[4] = { 0, 0, 0, 0 };
+    UBYTE buf[12], *p;
+    int i, name_bytes = 0, padding;
+
+    for (i = 0; i < PROF_COUNT; i++)
+        name_bytes += strlen(profile_name(i)) + 1;
+    padding = (4 - name_bytes % 4) % 4;
+
+    memcpy(buf, "BSTT", 4);
+    p = put_word(buf + 4, TRACE_VERSION);
+    p = put_word(p, TRACE_RECORD_SIZE);
+    p = put_word(p, PROF_COUNT);
+    put_word(p, (UWORD)(name_bytes + padding));
+    fwrite(buf, 1, sizeof(buf), trace_fp);
+    for (i = 0; i < PROF_COUNT; i++)
+        fwrite(profile_name(i), 1, strlen(profile_name(i)) + 1, trace_fp);
+    fwrite(pad, 1, padding, trace_fp);
+    return ferror(trace_fp) ? -1 : 0;
+}
+
+static void write_record(const struct trace_record *r)
+{
+    UBYTE buf[TRACE_RECORD_SIZE], *p;
+    int i;
+
+    p = put_long(buf, r->secs);
+    p = put_long(p, r->micro);
+    p = put_long(p, r->us);
+    p = put_word(p, r->call);
+    p = put_word(p, r->test);
+    for (i = 0; i < 4; i++)
+        p = put_long(p, (ULONG)r->args[i]);
+    p = put_long(p, (ULONG)r->result);
+    put_long(p, (ULONG)r->error);
+    fwrite(buf, 1, sizeof(buf), trace_fp);
+}
+
+/* ---- Public API ---- */
+
+int trace_open(const char *path, int append)
+{
+    trace_fp = fopen(path, append ? "ab" : "wb");
+    if (!trace_fp) {
+        tap_diagf("trace: cannot write %s", path);
+        return -1;
+    }
+    trace_path = path;
+    ring_next = 0;
+
+    /* An appended trace already has its header */
+    fseek(trace_fp, 0, SEEK_END);
+    if (ftell(trace_fp) == 0 && write_header() < 0) {
+        tap_diagf("trace: cannot write %s", path);
+        fclose(trace_fp);
+        trace_fp = NULL;
+        return -1;
+    }
+    fflush(trace_fp);
+    tap_diagf("trace: %d calls kept, dumped to %s on failure, timeout "
+              "or Ctrl-D", TRACE_RECORDS, path);
+    return 0;
+}
+
+int trace_enabled(void)
+{
+    return trace_fp != NULL;
+}
+
+void trace_set_test(int number)
+{
+    current_test = number;
+}
+
+void trace_record(int call, const struct bst_timestamp *start, ULONG us,
+                  LONG result, LONG error, LONG a0, LONG a1, LONG a2,
+                  LONG a3)
+{
+    struct trace_record *r;
+
+    if (!trace_fp)
+        return;
+    r = &ring[ring_next % TRACE_RECORDS];
+    ring_next++;
+
+    r->secs = start->ts_secs;
+    r->micro = start->ts_micro;
+    r->us = us;
+    r->call = (UWORD)call;
+    r->test = (UWORD)current_test;
+    r->args[0] = a0;
+    r->args[1] = a1;
+    r->args[2] = a2;
+    r->args[3] = a3;
+    r->result = result;
+    r->error = error;
+}
+
+int trace_dump(int reason, int number)
+{
+    UBYTE seg[16], *p;
+    ULONG first, n, i, outside = 0;
+
+    if (!trace_fp)
+        return 0;
+
+    n = ring_next < TRACE_RECORDS ? ring_next : TRACE_RECORDS;
+    first = ring_next - n;
+    memcpy(seg, "DUMP", 4);
+    p = put_word(seg + 4, (UWORD)reason);
+    p = put_word(p, (UWORD)number);
+    p = put_long(p, n);
+    put_long(p, ring_next - n);     /* overwritten */
+    fwrite(seg, 1, sizeof(seg), trace_fp);
+    for (i = 0; i < n; i++) {
+        if (ring[(first + i) % TRACE_RECORDS].test == 0)
+            outside++;
+        write_record(&ring[(first + i) % TRACE_RECORDS]);
+    }
+    /* Flushed now: the next test may be the one that kills the
+     * machine */
+    fflush(trace_fp);
+
+    ring_next = 0;
+    tap_diagf("  trace: %lu calls dumped to %s", (unsigned long)n,
+              trace_path);
+    if (outside > 0)
+        tap_diagf("  trace: %lu calls made outside a test",
+                  (unsigned long)outside);
+    return (int)n;
+}
+
+void trace_close(void)
+{
+    if (trace_fp) {
+        fclose(trace_fp);
+        trace_fp = NULL;
+    }
+}
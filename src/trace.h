@@ -0,0 +1,77 @@
+/*
+ * bsdsocktest — Socket call trace (TRACE/K)
+ *
+ * The profile wrappers (profile.c) also append each call to a ring
+ * buffer: call, test, start time, duration, up to four scalar
+ * arguments, result and errno.  Recording is a copy into the ring; the
+ * ring is written to the trace file only when a test fails, times out
+ * or Ctrl-D asks for it.  host/bsdsocktest_trace.py decodes the file.
+ *
+ * File layout, big-endian 16 and 32-bit fields whatever the host:
+ *
+ *   header   "BSTT", version, record size, call count, name bytes
+ *            (16 bits each), then the call names, NUL terminated,
+ *            padded to a multiple of 4
+ *   dump     "DUMP", reason, test (16 bits), records, records lost to
+ *            the ring wrapping (32 bits), then the records, oldest
+ *            first, each laid out as struct trace_record
+ */
+
+#ifndef BSDSOCKTEST_TRACE_H
+#define BSDSOCKTEST_TRACE_H
+
+#include <exec/types.h>
+
+#include "testutil.h"
+
+#define TRACE_VERSION 1
+
+/* Calls kept in the ring */
+#define TRACE_RECORDS 1024
+
+/* Why the ring was dumped */
+#define TRACE_FAILED  1     /* the test failed unexpectedly */
+#define TRACE_TIMEOUT 2     /* the watchdog interrupted the test */
+#define TRACE_REQUEST 3     /* Ctrl-D */
+
+/* One call; TRACE_RECORD_SIZE bytes in the file */
+#define TRACE_RECORD_SIZE 40
+
+struct trace_record {
+    ULONG secs;             /* start, timer_now() */
+    ULONG micro;
+    ULONG us;               /* duration */
+    UWORD call;             /* enum profile_call */
+    UWORD test;             /* test number, 0 outside a test */
+    LONG args[4];           /* per call, see the decoder */
+    LONG result;            /* pointer results: 1 = non-NULL */
+    LONG error;             /* errno after a failed call, else 0 */
+};
+
+/* Start tracing into 'path', replacing it or, for RESUME, appending
+ * to it.  Returns 0, or -1 if the file cannot be written (diagnostic
+ * emitted). */
+int trace_open(const char *path, int append);
+
+/* Non-zero while tracing. */
+int trace_enabled(void);
+
+/* Tag the following calls with a test number; 0 once the test body
+ * returns. */
+void trace_set_test(int number);
+
+/* Append a call to the ring. */
+void trace_record(int call, const struct bst_timestamp *start, ULONG us,
+                  LONG result, LONG error, LONG a0, LONG a1, LONG a2,
+                  LONG a3);
+
+/* Write the ring to the trace file, as taken for test 'number', and
+ * empty it.  Calls recorded outside a test body are counted in the
+ * log: the suite's own calls belong out of the trace.  Returns the
+ * number of records written. */
+int trace_dump(int reason, int number);
+
+/* Close the trace file. */
+void trace_close(void);
+
+#endif /* BSDSOCKTEST_TRACE_H */